@@ -2,6 +2,102 @@
 #define __SIGPROC_TOOLS_DECONVOLVE_CXX__
 
 #include "AdaptiveWiener.h"
+#include "Instrumentation.h"
+#include "ParallelFor.h"
+#include "Trace.h"
+#include "WindowKernels.h"
+
+// Channels per tile of the filter loops, the unit of the parallel tasks
+// and of the trace events
+static constexpr size_t kTileRows = 16;
+
+namespace {
+
+  // Window [i - HX, i + HX) x [j - HY, j + HY) of a pixel away from the
+  // plane borders, for registered half sizes: visited in row-major order
+  // as straight-line code
+  template <int HX, int HY>
+  struct FixedWindow {
+    template <typename Visit>
+    void forEach(const size_t i, const size_t j, Visit&& visit) const
+    {
+      icarussigproc::unrollRange<-HX, HX - 1>([&](auto dx) {
+        icarussigproc::unrollRange<-HY, HY - 1>([&](auto dy) {
+          visit(i + int(dx), j + int(dy));
+        });
+      });
+    }
+  };
+
+  // The same window clipped to the plane, for pixels near the borders and
+  // for sizes that are not registered
+  struct ClippedWindow {
+    size_t lowerBoundx;
+    size_t upperBoundx;
+    size_t lowerBoundy;
+    size_t upperBoundy;
+
+    template <typename Visit>
+    void forEach(const size_t, const size_t, Visit&& visit) const
+    {
+      for (size_t ix=lowerBoundx; ix<upperBoundx; ++ix) {
+        for (size_t iy=lowerBoundy; iy<upperBoundy; ++iy) {
+          visit(ix, iy);
+        }
+      }
+    }
+  };
+
+  // Calls pixel(i, j, window) for every pixel of the channels [begin, end)
+  // of a numChannels x nTicks plane. The filters write their per pixel code
+  // once, as a generic lambda; the compiler instantiates it for the
+  // FixedWindow of the registered sizes and for the ClippedWindow.
+  template <typename Pixel>
+  void forEachPixel(
+    const size_t numChannels,
+    const size_t nTicks,
+    const size_t begin,
+    const size_t end,
+    const int xHalfWindowSize,
+    const int yHalfWindowSize,
+    Pixel&& pixel)
+  {
+    auto clipped = [&](const size_t i, const size_t j) {
+      int lbx = i - (int) xHalfWindowSize;
+      int ubx = i + (int) xHalfWindowSize;
+      int lby = j - (int) yHalfWindowSize;
+      int uby = j + (int) yHalfWindowSize;
+      pixel(i, j, ClippedWindow{size_t(std::max(lbx, 0)),
+        size_t(std::min(ubx, (int) numChannels)), size_t(std::max(lby, 0)),
+        size_t(std::min(uby, (int) nTicks))});
+    };
+    bool fixed = icarussigproc::dispatchSizes(
+      icarussigproc::FilterHalfWindows(), icarussigproc::FilterHalfWindows(),
+      xHalfWindowSize, yHalfWindowSize, [&](auto halfx, auto halfy) {
+        constexpr int HX = decltype(halfx)::value;
+        constexpr int HY = decltype(halfy)::value;
+        FixedWindow<HX, HY> window;
+        size_t interiorBegin = std::min(size_t(HY), nTicks);
+        size_t interiorEnd = nTicks >= size_t(HY) ? nTicks - HY + 1 : 0;
+        interiorEnd = std::max(interiorBegin, interiorEnd);
+        for (size_t i=begin; i<end; ++i) {
+          bool interiorRow = i >= size_t(HX) && i + HX <= numChannels;
+          for (size_t j=0; j<nTicks; ++j) {
+            if (interiorRow && j >= interiorBegin && j < interiorEnd) {
+              pixel(i, j, window);
+            } else {
+              clipped(i, j);
+            }
+          }
+        }
+      });
+    if (fixed) return;
+    for (size_t i=begin; i<end; ++i) {
+      for (size_t j=0; j<nTicks; ++j) clipped(i, j);
+    }
+    return;
+  }
+}
 
 #endif
 
@@ -10,10 +106,10 @@ void sigproc_tools::AdaptiveWiener::filterLee(
   const std::vector<std::vector<short>>& waveLessCoherent,
   const float noiseVar,
   const unsigned int sx,
-  const unsigned int sy)
+  const unsigned int sy) const
 {
   filterLee<short>(
-    deconvolvedWaveform, waveLessCoherent, sx, sy, noiseVar);
+    deconvolvedWaveform, waveLessCoherent, noiseVar, sx, sy);
 }
 
 void sigproc_tools::AdaptiveWiener::filterLee(
@@ -21,10 +117,10 @@ void sigproc_tools::AdaptiveWiener::filterLee(
   const std::vector<std::vector<float>>& waveLessCoherent,
   const float noiseVar,
   const unsigned int sx,
-  const unsigned int sy)
+  const unsigned int sy) const
 {
   filterLee<float>(
-    deconvolvedWaveform, waveLessCoherent, sx, sy, noiseVar);
+    deconvolvedWaveform, waveLessCoherent, noiseVar, sx, sy);
 }
 
 void sigproc_tools::AdaptiveWiener::filterLee(
@@ -32,62 +128,89 @@ void sigproc_tools::AdaptiveWiener::filterLee(
   const std::vector<std::vector<double>>& waveLessCoherent,
   const float noiseVar,
   const unsigned int sx,
-  const unsigned int sy)
+  const unsigned int sy) const
 {
   filterLee<double>(
-    deconvolvedWaveform, waveLessCoherent, sx, sy, noiseVar);
+    deconvolvedWaveform, waveLessCoherent, noiseVar, sx, sy);
 }
 
-template <typename T>
 void sigproc_tools::AdaptiveWiener::filterLee(
-  std::vector<std::vector<T>>& deconvolvedWaveform,
-  const std::vector<std::vector<T>>& waveLessCoherent,
+  icarussigproc::Array2D<short>& deconvolvedWaveform,
+  const icarussigproc::Array2DView<const short> waveLessCoherent,
   const float noiseVar,
   const unsigned int sx,
-  const unsigned int sy)
+  const unsigned int sy) const
 {
-  size_t numChannels = waveLessCoherent.size();
-  size_t nTicks = waveLessCoherent.at(0).size();
+  filterLee<short>(
+    deconvolvedWaveform, waveLessCoherent, noiseVar, sx, sy);
+}
+
+void sigproc_tools::AdaptiveWiener::filterLee(
+  icarussigproc::Array2D<float>& deconvolvedWaveform,
+  const icarussigproc::Array2DView<const float> waveLessCoherent,
+  const float noiseVar,
+  const unsigned int sx,
+  const unsigned int sy) const
+{
+  filterLee<float>(
+    deconvolvedWaveform, waveLessCoherent, noiseVar, sx, sy);
+}
+
+void sigproc_tools::AdaptiveWiener::filterLee(
+  icarussigproc::Array2D<double>& deconvolvedWaveform,
+  const icarussigproc::Array2DView<const double> waveLessCoherent,
+  const float noiseVar,
+  const unsigned int sx,
+  const unsigned int sy) const
+{
+  filterLee<double>(
+    deconvolvedWaveform, waveLessCoherent, noiseVar, sx, sy);
+}
+
+template <typename T, typename OutArray, typename InArray>
+void sigproc_tools::AdaptiveWiener::filterLee(
+  OutArray& deconvolvedWaveform,
+  const InArray& waveLessCoherent,
+  const float noiseVar,
+  const unsigned int sx,
+  const unsigned int sy) const
+{
+  size_t numChannels = icarussigproc::numRows(waveLessCoherent);
+  size_t nTicks = icarussigproc::numCols(waveLessCoherent);
+  size_t numSamples = numChannels * nTicks;
+  SIGPROC_PHASE("AdaptiveWiener::filterLee", numSamples,
+    2 * numSamples * sizeof(T));
   int xHalfWindowSize(sx / 2);
   int yHalfWindowSize(sy / 2);
 
-  deconvolvedWaveform.resize(numChannels);
-  for (size_t i=0; i<numChannels; ++i) {
-    deconvolvedWaveform[i].resize(nTicks);
-  }
-
-  for (size_t i=0; i<numChannels; ++i) {
-    for (size_t j=0; j<nTicks; ++j) {
-      // For each center pixel, apply a adaptive local wiener filter.
-      int lbx = i - (int) xHalfWindowSize;
-      int ubx = i + (int) xHalfWindowSize;
-      int lby = j - (int) yHalfWindowSize;
-      int uby = j + (int) yHalfWindowSize;
-      size_t lowerBoundx = std::max(lbx, 0);
-      size_t upperBoundx = std::min(ubx, (int) numChannels);
-      size_t lowerBoundy = std::max(lby, 0);
-      size_t upperBoundy = std::min(uby, (int) nTicks);
-      std::vector<T> x;
-      x.reserve(sx * sy);
-      std::vector<T> xsq;
-      xsq.reserve(sx * sy);
-      for (size_t ix=lowerBoundx; ix<upperBoundx; ++ix) {
-        for (size_t iy=lowerBoundy; iy<upperBoundy; ++iy) {
-          x.push_back(waveLessCoherent[ix][iy]);
-          xsq.push_back(waveLessCoherent[ix][iy] * waveLessCoherent[ix][iy]);
+  icarussigproc::resize2D(deconvolvedWaveform, numChannels, nTicks);
+
+  auto processTile = [&](size_t begin, size_t end, unsigned int) {
+    SIGPROC_TRACE("AdaptiveWiener::filterLee tile", "firstChannel", begin);
+    forEachPixel(numChannels, nTicks, begin, end, xHalfWindowSize,
+      yHalfWindowSize, [&](size_t i, size_t j, const auto& window) {
+        // For each center pixel, apply a adaptive local wiener filter.
+        double sum = 0.;
+        double sumSq = 0.;
+        size_t count = 0;
+        window.forEach(i, j, [&](size_t ix, size_t iy) {
+          T value = waveLessCoherent[ix][iy];
+          sum += value;
+          sumSq += T(value * value);
+          ++count;
+        });
+        T localMean = sum / count;
+        T localSquare = sumSq / count;
+        T localVar = localSquare - localMean * localMean;
+        if (noiseVar > localVar) {
+          deconvolvedWaveform[i][j] = localMean;
+        } else {
+          deconvolvedWaveform[i][j] = localMean + (1 - noiseVar / localVar) *
+            (waveLessCoherent[i][j] - localMean);
         }
-      }
-      T localMean = std::accumulate(x.begin(), x.end(), 0.0) / x.size() ;
-      T localSquare = std::accumulate(xsq.begin(), xsq.end(), 0.0) / x.size() ;
-      T localVar = localSquare - localMean * localMean;
-      if (noiseVar > localVar) {
-        deconvolvedWaveform[i][j] = localMean;
-      } else {
-        deconvolvedWaveform[i][j] = localMean + (1 - noiseVar / localVar) *
-          (waveLessCoherent[i][j] - localMean);
-      }
-    }
-  }
+      });
+  };
+  icarussigproc::parallelFor(numChannels, kTileRows, processTile, fNumThreads);
   return;
 }
 
@@ -97,7 +220,7 @@ void sigproc_tools::AdaptiveWiener::MMWF(
   const std::vector<std::vector<short>>& waveLessCoherent,
   const float noiseVar,
   const unsigned int sx,
-  const unsigned int sy)
+  const unsigned int sy) const
 {
   MMWF<short>(
     deconvolvedWaveform, waveLessCoherent, noiseVar, sx, sy);
@@ -108,7 +231,7 @@ void sigproc_tools::AdaptiveWiener::MMWF(
   const std::vector<std::vector<float>>& waveLessCoherent,
   const float noiseVar,
   const unsigned int sx,
-  const unsigned int sy)
+  const unsigned int sy) const
 {
   MMWF<float>(
     deconvolvedWaveform, waveLessCoherent, noiseVar, sx, sy);
@@ -119,65 +242,102 @@ void sigproc_tools::AdaptiveWiener::MMWF(
   const std::vector<std::vector<double>>& waveLessCoherent,
   const float noiseVar,
   const unsigned int sx,
-  const unsigned int sy)
+  const unsigned int sy) const
 {
   MMWF<double>(
     deconvolvedWaveform, waveLessCoherent, noiseVar, sx, sy);
 }
 
-template <typename T>
 void sigproc_tools::AdaptiveWiener::MMWF(
-  std::vector<std::vector<T>>& deconvolvedWaveform,
-  const std::vector<std::vector<T>>& waveLessCoherent,
+  icarussigproc::Array2D<short>& deconvolvedWaveform,
+  const icarussigproc::Array2DView<const short> waveLessCoherent,
   const float noiseVar,
   const unsigned int sx,
-  const unsigned int sy)
+  const unsigned int sy) const
 {
-  size_t numChannels = waveLessCoherent.size();
-  size_t nTicks = waveLessCoherent.at(0).size();
-  int xHalfWindowSize(sx / 2);
-  int yHalfWindowSize(sy / 2);
+  MMWF<short>(
+    deconvolvedWaveform, waveLessCoherent, noiseVar, sx, sy);
+}
 
-  deconvolvedWaveform.resize(numChannels);
-  for (size_t i=0; i<numChannels; ++i) {
-    deconvolvedWaveform[i].resize(nTicks);
-  }
+void sigproc_tools::AdaptiveWiener::MMWF(
+  icarussigproc::Array2D<float>& deconvolvedWaveform,
+  const icarussigproc::Array2DView<const float> waveLessCoherent,
+  const float noiseVar,
+  const unsigned int sx,
+  const unsigned int sy) const
+{
+  MMWF<float>(
+    deconvolvedWaveform, waveLessCoherent, noiseVar, sx, sy);
+}
 
-  sigproc_tools::MiscUtils utils;
+void sigproc_tools::AdaptiveWiener::MMWF(
+  icarussigproc::Array2D<double>& deconvolvedWaveform,
+  const icarussigproc::Array2DView<const double> waveLessCoherent,
+  const float noiseVar,
+  const unsigned int sx,
+  const unsigned int sy) const
+{
+  MMWF<double>(
+    deconvolvedWaveform, waveLessCoherent, noiseVar, sx, sy);
+}
 
-  for (size_t i=0; i<numChannels; ++i) {
-    for (size_t j=0; j<nTicks; ++j) {
-      // For each center pixel, apply a adaptive local wiener filter.
-      int lbx = i - (int) xHalfWindowSize;
-      int ubx = i + (int) xHalfWindowSize;
-      int lby = j - (int) yHalfWindowSize;
-      int uby = j + (int) yHalfWindowSize;
-      size_t lowerBoundx = std::max(lbx, 0);
-      size_t upperBoundx = std::min(ubx, (int) numChannels);
-      size_t lowerBoundy = std::max(lby, 0);
-      size_t upperBoundy = std::min(uby, (int) nTicks);
-      std::vector<T> x;
-      x.reserve(sx * sy);
-      std::vector<T> xsq;
-      xsq.reserve(sx * sy);
-      for (size_t ix=lowerBoundx; ix<upperBoundx; ++ix) {
-        for (size_t iy=lowerBoundy; iy<upperBoundy; ++iy) {
-          x.push_back(waveLessCoherent[ix][iy]);
-          xsq.push_back(waveLessCoherent[ix][iy] * waveLessCoherent[ix][iy]);
+template <typename T, typename OutArray, typename InArray>
+void sigproc_tools::AdaptiveWiener::MMWF(
+  OutArray& deconvolvedWaveform,
+  const InArray& waveLessCoherent,
+  const float noiseVar,
+  const unsigned int sx,
+  const unsigned int sy) const
+{
+  size_t numChannels = icarussigproc::numRows(waveLessCoherent);
+  size_t nTicks = icarussigproc::numCols(waveLessCoherent);
+  size_t numSamples = numChannels * nTicks;
+  SIGPROC_PHASE("AdaptiveWiener::MMWF", numSamples,
+    2 * numSamples * sizeof(T));
+  int xHalfWindowSize(sx / 2);
+  int yHalfWindowSize(sy / 2);
+
+  icarussigproc::resize2D(deconvolvedWaveform, numChannels, nTicks);
+
+  icarussigproc::MiscUtils utils;
+
+  auto processTile = [&](size_t begin, size_t end, unsigned int) {
+    SIGPROC_TRACE("AdaptiveWiener::MMWF tile", "firstChannel", begin);
+    for (size_t i=begin; i<end; ++i) {
+      for (size_t j=0; j<nTicks; ++j) {
+        // For each center pixel, apply a adaptive local wiener filter.
+        int lbx = i - (int) xHalfWindowSize;
+        int ubx = i + (int) xHalfWindowSize;
+        int lby = j - (int) yHalfWindowSize;
+        int uby = j + (int) yHalfWindowSize;
+        size_t lowerBoundx = std::max(lbx, 0);
+        size_t upperBoundx = std::min(ubx, (int) numChannels);
+        size_t lowerBoundy = std::max(lby, 0);
+        size_t upperBoundy = std::min(uby, (int) nTicks);
+        std::vector<T> x;
+        x.reserve(sx * sy);
+        std::vector<T> xsq;
+        xsq.reserve(sx * sy);
+        for (size_t ix=lowerBoundx; ix<upperBoundx; ++ix) {
+          for (size_t iy=lowerBoundy; iy<upperBoundy; ++iy) {
+            x.push_back(waveLessCoherent[ix][iy]);
+            xsq.push_back(waveLessCoherent[ix][iy] * waveLessCoherent[ix][iy]);
+          }
+        }
+        T localMean = std::accumulate(x.begin(), x.end(), 0.0) / x.size() ;
+        T localSquare = std::accumulate(xsq.begin(), xsq.end(), 0.0) / x.size() ;
+        T localVar = localSquare - localMean * localMean;
+        T localMedian = utils.computeMedianInPlace(x.begin(), x.end());
+        if (noiseVar > localVar) {
+          deconvolvedWaveform[i][j] = localMedian;
+        } else {
+          deconvolvedWaveform[i][j] = localMedian + (1 - noiseVar / localVar) *
+            (waveLessCoherent[i][j] - localMedian);
         }
-      }
-      T localMean = std::accumulate(x.begin(), x.end(), 0.0) / x.size() ;
-      T localSquare = std::accumulate(xsq.begin(), xsq.end(), 0.0) / x.size() ;
-      T localVar = localSquare - localMean * localMean;
-      T localMedian = utils.computeMedian(x);
-      if (noiseVar > localVar) {
-        deconvolvedWaveform[i][j] = localMedian;
-      } else {
-        deconvolvedWaveform[i][j] = localMedian + (1 - noiseVar / localVar) *
-          (waveLessCoherent[i][j] - localMedian);
       }
     }
-  }
+  };
+  icarussigproc::parallelFor(numChannels, kTileRows, processTile, fNumThreads);
   return;
 }
 
@@ -186,7 +346,7 @@ void sigproc_tools::AdaptiveWiener::MMWFStar(
   std::vector<std::vector<short>>& deconvolvedWaveform,
   const std::vector<std::vector<short>>& waveLessCoherent,
   const unsigned int sx,
-  const unsigned int sy)
+  const unsigned int sy) const
 {
   MMWFStar<short>(
     deconvolvedWaveform, waveLessCoherent, sx, sy);
@@ -196,7 +356,7 @@ void sigproc_tools::AdaptiveWiener::MMWFStar(
   std::vector<std::vector<float>>& deconvolvedWaveform,
   const std::vector<std::vector<float>>& waveLessCoherent,
   const unsigned int sx,
-  const unsigned int sy)
+  const unsigned int sy) const
 {
   MMWFStar<float>(
     deconvolvedWaveform, waveLessCoherent, sx, sy);
@@ -206,91 +366,121 @@ void sigproc_tools::AdaptiveWiener::MMWFStar(
   std::vector<std::vector<double>>& deconvolvedWaveform,
   const std::vector<std::vector<double>>& waveLessCoherent,
   const unsigned int sx,
-  const unsigned int sy)
+  const unsigned int sy) const
 {
   MMWFStar<double>(
     deconvolvedWaveform, waveLessCoherent, sx, sy);
 }
 
-template <typename T>
 void sigproc_tools::AdaptiveWiener::MMWFStar(
-  std::vector<std::vector<T>>& deconvolvedWaveform,
-  const std::vector<std::vector<T>>& waveLessCoherent,
+  icarussigproc::Array2D<short>& deconvolvedWaveform,
+  const icarussigproc::Array2DView<const short> waveLessCoherent,
   const unsigned int sx,
-  const unsigned int sy)
+  const unsigned int sy) const
 {
-  size_t numChannels = waveLessCoherent.size();
-  size_t nTicks = waveLessCoherent.at(0).size();
-  int xHalfWindowSize(sx / 2);
-  int yHalfWindowSize(sy / 2);
-
-  deconvolvedWaveform.resize(numChannels);
-  for (size_t i=0; i<numChannels; ++i) {
-    deconvolvedWaveform[i].resize(nTicks);
-  }
+  MMWFStar<short>(
+    deconvolvedWaveform, waveLessCoherent, sx, sy);
+}
 
-  sigproc_tools::MiscUtils utils;
+void sigproc_tools::AdaptiveWiener::MMWFStar(
+  icarussigproc::Array2D<float>& deconvolvedWaveform,
+  const icarussigproc::Array2DView<const float> waveLessCoherent,
+  const unsigned int sx,
+  const unsigned int sy) const
+{
+  MMWFStar<float>(
+    deconvolvedWaveform, waveLessCoherent, sx, sy);
+}
 
-  std::vector<std::vector<T>> localMedians;
-  std::vector<std::vector<T>> localVars;
+void sigproc_tools::AdaptiveWiener::MMWFStar(
+  icarussigproc::Array2D<double>& deconvolvedWaveform,
+  const icarussigproc::Array2DView<const double> waveLessCoherent,
+  const unsigned int sx,
+  const unsigned int sy) const
+{
+  MMWFStar<double>(
+    deconvolvedWaveform, waveLessCoherent, sx, sy);
+}
 
-  localMedians.resize(numChannels);
-  for (size_t i=0; i<numChannels; ++i) {
-    localMedians[i].resize(nTicks);
-  }
+template <typename T, typename OutArray, typename InArray>
+void sigproc_tools::AdaptiveWiener::MMWFStar(
+  OutArray& deconvolvedWaveform,
+  const InArray& waveLessCoherent,
+  const unsigned int sx,
+  const unsigned int sy) const
+{
+  size_t numChannels = icarussigproc::numRows(waveLessCoherent);
+  size_t nTicks = icarussigproc::numCols(waveLessCoherent);
+  size_t numSamples = numChannels * nTicks;
+  SIGPROC_PHASE("AdaptiveWiener::MMWFStar", numSamples,
+    2 * numSamples * sizeof(T));
+  int xHalfWindowSize(sx / 2);
+  int yHalfWindowSize(sy / 2);
 
-  localVars.resize(numChannels);
-  for (size_t i=0; i<numChannels; ++i) {
-    localVars[i].resize(nTicks);
-  }
+  icarussigproc::resize2D(deconvolvedWaveform, numChannels, nTicks);
+
+  icarussigproc::MiscUtils utils;
+
+  icarussigproc::Array2D<T> localMedians(numChannels, nTicks);
+  icarussigproc::Array2D<T> localVars(numChannels, nTicks);
+
+  auto processTile = [&](size_t begin, size_t end, unsigned int) {
+    SIGPROC_TRACE("AdaptiveWiener::MMWFStar tile", "firstChannel", begin);
+    for (size_t i=begin; i<end; ++i) {
+      for (size_t j=0; j<nTicks; ++j) {
+        // For each center pixel, apply a adaptive local wiener filter.
+        int lbx = i - (int) xHalfWindowSize;
+        int ubx = i + (int) xHalfWindowSize;
+        int lby = j - (int) yHalfWindowSize;
+        int uby = j + (int) yHalfWindowSize;
+        size_t lowerBoundx = std::max(lbx, 0);
+        size_t upperBoundx = std::min(ubx, (int) numChannels);
+        size_t lowerBoundy = std::max(lby, 0);
+        size_t upperBoundy = std::min(uby, (int) nTicks);
+        std::vector<T> x;
+        x.reserve(sx * sy);
+        std::vector<T> xsq;
+        xsq.reserve(sx * sy);
+        for (size_t ix=lowerBoundx; ix<upperBoundx; ++ix) {
+          for (size_t iy=lowerBoundy; iy<upperBoundy; ++iy) {
+            x.push_back(waveLessCoherent[ix][iy]);
+            xsq.push_back(waveLessCoherent[ix][iy] * waveLessCoherent[ix][iy]);
+          }
+        }
+        T localMean = std::accumulate(x.begin(), x.end(), 0.0) / x.size() ;
+        T localSquare = std::accumulate(xsq.begin(), xsq.end(), 0.0) / x.size() ;
+        T localMedian = utils.computeMedianInPlace(x.begin(), x.end());
+        T localVar = localSquare - 2.0 * localMean * localMedian + std::pow(localMean, 2.0);
+        localMedians[i][j] = localMedian;
+        localVars[i][j] = localVar;
+      }
+    }
+  };
+  icarussigproc::parallelFor(numChannels, kTileRows, processTile, fNumThreads);
 
   std::vector<T> localVarTemp;
   localVarTemp.reserve(numChannels * nTicks);
-
   for (size_t i=0; i<numChannels; ++i) {
-    for (size_t j=0; j<nTicks; ++j) {
-      // For each center pixel, apply a adaptive local wiener filter.
-      int lbx = i - (int) xHalfWindowSize;
-      int ubx = i + (int) xHalfWindowSize;
-      int lby = j - (int) yHalfWindowSize;
-      int uby = j + (int) yHalfWindowSize;
-      size_t lowerBoundx = std::max(lbx, 0);
-      size_t upperBoundx = std::min(ubx, (int) numChannels);
-      size_t lowerBoundy = std::max(lby, 0);
-      size_t upperBoundy = std::min(uby, (int) nTicks);
-      std::vector<T> x;
-      x.reserve(sx * sy);
-      std::vector<T> xsq;
-      xsq.reserve(sx * sy);
-      for (size_t ix=lowerBoundx; ix<upperBoundx; ++ix) {
-        for (size_t iy=lowerBoundy; iy<upperBoundy; ++iy) {
-          x.push_back(waveLessCoherent[ix][iy]);
-          xsq.push_back(waveLessCoherent[ix][iy] * waveLessCoherent[ix][iy]);
-        }
-      }
-      T localMean = std::accumulate(x.begin(), x.end(), 0.0) / x.size() ;
-      T localSquare = std::accumulate(xsq.begin(), xsq.end(), 0.0) / x.size() ;
-      T localMedian = utils.computeMedian(x);
-      T localVar = localSquare - 2.0 * localMean * localMedian + std::pow(localMean, 2.0);
-      localMedians[i][j] = localMedian;
-      localVarTemp.push_back(localVar);
-      localVars[i][j] = localVar;
-    }
+    localVarTemp.insert(localVarTemp.end(), localVars[i], localVars[i] + nTicks);
   }
 
-  float noiseMedian = utils.computeMedian(localVarTemp);
-  std::cout << noiseMedian << std::endl;
-
-  for (size_t i=0; i<numChannels; ++i) {
-    for (size_t j=0; j<nTicks; ++j) {
-      if (noiseMedian > localVars[i][j]) {
-        deconvolvedWaveform[i][j] = localMedians[i][j];
-      } else {
-        deconvolvedWaveform[i][j] = localMedians[i][j] +
-        (1.0 - noiseMedian / localVars[i][j]) * (waveLessCoherent[i][j] - localMedians[i][j]);
+  float noiseMedian = utils.computeMedianInPlace(
+    localVarTemp.begin(), localVarTemp.end());
+
+  auto filterTile = [&](size_t begin, size_t end, unsigned int) {
+    SIGPROC_TRACE("AdaptiveWiener::MMWFStar tile", "firstChannel", begin);
+    for (size_t i=begin; i<end; ++i) {
+      for (size_t j=0; j<nTicks; ++j) {
+        if (noiseMedian > localVars[i][j]) {
+          deconvolvedWaveform[i][j] = localMedians[i][j];
+        } else {
+          deconvolvedWaveform[i][j] = localMedians[i][j] +
+          (1.0 - noiseMedian / localVars[i][j]) * (waveLessCoherent[i][j] - localMedians[i][j]);
+        }
       }
     }
-  }
+  };
+  icarussigproc::parallelFor(numChannels, kTileRows, filterTile, fNumThreads);
 
   return;
 }
@@ -303,10 +493,10 @@ void sigproc_tools::AdaptiveWiener::filterLeeEnhanced(
   const unsigned int sx,
   const unsigned int sy,
   const float a,
-  const float epsilon)
+  const float epsilon) const
 {
   filterLeeEnhanced<short>(
-    deconvolvedWaveform, waveLessCoherent, sx, sy, noiseVar, a, epsilon);
+    deconvolvedWaveform, waveLessCoherent, noiseVar, sx, sy, a, epsilon);
 }
 
 void sigproc_tools::AdaptiveWiener::filterLeeEnhanced(
@@ -316,10 +506,10 @@ void sigproc_tools::AdaptiveWiener::filterLeeEnhanced(
   const unsigned int sx,
   const unsigned int sy,
   const float a,
-  const float epsilon)
+  const float epsilon) const
 {
   filterLeeEnhanced<float>(
-    deconvolvedWaveform, waveLessCoherent, sx, sy, noiseVar, a, epsilon);
+    deconvolvedWaveform, waveLessCoherent, noiseVar, sx, sy, a, epsilon);
 }
 
 void sigproc_tools::AdaptiveWiener::filterLeeEnhanced(
@@ -329,76 +519,109 @@ void sigproc_tools::AdaptiveWiener::filterLeeEnhanced(
   const unsigned int sx,
   const unsigned int sy,
   const float a,
-  const float epsilon)
+  const float epsilon) const
+{
+  filterLeeEnhanced<double>(
+    deconvolvedWaveform, waveLessCoherent, noiseVar, sx, sy, a, epsilon);
+}
+
+void sigproc_tools::AdaptiveWiener::filterLeeEnhanced(
+  icarussigproc::Array2D<short>& deconvolvedWaveform,
+  const icarussigproc::Array2DView<const short> waveLessCoherent,
+  const float noiseVar,
+  const unsigned int sx,
+  const unsigned int sy,
+  const float a,
+  const float epsilon) const
+{
+  filterLeeEnhanced<short>(
+    deconvolvedWaveform, waveLessCoherent, noiseVar, sx, sy, a, epsilon);
+}
+
+void sigproc_tools::AdaptiveWiener::filterLeeEnhanced(
+  icarussigproc::Array2D<float>& deconvolvedWaveform,
+  const icarussigproc::Array2DView<const float> waveLessCoherent,
+  const float noiseVar,
+  const unsigned int sx,
+  const unsigned int sy,
+  const float a,
+  const float epsilon) const
+{
+  filterLeeEnhanced<float>(
+    deconvolvedWaveform, waveLessCoherent, noiseVar, sx, sy, a, epsilon);
+}
+
+void sigproc_tools::AdaptiveWiener::filterLeeEnhanced(
+  icarussigproc::Array2D<double>& deconvolvedWaveform,
+  const icarussigproc::Array2DView<const double> waveLessCoherent,
+  const float noiseVar,
+  const unsigned int sx,
+  const unsigned int sy,
+  const float a,
+  const float epsilon) const
 {
   filterLeeEnhanced<double>(
-    deconvolvedWaveform, waveLessCoherent, sx, sy, noiseVar, a, epsilon);
+    deconvolvedWaveform, waveLessCoherent, noiseVar, sx, sy, a, epsilon);
 }
 
-template <typename T>
+template <typename T, typename OutArray, typename InArray>
 void sigproc_tools::AdaptiveWiener::filterLeeEnhanced(
-  std::vector<std::vector<T>>& deconvolvedWaveform,
-  const std::vector<std::vector<T>>& waveLessCoherent,
+  OutArray& deconvolvedWaveform,
+  const InArray& waveLessCoherent,
   const float noiseVar,
   const unsigned int sx,
   const unsigned int sy,
   const float a,
-  const float epsilon)
+  const float epsilon) const
 {
-  size_t numChannels = waveLessCoherent.size();
-  size_t nTicks = waveLessCoherent.at(0).size();
+  size_t numChannels = icarussigproc::numRows(waveLessCoherent);
+  size_t nTicks = icarussigproc::numCols(waveLessCoherent);
+  size_t numSamples = numChannels * nTicks;
+  SIGPROC_PHASE("AdaptiveWiener::filterLeeEnhanced", numSamples,
+    2 * numSamples * sizeof(T));
   int xHalfWindowSize(sx / 2);
   int yHalfWindowSize(sy / 2);
 
-  deconvolvedWaveform.resize(numChannels);
-  for (size_t i=0; i<numChannels; ++i) {
-    deconvolvedWaveform[i].resize(nTicks);
-  }
+  icarussigproc::resize2D(deconvolvedWaveform, numChannels, nTicks);
 
-  for (size_t i=0; i<numChannels; ++i) {
-    for (size_t j=0; j<nTicks; ++j) {
-      // For each center pixel, apply a adaptive local wiener filter.
-      int lbx = i - (int) xHalfWindowSize;
-      int ubx = i + (int) xHalfWindowSize;
-      int lby = j - (int) yHalfWindowSize;
-      int uby = j + (int) yHalfWindowSize;
-      size_t lowerBoundx = std::max(lbx, 0);
-      size_t upperBoundx = std::min(ubx, (int) numChannels);
-      size_t lowerBoundy = std::max(lby, 0);
-      size_t upperBoundy = std::min(uby, (int) nTicks);
-      std::vector<T> x;
-      x.reserve(sx * sy);
-      std::vector<T> xsq;
-      xsq.reserve(sx * sy);
-      std::vector<float> weight;
-      weight.reserve(sx * sy);
-      for (size_t ix=lowerBoundx; ix<upperBoundx; ++ix) {
-        for (size_t iy=lowerBoundy; iy<upperBoundy; ++iy) {
-          float eps = std::pow(epsilon * std::sqrt(noiseVar), 2);
+  float eps = std::pow(epsilon * std::sqrt(noiseVar), 2);
+
+  auto processTile = [&](size_t begin, size_t end, unsigned int) {
+    SIGPROC_TRACE("AdaptiveWiener::filterLeeEnhanced tile", "firstChannel", begin);
+    std::vector<float> weight(sx * sy);
+    forEachPixel(numChannels, nTicks, begin, end, xHalfWindowSize,
+      yHalfWindowSize, [&](size_t i, size_t j, const auto& window) {
+        // For each center pixel, apply a adaptive local wiener filter.
+        size_t count = 0;
+        double weightSum = 0.;
+        window.forEach(i, j, [&](size_t ix, size_t iy) {
           float fsq = std::pow(waveLessCoherent[i][j] - waveLessCoherent[ix][iy], 2.0);
           float w = 1.0 / (1.0 + a * std::max(eps, fsq));
-          x.push_back(waveLessCoherent[ix][iy]);
-          xsq.push_back(waveLessCoherent[ix][iy] * waveLessCoherent[ix][iy]);
-          weight.push_back(w);
+          weight[count++] = w;
+          weightSum += w;
+        });
+        float normWeight = weightSum;
+        double sum = 0.;
+        double sumSq = 0.;
+        size_t k = 0;
+        window.forEach(i, j, [&](size_t ix, size_t iy) {
+          float w = weight[k++] / normWeight;
+          T value = waveLessCoherent[ix][iy];
+          sum += value * w;
+          sumSq += T(value * value) * w;
+        });
+        T localMean = sum / count;
+        T localSquare = sumSq / count;
+        T localVar = localSquare - localMean * localMean;
+        if (noiseVar > localVar) {
+          deconvolvedWaveform[i][j] = localMean;
+        } else {
+          deconvolvedWaveform[i][j] = localMean + (1 - noiseVar / localVar) *
+            (waveLessCoherent[i][j] - localMean);
         }
-      }
-      float normWeight = std::accumulate(weight.begin(), weight.end(), 0.0);
-      for (auto& w : weight) {
-        w = w / normWeight;
-      }
-      T localMean = std::inner_product(
-        x.begin(), x.end(), weight.begin(), 0.0) / x.size();
-      T localSquare = std::inner_product(
-        xsq.begin(), xsq.end(), weight.begin(), 0.0) / x.size();
-      T localVar = localSquare - localMean * localMean;
-      if (noiseVar > localVar) {
-        deconvolvedWaveform[i][j] = localMean;
-      } else {
-        deconvolvedWaveform[i][j] = localMean + (1 - noiseVar / localVar) *
-          (waveLessCoherent[i][j] - localMean);
-      }
-    }
-  }
+      });
+  };
+  icarussigproc::parallelFor(numChannels, kTileRows, processTile, fNumThreads);
   return;
 }
 
@@ -411,7 +634,7 @@ void sigproc_tools::AdaptiveWiener::adaptiveROIWiener(
   const unsigned int sx,
   const unsigned int sy,
   const float a,
-  const float epsilon)
+  const float epsilon) const
 {
   adaptiveROIWiener<short>(
     deconvolvedWaveform, waveLessCoherent, selectVals,
@@ -426,7 +649,7 @@ void sigproc_tools::AdaptiveWiener::adaptiveROIWiener(
   const unsigned int sx,
   const unsigned int sy,
   const float a,
-  const float epsilon)
+  const float epsilon) const
 {
   adaptiveROIWiener<float>(
     deconvolvedWaveform, waveLessCoherent, selectVals,
@@ -441,81 +664,121 @@ void sigproc_tools::AdaptiveWiener::adaptiveROIWiener(
   const unsigned int sx,
   const unsigned int sy,
   const float a,
-  const float epsilon)
+  const float epsilon) const
 {
   adaptiveROIWiener<double>(
     deconvolvedWaveform, waveLessCoherent, selectVals,
     noiseVar, sx, sy, a, epsilon);
 }
 
+void sigproc_tools::AdaptiveWiener::adaptiveROIWiener(
+  icarussigproc::Array2D<short>& deconvolvedWaveform,
+  const icarussigproc::Array2DView<const short> waveLessCoherent,
+  const icarussigproc::Array2DView<const bool> selectVals,
+  const float noiseVar,
+  const unsigned int sx,
+  const unsigned int sy,
+  const float a,
+  const float epsilon) const
+{
+  adaptiveROIWiener<short>(
+    deconvolvedWaveform, waveLessCoherent, selectVals,
+    noiseVar, sx, sy, a, epsilon);
+}
 
-template <typename T>
 void sigproc_tools::AdaptiveWiener::adaptiveROIWiener(
-  std::vector<std::vector<T>>& deconvolvedWaveform,
-  const std::vector<std::vector<T>>& waveLessCoherent,
-  const std::vector<std::vector<bool>>& selectVals,
+  icarussigproc::Array2D<float>& deconvolvedWaveform,
+  const icarussigproc::Array2DView<const float> waveLessCoherent,
+  const icarussigproc::Array2DView<const bool> selectVals,
   const float noiseVar,
   const unsigned int sx,
   const unsigned int sy,
   const float a,
-  const float epsilon)
+  const float epsilon) const
 {
-  size_t numChannels = waveLessCoherent.size();
-  size_t nTicks = waveLessCoherent.at(0).size();
+  adaptiveROIWiener<float>(
+    deconvolvedWaveform, waveLessCoherent, selectVals,
+    noiseVar, sx, sy, a, epsilon);
+}
+
+void sigproc_tools::AdaptiveWiener::adaptiveROIWiener(
+  icarussigproc::Array2D<double>& deconvolvedWaveform,
+  const icarussigproc::Array2DView<const double> waveLessCoherent,
+  const icarussigproc::Array2DView<const bool> selectVals,
+  const float noiseVar,
+  const unsigned int sx,
+  const unsigned int sy,
+  const float a,
+  const float epsilon) const
+{
+  adaptiveROIWiener<double>(
+    deconvolvedWaveform, waveLessCoherent, selectVals,
+    noiseVar, sx, sy, a, epsilon);
+}
+
+
+template <typename T, typename OutArray, typename InArray, typename MaskArray>
+void sigproc_tools::AdaptiveWiener::adaptiveROIWiener(
+  OutArray& deconvolvedWaveform,
+  const InArray& waveLessCoherent,
+  const MaskArray& selectVals,
+  const float noiseVar,
+  const unsigned int sx,
+  const unsigned int sy,
+  const float a,
+  const float epsilon) const
+{
+  size_t numChannels = icarussigproc::numRows(waveLessCoherent);
+  size_t nTicks = icarussigproc::numCols(waveLessCoherent);
+  size_t numSamples = numChannels * nTicks;
+  SIGPROC_PHASE("AdaptiveWiener::adaptiveROIWiener", numSamples,
+    2 * numSamples * sizeof(T) +
+    numSamples * sizeof(bool));
   int xHalfWindowSize(sx / 2);
   int yHalfWindowSize(sy / 2);
 
-  deconvolvedWaveform.resize(numChannels);
-  for (size_t i=0; i<numChannels; ++i) {
-    deconvolvedWaveform[i].resize(nTicks);
-  }
+  icarussigproc::resize2D(deconvolvedWaveform, numChannels, nTicks);
 
-  for (size_t i=0; i<numChannels; ++i) {
-    for (size_t j=0; j<nTicks; ++j) {
-      // For each center pixel, apply a adaptive local wiener filter.
-      int lbx = i - (int) xHalfWindowSize;
-      int ubx = i + (int) xHalfWindowSize;
-      int lby = j - (int) yHalfWindowSize;
-      int uby = j + (int) yHalfWindowSize;
-      size_t lowerBoundx = std::max(lbx, 0);
-      size_t upperBoundx = std::min(ubx, (int) numChannels);
-      size_t lowerBoundy = std::max(lby, 0);
-      size_t upperBoundy = std::min(uby, (int) nTicks);
-      std::vector<T> x;
-      x.reserve(sx * sy);
-      std::vector<T> xsq;
-      xsq.reserve(sx * sy);
-      std::vector<float> weight;
-      weight.reserve(sx * sy);
-      for (size_t ix=lowerBoundx; ix<upperBoundx; ++ix) {
-        for (size_t iy=lowerBoundy; iy<upperBoundy; ++iy) {
-          float eps = std::pow(epsilon * std::sqrt(noiseVar), 2);
+  float eps = std::pow(epsilon * std::sqrt(noiseVar), 2);
+
+  auto processTile = [&](size_t begin, size_t end, unsigned int) {
+    SIGPROC_TRACE("AdaptiveWiener::adaptiveROIWiener tile", "firstChannel", begin);
+    std::vector<float> weight(sx * sy);
+    forEachPixel(numChannels, nTicks, begin, end, xHalfWindowSize,
+      yHalfWindowSize, [&](size_t i, size_t j, const auto& window) {
+        // For each center pixel, apply a adaptive local wiener filter.
+        size_t count = 0;
+        double weightSum = 0.;
+        window.forEach(i, j, [&](size_t ix, size_t iy) {
           float fsq = std::pow(waveLessCoherent[i][j] - waveLessCoherent[ix][iy], 2.0);
           float w = 1.0 / (1.0 + a * std::max(eps, fsq));
-          x.push_back(waveLessCoherent[ix][iy]);
-          xsq.push_back(waveLessCoherent[ix][iy] * waveLessCoherent[ix][iy]);
-          weight.push_back(w);
+          weight[count++] = w;
+          weightSum += w;
+        });
+        float normWeight = weightSum;
+        double sum = 0.;
+        double sumSq = 0.;
+        size_t k = 0;
+        window.forEach(i, j, [&](size_t ix, size_t iy) {
+          float w = weight[k++] / normWeight;
+          T value = waveLessCoherent[ix][iy];
+          sum += value * w;
+          sumSq += T(value * value) * w;
+        });
+        T localMean = sum / count;
+        T localSquare = sumSq / count;
+        T localVar = localSquare - localMean * localMean;
+        if (noiseVar > localVar) {
+          deconvolvedWaveform[i][j] = localMean;
+        } else if (selectVals[i][j]) {
+          deconvolvedWaveform[i][j] = waveLessCoherent[i][j];
+        } else {
+          deconvolvedWaveform[i][j] = localMean + (1 - noiseVar / localVar) *
+          (waveLessCoherent[i][j] - localMean);
         }
-      }
-      float normWeight = std::accumulate(weight.begin(), weight.end(), 0.0);
-      for (auto& w : weight) {
-        w = w / normWeight;
-      }
-      T localMean = std::inner_product(
-        x.begin(), x.end(), weight.begin(), 0.0) / x.size();
-      T localSquare = std::inner_product(
-        xsq.begin(), xsq.end(), weight.begin(), 0.0) / x.size();
-      T localVar = localSquare - localMean * localMean;
-      if (noiseVar > localVar) {
-        deconvolvedWaveform[i][j] = localMean;
-      } else if (selectVals[i][j]) {
-        deconvolvedWaveform[i][j] = waveLessCoherent[i][j];
-      } else {
-        deconvolvedWaveform[i][j] = localMean + (1 - noiseVar / localVar) *
-        (waveLessCoherent[i][j] - localMean);
-      }
-    }
-  }
+      });
+  };
+  icarussigproc::parallelFor(numChannels, kTileRows, processTile, fNumThreads);
   return;
 }
 
@@ -527,7 +790,7 @@ void sigproc_tools::AdaptiveWiener::sigmaFilter(
   const unsigned int sx,
   const unsigned int sy,
   const unsigned int K,
-  const float sigmaFactor)
+  const float sigmaFactor) const
 {
   sigmaFilter<short>(
     deconvolvedWaveform, waveLessCoherent, noiseVar, sx, sy, K, sigmaFactor);
@@ -540,7 +803,7 @@ void sigproc_tools::AdaptiveWiener::sigmaFilter(
   const unsigned int sx,
   const unsigned int sy,
   const unsigned int K,
-  const float sigmaFactor)
+  const float sigmaFactor) const
 {
   sigmaFilter<float>(
     deconvolvedWaveform, waveLessCoherent, noiseVar, sx, sy, K, sigmaFactor);
@@ -553,60 +816,94 @@ void sigproc_tools::AdaptiveWiener::sigmaFilter(
   const unsigned int sx,
   const unsigned int sy,
   const unsigned int K,
-  const float sigmaFactor)
+  const float sigmaFactor) const
+{
+  sigmaFilter<double>(
+    deconvolvedWaveform, waveLessCoherent, noiseVar, sx, sy, K, sigmaFactor);
+}
+
+void sigproc_tools::AdaptiveWiener::sigmaFilter(
+  icarussigproc::Array2D<short>& deconvolvedWaveform,
+  const icarussigproc::Array2DView<const short> waveLessCoherent,
+  const float noiseVar,
+  const unsigned int sx,
+  const unsigned int sy,
+  const unsigned int K,
+  const float sigmaFactor) const
+{
+  sigmaFilter<short>(
+    deconvolvedWaveform, waveLessCoherent, noiseVar, sx, sy, K, sigmaFactor);
+}
+
+void sigproc_tools::AdaptiveWiener::sigmaFilter(
+  icarussigproc::Array2D<float>& deconvolvedWaveform,
+  const icarussigproc::Array2DView<const float> waveLessCoherent,
+  const float noiseVar,
+  const unsigned int sx,
+  const unsigned int sy,
+  const unsigned int K,
+  const float sigmaFactor) const
+{
+  sigmaFilter<float>(
+    deconvolvedWaveform, waveLessCoherent, noiseVar, sx, sy, K, sigmaFactor);
+}
+
+void sigproc_tools::AdaptiveWiener::sigmaFilter(
+  icarussigproc::Array2D<double>& deconvolvedWaveform,
+  const icarussigproc::Array2DView<const double> waveLessCoherent,
+  const float noiseVar,
+  const unsigned int sx,
+  const unsigned int sy,
+  const unsigned int K,
+  const float sigmaFactor) const
 {
   sigmaFilter<double>(
     deconvolvedWaveform, waveLessCoherent, noiseVar, sx, sy, K, sigmaFactor);
 }
 
 
-template <typename T>
+template <typename T, typename OutArray, typename InArray>
 void sigproc_tools::AdaptiveWiener::sigmaFilter(
-  std::vector<std::vector<T>>& deconvolvedWaveform,
-  const std::vector<std::vector<T>>& waveLessCoherent,
+  OutArray& deconvolvedWaveform,
+  const InArray& waveLessCoherent,
   const float noiseVar,
   const unsigned int sx,
   const unsigned int sy,
   const unsigned int K,
-  const float sigmaFactor)
+  const float sigmaFactor) const
 {
-  size_t numChannels = waveLessCoherent.size();
-  size_t nTicks = waveLessCoherent.at(0).size();
+  size_t numChannels = icarussigproc::numRows(waveLessCoherent);
+  size_t nTicks = icarussigproc::numCols(waveLessCoherent);
+  size_t numSamples = numChannels * nTicks;
+  SIGPROC_PHASE("AdaptiveWiener::sigmaFilter", numSamples,
+    2 * numSamples * sizeof(T));
   int xHalfWindowSize(sx / 2);
   int yHalfWindowSize(sy / 2);
 
-  deconvolvedWaveform.resize(numChannels);
-  for (size_t i=0; i<numChannels; ++i) {
-    deconvolvedWaveform[i].resize(nTicks);
-  }
+  icarussigproc::resize2D(deconvolvedWaveform, numChannels, nTicks);
 
-  for (size_t i=0; i<numChannels; ++i) {
-    for (size_t j=0; j<nTicks; ++j) {
-      // For each center pixel, apply a adaptive local wiener filter.
-      int lbx = i - (int) xHalfWindowSize;
-      int ubx = i + (int) xHalfWindowSize;
-      int lby = j - (int) yHalfWindowSize;
-      int uby = j + (int) yHalfWindowSize;
-      size_t lowerBoundx = std::max(lbx, 0);
-      size_t upperBoundx = std::min(ubx, (int) numChannels);
-      size_t lowerBoundy = std::max(lby, 0);
-      size_t upperBoundy = std::min(uby, (int) nTicks);
-      std::vector<T> x;
-      x.reserve(sx * sy);
-      for (size_t ix=lowerBoundx; ix<upperBoundx; ++ix) {
-        for (size_t iy=lowerBoundy; iy<upperBoundy; ++iy) {
+  auto processTile = [&](size_t begin, size_t end, unsigned int) {
+    SIGPROC_TRACE("AdaptiveWiener::sigmaFilter tile", "firstChannel", begin);
+    forEachPixel(numChannels, nTicks, begin, end, xHalfWindowSize,
+      yHalfWindowSize, [&](size_t i, size_t j, const auto& window) {
+        // For each center pixel, apply a adaptive local wiener filter.
+        double sum = 0.;
+        size_t count = 0;
+        window.forEach(i, j, [&](size_t ix, size_t iy) {
           if (std::abs(waveLessCoherent[ix][iy]) < sigmaFactor * noiseVar) {
-            x.push_back(waveLessCoherent[ix][iy]);
+            T value = waveLessCoherent[ix][iy];
+            sum += value;
+            ++count;
           }
+        });
+        T localMean = sum / count;
+        if (count > K) {
+          deconvolvedWaveform[i][j] = localMean;
+        } else {
+          deconvolvedWaveform[i][j] = waveLessCoherent[i][j];
         }
-      }
-      T localMean = std::accumulate(x.begin(), x.end(), 0.0) / x.size() ;
-      if (x.size() > K) {
-        deconvolvedWaveform[i][j] = localMean;
-      } else {
-        deconvolvedWaveform[i][j] = waveLessCoherent[i][j];
-      }
-    }
-  }
+      });
+  };
+  icarussigproc::parallelFor(numChannels, kTileRows, processTile, fNumThreads);
   return;
 }
@@ -23,6 +23,7 @@
 #include <cmath>
 #include <functional>
 #include "MiscUtils.h"
+#include "Array2D.h"
 
 namespace sigproc_tools {
 
@@ -30,6 +31,8 @@ namespace sigproc_tools {
      \class Deconvolve
      User defined class Deconvolve ... these comments are used to generate
      doxygen documentation!
+     Stateless apart from the thread count set before use; the filters are
+     const and reentrant.
   */
   class AdaptiveWiener{
 
@@ -44,7 +47,7 @@ namespace sigproc_tools {
         const float,
         const unsigned int,
         const unsigned int
-      );
+      ) const;
 
       void filterLee(
         std::vector<std::vector<float>>&,
@@ -52,7 +55,7 @@ namespace sigproc_tools {
         const float,
         const unsigned int,
         const unsigned int
-      );
+      ) const;
 
       void filterLee(
         std::vector<std::vector<double>>&,
@@ -60,7 +63,31 @@ namespace sigproc_tools {
         const float,
         const unsigned int,
         const unsigned int
-      );
+      ) const;
+
+      void filterLee(
+        icarussigproc::Array2D<short>&,
+        const icarussigproc::Array2DView<const short>,
+        const float,
+        const unsigned int,
+        const unsigned int
+      ) const;
+
+      void filterLee(
+        icarussigproc::Array2D<float>&,
+        const icarussigproc::Array2DView<const float>,
+        const float,
+        const unsigned int,
+        const unsigned int
+      ) const;
+
+      void filterLee(
+        icarussigproc::Array2D<double>&,
+        const icarussigproc::Array2DView<const double>,
+        const float,
+        const unsigned int,
+        const unsigned int
+      ) const;
 
 
       void MMWF(
@@ -69,7 +96,7 @@ namespace sigproc_tools {
         const float,
         const unsigned int,
         const unsigned int
-      );
+      ) const;
 
       void MMWF(
         std::vector<std::vector<float>>&,
@@ -77,7 +104,7 @@ namespace sigproc_tools {
         const float,
         const unsigned int,
         const unsigned int
-      );
+      ) const;
 
       void MMWF(
         std::vector<std::vector<double>>&,
@@ -85,7 +112,31 @@ namespace sigproc_tools {
         const float,
         const unsigned int,
         const unsigned int
-      );
+      ) const;
+
+      void MMWF(
+        icarussigproc::Array2D<short>&,
+        const icarussigproc::Array2DView<const short>,
+        const float,
+        const unsigned int,
+        const unsigned int
+      ) const;
+
+      void MMWF(
+        icarussigproc::Array2D<float>&,
+        const icarussigproc::Array2DView<const float>,
+        const float,
+        const unsigned int,
+        const unsigned int
+      ) const;
+
+      void MMWF(
+        icarussigproc::Array2D<double>&,
+        const icarussigproc::Array2DView<const double>,
+        const float,
+        const unsigned int,
+        const unsigned int
+      ) const;
 
 
       void MMWFStar(
@@ -93,21 +144,42 @@ namespace sigproc_tools {
         const std::vector<std::vector<short>>&,
         const unsigned int,
         const unsigned int
-      );
+      ) const;
 
       void MMWFStar(
         std::vector<std::vector<float>>&,
         const std::vector<std::vector<float>>&,
         const unsigned int,
         const unsigned int
-      );
+      ) const;
 
       void MMWFStar(
         std::vector<std::vector<double>>&,
         const std::vector<std::vector<double>>&,
         const unsigned int,
         const unsigned int
-      );
+      ) const;
+
+      void MMWFStar(
+        icarussigproc::Array2D<short>&,
+        const icarussigproc::Array2DView<const short>,
+        const unsigned int,
+        const unsigned int
+      ) const;
+
+      void MMWFStar(
+        icarussigproc::Array2D<float>&,
+        const icarussigproc::Array2DView<const float>,
+        const unsigned int,
+        const unsigned int
+      ) const;
+
+      void MMWFStar(
+        icarussigproc::Array2D<double>&,
+        const icarussigproc::Array2DView<const double>,
+        const unsigned int,
+        const unsigned int
+      ) const;
 
 
       void filterLeeEnhanced(
@@ -118,7 +190,7 @@ namespace sigproc_tools {
         const unsigned int,
         const float,
         const float
-      );
+      ) const;
 
       void filterLeeEnhanced(
         std::vector<std::vector<float>>&,
@@ -128,7 +200,7 @@ namespace sigproc_tools {
         const unsigned int,
         const float,
         const float
-      );
+      ) const;
 
       void filterLeeEnhanced(
         std::vector<std::vector<double>>&,
@@ -138,7 +210,37 @@ namespace sigproc_tools {
         const unsigned int,
         const float,
         const float
-      );
+      ) const;
+
+      void filterLeeEnhanced(
+        icarussigproc::Array2D<short>&,
+        const icarussigproc::Array2DView<const short>,
+        const float,
+        const unsigned int,
+        const unsigned int,
+        const float,
+        const float
+      ) const;
+
+      void filterLeeEnhanced(
+        icarussigproc::Array2D<float>&,
+        const icarussigproc::Array2DView<const float>,
+        const float,
+        const unsigned int,
+        const unsigned int,
+        const float,
+        const float
+      ) const;
+
+      void filterLeeEnhanced(
+        icarussigproc::Array2D<double>&,
+        const icarussigproc::Array2DView<const double>,
+        const float,
+        const unsigned int,
+        const unsigned int,
+        const float,
+        const float
+      ) const;
 
 
       void adaptiveROIWiener(
@@ -150,7 +252,7 @@ namespace sigproc_tools {
         const unsigned int,
         const float,
         const float
-      );
+      ) const;
 
       void adaptiveROIWiener(
         std::vector<std::vector<float>>&,
@@ -161,7 +263,7 @@ namespace sigproc_tools {
         const unsigned int,
         const float,
         const float
-      );
+      ) const;
 
       void adaptiveROIWiener(
         std::vector<std::vector<double>>&,
@@ -172,7 +274,40 @@ namespace sigproc_tools {
         const unsigned int,
         const float,
         const float
-      );
+      ) const;
+
+      void adaptiveROIWiener(
+        icarussigproc::Array2D<short>&,
+        const icarussigproc::Array2DView<const short>,
+        const icarussigproc::Array2DView<const bool>,
+        const float,
+        const unsigned int,
+        const unsigned int,
+        const float,
+        const float
+      ) const;
+
+      void adaptiveROIWiener(
+        icarussigproc::Array2D<float>&,
+        const icarussigproc::Array2DView<const float>,
+        const icarussigproc::Array2DView<const bool>,
+        const float,
+        const unsigned int,
+        const unsigned int,
+        const float,
+        const float
+      ) const;
+
+      void adaptiveROIWiener(
+        icarussigproc::Array2D<double>&,
+        const icarussigproc::Array2DView<const double>,
+        const icarussigproc::Array2DView<const bool>,
+        const float,
+        const unsigned int,
+        const unsigned int,
+        const float,
+        const float
+      ) const;
 
 
       void sigmaFilter(
@@ -182,7 +317,7 @@ namespace sigproc_tools {
         const unsigned int,
         const unsigned int,
         const unsigned int,
-        const float);
+        const float) const;
 
       void sigmaFilter(
         std::vector<std::vector<float>>&,
@@ -191,7 +326,7 @@ namespace sigproc_tools {
         const unsigned int,
         const unsigned int,
         const unsigned int,
-        const float);
+        const float) const;
 
       void sigmaFilter(
         std::vector<std::vector<double>>&,
@@ -200,66 +335,100 @@ namespace sigproc_tools {
         const unsigned int,
         const unsigned int,
         const unsigned int,
-        const float);
+        const float) const;
+
+      void sigmaFilter(
+        icarussigproc::Array2D<short>&,
+        const icarussigproc::Array2DView<const short>,
+        const float,
+        const unsigned int,
+        const unsigned int,
+        const unsigned int,
+        const float) const;
+
+      void sigmaFilter(
+        icarussigproc::Array2D<float>&,
+        const icarussigproc::Array2DView<const float>,
+        const float,
+        const unsigned int,
+        const unsigned int,
+        const unsigned int,
+        const float) const;
+
+      void sigmaFilter(
+        icarussigproc::Array2D<double>&,
+        const icarussigproc::Array2DView<const double>,
+        const float,
+        const unsigned int,
+        const unsigned int,
+        const unsigned int,
+        const float) const;
+
+      /// Threads of the parallel loops over channels, 0 for the
+      /// concurrency of the library thread pool
+      void setNumThreads(const unsigned int numThreads) { fNumThreads = numThreads; }
 
       /// Default destructor
       ~AdaptiveWiener(){}
 
     private:
 
-      template <typename T>
+      template <typename T, typename OutArray, typename InArray>
       void filterLee(
-        std::vector<std::vector<T> >& deconvolvedWaveform,
-        const std::vector<std::vector<T> >& waveLessCoherent,
+        OutArray& deconvolvedWaveform,
+        const InArray& waveLessCoherent,
         const float noiseVar,
         const unsigned int sx=7,
-        const unsigned int sy=7);
+        const unsigned int sy=7) const;
 
-      template <typename T>
+      template <typename T, typename OutArray, typename InArray>
       void MMWF(
-        std::vector<std::vector<T> >& deconvolvedWaveform,
-        const std::vector<std::vector<T> >& waveLessCoherent,
+        OutArray& deconvolvedWaveform,
+        const InArray& waveLessCoherent,
         const float noiseVar,
         const unsigned int sx=7,
-        const unsigned int sy=7);
+        const unsigned int sy=7) const;
 
-      template <typename T>
+      template <typename T, typename OutArray, typename InArray>
       void MMWFStar(
-        std::vector<std::vector<T> >& deconvolvedWaveform,
-        const std::vector<std::vector<T> >& waveLessCoherent,
+        OutArray& deconvolvedWaveform,
+        const InArray& waveLessCoherent,
         const unsigned int sx=7,
-        const unsigned int sy=7);
+        const unsigned int sy=7) const;
 
-      template <typename T>
+      template <typename T, typename OutArray, typename InArray>
       void filterLeeEnhanced(
-        std::vector<std::vector<T> >& deconvolvedWaveform,
-        const std::vector<std::vector<T> >& waveLessCoherent,
+        OutArray& deconvolvedWaveform,
+        const InArray& waveLessCoherent,
         const float noiseVar,
         const unsigned int sx=3,
         const unsigned int sy=3,
         const float a=1,
-        const float epsilon=2.5);
+        const float epsilon=2.5) const;
 
-      template <typename T>
+      template <typename T, typename OutArray, typename InArray,
+        typename MaskArray>
       void adaptiveROIWiener(
-        std::vector<std::vector<T>>& deconvolvedWaveform,
-        const std::vector<std::vector<T>>& waveLessCoherent,
-        const std::vector<std::vector<bool>>& selectVals,
+        OutArray& deconvolvedWaveform,
+        const InArray& waveLessCoherent,
+        const MaskArray& selectVals,
         const float noiseVar,
         const unsigned int sx=3,
         const unsigned int sy=3,
         const float a=1,
-        const float epsilon=2.5);
+        const float epsilon=2.5) const;
 
-      template <typename T>
+      template <typename T, typename OutArray, typename InArray>
       void sigmaFilter(
-        std::vector<std::vector<T>>& deconvolvedWaveform,
-        const std::vector<std::vector<T> >& waveLessCoherent,
+        OutArray& deconvolvedWaveform,
+        const InArray& waveLessCoherent,
         const float noiseVar,
         const unsigned int sx=7,
         const unsigned int sy=7,
         const unsigned int K=5,
-        const float sigmaFactor=2.0);
+        const float sigmaFactor=2.0) const;
+
+      unsigned int fNumThreads = 0;
   };
 }
 
@@ -0,0 +1,310 @@
+/**
+ * \file Array2D.h
+ *
+ * \ingroup icarussigproc
+ *
+ * \brief Contiguous, aligned 2D arrays of channels x ticks
+ *
+ */
+
+/** \addtogroup icarussigproc
+
+    @{*/
+#ifndef __SIGPROC_TOOLS_ARRAY2D_H__
+#define __SIGPROC_TOOLS_ARRAY2D_H__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include "Span.h"
+
+namespace icarussigproc {
+
+  /// Alignment of Array2D storage and rows, in bytes (one cache line)
+  constexpr size_t kArray2DAlignment = 64;
+
+  /**
+     \class Array2DView
+     Non-owning view of numRows rows of numCols elements, consecutive rows
+     being stride elements apart. Wraps Array2D storage or external memory;
+     a[i][j] indexes it like the nested vectors used elsewhere.
+  */
+  template <typename T>
+  class Array2DView{
+
+    public:
+
+      using value_type = typename std::remove_cv<T>::type;
+
+      Array2DView() : fData(nullptr), fNumRows(0), fNumCols(0), fStride(0) {}
+
+      Array2DView(T* data, const size_t numRows, const size_t numCols,
+        const size_t stride) :
+        fData(data), fNumRows(numRows), fNumCols(numCols), fStride(stride) {}
+
+      /// Densely packed rows
+      Array2DView(T* data, const size_t numRows, const size_t numCols) :
+        Array2DView(data, numRows, numCols, numCols) {}
+
+      template <typename U, typename = typename std::enable_if<
+        std::is_convertible<U*, T*>::value>::type>
+      Array2DView(const Array2DView<U>& other) :
+        fData(other.data()), fNumRows(other.numRows()),
+        fNumCols(other.numCols()), fStride(other.stride()) {}
+
+      T*     data()    const { return fData; }
+      size_t numRows() const { return fNumRows; }
+      size_t numCols() const { return fNumCols; }
+      size_t stride()  const { return fStride; }
+      bool   empty()   const { return fNumRows == 0 || fNumCols == 0; }
+
+      T* operator[](const size_t row) const { return fData + row * fStride; }
+
+      Span<T> row(const size_t row) const
+      {
+        return Span<T>(fData + row * fStride, fNumCols);
+      }
+
+      /// Rectangular tile [rowBegin, rowBegin+rows) x [colBegin, colBegin+cols)
+      Array2DView subView(const size_t rowBegin, const size_t rows,
+        const size_t colBegin, const size_t cols) const
+      {
+        return Array2DView(fData + rowBegin * fStride + colBegin, rows, cols,
+          fStride);
+      }
+
+    private:
+
+      T*     fData;
+      size_t fNumRows;
+      size_t fNumCols;
+      size_t fStride;
+  };
+
+  /**
+     \class Array2D
+     Owning 2D array in one 64 byte aligned block, rows padded so that each
+     starts on a cache line. Elements must be trivially copyable (numbers,
+     bool, complex); unlike std::vector<bool>, Array2D<bool> stores one byte
+     per element. Converts implicitly to an Array2DView.
+  */
+  template <typename T>
+  class Array2D{
+
+    static_assert(std::is_trivially_copyable<T>::value,
+      "Array2D elements must be trivially copyable");
+
+    public:
+
+      using value_type = T;
+
+      Array2D() : fNumRows(0), fNumCols(0), fStride(0), fCapacity(0) {}
+
+      Array2D(const size_t numRows, const size_t numCols,
+        const T& value = T()) : Array2D()
+      {
+        assign(numRows, numCols, value);
+      }
+
+      Array2D(const Array2D& other) : Array2D()
+      {
+        *this = other;
+      }
+
+      Array2D(Array2D&& other) noexcept : Array2D()
+      {
+        swap(other);
+      }
+
+      Array2D& operator=(const Array2D& other)
+      {
+        if (this == &other) return *this;
+        allocate(other.fNumRows, other.fNumCols);
+        if (fNumRows * fStride > 0) {
+          std::memcpy(static_cast<void*>(fData.get()), other.fData.get(),
+            fNumRows * fStride * sizeof(T));
+        }
+        return *this;
+      }
+
+      Array2D& operator=(Array2D&& other) noexcept
+      {
+        swap(other);
+        return *this;
+      }
+
+      void swap(Array2D& other) noexcept
+      {
+        std::swap(fData, other.fData);
+        std::swap(fNumRows, other.fNumRows);
+        std::swap(fNumCols, other.fNumCols);
+        std::swap(fStride, other.fStride);
+        std::swap(fCapacity, other.fCapacity);
+      }
+
+      /// Resize to numRows x numCols. The contents are kept when the shape
+      /// does not change, otherwise all elements are value initialized.
+      void resize(const size_t numRows, const size_t numCols)
+      {
+        if (numRows == fNumRows && numCols == fNumCols) return;
+        assign(numRows, numCols, T());
+      }
+
+      /// Resize and set all elements to value
+      void assign(const size_t numRows, const size_t numCols, const T& value)
+      {
+        allocate(numRows, numCols);
+        std::uninitialized_fill_n(fData.get(), fNumRows * fStride, value);
+      }
+
+      T*       data()       { return fData.get(); }
+      const T* data() const { return fData.get(); }
+      size_t numRows() const { return fNumRows; }
+      size_t numCols() const { return fNumCols; }
+      size_t stride()  const { return fStride; }
+      bool   empty()   const { return fNumRows == 0 || fNumCols == 0; }
+
+      T*       operator[](const size_t row)       { return data() + row * fStride; }
+      const T* operator[](const size_t row) const { return data() + row * fStride; }
+
+      Span<T>       row(const size_t row)       { return Span<T>((*this)[row], fNumCols); }
+      Span<const T> row(const size_t row) const { return Span<const T>((*this)[row], fNumCols); }
+
+      Array2DView<T> view()
+      {
+        return Array2DView<T>(data(), fNumRows, fNumCols, fStride);
+      }
+
+      Array2DView<const T> view() const
+      {
+        return Array2DView<const T>(data(), fNumRows, fNumCols, fStride);
+      }
+
+      operator Array2DView<T>()             { return view(); }
+      operator Array2DView<const T>() const { return view(); }
+
+    private:
+
+      struct AlignedDelete {
+        void operator()(T* ptr) const
+        {
+          ::operator delete(ptr, std::align_val_t(kArray2DAlignment));
+        }
+      };
+
+      /// Sets the shape, reallocating only when the block must grow
+      void allocate(const size_t numRows, const size_t numCols)
+      {
+        const size_t rowBytes = numCols * sizeof(T);
+        const size_t paddedBytes = (rowBytes + kArray2DAlignment - 1) /
+          kArray2DAlignment * kArray2DAlignment;
+        const size_t stride = paddedBytes % sizeof(T) == 0 ?
+          paddedBytes / sizeof(T) : numCols;
+        const size_t size = numRows * stride;
+        if (size > fCapacity) {
+          fData.reset(static_cast<T*>(::operator new(size * sizeof(T),
+            std::align_val_t(kArray2DAlignment))));
+          fCapacity = size;
+        }
+        fNumRows = numRows;
+        fNumCols = numCols;
+        fStride = stride;
+      }
+
+      std::unique_ptr<T, AlignedDelete> fData;
+      size_t                            fNumRows;
+      size_t                            fNumCols;
+      size_t                            fStride;
+      size_t                            fCapacity;
+  };
+
+  /// Shape accessors shared by nested vectors, Array2D and Array2DView, so
+  /// that the algorithms can be written once for all of them
+  template <typename T>
+  size_t numRows(const std::vector<std::vector<T>>& array) { return array.size(); }
+
+  template <typename T>
+  size_t numCols(const std::vector<std::vector<T>>& array)
+  {
+    return array.empty() ? 0 : array[0].size();
+  }
+
+  template <typename T>
+  size_t numRows(const Array2D<T>& array) { return array.numRows(); }
+
+  template <typename T>
+  size_t numCols(const Array2D<T>& array) { return array.numCols(); }
+
+  template <typename T>
+  size_t numRows(const Array2DView<T>& array) { return array.numRows(); }
+
+  template <typename T>
+  size_t numCols(const Array2DView<T>& array) { return array.numCols(); }
+
+  template <typename T>
+  void resize2D(std::vector<std::vector<T>>& array, const size_t numRows,
+    const size_t numCols)
+  {
+    array.resize(numRows);
+    for (auto& row : array) row.resize(numCols);
+  }
+
+  template <typename T>
+  void resize2D(Array2D<T>& array, const size_t numRows, const size_t numCols)
+  {
+    array.resize(numRows, numCols);
+  }
+
+  /// Views cannot be resized, their shape must already match
+  template <typename T>
+  void resize2D(Array2DView<T>& array, const size_t numRows,
+    const size_t numCols)
+  {
+    if (array.numRows() != numRows || array.numCols() != numCols) {
+      throw std::invalid_argument("Array2DView: shape mismatch");
+    }
+  }
+
+  /// Copies between nested vectors and Array2D (e.g. Array2D<bool> from the
+  /// std::vector<std::vector<bool>> masks)
+  template <typename T>
+  void toArray2D(const std::vector<std::vector<T>>& input, Array2D<T>& output)
+  {
+    size_t numCols = icarussigproc::numCols(input);
+    for (const auto& row : input) {
+      if (row.size() != numCols) {
+        throw std::invalid_argument("toArray2D: rows of different lengths");
+      }
+    }
+    output.resize(input.size(), numCols);
+    for (size_t i=0; i<input.size(); ++i) {
+      std::copy(input[i].begin(), input[i].end(), output[i]);
+    }
+  }
+
+  template <typename T>
+  void toNestedVector(const Array2DView<const T> input,
+    std::vector<std::vector<T>>& output)
+  {
+    output.resize(input.numRows());
+    for (size_t i=0; i<input.numRows(); ++i) {
+      output[i].assign(input[i], input[i] + input.numCols());
+    }
+  }
+
+  template <typename T>
+  void toNestedVector(const Array2D<T>& input,
+    std::vector<std::vector<T>>& output)
+  {
+    toNestedVector(input.view(), output);
+  }
+}
+
+#endif
+/** @} */ // end of doxygen group
+
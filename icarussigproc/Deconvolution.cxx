@@ -2,6 +2,27 @@
 #define __SIGPROC_TOOLS_DECONVOLUTION_CXX__
 
 #include "Deconvolution.h"
+#include "Trace.h"
+#include "ParallelFor.h"
+
+#include <stdexcept>
+
+// Channels per task of the loops over channels
+static const size_t kBandRows = 8;
+
+// Half spectrum of one row of nTicks samples. The pointer interface of
+// Eigen::FFT serves rows of nested vectors and of Array2D alike.
+template <typename T>
+static void forwardRow(
+  Eigen::FFT<T>& fft,
+  std::vector<std::complex<T>>& freqVec,
+  const T* row,
+  const size_t nTicks)
+{
+  freqVec.resize(nTicks / 2 + 1);
+  fft.fwd(freqVec.data(), row, nTicks);
+  return;
+}
 
 // 1D Inverse Filtering. Probably we should not use it...
 
@@ -21,31 +42,33 @@ void sigproc_tools::Deconvolution::Inverse1D(
   Inverse1D<double>(outputWaveform, inputWaveform, responseFunction);
 }
 
-template <typename T>
+template <typename T, typename OutArray, typename InArray>
 void sigproc_tools::Deconvolution::Inverse1D(
-  std::vector<std::vector<T>>& outputWaveform,
-  const std::vector<std::vector<T>>& inputWaveform,
-  const std::vector<T>& responseFunction)
+  OutArray& outputWaveform,
+  const InArray& inputWaveform,
+  const ResponseVector<T>& responseFunction)
 {
-  size_t numChannels = inputWaveform.size();
-  size_t nTicks = inputWaveform.at(0).size();
-  outputWaveform.resize(numChannels);
-  for (size_t i=0; i<numChannels; ++i) {
-    outputWaveform[i].resize(nTicks);
-  }
-  for (size_t i=0; i<numChannels; ++i) {
-    Eigen::FFT<T> fft;
-    fft.SetFlag(fft.HalfSpectrum);
+  size_t numChannels = icarussigproc::numRows(inputWaveform);
+  size_t nTicks = icarussigproc::numCols(inputWaveform);
+  SIGPROC_TRACE("Deconvolution::Inverse1D", "channels", numChannels);
+  icarussigproc::resize2D(outputWaveform, numChannels, nTicks);
+
+  std::vector<std::complex<T>> responseFFT;
+  fPlanCache.getFFT<T>().fwd(responseFFT, responseFunction);
+  size_t nBins = std::min(nTicks / 2 + 1, responseFFT.size());
+  prepareLanePlanCaches();
+  auto processBand = [&](size_t begin, size_t end, unsigned int lane) {
+    Eigen::FFT<T>& fft = getLanePlanCache(lane).getFFT<T>();
     std::vector<std::complex<T>> freqVec;
-    std::vector<std::complex<T>> responseFFT;
-    fft.fwd(freqVec, inputWaveform[i]);
-    fft.fwd(responseFFT, responseFunction);
-    for (size_t j=0; j<nTicks; ++j) {
-      freqVec[j] = freqVec[j] / responseFFT[j];
+    for (size_t i=begin; i<end; ++i) {
+      forwardRow(fft, freqVec, &inputWaveform[i][0], nTicks);
+      for (size_t j=0; j<nBins; ++j) {
+        freqVec[j] = freqVec[j] / responseFFT[j];
+      }
+      fft.inv(&outputWaveform[i][0], freqVec.data(), nTicks);
     }
-    fft.inv(outputWaveform[i], freqVec);
-    fft.ClearFlag(fft.HalfSpectrum);
-  }
+  };
+  icarussigproc::parallelFor(numChannels, kBandRows, processBand, fNumThreads);
   return;
 }
 
@@ -70,42 +93,632 @@ void sigproc_tools::Deconvolution::Wiener1D(
   Wiener1D<double>(outputWaveform, inputWaveform, responseFunction, noiseVar);
 }
 
-template <typename T>
+template <typename T, typename OutArray, typename InArray>
 void sigproc_tools::Deconvolution::Wiener1D(
-  std::vector<std::vector<T>>& outputWaveform,
-  const std::vector<std::vector<T>>& inputWaveform,
-  const std::vector<T>& responseFunction,
+  OutArray& outputWaveform,
+  const InArray& inputWaveform,
+  const ResponseVector<T>& responseFunction,
   const float noiseVar)
 {
-  size_t numChannels = inputWaveform.size();
-  size_t nTicks = inputWaveform.at(0).size();
-  std::complex<T> noisePower(noiseVar, 0);
+  size_t numChannels = icarussigproc::numRows(inputWaveform);
+  size_t nTicks = icarussigproc::numCols(inputWaveform);
+  SIGPROC_TRACE("Deconvolution::Wiener1D", "channels", numChannels);
 
-  outputWaveform.resize(numChannels);
-  for (size_t i=0; i<numChannels; ++i) {
-    outputWaveform[i].resize(nTicks);
+  icarussigproc::resize2D(outputWaveform, numChannels, nTicks);
+
+  SplitSpectrum<T> response;
+  getResponseSpectrum(responseFunction, nTicks, response);
+
+  prepareLanePlanCaches();
+  auto processBand = [&](size_t begin, size_t end, unsigned int lane) {
+    Eigen::FFT<T>& fft = getLanePlanCache(lane).getFFT<T>();
+    std::vector<std::complex<T>> freqVec;
+    for (size_t i=begin; i<end; ++i) {
+      forwardRow(fft, freqVec, &inputWaveform[i][0], nTicks);
+      icarussigproc::DenormalScope denormalScope(fFlushDenormals);
+      applyWiener(freqVec.data(), freqVec.size(), response, noiseVar);
+      fft.inv(&outputWaveform[i][0], freqVec.data(), nTicks);
+    }
+  };
+  icarussigproc::parallelFor(numChannels, kBandRows, processBand, fNumThreads);
+  return;
+}
+
+// 1D Wiener Deconvolution with a frequency dependent noise power, one
+// spectrum per group of channels (see NoiseSpectrum).
+
+void sigproc_tools::Deconvolution::Wiener1D(
+  std::vector<std::vector<float>>& outputWaveform,
+  const std::vector<std::vector<float>>& inputWaveform,
+  const std::vector<float>& responseFunction,
+  const std::vector<std::vector<float>>& noisePSD,
+  const unsigned int grouping)
+{
+  Wiener1D<float>(outputWaveform, inputWaveform, responseFunction, 
+    noisePSD, grouping);
+}
+
+void sigproc_tools::Deconvolution::Wiener1D(
+  std::vector<std::vector<double>>& outputWaveform,
+  const std::vector<std::vector<double>>& inputWaveform,
+  const std::vector<double>& responseFunction,
+  const std::vector<std::vector<double>>& noisePSD,
+  const unsigned int grouping)
+{
+  Wiener1D<double>(outputWaveform, inputWaveform, responseFunction, 
+    noisePSD, grouping);
+}
+
+template <typename T, typename OutArray, typename InArray>
+void sigproc_tools::Deconvolution::Wiener1D(
+  OutArray& outputWaveform,
+  const InArray& inputWaveform,
+  const ResponseVector<T>& responseFunction,
+  const std::vector<ResponseVector<T>>& noisePSD,
+  const unsigned int grouping)
+{
+  size_t numChannels = icarussigproc::numRows(inputWaveform);
+  size_t nTicks = icarussigproc::numCols(inputWaveform);
+  SIGPROC_TRACE("Deconvolution::Wiener1D", "channels", numChannels);
+
+  icarussigproc::resize2D(outputWaveform, numChannels, nTicks);
+
+  SplitSpectrum<T> response;
+  getResponseSpectrum(responseFunction, nTicks, response);
+
+  prepareLanePlanCaches();
+  auto processBand = [&](size_t begin, size_t end, unsigned int lane) {
+    Eigen::FFT<T>& fft = getLanePlanCache(lane).getFFT<T>();
+    std::vector<std::complex<T>> freqVec;
+    for (size_t i=begin; i<end; ++i) {
+      forwardRow(fft, freqVec, &inputWaveform[i][0], nTicks);
+      icarussigproc::DenormalScope denormalScope(fFlushDenormals);
+      applyWiener(freqVec.data(), freqVec.size(), response,
+        noisePSD.at(i / grouping));
+      fft.inv(&outputWaveform[i][0], freqVec.data(), nTicks);
+    }
+  };
+  icarussigproc::parallelFor(numChannels, kBandRows, processBand, fNumThreads);
+  return;
+}
+
+
+// Split forward transform and 1D Wiener Deconvolution, so that spectral
+// stages (e.g. HarmonicNoiseFilter) can work on the same spectra in between.
+
+void sigproc_tools::Deconvolution::getSpectra(
+  std::vector<std::vector<std::complex<float>>>& spectra,
+  const std::vector<std::vector<float>>& inputWaveform)
+{
+  getSpectra<float>(spectra, inputWaveform);
+}
+
+void sigproc_tools::Deconvolution::getSpectra(
+  std::vector<std::vector<std::complex<double>>>& spectra,
+  const std::vector<std::vector<double>>& inputWaveform)
+{
+  getSpectra<double>(spectra, inputWaveform);
+}
+
+template <typename T, typename SpectraArray, typename InArray>
+void sigproc_tools::Deconvolution::getSpectra(
+  SpectraArray& spectra,
+  const InArray& inputWaveform)
+{
+  size_t numChannels = icarussigproc::numRows(inputWaveform);
+  size_t nTicks = icarussigproc::numCols(inputWaveform);
+  SIGPROC_TRACE("Deconvolution::getSpectra", "channels", numChannels);
+  icarussigproc::resize2D(spectra, numChannels, nTicks / 2 + 1);
+  prepareLanePlanCaches();
+  auto processBand = [&](size_t begin, size_t end, unsigned int lane) {
+    Eigen::FFT<T>& fft = getLanePlanCache(lane).getFFT<T>();
+    for (size_t i=begin; i<end; ++i) {
+      fft.fwd(&spectra[i][0], &inputWaveform[i][0], nTicks);
+    }
+  };
+  icarussigproc::parallelFor(numChannels, kBandRows, processBand, fNumThreads);
+  return;
+}
+
+void sigproc_tools::Deconvolution::Wiener1D(
+  std::vector<std::vector<float>>& outputWaveform,
+  std::vector<std::vector<std::complex<float>>>& spectra,
+  const std::vector<float>& responseFunction,
+  const float noiseVar,
+  const size_t nTicks)
+{
+  Wiener1D<float>(outputWaveform, spectra, responseFunction, noiseVar, nTicks);
+}
+
+void sigproc_tools::Deconvolution::Wiener1D(
+  std::vector<std::vector<double>>& outputWaveform,
+  std::vector<std::vector<std::complex<double>>>& spectra,
+  const std::vector<double>& responseFunction,
+  const float noiseVar,
+  const size_t nTicks)
+{
+  Wiener1D<double>(outputWaveform, spectra, responseFunction, noiseVar, nTicks);
+}
+
+template <typename T, typename OutArray, typename SpectraArray>
+void sigproc_tools::Deconvolution::Wiener1D(
+  OutArray& outputWaveform,
+  SpectraArray& spectra,
+  const ResponseVector<T>& responseFunction,
+  const float noiseVar,
+  const size_t nTicks)
+{
+  // The spectra are filtered in place
+  size_t numChannels = icarussigproc::numRows(spectra);
+  size_t nBins = icarussigproc::numCols(spectra);
+  SIGPROC_TRACE("Deconvolution::Wiener1D", "channels", numChannels);
+
+  icarussigproc::resize2D(outputWaveform, numChannels, nTicks);
+
+  SplitSpectrum<T> response;
+  getResponseSpectrum(responseFunction, nTicks, response);
+
+  prepareLanePlanCaches();
+  auto processBand = [&](size_t begin, size_t end, unsigned int lane) {
+    Eigen::FFT<T>& fft = getLanePlanCache(lane).getFFT<T>();
+    for (size_t i=begin; i<end; ++i) {
+      icarussigproc::DenormalScope denormalScope(fFlushDenormals);
+      applyWiener(&spectra[i][0], nBins, response, noiseVar);
+      fft.inv(&outputWaveform[i][0], &spectra[i][0], nTicks);
+    }
+  };
+  icarussigproc::parallelFor(numChannels, kBandRows, processBand, fNumThreads);
+  return;
+}
+
+
+// 1D Wiener Deconvolution with a response spectrum memoized by the
+// ResponseRegistry. Same filter, and so the same result up to rounding, as
+// Wiener1D with the response function and the same noiseVar; only the
+// transform of the response is saved.
+
+void sigproc_tools::Deconvolution::Wiener1D(
+  std::vector<std::vector<float>>& outputWaveform,
+  const std::vector<std::vector<float>>& inputWaveform,
+  const icarussigproc::FilterSpectrum& filterSpectrum,
+  const float noiseVar)
+{
+  Wiener1D<float>(outputWaveform, inputWaveform, filterSpectrum, noiseVar);
+}
+
+void sigproc_tools::Deconvolution::Wiener1D(
+  std::vector<std::vector<double>>& outputWaveform,
+  const std::vector<std::vector<double>>& inputWaveform,
+  const icarussigproc::FilterSpectrum& filterSpectrum,
+  const float noiseVar)
+{
+  Wiener1D<double>(outputWaveform, inputWaveform, filterSpectrum, noiseVar);
+}
+
+template <typename T, typename OutArray, typename InArray>
+void sigproc_tools::Deconvolution::Wiener1D(
+  OutArray& outputWaveform,
+  const InArray& inputWaveform,
+  const icarussigproc::FilterSpectrum& filterSpectrum,
+  const float noiseVar)
+{
+  size_t numChannels = icarussigproc::numRows(inputWaveform);
+  size_t nTicks = icarussigproc::numCols(inputWaveform);
+  SIGPROC_TRACE("Deconvolution::Wiener1D", "channels", numChannels);
+  if (nTicks != filterSpectrum.nTicks) {
+    throw std::invalid_argument(
+      "Deconvolution::Wiener1D: filter spectrum built for " + 
+      std::to_string(filterSpectrum.nTicks) + " ticks, waveforms have " +
+      std::to_string(nTicks));
   }
 
-  for (size_t i=0; i<numChannels; ++i) {
-    Eigen::FFT<T> fft;
-    fft.SetFlag(fft.HalfSpectrum);
-    std::complex<T> wiener;
+  icarussigproc::resize2D(outputWaveform, numChannels, nTicks);
+
+  size_t nBins = filterSpectrum.response.size();
+  SplitSpectrum<T> response;
+  response.real.resize(nBins);
+  response.imag.resize(nBins);
+  response.power.resize(nBins);
+  for (size_t j=0; j<nBins; ++j) {
+    response.real[j] = filterSpectrum.response[j].real();
+    response.imag[j] = filterSpectrum.response[j].imag();
+    response.power[j] = filterSpectrum.responsePower[j];
+  }
+
+  prepareLanePlanCaches();
+  auto processBand = [&](size_t begin, size_t end, unsigned int lane) {
+    Eigen::FFT<T>& fft = getLanePlanCache(lane).getFFT<T>();
     std::vector<std::complex<T>> freqVec;
-    std::vector<std::complex<T>> responseFFT;
-    fft.fwd(freqVec, inputWaveform[i]);
-    fft.fwd(responseFFT, responseFunction);
-    for (size_t j=0; j<responseFFT.size(); ++j) {
-      wiener = std::conj(responseFFT[j]) / 
-      ((std::complex<T>) std::pow(std::abs(responseFFT[j]), 2.0) + 
-        (std::complex<T>) noiseVar / (std::complex<T>) std::pow(std::abs(freqVec[j]), 2.0));
-      freqVec[j] = freqVec[j] * wiener;
+    for (size_t i=begin; i<end; ++i) {
+      forwardRow(fft, freqVec, &inputWaveform[i][0], nTicks);
+      icarussigproc::DenormalScope denormalScope(fFlushDenormals);
+      applyWiener(freqVec.data(), freqVec.size(), response, noiseVar);
+      fft.inv(&outputWaveform[i][0], freqVec.data(), nTicks);
     }
-    fft.inv(outputWaveform[i], freqVec);
-    fft.ClearFlag(fft.HalfSpectrum);
+  };
+  icarussigproc::parallelFor(numChannels, kBandRows, processBand, fNumThreads);
+  return;
+}
+
+template <typename T>
+void sigproc_tools::Deconvolution::getResponseSpectrum(
+  const std::vector<T>& responseFunction,
+  const size_t fftSize,
+  SplitSpectrum<T>& response)
+{
+  // Responses longer than the transform wrap around (circular convolution),
+  // as in the full length filters; WienerROI1D windows hold the response
+  std::vector<T> folded(fftSize, 0);
+  for (size_t k=0; k<responseFunction.size(); ++k) {
+    folded[k % fftSize] += responseFunction[k];
+  }
+  std::vector<std::complex<T>> responseFFT;
+  fPlanCache.getFFT<T>().fwd(responseFFT, folded);
+
+  size_t nBins = responseFFT.size();
+  response.real.resize(nBins);
+  response.imag.resize(nBins);
+  response.power.resize(nBins);
+  for (size_t j=0; j<nBins; ++j) {
+    response.real[j] = responseFFT[j].real();
+    response.imag[j] = responseFFT[j].imag();
+    response.power[j] = std::norm(responseFFT[j]);
   }
   return;
 }
 
+template <typename T>
+void sigproc_tools::Deconvolution::applyWiener(
+  std::complex<T>* freqVec,
+  const size_t numBins,
+  const SplitSpectrum<T>& response,
+  const float noiseVar,
+  const float missingPower) const
+{
+  /*
+  Wiener filter W = conj(H) / (|H|^2 + noiseVar / |X|^2), applied as
+  X W = X conj(H) |X|^2 / (|H|^2 |X|^2 + noiseVar) so each bin costs one
+  real division. missingPower is added to |X|^2 (see WienerROI1D). The
+  spectrum is read as interleaved (re, im) pairs, which std::complex
+  guarantees, with no aliasing so the loop vectorizes.
+  */
+  size_t nBins = std::min(numBins, response.power.size());
+  T* __restrict__ x = reinterpret_cast<T*>(freqVec);
+  const T* __restrict__ hRe = response.real.data();
+  const T* __restrict__ hIm = response.imag.data();
+  const T* __restrict__ hPow = response.power.data();
+  const T noise = noiseVar;
+  const T offset = missingPower;
+  for (size_t j=0; j<nBins; ++j) {
+    T xRe = x[2*j];
+    T xIm = x[2*j+1];
+    T xPow = xRe * xRe + xIm * xIm + offset;
+    T scale = xPow / (hPow[j] * xPow + noise);
+    x[2*j]   = (xRe * hRe[j] + xIm * hIm[j]) * scale;
+    x[2*j+1] = (xIm * hRe[j] - xRe * hIm[j]) * scale;
+  }
+  return;
+}
+
+template <typename T>
+void sigproc_tools::Deconvolution::applyWiener(
+  std::complex<T>* freqVec,
+  const size_t numBins,
+  const SplitSpectrum<T>& response,
+  const std::vector<T>& noisePSD) const
+{
+  // As above with the noise power of each bin, in units of |X|^2
+  size_t nBins = std::min(
+    {numBins, response.power.size(), noisePSD.size()});
+  T* __restrict__ x = reinterpret_cast<T*>(freqVec);
+  const T* __restrict__ hRe = response.real.data();
+  const T* __restrict__ hIm = response.imag.data();
+  const T* __restrict__ hPow = response.power.data();
+  const T* __restrict__ noise = noisePSD.data();
+  for (size_t j=0; j<nBins; ++j) {
+    T xRe = x[2*j];
+    T xIm = x[2*j+1];
+    T xPow = xRe * xRe + xIm * xIm;
+    T scale = xPow / (hPow[j] * xPow + noise[j]);
+    x[2*j]   = (xRe * hRe[j] + xIm * hIm[j]) * scale;
+    x[2*j+1] = (xIm * hRe[j] - xRe * hIm[j]) * scale;
+  }
+  return;
+}
+
+
+// 1D Wiener Deconvolution of the regions of interest only.
+// Each ROI is padded by margin ticks on both sides (overlapping windows on
+// a channel are merged) and deconvolved in a window of the smallest FFT
+// size class that holds it and the support of the response, taken from the
+// surrounding waveform, so that the response does not wrap around within
+// the window. Windows of one size class share the FFT plan and the response
+// spectrum (the zero padded response). The filter of Wiener1D weighs the
+// noise power against the power of the full length transform, of which the
+// window only holds the signal and nWindow noiseVar of the nTicks noiseVar
+// of white noise; the missing (nTicks - nWindow) noiseVar is added back.
+// The result matches Wiener1D up to the fluctuation of the noise power of
+// the full length transform around its expectation.
+
+void sigproc_tools::Deconvolution::WienerROI1D(
+  std::vector<ROIWaveform<float>>& outputROIs,
+  const std::vector<std::vector<float>>& inputWaveform,
+  const std::vector<std::vector<bool>>& roi,
+  const std::vector<float>& responseFunction,
+  const float noiseVar,
+  const unsigned int margin)
+{
+  WienerROI1D<float>(outputROIs, inputWaveform, roi, 
+    responseFunction, noiseVar, margin);
+}
+
+void sigproc_tools::Deconvolution::WienerROI1D(
+  std::vector<ROIWaveform<double>>& outputROIs,
+  const std::vector<std::vector<double>>& inputWaveform,
+  const std::vector<std::vector<bool>>& roi,
+  const std::vector<double>& responseFunction,
+  const float noiseVar,
+  const unsigned int margin)
+{
+  WienerROI1D<double>(outputROIs, inputWaveform, roi, 
+    responseFunction, noiseVar, margin);
+}
+
+template <typename T, typename InArray, typename MaskArray>
+void sigproc_tools::Deconvolution::WienerROI1D(
+  ROIVector<T>& outputROIs,
+  const InArray& inputWaveform,
+  const MaskArray& roi,
+  const ResponseVector<T>& responseFunction,
+  const float noiseVar,
+  const unsigned int margin)
+{
+  size_t numChannels = icarussigproc::numRows(inputWaveform);
+  size_t nTicks = icarussigproc::numCols(inputWaveform);
+  SIGPROC_TRACE("Deconvolution::WienerROI1D", "channels", numChannels);
+
+  outputROIs.clear();
+
+  // Ticks over which a deposit shows up in the waveform
+  size_t support = responseFunction.size();
+  while (support > 0 && responseFunction[support-1] == T(0)) --support;
+
+  // Padded and merged windows, in channel order, indexed by size class.
+  std::map<size_t, std::vector<size_t>> windowsBySize;
+
+  for (size_t i=0; i<numChannels; ++i) {
+    size_t firstWindow = outputROIs.size();
+    size_t j = 0;
+    while (j < nTicks) {
+      if (!roi[i][j]) {
+        ++j;
+        continue;
+      }
+      size_t roiEnd = j;
+      while (roiEnd < nTicks && roi[i][roiEnd]) ++roiEnd;
+      size_t lowerBound = j - std::min(j, (size_t) margin);
+      size_t upperBound = std::min(roiEnd + margin, nTicks);
+      if (outputROIs.size() > firstWindow && 
+          lowerBound <= outputROIs.back().startTick + outputROIs.back().data.size()) {
+        outputROIs.back().data.resize(upperBound - outputROIs.back().startTick);
+      } else {
+        outputROIs.push_back(ROIWaveform<T>{i, lowerBound, 
+          std::vector<T>(upperBound - lowerBound)});
+      }
+      j = roiEnd;
+    }
+    for (size_t k=firstWindow; k<outputROIs.size(); ++k) {
+      size_t sizeClass = fPlanCache.getSizeClass(
+        outputROIs[k].data.size() + support, nTicks);
+      windowsBySize[sizeClass].push_back(k);
+    }
+  }
+
+  SplitSpectrum<T> response;
+  prepareLanePlanCaches();
+
+  for (const auto& sizeClass : windowsBySize) {
+    size_t fftSize = sizeClass.first;
+    const std::vector<size_t>& windows = sizeClass.second;
+    getResponseSpectrum(responseFunction, fftSize, response);
+    float missingPower = noiseVar * float(nTicks - fftSize);
+
+    // Windows of a size class are independent
+    auto processWindows = [&](size_t begin, size_t end, unsigned int lane) {
+      Eigen::FFT<T>& fft = getLanePlanCache(lane).getFFT<T>();
+      std::vector<T> segment(fftSize);
+      std::vector<T> deconvolved(fftSize);
+      std::vector<std::complex<T>> freqVec;
+      for (size_t w=begin; w<end; ++w) {
+        ROIWaveform<T>& window = outputROIs[windows[w]];
+        size_t length = window.data.size();
+        // Window from the ROI start to the end of the response of its last
+        // tick, centered in the FFT window. Windows wrap around the ends of
+        // the waveform, as the full length transform does.
+        size_t offset = (fftSize - std::min(fftSize, length + support)) / 2;
+        size_t fftStart = (window.startTick + nTicks - offset) % nTicks;
+        size_t firstPart = std::min(fftSize, nTicks - fftStart);
+        const T* waveform = &inputWaveform[window.channel][0];
+        std::copy(waveform + fftStart,
+          waveform + fftStart + firstPart, segment.begin());
+        std::copy(waveform, waveform + (fftSize - firstPart),
+          segment.begin() + firstPart);
+        fft.fwd(freqVec, segment);
+        icarussigproc::DenormalScope denormalScope(fFlushDenormals);
+        applyWiener(freqVec.data(), freqVec.size(), response, noiseVar,
+          missingPower);
+        fft.inv(deconvolved, freqVec, fftSize);
+        auto roiStart = deconvolved.begin() + offset;
+        std::copy(roiStart, roiStart + length, window.data.begin());
+      }
+    };
+    icarussigproc::parallelFor(windows.size(), kBandRows, processWindows,
+      fNumThreads);
+  }
+  return;
+}
+
+void sigproc_tools::Deconvolution::prepareLanePlanCaches()
+{
+  size_t numLanes = icarussigproc::getNumWorkers(fNumThreads);
+  while (fLanePlanCaches.size() + 1 < numLanes) {
+    fLanePlanCaches.emplace_back(new icarussigproc::FFTPlanCache);
+  }
+  return;
+}
+
+// Overloads on contiguous arrays, sharing the templates above
+
+void sigproc_tools::Deconvolution::Inverse1D(
+  icarussigproc::Array2D<float>& outputWaveform,
+  const icarussigproc::Array2DView<const float> inputWaveform,
+  const std::vector<float>& responseFunction)
+{
+  Inverse1D<float>(outputWaveform, inputWaveform, responseFunction);
+}
+
+void sigproc_tools::Deconvolution::Inverse1D(
+  icarussigproc::Array2D<double>& outputWaveform,
+  const icarussigproc::Array2DView<const double> inputWaveform,
+  const std::vector<double>& responseFunction)
+{
+  Inverse1D<double>(outputWaveform, inputWaveform, responseFunction);
+}
+
+void sigproc_tools::Deconvolution::Wiener1D(
+  icarussigproc::Array2D<float>& outputWaveform,
+  const icarussigproc::Array2DView<const float> inputWaveform,
+  const std::vector<float>& responseFunction,
+  const float noiseVar)
+{
+  Wiener1D<float>(outputWaveform, inputWaveform, responseFunction, noiseVar);
+}
+
+void sigproc_tools::Deconvolution::Wiener1D(
+  icarussigproc::Array2D<double>& outputWaveform,
+  const icarussigproc::Array2DView<const double> inputWaveform,
+  const std::vector<double>& responseFunction,
+  const float noiseVar)
+{
+  Wiener1D<double>(outputWaveform, inputWaveform, responseFunction, noiseVar);
+}
+
+void sigproc_tools::Deconvolution::Wiener1D(
+  icarussigproc::Array2DView<float> outputWaveform,
+  const icarussigproc::Array2DView<const float> inputWaveform,
+  const std::vector<float>& responseFunction,
+  const float noiseVar)
+{
+  Wiener1D<float>(outputWaveform, inputWaveform, responseFunction, noiseVar);
+}
+
+void sigproc_tools::Deconvolution::Wiener1D(
+  icarussigproc::Array2DView<double> outputWaveform,
+  const icarussigproc::Array2DView<const double> inputWaveform,
+  const std::vector<double>& responseFunction,
+  const float noiseVar)
+{
+  Wiener1D<double>(outputWaveform, inputWaveform, responseFunction, noiseVar);
+}
+
+void sigproc_tools::Deconvolution::Wiener1D(
+  icarussigproc::Array2D<float>& outputWaveform,
+  const icarussigproc::Array2DView<const float> inputWaveform,
+  const icarussigproc::FilterSpectrum& filterSpectrum,
+  const float noiseVar)
+{
+  Wiener1D<float>(outputWaveform, inputWaveform, filterSpectrum, noiseVar);
+}
+
+void sigproc_tools::Deconvolution::Wiener1D(
+  icarussigproc::Array2D<double>& outputWaveform,
+  const icarussigproc::Array2DView<const double> inputWaveform,
+  const icarussigproc::FilterSpectrum& filterSpectrum,
+  const float noiseVar)
+{
+  Wiener1D<double>(outputWaveform, inputWaveform, filterSpectrum, noiseVar);
+}
+
+void sigproc_tools::Deconvolution::Wiener1D(
+  icarussigproc::Array2D<float>& outputWaveform,
+  const icarussigproc::Array2DView<const float> inputWaveform,
+  const std::vector<float>& responseFunction,
+  const std::vector<std::vector<float>>& noisePSD,
+  const unsigned int grouping)
+{
+  Wiener1D<float>(outputWaveform, inputWaveform, responseFunction, 
+    noisePSD, grouping);
+}
+
+void sigproc_tools::Deconvolution::Wiener1D(
+  icarussigproc::Array2D<double>& outputWaveform,
+  const icarussigproc::Array2DView<const double> inputWaveform,
+  const std::vector<double>& responseFunction,
+  const std::vector<std::vector<double>>& noisePSD,
+  const unsigned int grouping)
+{
+  Wiener1D<double>(outputWaveform, inputWaveform, responseFunction, 
+    noisePSD, grouping);
+}
+
+void sigproc_tools::Deconvolution::getSpectra(
+  icarussigproc::Array2D<std::complex<float>>& spectra,
+  const icarussigproc::Array2DView<const float> inputWaveform)
+{
+  getSpectra<float>(spectra, inputWaveform);
+}
+
+void sigproc_tools::Deconvolution::getSpectra(
+  icarussigproc::Array2D<std::complex<double>>& spectra,
+  const icarussigproc::Array2DView<const double> inputWaveform)
+{
+  getSpectra<double>(spectra, inputWaveform);
+}
+
+void sigproc_tools::Deconvolution::Wiener1D(
+  icarussigproc::Array2D<float>& outputWaveform,
+  icarussigproc::Array2D<std::complex<float>>& spectra,
+  const std::vector<float>& responseFunction,
+  const float noiseVar,
+  const size_t nTicks)
+{
+  Wiener1D<float>(outputWaveform, spectra, responseFunction, noiseVar, nTicks);
+}
+
+void sigproc_tools::Deconvolution::Wiener1D(
+  icarussigproc::Array2D<double>& outputWaveform,
+  icarussigproc::Array2D<std::complex<double>>& spectra,
+  const std::vector<double>& responseFunction,
+  const float noiseVar,
+  const size_t nTicks)
+{
+  Wiener1D<double>(outputWaveform, spectra, responseFunction, noiseVar, nTicks);
+}
+
+void sigproc_tools::Deconvolution::WienerROI1D(
+  std::vector<ROIWaveform<float>>& outputROIs,
+  const icarussigproc::Array2DView<const float> inputWaveform,
+  const icarussigproc::Array2DView<const bool> roi,
+  const std::vector<float>& responseFunction,
+  const float noiseVar,
+  const unsigned int margin)
+{
+  WienerROI1D<float>(outputROIs, inputWaveform, roi, 
+    responseFunction, noiseVar, margin);
+}
+
+void sigproc_tools::Deconvolution::WienerROI1D(
+  std::vector<ROIWaveform<double>>& outputROIs,
+  const icarussigproc::Array2DView<const double> inputWaveform,
+  const icarussigproc::Array2DView<const bool> roi,
+  const std::vector<double>& responseFunction,
+  const float noiseVar,
+  const unsigned int margin)
+{
+  WienerROI1D<double>(outputROIs, inputWaveform, roi, 
+    responseFunction, noiseVar, margin);
+}
+
 // 2D PseudoWiener Filtering
 
 
@@ -20,7 +20,14 @@
 #include <numeric>
 #include <cmath>
 #include <functional>
+#include <map>
+#include <memory>
+#include <type_traits>
 #include "MiscUtils.h"
+#include "FFTPlanCache.h"
+#include "ResponseRegistry.h"
+#include "DenormalScope.h"
+#include "Array2D.h"
 
 #include <Eigen/Core>
 #include <unsupported/Eigen/FFT>
@@ -30,10 +37,36 @@
 
 namespace sigproc_tools {
 
+  /**
+     \struct ROIWaveform
+     Deconvolved samples [startTick, startTick + data.size()) of a channel.
+     Ticks not covered by any ROIWaveform are zero.
+  */
+  template <typename T>
+  struct ROIWaveform {
+    size_t         channel;
+    size_t         startTick;
+    std::vector<T> data;
+  };
+
+  /**
+     \struct SplitSpectrum
+     Response half spectrum split into real and imaginary parts, with the
+     power |H|^2 precomputed, as read by the vectorized Wiener kernel.
+  */
+  template <typename T>
+  struct SplitSpectrum {
+    std::vector<T> real;
+    std::vector<T> imag;
+    std::vector<T> power;
+  };
+
   /**
      \class Deconvolution
      User defined class Deconvolution ... these comments are used to generate
      doxygen documentation!
+     Not shareable between threads: the FFT plan and response caches are
+     filled by the calls. Use one instance per thread.
   */
   class Deconvolution{
     
@@ -69,26 +102,325 @@ namespace sigproc_tools {
         const float
       );
 
+      void Wiener1D(
+        std::vector<std::vector<float>>&,
+        const std::vector<std::vector<float>>&,
+        const icarussigproc::FilterSpectrum&,
+        const float
+      );
+
+      void Wiener1D(
+        std::vector<std::vector<double>>&,
+        const std::vector<std::vector<double>>&,
+        const icarussigproc::FilterSpectrum&,
+        const float
+      );
+
+      void Wiener1D(
+        std::vector<std::vector<float>>&,
+        const std::vector<std::vector<float>>&,
+        const std::vector<float>&,
+        const std::vector<std::vector<float>>&,
+        const unsigned int
+      );
+
+      void Wiener1D(
+        std::vector<std::vector<double>>&,
+        const std::vector<std::vector<double>>&,
+        const std::vector<double>&,
+        const std::vector<std::vector<double>>&,
+        const unsigned int
+      );
+
+
+      void getSpectra(
+        std::vector<std::vector<std::complex<float>>>&,
+        const std::vector<std::vector<float>>&
+      );
+
+      void getSpectra(
+        std::vector<std::vector<std::complex<double>>>&,
+        const std::vector<std::vector<double>>&
+      );
+
+      void Wiener1D(
+        std::vector<std::vector<float>>&,
+        std::vector<std::vector<std::complex<float>>>&,
+        const std::vector<float>&,
+        const float,
+        const size_t
+      );
+
+      void Wiener1D(
+        std::vector<std::vector<double>>&,
+        std::vector<std::vector<std::complex<double>>>&,
+        const std::vector<double>&,
+        const float,
+        const size_t
+      );
+
+
+      void WienerROI1D(
+        std::vector<ROIWaveform<float>>&,
+        const std::vector<std::vector<float>>&,
+        const std::vector<std::vector<bool>>&,
+        const std::vector<float>&,
+        const float,
+        const unsigned int
+      );
+
+      void WienerROI1D(
+        std::vector<ROIWaveform<double>>&,
+        const std::vector<std::vector<double>>&,
+        const std::vector<std::vector<bool>>&,
+        const std::vector<double>&,
+        const float,
+        const unsigned int
+      );
+
+
+      /// Overloads on contiguous arrays (see Array2D.h). Spectra are stored
+      /// as Array2D<std::complex<T>> of numChannels x (nTicks/2 + 1) bins.
+
+      void Inverse1D(
+        icarussigproc::Array2D<float>&,
+        const icarussigproc::Array2DView<const float>,
+        const std::vector<float>&
+      );
+
+      void Inverse1D(
+        icarussigproc::Array2D<double>&,
+        const icarussigproc::Array2DView<const double>,
+        const std::vector<double>&
+      );
+
+      void Wiener1D(
+        icarussigproc::Array2D<float>&,
+        const icarussigproc::Array2DView<const float>,
+        const std::vector<float>&,
+        const float
+      );
+
+      void Wiener1D(
+        icarussigproc::Array2D<double>&,
+        const icarussigproc::Array2DView<const double>,
+        const std::vector<double>&,
+        const float
+      );
+
+      /// Into an existing view of the input shape, e.g. rows of a larger
+      /// plane; the output may be the input itself
+      void Wiener1D(
+        icarussigproc::Array2DView<float>,
+        const icarussigproc::Array2DView<const float>,
+        const std::vector<float>&,
+        const float
+      );
+
+      void Wiener1D(
+        icarussigproc::Array2DView<double>,
+        const icarussigproc::Array2DView<const double>,
+        const std::vector<double>&,
+        const float
+      );
+
+      void Wiener1D(
+        icarussigproc::Array2D<float>&,
+        const icarussigproc::Array2DView<const float>,
+        const icarussigproc::FilterSpectrum&,
+        const float
+      );
+
+      void Wiener1D(
+        icarussigproc::Array2D<double>&,
+        const icarussigproc::Array2DView<const double>,
+        const icarussigproc::FilterSpectrum&,
+        const float
+      );
+
+      void Wiener1D(
+        icarussigproc::Array2D<float>&,
+        const icarussigproc::Array2DView<const float>,
+        const std::vector<float>&,
+        const std::vector<std::vector<float>>&,
+        const unsigned int
+      );
+
+      void Wiener1D(
+        icarussigproc::Array2D<double>&,
+        const icarussigproc::Array2DView<const double>,
+        const std::vector<double>&,
+        const std::vector<std::vector<double>>&,
+        const unsigned int
+      );
+
+      void getSpectra(
+        icarussigproc::Array2D<std::complex<float>>&,
+        const icarussigproc::Array2DView<const float>
+      );
+
+      void getSpectra(
+        icarussigproc::Array2D<std::complex<double>>&,
+        const icarussigproc::Array2DView<const double>
+      );
+
+      void Wiener1D(
+        icarussigproc::Array2D<float>&,
+        icarussigproc::Array2D<std::complex<float>>&,
+        const std::vector<float>&,
+        const float,
+        const size_t
+      );
+
+      void Wiener1D(
+        icarussigproc::Array2D<double>&,
+        icarussigproc::Array2D<std::complex<double>>&,
+        const std::vector<double>&,
+        const float,
+        const size_t
+      );
+
+      void WienerROI1D(
+        std::vector<ROIWaveform<float>>&,
+        const icarussigproc::Array2DView<const float>,
+        const icarussigproc::Array2DView<const bool>,
+        const std::vector<float>&,
+        const float,
+        const unsigned int
+      );
+
+      void WienerROI1D(
+        std::vector<ROIWaveform<double>>&,
+        const icarussigproc::Array2DView<const double>,
+        const icarussigproc::Array2DView<const bool>,
+        const std::vector<double>&,
+        const float,
+        const unsigned int
+      );
+
+      /// FFT engines, to share plans with other spectral stages (NoiseSpectrum)
+      icarussigproc::FFTPlanCache& getPlanCache() { return fPlanCache; }
+
+      /// Opt in to flush-to-zero/denormals-are-zero around the spectral
+      /// kernel and inverse FFT
+      void setFlushDenormals(const bool flush) { fFlushDenormals = flush; }
+
+      /// Threads of the parallel loops over channels, 0 for the
+      /// concurrency of the library thread pool
+      void setNumThreads(const unsigned int numThreads) { fNumThreads = numThreads; }
+
       
       /// Default destructor
       ~Deconvolution(){}
 
     private:
 
+      /// The templates below are always called with an explicit T; taking
+      /// the response and ROIs in a non-deduced context keeps calls with
+      /// Array2D arguments on the public overloads
+      template <typename T>
+      using ResponseVector = std::vector<typename std::common_type<T>::type>;
       template <typename T>
+      using ROIVector =
+        std::vector<ROIWaveform<typename std::common_type<T>::type>>;
+
+      template <typename T, typename OutArray, typename InArray>
       void Inverse1D(
-        std::vector<std::vector<T>>& outputWaveform,
-        const std::vector<std::vector<T>>& inputWaveform,
-        const std::vector<T>& responseFunction
+        OutArray& outputWaveform,
+        const InArray& inputWaveform,
+        const ResponseVector<T>& responseFunction
       );
 
-      template <typename T>
+      template <typename T, typename OutArray, typename InArray>
       void Wiener1D(
-        std::vector<std::vector<T>>& outputWaveform,
-        const std::vector<std::vector<T>>& inputWaveform,
-        const std::vector<T>& responseFunction,
+        OutArray& outputWaveform,
+        const InArray& inputWaveform,
+        const ResponseVector<T>& responseFunction,
         const float noiseVar
       );
+
+      template <typename T, typename OutArray, typename InArray>
+      void Wiener1D(
+        OutArray& outputWaveform,
+        const InArray& inputWaveform,
+        const icarussigproc::FilterSpectrum& filterSpectrum,
+        const float noiseVar
+      );
+
+      template <typename T, typename OutArray, typename InArray>
+      void Wiener1D(
+        OutArray& outputWaveform,
+        const InArray& inputWaveform,
+        const ResponseVector<T>& responseFunction,
+        const std::vector<ResponseVector<T>>& noisePSD,
+        const unsigned int grouping
+      );
+
+      template <typename T, typename SpectraArray, typename InArray>
+      void getSpectra(
+        SpectraArray& spectra,
+        const InArray& inputWaveform
+      );
+
+      template <typename T, typename OutArray, typename SpectraArray>
+      void Wiener1D(
+        OutArray& outputWaveform,
+        SpectraArray& spectra,
+        const ResponseVector<T>& responseFunction,
+        const float noiseVar,
+        const size_t nTicks
+      );
+
+      template <typename T, typename InArray, typename MaskArray>
+      void WienerROI1D(
+        ROIVector<T>& outputROIs,
+        const InArray& inputWaveform,
+        const MaskArray& roi,
+        const ResponseVector<T>& responseFunction,
+        const float noiseVar,
+        const unsigned int margin=32
+      );
+
+      template <typename T>
+      void getResponseSpectrum(
+        const std::vector<T>& responseFunction,
+        const size_t fftSize,
+        SplitSpectrum<T>& response
+      );
+
+      template <typename T>
+      void applyWiener(
+        std::complex<T>* freqVec,
+        const size_t numBins,
+        const SplitSpectrum<T>& response,
+        const float noiseVar,
+        const float missingPower=0.
+      ) const;
+
+      template <typename T>
+      void applyWiener(
+        std::complex<T>* freqVec,
+        const size_t numBins,
+        const SplitSpectrum<T>& response,
+        const std::vector<T>& noisePSD
+      ) const;
+
+      /// Makes sure every worker of the parallel loops has FFT engines;
+      /// call it before the loop, from the calling thread
+      void prepareLanePlanCaches();
+
+      /// FFT engines of a worker of the parallel loops, worker 0 using
+      /// fPlanCache (Eigen::FFT fills its plans on use, so engines are
+      /// never shared between threads)
+      icarussigproc::FFTPlanCache& getLanePlanCache(const unsigned int lane)
+      {
+        return lane == 0 ? fPlanCache : *fLanePlanCaches[lane - 1];
+      }
+
+      icarussigproc::FFTPlanCache fPlanCache;
+      std::vector<std::unique_ptr<icarussigproc::FFTPlanCache>> fLanePlanCaches;
+      bool                        fFlushDenormals = false;
+      unsigned int                fNumThreads = 0;
       
     };
 }
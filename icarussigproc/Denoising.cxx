@@ -2,7 +2,58 @@
 #define __SIGPROC_TOOLS_DENOISING_CXX__
 
 #include "Denoising.h"
+#include "Instrumentation.h"
+#include "Int16Kernels.h"
+#include "ParallelFor.h"
+
+// Channels per task of the loops over channels
+static const size_t kBandRows = 8;
+
+// Coherent noise subtraction of one channel: the group medians come off
+// every sample not selected as signal. int16 rows go through the saturating
+// row kernel of Int16Kernels.h, then get their selected samples back.
+template <typename T, typename InRow, typename MedianRow, typename MaskRow,
+  typename OutRow>
+static void subtractMedians(
+  const InRow& filtered,
+  const MedianRow& medians,
+  const MaskRow& selected,
+  OutRow&& output,
+  const size_t nTicks)
+{
+  if constexpr (std::is_same<T, short>::value) {
+    if (nTicks == 0) return;
+    icarussigproc::subtractRow(&filtered[0], &medians[0], &output[0], nTicks);
+    for (size_t i=0; i<nTicks; ++i) {
+      if (selected[i]) output[i] = filtered[i];
+    }
+  } else {
+    for (size_t i=0; i<nTicks; ++i) {
+      output[i] = selected[i] ? filtered[i] : filtered[i] - medians[i];
+    }
+  }
+  return;
+}
 
+// Morph1D filters run on the rows where they are, for nested vectors and
+// Array2D alike; the output rows already hold nTicks samples
+template <typename T, typename InArray, typename OutArray, typename Filter>
+static void applyToRows(
+  const InArray& input,
+  OutArray& output,
+  Filter filter,
+  const unsigned int numThreads)
+{
+  size_t nTicks = icarussigproc::numCols(input);
+  if (nTicks == 0) return;
+  icarussigproc::parallelFor(icarussigproc::numRows(input), kBandRows,
+    [&](size_t begin, size_t end, unsigned int) {
+      for (size_t i=begin; i<end; ++i) {
+        filter(&input[i][0], nTicks, &output[i][0]);
+      }
+    }, numThreads);
+  return;
+}
 
 void icarussigproc::Denoising::getSelectVals(
   const ArrayShort& waveforms,
@@ -10,7 +61,7 @@ void icarussigproc::Denoising::getSelectVals(
   ArrayBool& selectVals,
   ArrayBool& roi,
   const unsigned int window,
-  const float thresholdFactor)
+  const float thresholdFactor) const
 {
   getSelectVals<short>(waveforms, morphedWaveforms, selectVals,
     roi, window, thresholdFactor);
@@ -22,7 +73,7 @@ void icarussigproc::Denoising::getSelectVals(
   ArrayBool& selectVals,
   ArrayBool& roi,
   const unsigned int window,
-  const float thresholdFactor)
+  const float thresholdFactor) const
 {
   getSelectVals<float>(waveforms, morphedWaveforms, selectVals,
     roi, window, thresholdFactor);
@@ -34,67 +85,99 @@ void icarussigproc::Denoising::getSelectVals(
   ArrayBool& selectVals,
   ArrayBool& roi,
   const unsigned int window,
-  const float thresholdFactor)
+  const float thresholdFactor) const
 {
   getSelectVals<double>(waveforms, morphedWaveforms, selectVals,
     roi, window, thresholdFactor);
 }
 
-template <typename T>
 void icarussigproc::Denoising::getSelectVals(
-  const std::vector<std::vector<T>>& waveforms,
-  const std::vector<std::vector<T>>& morphedWaveforms,
-  ArrayBool& selectVals,
-  ArrayBool& roi,
+  const Array2DView<const short> waveforms,
+  const Array2DView<const short> morphedWaveforms,
+  Array2D<bool>& selectVals,
+  Array2D<bool>& roi,
   const unsigned int window,
-  const float thresholdFactor)
+  const float thresholdFactor) const
 {
-  auto numChannels = waveforms.size();
-  auto nTicks = waveforms.at(0).size();
-
-  for (size_t i=0; i<numChannels; ++i) {
-    T median = 0.0;
-    std::vector<T> localVec = morphedWaveforms[i];
-    if (localVec.size() % 2 == 0) {
-      const auto m1 = localVec.begin() + localVec.size() / 2 - 1;
-      const auto m2 = localVec.begin() + localVec.size() / 2;
-      std::nth_element(localVec.begin(), m1, localVec.end());
-      const auto e1 = *m1;
-      std::nth_element(localVec.begin(), m2, localVec.end());
-      const auto e2 = *m2;
-      median = (e1 + e2) / 2.0;
-    } else {
-      const auto m = localVec.begin() + localVec.size() / 2;
-      std::nth_element(localVec.begin(), m, localVec.end());
-      median = *m;
-    }
-    std::vector<T> baseVec;
-    baseVec.resize(localVec.size());
-    for (size_t j=0; j<baseVec.size(); ++j) {
-      baseVec[j] = morphedWaveforms[i][j] - median;
-    }
-    float rms;
-    rms = std::sqrt(std::inner_product(baseVec.begin(), 
-      baseVec.end(), baseVec.begin(), 0.) / float(baseVec.size()));
-    float threshold;
-    threshold = thresholdFactor * rms;
-
-    for (size_t j=0; j<nTicks; ++j) {
-      if (std::fabs(morphedWaveforms[i][j]) > threshold) {
-        // Check Bounds
-        selectVals[i][j] = true;
-        int lb = j - (int) window;
-        int ub = j + (int) window + 1;
-        size_t lowerBound = std::max(lb, 0);
-        size_t upperBound = std::min(ub, (int) nTicks);
-        for (size_t k=lowerBound; k<upperBound; ++k) {
-          roi[i][k] = true;
+  getSelectVals<short>(waveforms, morphedWaveforms, selectVals,
+    roi, window, thresholdFactor);
+}
+
+void icarussigproc::Denoising::getSelectVals(
+  const Array2DView<const float> waveforms,
+  const Array2DView<const float> morphedWaveforms,
+  Array2D<bool>& selectVals,
+  Array2D<bool>& roi,
+  const unsigned int window,
+  const float thresholdFactor) const
+{
+  getSelectVals<float>(waveforms, morphedWaveforms, selectVals,
+    roi, window, thresholdFactor);
+}
+
+void icarussigproc::Denoising::getSelectVals(
+  const Array2DView<const double> waveforms,
+  const Array2DView<const double> morphedWaveforms,
+  Array2D<bool>& selectVals,
+  Array2D<bool>& roi,
+  const unsigned int window,
+  const float thresholdFactor) const
+{
+  getSelectVals<double>(waveforms, morphedWaveforms, selectVals,
+    roi, window, thresholdFactor);
+}
+
+template <typename T, typename InArray, typename MorphArray,
+  typename MaskArray>
+void icarussigproc::Denoising::getSelectVals(
+  const InArray& waveforms,
+  const MorphArray& morphedWaveforms,
+  MaskArray& selectVals,
+  MaskArray& roi,
+  const unsigned int window,
+  const float thresholdFactor) const
+{
+  auto numChannels = numRows(waveforms);
+  auto nTicks = numCols(waveforms);
+
+  parallelFor(numChannels, kBandRows,
+    [&](size_t begin, size_t end, unsigned int) {
+      std::vector<T> localVec;
+      for (size_t i=begin; i<end; ++i) {
+        // The rms about the median is accumulated in the same pass that would
+        // have filled a median subtracted copy
+        const T* morphed = &morphedWaveforms[i][0];
+        T median = icarussigproc::MiscUtils::computeMedian(
+          morphed, morphed + nTicks, localVec);
+        double sumSq = 0.;
+        for (size_t j=0; j<nTicks; ++j) {
+          T diff = morphed[j] - median;
+          sumSq += diff * diff;
+        }
+        float rms;
+        rms = std::sqrt(sumSq / float(nTicks));
+        float threshold;
+        threshold = thresholdFactor * rms;
+
+        // Reused output buffers must not keep the ROI of a previous call
+        for (size_t j=0; j<nTicks; ++j) roi[i][j] = false;
+        for (size_t j=0; j<nTicks; ++j) {
+          if (std::fabs(morphed[j]) > threshold) {
+            // Check Bounds
+            selectVals[i][j] = true;
+            int lb = j - (int) window;
+            int ub = j + (int) window + 1;
+            size_t lowerBound = std::max(lb, 0);
+            size_t upperBound = std::min(ub, (int) nTicks);
+            for (size_t k=lowerBound; k<upperBound; ++k) {
+              roi[i][k] = true;
+            }
+          } else {
+            selectVals[i][j] = false;
+          }
         }
-      } else {
-        selectVals[i][j] = false;
       }
-    }
-  }
+    }, fNumThreads);
   return;
 }
 
@@ -111,7 +194,7 @@ void icarussigproc::Denoising::removeCoherentNoise1D(
   const unsigned int grouping,
   const unsigned int structuringElement,
   const unsigned int window,
-  const float thresholdFactor)
+  const float thresholdFactor) const
 {
   removeCoherentNoise1D<short>(
     waveLessCoherent, filteredWaveforms, morphedWaveforms, 
@@ -132,7 +215,7 @@ void icarussigproc::Denoising::removeCoherentNoise1D(
   const unsigned int grouping,
   const unsigned int structuringElement,
   const unsigned int window,
-  const float thresholdFactor)
+  const float thresholdFactor) const
 {
   removeCoherentNoise1D<float>(
     waveLessCoherent, filteredWaveforms, morphedWaveforms, 
@@ -153,7 +236,7 @@ void icarussigproc::Denoising::removeCoherentNoise1D(
   const unsigned int grouping,
   const unsigned int structuringElement,
   const unsigned int window,
-  const float thresholdFactor)
+  const float thresholdFactor) const
 {
   removeCoherentNoise1D<double>(
     waveLessCoherent, filteredWaveforms, morphedWaveforms, 
@@ -162,146 +245,266 @@ void icarussigproc::Denoising::removeCoherentNoise1D(
   return;
 }
 
-template <typename T>
 void icarussigproc::Denoising::removeCoherentNoise1D(
-  std::vector<std::vector<T>>& waveLessCoherent,
-  const std::vector<std::vector<T>>& filteredWaveforms,
-  std::vector<std::vector<T>>& morphedWaveforms,
-  std::vector<std::vector<T>>& intrinsicRMS,
-  ArrayBool& selectVals,
-  ArrayBool& roi,
-  std::vector<std::vector<T>>& correctedMedians,
+  Array2D<short>& waveLessCoherent,
+  const Array2DView<const short> filteredWaveforms,
+  Array2D<short>& morphedWaveforms,
+  Array2D<short>& intrinsicRMS,
+  Array2D<bool>& selectVals,
+  Array2D<bool>& roi,
+  Array2D<short>& correctedMedians,
+  const char filterName,
+  const unsigned int grouping,
+  const unsigned int structuringElement,
+  const unsigned int window,
+  const float thresholdFactor) const
+{
+  removeCoherentNoise1D<short>(
+    waveLessCoherent, filteredWaveforms, morphedWaveforms, 
+    intrinsicRMS, selectVals, roi, correctedMedians,
+    filterName, grouping, structuringElement, window, thresholdFactor);
+  return;
+}
+
+void icarussigproc::Denoising::removeCoherentNoise1D(
+  Array2D<float>& waveLessCoherent,
+  const Array2DView<const float> filteredWaveforms,
+  Array2D<float>& morphedWaveforms,
+  Array2D<float>& intrinsicRMS,
+  Array2D<bool>& selectVals,
+  Array2D<bool>& roi,
+  Array2D<float>& correctedMedians,
+  const char filterName,
+  const unsigned int grouping,
+  const unsigned int structuringElement,
+  const unsigned int window,
+  const float thresholdFactor) const
+{
+  removeCoherentNoise1D<float>(
+    waveLessCoherent, filteredWaveforms, morphedWaveforms, 
+    intrinsicRMS, selectVals, roi, correctedMedians,
+    filterName, grouping, structuringElement, window, thresholdFactor);
+  return;
+}
+
+void icarussigproc::Denoising::removeCoherentNoise1D(
+  Array2D<double>& waveLessCoherent,
+  const Array2DView<const double> filteredWaveforms,
+  Array2D<double>& morphedWaveforms,
+  Array2D<double>& intrinsicRMS,
+  Array2D<bool>& selectVals,
+  Array2D<bool>& roi,
+  Array2D<double>& correctedMedians,
+  const char filterName,
+  const unsigned int grouping,
+  const unsigned int structuringElement,
+  const unsigned int window,
+  const float thresholdFactor) const
+{
+  removeCoherentNoise1D<double>(
+    waveLessCoherent, filteredWaveforms, morphedWaveforms, 
+    intrinsicRMS, selectVals, roi, correctedMedians,
+    filterName, grouping, structuringElement, window, thresholdFactor);
+  return;
+}
+
+void icarussigproc::Denoising::removeCoherentNoise1D(
+  Array2DView<short> waveLessCoherent,
+  const Array2DView<const short> filteredWaveforms,
+  Array2DView<short> morphedWaveforms,
+  Array2DView<short> intrinsicRMS,
+  Array2DView<bool> selectVals,
+  Array2DView<bool> roi,
+  Array2DView<short> correctedMedians,
+  const char filterName,
+  const unsigned int grouping,
+  const unsigned int structuringElement,
+  const unsigned int window,
+  const float thresholdFactor) const
+{
+  removeCoherentNoise1D<short>(
+    waveLessCoherent, filteredWaveforms, morphedWaveforms, 
+    intrinsicRMS, selectVals, roi, correctedMedians,
+    filterName, grouping, structuringElement, window, thresholdFactor);
+  return;
+}
+
+void icarussigproc::Denoising::removeCoherentNoise1D(
+  Array2DView<float> waveLessCoherent,
+  const Array2DView<const float> filteredWaveforms,
+  Array2DView<float> morphedWaveforms,
+  Array2DView<float> intrinsicRMS,
+  Array2DView<bool> selectVals,
+  Array2DView<bool> roi,
+  Array2DView<float> correctedMedians,
+  const char filterName,
+  const unsigned int grouping,
+  const unsigned int structuringElement,
+  const unsigned int window,
+  const float thresholdFactor) const
+{
+  removeCoherentNoise1D<float>(
+    waveLessCoherent, filteredWaveforms, morphedWaveforms, 
+    intrinsicRMS, selectVals, roi, correctedMedians,
+    filterName, grouping, structuringElement, window, thresholdFactor);
+  return;
+}
+
+void icarussigproc::Denoising::removeCoherentNoise1D(
+  Array2DView<double> waveLessCoherent,
+  const Array2DView<const double> filteredWaveforms,
+  Array2DView<double> morphedWaveforms,
+  Array2DView<double> intrinsicRMS,
+  Array2DView<bool> selectVals,
+  Array2DView<bool> roi,
+  Array2DView<double> correctedMedians,
+  const char filterName,
+  const unsigned int grouping,
+  const unsigned int structuringElement,
+  const unsigned int window,
+  const float thresholdFactor) const
+{
+  removeCoherentNoise1D<double>(
+    waveLessCoherent, filteredWaveforms, morphedWaveforms, 
+    intrinsicRMS, selectVals, roi, correctedMedians,
+    filterName, grouping, structuringElement, window, thresholdFactor);
+  return;
+}
+
+template <typename T, typename OutArray, typename InArray, typename MaskArray>
+void icarussigproc::Denoising::removeCoherentNoise1D(
+  OutArray& waveLessCoherent,
+  const InArray& filteredWaveforms,
+  OutArray& morphedWaveforms,
+  OutArray& intrinsicRMS,
+  MaskArray& selectVals,
+  MaskArray& roi,
+  OutArray& correctedMedians,
   const char filterName,
   const unsigned int grouping,
   const unsigned int structuringElement,
   const unsigned int window,
-  const float thresholdFactor)
+  const float thresholdFactor) const
 {
-  auto numChannels = filteredWaveforms.size();
-  auto nTicks = filteredWaveforms.at(0).size();
-  auto nGroups = numChannels / grouping;
+  auto numChannels = numRows(filteredWaveforms);
+  auto nTicks = numCols(filteredWaveforms);
+  // A trailing partial group is processed as a group of its own
+  auto nGroups = (numChannels + grouping - 1) / grouping;
+  size_t numSamples = numChannels * nTicks;
+  size_t numGroupSamples = nGroups * nTicks;
 
   // Coherent noise subtracted denoised waveforms
-  waveLessCoherent.resize(filteredWaveforms.size());
-  for (auto& v : waveLessCoherent) {
-    v.resize(filteredWaveforms.at(0).size());
-  }
+  resize2D(waveLessCoherent, numChannels, nTicks);
 
   // Waveform with morphological filter applied
-  morphedWaveforms.resize(filteredWaveforms.size());
-  for (auto& v : morphedWaveforms) {
-    v.resize(filteredWaveforms.at(0).size());
-  }
+  resize2D(morphedWaveforms, numChannels, nTicks);
 
   // Regions to protect waveform from coherent noise subtraction.
-  selectVals.resize(filteredWaveforms.size());
-  for (auto& v : selectVals) {
-    v.resize(filteredWaveforms.at(0).size());
-  }
+  resize2D(selectVals, numChannels, nTicks);
 
-  roi.resize(filteredWaveforms.size());
-  for (auto& v : roi) {
-    v.resize(filteredWaveforms.at(0).size());
-  }
+  resize2D(roi, numChannels, nTicks);
 
-  correctedMedians.resize(nGroups);
-  for (auto& v : correctedMedians) {
-    v.resize(nTicks);
-  }
+  resize2D(correctedMedians, nGroups, nTicks);
 
-  intrinsicRMS.resize(nGroups);
-  for (auto& v : intrinsicRMS) {
-    v.resize(nTicks);
-  }
+  resize2D(intrinsicRMS, nGroups, nTicks);
 
   icarussigproc::Morph1D denoiser;
 
-  switch (filterName) {
-    case 'd':
-      for (size_t i=0; i<numChannels; ++i) {
-        denoiser.getDilation(filteredWaveforms[i],
-          structuringElement, morphedWaveforms[i]);
-      };
-      break;
-    case 'e':
-      for (size_t i=0; i<numChannels; ++i) {
-        denoiser.getErosion(filteredWaveforms[i],
-          structuringElement, morphedWaveforms[i]);
-      };
-      break;
-    case 'a':
-      for (size_t i=0; i<numChannels; ++i) {
-        denoiser.getAverage(filteredWaveforms[i],
-          structuringElement, morphedWaveforms[i]);
-      };
-      break;
-    case 'g':
-      for (size_t i=0; i<numChannels; ++i) {
-        denoiser.getGradient(filteredWaveforms[i],
-          structuringElement, morphedWaveforms[i]);
-      };
-      break;
-    default:
-      for (size_t i=0; i<numChannels; ++i) {
-        denoiser.getDilation(filteredWaveforms[i],
-          structuringElement, morphedWaveforms[i]);
-      };
-      break;
+  {
+    SIGPROC_PHASE("Denoising1D::morphology", numSamples,
+      2 * numSamples * sizeof(T));
+    switch (filterName) {
+      case 'd':
+        applyToRows<T>(filteredWaveforms, morphedWaveforms,
+          [&](const T* in, size_t n, T* out) {
+            denoiser.getDilation(in, n, structuringElement, out); },
+          fNumThreads);
+        break;
+      case 'e':
+        applyToRows<T>(filteredWaveforms, morphedWaveforms,
+          [&](const T* in, size_t n, T* out) {
+            denoiser.getErosion(in, n, structuringElement, out); },
+          fNumThreads);
+        break;
+      case 'a':
+        applyToRows<T>(filteredWaveforms, morphedWaveforms,
+          [&](const T* in, size_t n, T* out) {
+            denoiser.getAverage(in, n, structuringElement, out); },
+          fNumThreads);
+        break;
+      case 'g':
+        applyToRows<T>(filteredWaveforms, morphedWaveforms,
+          [&](const T* in, size_t n, T* out) {
+            denoiser.getGradient(in, n, structuringElement, out); },
+          fNumThreads);
+        break;
+      default:
+        applyToRows<T>(filteredWaveforms, morphedWaveforms,
+          [&](const T* in, size_t n, T* out) {
+            denoiser.getDilation(in, n, structuringElement, out); },
+          fNumThreads);
+        break;
+    }
   }
 
-  getSelectVals(filteredWaveforms, morphedWaveforms, 
-    selectVals, roi, window, thresholdFactor);
+  {
+    SIGPROC_PHASE("Denoising1D::selection", numSamples,
+      2 * numSamples * (sizeof(T) + sizeof(bool)));
+    getSelectVals<T>(filteredWaveforms, morphedWaveforms,
+      selectVals, roi, window, thresholdFactor);
+  }
 
-  for (size_t i=0; i<nTicks; ++i) {
-    for (size_t j=0; j<nGroups; ++j) {
-      size_t group_start = j * grouping;
-      size_t group_end = (j+1) * grouping;
-      // Compute median.
+  // Groups are independent: one task per group, each with its own scratch
+  {
+    SIGPROC_PHASE("Denoising1D::median", numSamples,
+      numSamples * (2 * sizeof(T) + sizeof(bool)) +
+      numGroupSamples * sizeof(T));
+    parallelFor(nGroups, 1, [&](size_t begin, size_t end, unsigned int) {
       std::vector<T> v;
-      for (size_t c=group_start; c<group_end; ++c) {
-        if (!selectVals[c][i]) {
-          v.push_back(filteredWaveforms[c][i]);
+      v.reserve(grouping);
+      for (size_t j=begin; j<end; ++j) {
+        size_t group_start = j * grouping;
+        size_t group_end = std::min((j+1) * grouping, size_t(numChannels));
+        for (size_t i=0; i<nTicks; ++i) {
+          // Compute median.
+          v.clear();
+          for (size_t c=group_start; c<group_end; ++c) {
+            if (!selectVals[c][i]) {
+              v.push_back(filteredWaveforms[c][i]);
+            }
+          }
+          T median = icarussigproc::MiscUtils::computeMedianInPlace(
+            v.begin(), v.end());
+          correctedMedians[j][i] = median;
         }
-      }
-      T median = (T) 0;
-      if (v.size() > 0) {
-        if (v.size() % 2 == 0) {
-          const auto m1 = v.begin() + v.size() / 2 - 1;
-          const auto m2 = v.begin() + v.size() / 2;
-          std::nth_element(v.begin(), m1, v.end());
-          const auto e1 = *m1;
-          std::nth_element(v.begin(), m2, v.end());
-          const auto e2 = *m2;
-          median = (e1 + e2) / 2.0;
-        } else {
-          const auto m = v.begin() + v.size() / 2;
-          std::nth_element(v.begin(), m, v.end());
-          median = *m;
-        }
-      }
-      correctedMedians[j][i] = median;
-      for (auto k=group_start; k<group_end; ++k) {
-        if (!selectVals[k][i]) {
-          waveLessCoherent[k][i] = filteredWaveforms[k][i] - median;
-        } else {
-          waveLessCoherent[k][i] = filteredWaveforms[k][i];
+        for (auto k=group_start; k<group_end; ++k) {
+          subtractMedians<T>(filteredWaveforms[k], correctedMedians[j],
+            selectVals[k], waveLessCoherent[k], nTicks);
         }
       }
-    }
+    }, fNumThreads);
   }
 
-  T rms = (T) 0;
-  for (size_t i=0; i<nGroups; ++i) {
-    for (size_t j=0; j<nTicks; ++j) {
+  {
+    SIGPROC_PHASE("Denoising1D::rms", numSamples,
+      numSamples * sizeof(T) + numGroupSamples * sizeof(T));
+    parallelFor(nGroups, 1, [&](size_t begin, size_t end, unsigned int) {
       std::vector<T> v;
-      for (size_t k=i*grouping; k<(i+1)*grouping; ++k) {
-        v.push_back(waveLessCoherent[k][j]);
+      v.reserve(grouping);
+      T rms = (T) 0;
+      for (size_t i=begin; i<end; ++i) {
+        for (size_t j=0; j<nTicks; ++j) {
+          v.clear();
+          for (size_t k=i*grouping; k<std::min((i+1)*grouping, size_t(numChannels)); ++k) {
+            v.push_back(waveLessCoherent[k][j]);
+          }
+          rms = std::sqrt(
+            std::inner_product(
+              v.begin(), v.end(), v.begin(), 0.) / T(v.size()));
+          intrinsicRMS[i][j] = (T) rms;
+        }
       }
-      rms = std::sqrt(
-        std::inner_product(
-          v.begin(), v.end(), v.begin(), 0.) / T(v.size()));
-      intrinsicRMS[i][j] = (T) rms;
-    }
+    }, fNumThreads);
   }
   return;
 }
@@ -320,7 +523,7 @@ void icarussigproc::Denoising::removeCoherentNoise2D(
   const unsigned int structuringElementx,
   const unsigned int structuringElementy,
   const unsigned int window,
-  const float thresholdFactor)
+  const float thresholdFactor) const
 {
   removeCoherentNoise2D<short>(
     waveLessCoherent, filteredWaveforms, morphedWaveforms, 
@@ -343,7 +546,7 @@ void icarussigproc::Denoising::removeCoherentNoise2D(
   const unsigned int structuringElementx,
   const unsigned int structuringElementy,
   const unsigned int window,
-  const float thresholdFactor)
+  const float thresholdFactor) const
 {
   removeCoherentNoise2D<float>(
     waveLessCoherent, filteredWaveforms, morphedWaveforms, 
@@ -366,7 +569,7 @@ void icarussigproc::Denoising::removeCoherentNoise2D(
   const unsigned int structuringElementx,
   const unsigned int structuringElementy,
   const unsigned int window,
-  const float thresholdFactor)
+  const float thresholdFactor) const
 {
   removeCoherentNoise2D<double>(
     waveLessCoherent, filteredWaveforms, morphedWaveforms, 
@@ -376,141 +579,208 @@ void icarussigproc::Denoising::removeCoherentNoise2D(
   return;
 }
 
-template <typename T>
 void icarussigproc::Denoising::removeCoherentNoise2D(
-  std::vector<std::vector<T>>& waveLessCoherent,
-  const std::vector<std::vector<T>>& filteredWaveforms,
-  std::vector<std::vector<T>>& morphedWaveforms,
-  std::vector<std::vector<T>>& intrinsicRMS,
-  ArrayBool& selectVals,
-  ArrayBool& roi,
-  std::vector<std::vector<T>>& correctedMedians,
+  Array2D<short>& waveLessCoherent,
+  const Array2DView<const short> filteredWaveforms,
+  Array2D<short>& morphedWaveforms,
+  Array2D<short>& intrinsicRMS,
+  Array2D<bool>& selectVals,
+  Array2D<bool>& roi,
+  Array2D<short>& correctedMedians,
+  const char filterName,
+  const unsigned int grouping,
+  const unsigned int structuringElementx,
+  const unsigned int structuringElementy,
+  const unsigned int window,
+  const float thresholdFactor) const
+{
+  removeCoherentNoise2D<short>(
+    waveLessCoherent, filteredWaveforms, morphedWaveforms, 
+    intrinsicRMS, selectVals, roi, correctedMedians,
+    filterName, grouping, structuringElementx, structuringElementy, 
+    window, thresholdFactor);
+  return;
+}
+
+void icarussigproc::Denoising::removeCoherentNoise2D(
+  Array2D<float>& waveLessCoherent,
+  const Array2DView<const float> filteredWaveforms,
+  Array2D<float>& morphedWaveforms,
+  Array2D<float>& intrinsicRMS,
+  Array2D<bool>& selectVals,
+  Array2D<bool>& roi,
+  Array2D<float>& correctedMedians,
+  const char filterName,
+  const unsigned int grouping,
+  const unsigned int structuringElementx,
+  const unsigned int structuringElementy,
+  const unsigned int window,
+  const float thresholdFactor) const
+{
+  removeCoherentNoise2D<float>(
+    waveLessCoherent, filteredWaveforms, morphedWaveforms, 
+    intrinsicRMS, selectVals, roi, correctedMedians,
+    filterName, grouping, structuringElementx, structuringElementy, 
+    window, thresholdFactor);
+  return;
+}
+
+void icarussigproc::Denoising::removeCoherentNoise2D(
+  Array2D<double>& waveLessCoherent,
+  const Array2DView<const double> filteredWaveforms,
+  Array2D<double>& morphedWaveforms,
+  Array2D<double>& intrinsicRMS,
+  Array2D<bool>& selectVals,
+  Array2D<bool>& roi,
+  Array2D<double>& correctedMedians,
+  const char filterName,
+  const unsigned int grouping,
+  const unsigned int structuringElementx,
+  const unsigned int structuringElementy,
+  const unsigned int window,
+  const float thresholdFactor) const
+{
+  removeCoherentNoise2D<double>(
+    waveLessCoherent, filteredWaveforms, morphedWaveforms, 
+    intrinsicRMS, selectVals, roi, correctedMedians,
+    filterName, grouping, structuringElementx, structuringElementy, 
+    window, thresholdFactor);
+  return;
+}
+
+template <typename T, typename OutArray, typename InArray, typename MaskArray>
+void icarussigproc::Denoising::removeCoherentNoise2D(
+  OutArray& waveLessCoherent,
+  const InArray& filteredWaveforms,
+  OutArray& morphedWaveforms,
+  OutArray& intrinsicRMS,
+  MaskArray& selectVals,
+  MaskArray& roi,
+  OutArray& correctedMedians,
   const char filterName,
   const unsigned int grouping,
   const unsigned int structuringElementx,
   const unsigned int structuringElementy,
   const unsigned int window,
-  const float thresholdFactor)
+  const float thresholdFactor) const
 {
-  auto numChannels = filteredWaveforms.size();
-  auto nTicks = filteredWaveforms.at(0).size();
-  auto nGroups = numChannels / grouping;
+  auto numChannels = numRows(filteredWaveforms);
+  auto nTicks = numCols(filteredWaveforms);
+  // A trailing partial group is processed as a group of its own
+  auto nGroups = (numChannels + grouping - 1) / grouping;
+  size_t numSamples = numChannels * nTicks;
+  size_t numGroupSamples = nGroups * nTicks;
 
   // Coherent noise subtracted denoised waveforms
-  waveLessCoherent.resize(filteredWaveforms.size());
-  for (auto& v : waveLessCoherent) {
-    v.resize(filteredWaveforms.at(0).size());
-  }
+  resize2D(waveLessCoherent, numChannels, nTicks);
 
   // Regions to protect waveform from coherent noise subtraction.
-  selectVals.resize(filteredWaveforms.size());
-  for (auto& v : selectVals) {
-    v.resize(filteredWaveforms.at(0).size());
-  }
+  resize2D(selectVals, numChannels, nTicks);
 
-  roi.resize(filteredWaveforms.size());
-  for (auto& v : roi) {
-    v.resize(filteredWaveforms.at(0).size());
-  }
+  resize2D(roi, numChannels, nTicks);
 
-  correctedMedians.resize(nGroups);
-  for (auto& v : correctedMedians) {
-    v.resize(nTicks);
-  }
+  resize2D(correctedMedians, nGroups, nTicks);
 
-  intrinsicRMS.resize(nGroups);
-  for (auto& v : intrinsicRMS) {
-    v.resize(nTicks);
-  }
+  resize2D(intrinsicRMS, nGroups, nTicks);
 
   icarussigproc::Morph2D denoiser;
+  denoiser.setNumThreads(fNumThreads);
+
+  OutArray dilation;
+  OutArray erosion;
+  OutArray average;
+  OutArray gradient;
+
+  {
+    SIGPROC_PHASE("Denoising2D::morphology", numSamples,
+      2 * numSamples * sizeof(T));
+    denoiser.getFilter2D(filteredWaveforms, structuringElementx,
+      structuringElementy, dilation, erosion, average, gradient);
+  }
 
-  std::vector<std::vector<T>> dilation;
-  std::vector<std::vector<T>> erosion;
-  std::vector<std::vector<T>> average;
-  std::vector<std::vector<T>> gradient;
-
-  denoiser.getFilter2D(filteredWaveforms, structuringElementx,
-    structuringElementy, dilation, erosion, average, gradient);
-
-  switch (filterName) {
-    case 'd':
-      getSelectVals(filteredWaveforms, dilation, 
-        selectVals, roi, window, thresholdFactor);
-      morphedWaveforms = dilation;
-      break;
-    case 'e':
-      getSelectVals(filteredWaveforms, erosion, 
-        selectVals, roi, window, thresholdFactor);
-      morphedWaveforms = erosion;
-      break;
-    case 'a':
-      getSelectVals(filteredWaveforms, average, 
-        selectVals, roi, window, thresholdFactor);
-      morphedWaveforms = average;
-      break;
-    case 'g':
-      getSelectVals(filteredWaveforms, gradient, 
-        selectVals, roi, window, thresholdFactor);
-      morphedWaveforms = gradient;
-      break;
-    default:
-      getSelectVals(filteredWaveforms, gradient, 
-        selectVals, roi, window, thresholdFactor);
-      morphedWaveforms = gradient;
-      break;
+  {
+    SIGPROC_PHASE("Denoising2D::selection", numSamples,
+      2 * numSamples * (sizeof(T) + sizeof(bool)));
+    switch (filterName) {
+      case 'd':
+        getSelectVals<T>(filteredWaveforms, dilation,
+          selectVals, roi, window, thresholdFactor);
+        morphedWaveforms = std::move(dilation);
+        break;
+      case 'e':
+        getSelectVals<T>(filteredWaveforms, erosion,
+          selectVals, roi, window, thresholdFactor);
+        morphedWaveforms = std::move(erosion);
+        break;
+      case 'a':
+        getSelectVals<T>(filteredWaveforms, average,
+          selectVals, roi, window, thresholdFactor);
+        morphedWaveforms = std::move(average);
+        break;
+      case 'g':
+        getSelectVals<T>(filteredWaveforms, gradient,
+          selectVals, roi, window, thresholdFactor);
+        morphedWaveforms = std::move(gradient);
+        break;
+      default:
+        getSelectVals<T>(filteredWaveforms, gradient,
+          selectVals, roi, window, thresholdFactor);
+        morphedWaveforms = std::move(gradient);
+        break;
+    }
   }
 
-  for (size_t i=0; i<nTicks; ++i) {
-    for (size_t j=0; j<nGroups; ++j) {
-      size_t group_start = j * grouping;
-      size_t group_end = (j+1) * grouping;
-      // Compute median.
+  // Groups are independent: one task per group, each with its own scratch
+  {
+    SIGPROC_PHASE("Denoising2D::median", numSamples,
+      numSamples * (2 * sizeof(T) + sizeof(bool)) +
+      numGroupSamples * sizeof(T));
+    parallelFor(nGroups, 1, [&](size_t begin, size_t end, unsigned int) {
       std::vector<T> v;
-      for (size_t c=group_start; c<group_end; ++c) {
-        if (!selectVals[c][i]) {
-          v.push_back(filteredWaveforms[c][i]);
+      v.reserve(grouping);
+      for (size_t j=begin; j<end; ++j) {
+        size_t group_start = j * grouping;
+        size_t group_end = std::min((j+1) * grouping, size_t(numChannels));
+        for (size_t i=0; i<nTicks; ++i) {
+          // Compute median.
+          v.clear();
+          for (size_t c=group_start; c<group_end; ++c) {
+            if (!selectVals[c][i]) {
+              v.push_back(filteredWaveforms[c][i]);
+            }
+          }
+          T median = icarussigproc::MiscUtils::computeMedianInPlace(
+            v.begin(), v.end());
+          correctedMedians[j][i] = median;
         }
-      }
-      T median = (T) 0.0;
-      if (v.size() > 0) {
-        if (v.size() % 2 == 0) {
-          const auto m1 = v.begin() + v.size() / 2 - 1;
-          const auto m2 = v.begin() + v.size() / 2;
-          std::nth_element(v.begin(), m1, v.end());
-          const auto e1 = *m1;
-          std::nth_element(v.begin(), m2, v.end());
-          const auto e2 = *m2;
-          median = (e1 + e2) / 2.0;
-        } else {
-          const auto m = v.begin() + v.size() / 2;
-          std::nth_element(v.begin(), m, v.end());
-          median = *m;
-        }
-      }
-      correctedMedians[j][i] = median;
-      for (size_t k=group_start; k<group_end; ++k) {
-        if (!selectVals[k][i]) {
-          waveLessCoherent[k][i] = filteredWaveforms[k][i] - median;
-        } else {
-          waveLessCoherent[k][i] = filteredWaveforms[k][i];
+        for (size_t k=group_start; k<group_end; ++k) {
+          subtractMedians<T>(filteredWaveforms[k], correctedMedians[j],
+            selectVals[k], waveLessCoherent[k], nTicks);
         }
       }
-    }
+    }, fNumThreads);
   }
 
-  float rms = 0.0;
-  for (size_t i=0; i<nGroups; ++i) {
-    for (size_t j=0; j<nTicks; ++j) {
+  {
+    SIGPROC_PHASE("Denoising2D::rms", numSamples,
+      numSamples * sizeof(T) + numGroupSamples * sizeof(T));
+    parallelFor(nGroups, 1, [&](size_t begin, size_t end, unsigned int) {
       std::vector<T> v;
-      for (size_t k=i*grouping; k<(i+1)*grouping; ++k) {
-        v.push_back(waveLessCoherent[k][j]);
+      v.reserve(grouping);
+      float rms = 0.0;
+      for (size_t i=begin; i<end; ++i) {
+        for (size_t j=0; j<nTicks; ++j) {
+          v.clear();
+          for (size_t k=i*grouping; k<std::min((i+1)*grouping, size_t(numChannels)); ++k) {
+            v.push_back(waveLessCoherent[k][j]);
+          }
+          rms = std::sqrt(
+            std::inner_product(
+              v.begin(), v.end(), v.begin(), 0.) / T(v.size()));
+          intrinsicRMS[i][j] = (T) rms;
+        }
       }
-      rms = std::sqrt(
-        std::inner_product(
-          v.begin(), v.end(), v.begin(), 0.) / T(v.size()));
-      intrinsicRMS[i][j] = (T) rms;
-    }
+    }, fNumThreads);
   }
   return;
 }
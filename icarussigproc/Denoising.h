@@ -24,6 +24,8 @@
 #include <functional>
 #include "Morph1D.h"
 #include "Morph2D.h"
+#include "MiscUtils.h"
+#include "Array2D.h"
 
 namespace icarussigproc {
 
@@ -31,6 +33,8 @@ namespace icarussigproc {
      \class Denoising
      User defined class Denoising ... these comments are used to generate
      doxygen documentation!
+     All kernels are const; outputs are fully rewritten by each call, so
+     concurrent calls on one instance only need distinct output arrays.
   */
   class Denoising{
     
@@ -56,7 +60,7 @@ namespace icarussigproc {
         ArrayBool&,
         ArrayBool&,
         const unsigned int,
-        const float);
+        const float) const;
 
       void getSelectVals(
         const ArrayFloat&,
@@ -64,7 +68,7 @@ namespace icarussigproc {
         ArrayBool&,
         ArrayBool&,
         const unsigned int,
-        const float);
+        const float) const;
 
       void getSelectVals(
         const ArrayDouble&,
@@ -72,7 +76,31 @@ namespace icarussigproc {
         ArrayBool&,
         ArrayBool&,
         const unsigned int,
-        const float);
+        const float) const;
+
+      void getSelectVals(
+        const Array2DView<const short>,
+        const Array2DView<const short>,
+        Array2D<bool>&,
+        Array2D<bool>&,
+        const unsigned int,
+        const float) const;
+
+      void getSelectVals(
+        const Array2DView<const float>,
+        const Array2DView<const float>,
+        Array2D<bool>&,
+        Array2D<bool>&,
+        const unsigned int,
+        const float) const;
+
+      void getSelectVals(
+        const Array2DView<const double>,
+        const Array2DView<const double>,
+        Array2D<bool>&,
+        Array2D<bool>&,
+        const unsigned int,
+        const float) const;
 
 
       void removeCoherentNoise1D(
@@ -88,7 +116,7 @@ namespace icarussigproc {
         const unsigned int,
         const unsigned int,
         const float 
-      );
+      ) const;
 
       void removeCoherentNoise1D(
         ArrayFloat&,
@@ -103,7 +131,7 @@ namespace icarussigproc {
         const unsigned int,
         const unsigned int,
         const float 
-      );
+      ) const;
 
       void removeCoherentNoise1D(
         ArrayDouble&, 
@@ -118,7 +146,100 @@ namespace icarussigproc {
         const unsigned int,
         const unsigned int,
         const float 
-      );
+      ) const;
+
+      void removeCoherentNoise1D(
+        Array2D<short>&,
+        const Array2DView<const short>,
+        Array2D<short>&,
+        Array2D<short>&,
+        Array2D<bool>&,
+        Array2D<bool>&,
+        Array2D<short>&,
+        const char,
+        const unsigned int,
+        const unsigned int,
+        const unsigned int,
+        const float 
+      ) const;
+
+      void removeCoherentNoise1D(
+        Array2D<float>&,
+        const Array2DView<const float>,
+        Array2D<float>&,
+        Array2D<float>&,
+        Array2D<bool>&,
+        Array2D<bool>&,
+        Array2D<float>&,
+        const char,
+        const unsigned int,
+        const unsigned int,
+        const unsigned int,
+        const float 
+      ) const;
+
+      void removeCoherentNoise1D(
+        Array2D<double>&, 
+        const Array2DView<const double>,
+        Array2D<double>&,
+        Array2D<double>&,
+        Array2D<bool>&,
+        Array2D<bool>&,
+        Array2D<double>&,
+        const char,
+        const unsigned int,
+        const unsigned int,
+        const unsigned int,
+        const float 
+      ) const;
+
+      /// Versions writing into existing views, e.g. a band of grouping rows
+      /// of larger planes (one row for the group outputs); the shapes must
+      /// already match
+      void removeCoherentNoise1D(
+        Array2DView<short>,
+        const Array2DView<const short>,
+        Array2DView<short>,
+        Array2DView<short>,
+        Array2DView<bool>,
+        Array2DView<bool>,
+        Array2DView<short>,
+        const char,
+        const unsigned int,
+        const unsigned int,
+        const unsigned int,
+        const float 
+      ) const;
+
+      void removeCoherentNoise1D(
+        Array2DView<float>,
+        const Array2DView<const float>,
+        Array2DView<float>,
+        Array2DView<float>,
+        Array2DView<bool>,
+        Array2DView<bool>,
+        Array2DView<float>,
+        const char,
+        const unsigned int,
+        const unsigned int,
+        const unsigned int,
+        const float 
+      ) const;
+
+      void removeCoherentNoise1D(
+        Array2DView<double>,
+        const Array2DView<const double>,
+        Array2DView<double>,
+        Array2DView<double>,
+        Array2DView<bool>,
+        Array2DView<bool>,
+        Array2DView<double>,
+        const char,
+        const unsigned int,
+        const unsigned int,
+        const unsigned int,
+        const float 
+      ) const;
 
 
       void removeCoherentNoise2D(
@@ -134,7 +255,7 @@ namespace icarussigproc {
         const unsigned int,
         const unsigned int,
         const unsigned int,
-        const float);
+        const float) const;
 
       void removeCoherentNoise2D(
         ArrayFloat&,
@@ -149,7 +270,7 @@ namespace icarussigproc {
         const unsigned int,
         const unsigned int,
         const unsigned int,
-        const float);
+        const float) const;
 
       void removeCoherentNoise2D(
         ArrayDouble&, 
@@ -164,56 +285,109 @@ namespace icarussigproc {
         const unsigned int,
         const unsigned int,
         const unsigned int,
-        const float);
+        const float) const;
+
+      void removeCoherentNoise2D(
+        Array2D<short>&,
+        const Array2DView<const short>, 
+        Array2D<short>&,
+        Array2D<short>&,
+        Array2D<bool>&,
+        Array2D<bool>&,
+        Array2D<short>&,
+        const char, 
+        const unsigned int,
+        const unsigned int,
+        const unsigned int,
+        const unsigned int,
+        const float) const;
+
+      void removeCoherentNoise2D(
+        Array2D<float>&,
+        const Array2DView<const float>, 
+        Array2D<float>&,
+        Array2D<float>&,
+        Array2D<bool>&,
+        Array2D<bool>&,
+        Array2D<float>&,
+        const char, 
+        const unsigned int,
+        const unsigned int,
+        const unsigned int,
+        const unsigned int,
+        const float) const;
 
+      void removeCoherentNoise2D(
+        Array2D<double>&, 
+        const Array2DView<const double>, 
+        Array2D<double>&,
+        Array2D<double>&,
+        Array2D<bool>&,
+        Array2D<bool>&,
+        Array2D<double>&,
+        const char, 
+        const unsigned int,
+        const unsigned int,
+        const unsigned int,
+        const unsigned int,
+        const float) const;
+
+    /// Threads of the parallel loops over channels, 0 for the
+    /// concurrency of the library thread pool
+    void setNumThreads(const unsigned int numThreads) { fNumThreads = numThreads; }
     
     /// Default destructor
     ~Denoising(){}
 
     private:
 
-      template <typename T>
+      template <typename T, typename InArray, typename MorphArray,
+        typename MaskArray>
       void getSelectVals(
-        const std::vector<std::vector<T> >& waveforms,
-        const std::vector<std::vector<T> >& morphedWaveforms,
-        ArrayBool& selectVals,
-        ArrayBool& roi,
+        const InArray& waveforms,
+        const MorphArray& morphedWaveforms,
+        MaskArray& selectVals,
+        MaskArray& roi,
         const unsigned int window,
         const float thresholdFactor
-      );
+      ) const;
 
 
-      template <typename T>
+      template <typename T, typename OutArray, typename InArray,
+        typename MaskArray>
       void removeCoherentNoise1D(
-        std::vector<std::vector<T> >& waveLessCoherent, 
-        const std::vector<std::vector<T> >& filteredWaveforms, 
-        std::vector<std::vector<T> >& morphedWaveforms, 
-        std::vector<std::vector<T> >& intrinsicRMS,
-        ArrayBool& selectVals,
-        ArrayBool& roi,
-        std::vector<std::vector<T> >& correctedMedians,
+        OutArray& waveLessCoherent,
+        const InArray& filteredWaveforms,
+        OutArray& morphedWaveforms,
+        OutArray& intrinsicRMS,
+        MaskArray& selectVals,
+        MaskArray& roi,
+        OutArray& correctedMedians,
         const char filterName='d', 
         const unsigned int grouping=64,
         const unsigned int structuringElement=5,
         const unsigned int window=0,
-        const float thresholdFactor=2.5);
+        const float thresholdFactor=2.5) const;
 
 
-      template <typename T>
+      template <typename T, typename OutArray, typename InArray,
+        typename MaskArray>
       void removeCoherentNoise2D(
-        std::vector<std::vector<T> >& waveLessCoherent, 
-        const std::vector<std::vector<T> >& filteredWaveforms,
-        std::vector<std::vector<T> >& morphedWaveforms, 
-        std::vector<std::vector<T> >& intrinsicRMS,
-        ArrayBool& selectVals,
-        ArrayBool& roi,
-        std::vector<std::vector<T> >& correctedMedians,
+        OutArray& waveLessCoherent,
+        const InArray& filteredWaveforms,
+        OutArray& morphedWaveforms,
+        OutArray& intrinsicRMS,
+        MaskArray& selectVals,
+        MaskArray& roi,
+        OutArray& correctedMedians,
         const char filterName='g',
         const unsigned int grouping=64, 
         const unsigned int structuringElementx=5,
         const unsigned int structuringElementy=20,
         const unsigned int window=0,
-        const float thresholdFactor=2.5);
+        const float thresholdFactor=2.5) const;
+
+      unsigned int fNumThreads = 0;
     
   };
 }
@@ -0,0 +1,39 @@
+#ifndef __SIGPROC_TOOLS_DENORMALSCOPE_CXX__
+#define __SIGPROC_TOOLS_DENORMALSCOPE_CXX__
+
+#include "DenormalScope.h"
+
+#if defined(__SSE2__) || defined(__x86_64__)
+#include <xmmintrin.h>
+// MXCSR flush-to-zero and denormals-are-zero bits
+static const unsigned int kFlushDenormalBits = 0x8040;
+#elif defined(__aarch64__)
+// FPCR flush-to-zero bit (also treats denormal inputs as zero)
+static const unsigned long kFlushDenormalBits = 1UL << 24;
+#endif
+
+icarussigproc::DenormalScope::DenormalScope(const bool enable) :
+  fEnabled(enable),
+  fSavedState(0)
+{
+  if (!fEnabled) return;
+#if defined(__SSE2__) || defined(__x86_64__)
+  fSavedState = _mm_getcsr();
+  _mm_setcsr(fSavedState | kFlushDenormalBits);
+#elif defined(__aarch64__)
+  fSavedState = __builtin_aarch64_get_fpcr();
+  __builtin_aarch64_set_fpcr(fSavedState | kFlushDenormalBits);
+#endif
+}
+
+icarussigproc::DenormalScope::~DenormalScope()
+{
+  if (!fEnabled) return;
+#if defined(__SSE2__) || defined(__x86_64__)
+  _mm_setcsr(fSavedState);
+#elif defined(__aarch64__)
+  __builtin_aarch64_set_fpcr(fSavedState);
+#endif
+}
+
+#endif
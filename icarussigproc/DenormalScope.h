@@ -0,0 +1,46 @@
+/**
+ * \file DenormalScope.h
+ *
+ * \ingroup icarussigproc
+ *
+ * \brief Class def header for a class DenormalScope
+ *
+ */
+
+/** \addtogroup icarussigproc
+
+    @{*/
+#ifndef __SIGPROC_TOOLS_DENORMALSCOPE_H__
+#define __SIGPROC_TOOLS_DENORMALSCOPE_H__
+
+namespace icarussigproc {
+
+  /**
+     \class DenormalScope
+     Sets flush-to-zero and denormals-are-zero on the calling thread for
+     its lifetime and restores the previous floating point control state on
+     destruction. Denormal results (e.g. from near-zero response bins) are
+     then treated as zero instead of taking the slow microcoded path.
+     A no-op when disabled or on unsupported architectures.
+  */
+  class DenormalScope{
+
+    public:
+
+      explicit DenormalScope(const bool enable=true);
+
+      ~DenormalScope();
+
+      DenormalScope(const DenormalScope&) = delete;
+      DenormalScope& operator=(const DenormalScope&) = delete;
+
+    private:
+
+      bool          fEnabled;
+      unsigned long fSavedState;
+  };
+}
+
+#endif
+/** @} */ // end of doxygen group
+
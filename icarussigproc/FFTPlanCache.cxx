@@ -0,0 +1,24 @@
+#ifndef __SIGPROC_TOOLS_FFTPLANCACHE_CXX__
+#define __SIGPROC_TOOLS_FFTPLANCACHE_CXX__
+
+#include "FFTPlanCache.h"
+
+// Size classes are powers of two starting from this length.
+static const size_t kMinSizeClass = 32;
+
+icarussigproc::FFTPlanCache::FFTPlanCache()
+{
+  fFFTFloat.SetFlag(fFFTFloat.HalfSpectrum);
+  fFFTDouble.SetFlag(fFFTDouble.HalfSpectrum);
+}
+
+size_t icarussigproc::FFTPlanCache::getSizeClass(
+  const size_t length,
+  const size_t maxLength) const
+{
+  size_t sizeClass = kMinSizeClass;
+  while (sizeClass < length) sizeClass *= 2;
+  return std::min(sizeClass, maxLength);
+}
+
+#endif
@@ -0,0 +1,68 @@
+/**
+ * \file FFTPlanCache.h
+ *
+ * \ingroup icarussigproc
+ *
+ * \brief Class def header for a class FFTPlanCache
+ *
+ */
+
+/** \addtogroup icarussigproc
+
+    @{*/
+#ifndef __SIGPROC_TOOLS_FFTPLANCACHE_H__
+#define __SIGPROC_TOOLS_FFTPLANCACHE_H__
+
+#include <vector>
+#include <algorithm>
+#include <complex>
+#include <cstddef>
+
+#include <Eigen/Core>
+#include <unsupported/Eigen/FFT>
+
+namespace icarussigproc {
+
+  /**
+     \class FFTPlanCache
+     Holds the FFT engines (and therefore their per-size plans) used by the
+     spectral stages so that plans are built once and reused across calls.
+     The engines keep mutable plan tables: use one cache per thread.
+  */
+  class FFTPlanCache{
+
+    public:
+
+      /// Default constructor
+      FFTPlanCache();
+
+      /// Engine for the requested precision, configured for half spectra
+      template <typename T> Eigen::FFT<T>& getFFT();
+
+      /// Smallest transform size class holding length samples, capped
+      /// at maxLength (which is then used as is)
+      size_t getSizeClass(const size_t length, const size_t maxLength) const;
+
+      /// Default destructor
+      ~FFTPlanCache(){}
+
+    private:
+
+      Eigen::FFT<float>  fFFTFloat;
+      Eigen::FFT<double> fFFTDouble;
+  };
+
+  template <> inline Eigen::FFT<float>& FFTPlanCache::getFFT<float>()
+  {
+    return fFFTFloat;
+  }
+
+  template <> inline Eigen::FFT<double>& FFTPlanCache::getFFT<double>()
+  {
+    return fFFTDouble;
+  }
+}
+
+#endif
+/** @} */ // end of doxygen group
+
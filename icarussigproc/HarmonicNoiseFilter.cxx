@@ -0,0 +1,144 @@
+#ifndef __SIGPROC_TOOLS_HARMONICNOISEFILTER_CXX__
+#define __SIGPROC_TOOLS_HARMONICNOISEFILTER_CXX__
+
+#include "HarmonicNoiseFilter.h"
+
+
+void icarussigproc::HarmonicNoiseFilter::removeHarmonics(
+  ArraySpectrumFloat& spectra,
+  ArrayBins& notchedBins,
+  const char notchMode,
+  const unsigned int grouping,
+  const unsigned int baselineWindow,
+  const float threshold) const
+{
+  removeHarmonics<float>(spectra, notchedBins, notchMode, grouping,
+    baselineWindow, threshold);
+  return;
+}
+
+void icarussigproc::HarmonicNoiseFilter::removeHarmonics(
+  ArraySpectrumDouble& spectra,
+  ArrayBins& notchedBins,
+  const char notchMode,
+  const unsigned int grouping,
+  const unsigned int baselineWindow,
+  const float threshold) const
+{
+  removeHarmonics<double>(spectra, notchedBins, notchMode, grouping,
+    baselineWindow, threshold);
+  return;
+}
+
+void icarussigproc::HarmonicNoiseFilter::removeHarmonics(
+  Array2D<std::complex<float>>& spectra,
+  ArrayBins& notchedBins,
+  const char notchMode,
+  const unsigned int grouping,
+  const unsigned int baselineWindow,
+  const float threshold) const
+{
+  removeHarmonics<float>(spectra, notchedBins, notchMode, grouping,
+    baselineWindow, threshold);
+  return;
+}
+
+void icarussigproc::HarmonicNoiseFilter::removeHarmonics(
+  Array2D<std::complex<double>>& spectra,
+  ArrayBins& notchedBins,
+  const char notchMode,
+  const unsigned int grouping,
+  const unsigned int baselineWindow,
+  const float threshold) const
+{
+  removeHarmonics<double>(spectra, notchedBins, notchMode, grouping,
+    baselineWindow, threshold);
+  return;
+}
+
+template <typename T, typename SpectraArray>
+void icarussigproc::HarmonicNoiseFilter::removeHarmonics(
+  SpectraArray& spectra,
+  ArrayBins& notchedBins,
+  const char notchMode,
+  const unsigned int grouping,
+  const unsigned int baselineWindow,
+  const float threshold) const
+{
+  /*
+  Notch coherent harmonic lines out of the channel spectra.
+
+  INPUTS:
+    - notchMode: 'z' zeroes the notched bins, 'i' (default) interpolates
+      them linearly from the nearest bins that are not notched.
+    - grouping: number of consecutive channels sharing the pickup.
+    - baselineWindow: half width, in bins, of the running median giving
+      the smooth noise level a peak is compared to.
+    - threshold: ratio of group averaged power to baseline above which a
+      bin is notched. The DC bin is never notched.
+
+  MODIFIES:
+    - spectra: half spectra of all channels, filtered in place.
+    - notchedBins: notched bins of each group (the last may be partial).
+  */
+  size_t numChannels = numRows(spectra);
+  size_t nBins = numCols(spectra);
+  size_t nGroups = (numChannels + grouping - 1) / grouping;
+
+  icarussigproc::MiscUtils utils;
+
+  notchedBins.resize(nGroups);
+  std::vector<T> groupPower(nBins);
+  std::vector<T> localPower;
+  std::vector<bool> notched(nBins);
+
+  for (size_t g=0; g<nGroups; ++g) {
+    size_t groupStart = g * grouping;
+    size_t groupEnd = std::min(groupStart + grouping, numChannels);
+
+    std::fill(groupPower.begin(), groupPower.end(), T(0));
+    for (size_t i=groupStart; i<groupEnd; ++i) {
+      for (size_t k=0; k<nBins; ++k) {
+        groupPower[k] += std::norm(spectra[i][k]);
+      }
+    }
+
+    notchedBins[g].clear();
+    std::fill(notched.begin(), notched.end(), false);
+    for (size_t k=1; k<nBins; ++k) {
+      size_t lowerBound = k - std::min(k, (size_t) baselineWindow);
+      size_t upperBound = std::min(k + baselineWindow + 1, nBins);
+      T baseline = utils.computeMedian(groupPower.begin() + lowerBound,
+        groupPower.begin() + upperBound, localPower);
+      if (groupPower[k] > threshold * baseline) {
+        notched[k] = true;
+        notchedBins[g].push_back(k);
+      }
+    }
+    if (notchedBins[g].empty()) continue;
+
+    // One pass over the group applying the common set of notches
+    for (size_t i=groupStart; i<groupEnd; ++i) {
+      std::complex<T>* spectrum = &spectra[i][0];
+      for (const auto& k : notchedBins[g]) {
+        if (notchMode != 'i') {
+          spectrum[k] = std::complex<T>(0, 0);
+          continue;
+        }
+        size_t lower = k;
+        while (lower > 0 && notched[lower]) --lower;
+        size_t upper = k;
+        while (upper < nBins && notched[upper]) ++upper;
+        if (upper == nBins) {
+          spectrum[k] = spectrum[lower];
+        } else {
+          T frac = T(k - lower) / T(upper - lower);
+          spectrum[k] = (T(1) - frac) * spectrum[lower] + frac * spectrum[upper];
+        }
+      }
+    }
+  }
+  return;
+}
+
+#endif
@@ -0,0 +1,98 @@
+/**
+ * \file HarmonicNoiseFilter.h
+ *
+ * \ingroup icarussigproc
+ *
+ * \brief Class def header for a class HarmonicNoiseFilter
+ *
+ */
+
+/** \addtogroup icarussigproc
+
+    @{*/
+#ifndef __SIGPROC_TOOLS_HARMONICNOISEFILTER_H__
+#define __SIGPROC_TOOLS_HARMONICNOISEFILTER_H__
+
+#include <vector>
+#include <complex>
+#include <algorithm>
+#include <cmath>
+#include "MiscUtils.h"
+#include "Array2D.h"
+
+namespace icarussigproc {
+
+  /**
+     \class HarmonicNoiseFilter
+     Spectral notch filter for coherent harmonic pickup. Narrow peaks are
+     found in the power spectrum averaged over a channel group and the same
+     bins are removed from every channel of the group in one pass. Works on
+     the half spectra produced by Deconvolution::getSpectra so that no extra
+     transform is needed per channel. Spectra may be nested vectors or the
+     Array2D spectra of the Array2D getSpectra.
+  */
+  class HarmonicNoiseFilter{
+
+    public:
+
+      /// Default constructor
+      HarmonicNoiseFilter(){}
+
+      /// Define some more convenient names for containers we are going to be using
+      using SpectrumFloat  = std::vector<std::complex<float>>;
+      using SpectrumDouble = std::vector<std::complex<double>>;
+      using ArraySpectrumFloat  = std::vector<SpectrumFloat>;
+      using ArraySpectrumDouble = std::vector<SpectrumDouble>;
+      using ArrayBins      = std::vector<std::vector<size_t>>;
+
+      void removeHarmonics(
+        ArraySpectrumFloat&,
+        ArrayBins&,
+        const char,
+        const unsigned int,
+        const unsigned int,
+        const float) const;
+
+      void removeHarmonics(
+        ArraySpectrumDouble&,
+        ArrayBins&,
+        const char,
+        const unsigned int,
+        const unsigned int,
+        const float) const;
+
+      void removeHarmonics(
+        Array2D<std::complex<float>>&,
+        ArrayBins&,
+        const char,
+        const unsigned int,
+        const unsigned int,
+        const float) const;
+
+      void removeHarmonics(
+        Array2D<std::complex<double>>&,
+        ArrayBins&,
+        const char,
+        const unsigned int,
+        const unsigned int,
+        const float) const;
+
+      /// Default destructor
+      ~HarmonicNoiseFilter(){}
+
+    private:
+
+      template <typename T, typename SpectraArray>
+      void removeHarmonics(
+        SpectraArray& spectra,
+        ArrayBins& notchedBins,
+        const char notchMode='i',
+        const unsigned int grouping=64,
+        const unsigned int baselineWindow=8,
+        const float threshold=10.0) const;
+  };
+}
+
+#endif
+/** @} */ // end of doxygen group
+
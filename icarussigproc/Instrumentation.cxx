@@ -0,0 +1,361 @@
+#ifndef __SIGPROC_TOOLS_INSTRUMENTATION_CXX__
+#define __SIGPROC_TOOLS_INSTRUMENTATION_CXX__
+
+#include "Instrumentation.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <ostream>
+
+namespace {
+
+  // Plain thread_local integers: usable from operator new without recursion
+  thread_local uint64_t tAllocations = 0;
+  thread_local uint64_t tAllocatedBytes = 0;
+
+  struct ThreadRecord {
+    std::mutex                                          mutex;
+    std::vector<std::pair<const char*, icarussigproc::PhaseStats>> phases;
+  };
+
+  class Registry {
+
+    public:
+
+      // Never destroyed: threads may release their slot during static
+      // destruction
+      static Registry& get()
+      {
+        static Registry* registry = new Registry;
+        return *registry;
+      }
+
+      ThreadRecord* acquire()
+      {
+        std::lock_guard<std::mutex> lock(fMutex);
+        for (size_t i=0; i<fRecords.size(); ++i) {
+          if (!fInUse[i]) {
+            fInUse[i] = true;
+            return fRecords[i].get();
+          }
+        }
+        fRecords.emplace_back(new ThreadRecord);
+        fInUse.push_back(true);
+        return fRecords.back().get();
+      }
+
+      void release(const ThreadRecord* record)
+      {
+        std::lock_guard<std::mutex> lock(fMutex);
+        for (size_t i=0; i<fRecords.size(); ++i) {
+          if (fRecords[i].get() == record) fInUse[i] = false;
+        }
+        return;
+      }
+
+      template <typename Func>
+      void forEach(Func func)
+      {
+        std::lock_guard<std::mutex> lock(fMutex);
+        for (auto& record : fRecords) {
+          std::lock_guard<std::mutex> recordLock(record->mutex);
+          func(*record);
+        }
+        return;
+      }
+
+    private:
+
+      std::mutex                                 fMutex;
+      std::vector<std::unique_ptr<ThreadRecord>> fRecords;
+      std::vector<bool>                          fInUse;
+  };
+
+  struct ThreadSlot {
+    ThreadRecord* record = nullptr;
+
+    ThreadRecord& get()
+    {
+      if (!record) record = Registry::get().acquire();
+      return *record;
+    }
+
+    ~ThreadSlot()
+    {
+      if (record) Registry::get().release(record);
+    }
+  };
+
+  thread_local ThreadSlot tSlot;
+
+  void writeString(std::ostream& stream, const std::string& value)
+  {
+    stream << '"';
+    for (char c : value) {
+      if (c == '"' || c == '\\') stream << '\\' << c;
+      else if (c == '\n') stream << "\\n";
+      else if (static_cast<unsigned char>(c) >= 0x20) stream << c;
+    }
+    stream << '"';
+    return;
+  }
+
+  void writeStats(std::ostream& stream, const icarussigproc::PhaseStats& stats)
+  {
+    stream << "{\"calls\": " << stats.calls
+           << ", \"ns\": " << stats.nanoseconds
+           << ", \"samples\": " << stats.samples
+           << ", \"bytes\": " << stats.bytes
+           << ", \"allocations\": " << stats.allocations
+           << ", \"allocatedBytes\": " << stats.allocatedBytes << "}";
+    return;
+  }
+
+  void writePhases(std::ostream& stream,
+    const icarussigproc::Instrumentation::ThreadReport& phases,
+    const char* indent)
+  {
+    stream << "{";
+    for (size_t i=0; i<phases.size(); ++i) {
+      stream << (i == 0 ? "\n" : ",\n") << indent;
+      writeString(stream, phases[i].first);
+      stream << ": ";
+      writeStats(stream, phases[i].second);
+    }
+    stream << "}";
+    return;
+  }
+}
+
+void icarussigproc::PhaseStats::add(const PhaseStats& other)
+{
+  calls += other.calls;
+  nanoseconds += other.nanoseconds;
+  samples += other.samples;
+  bytes += other.bytes;
+  allocations += other.allocations;
+  allocatedBytes += other.allocatedBytes;
+  return;
+}
+
+void icarussigproc::Instrumentation::record(
+  const char* phase,
+  const PhaseStats& stats)
+{
+  ThreadRecord& record = tSlot.get();
+  std::lock_guard<std::mutex> lock(record.mutex);
+  for (auto& entry : record.phases) {
+    if (entry.first == phase || std::strcmp(entry.first, phase) == 0) {
+      entry.second.add(stats);
+      return;
+    }
+  }
+  record.phases.emplace_back(phase, stats);
+  return;
+}
+
+void icarussigproc::Instrumentation::getAllocations(
+  uint64_t& count,
+  uint64_t& bytes)
+{
+  count = tAllocations;
+  bytes = tAllocatedBytes;
+  return;
+}
+
+std::vector<icarussigproc::Instrumentation::ThreadReport>
+icarussigproc::Instrumentation::getReport()
+{
+  std::vector<ThreadReport> report;
+  Registry::get().forEach([&](const ThreadRecord& record) {
+    ThreadReport phases;
+    for (const auto& entry : record.phases) {
+      phases.emplace_back(entry.first, entry.second);
+    }
+    report.push_back(std::move(phases));
+  });
+  return report;
+}
+
+void icarussigproc::Instrumentation::reset()
+{
+  Registry::get().forEach([](ThreadRecord& record) { record.phases.clear(); });
+  return;
+}
+
+void icarussigproc::Instrumentation::writeJSON(
+  std::ostream& stream,
+  const std::string& job)
+{
+  std::vector<ThreadReport> report = getReport();
+
+  ThreadReport total;
+  for (const auto& phases : report) {
+    for (const auto& entry : phases) {
+      auto itr = std::find_if(total.begin(), total.end(),
+        [&](const auto& t) { return t.first == entry.first; });
+      if (itr == total.end()) total.push_back(entry);
+      else itr->second.add(entry.second);
+    }
+  }
+
+  stream << "{\n  \"job\": ";
+  writeString(stream, job);
+  stream << ",\n  \"enabled\": " << (enabled ? "true" : "false")
+         << ",\n  \"threads\": [";
+  bool first = true;
+  for (size_t i=0; i<report.size(); ++i) {
+    if (report[i].empty()) continue;
+    stream << (first ? "\n" : ",\n") << "    {\"thread\": " << i
+           << ", \"phases\": ";
+    writePhases(stream, report[i], "      ");
+    stream << "}";
+    first = false;
+  }
+  stream << "],\n  \"total\": ";
+  writePhases(stream, total, "    ");
+  stream << "\n}\n";
+  return;
+}
+
+icarussigproc::ScopedPhase::ScopedPhase(
+  const char* phase,
+  const uint64_t samples,
+  const uint64_t bytes) :
+  fPhase(phase),
+  fSamples(samples),
+  fBytes(bytes),
+  fAllocations(tAllocations),
+  fAllocatedBytes(tAllocatedBytes),
+  fStart(std::chrono::steady_clock::now())
+{
+}
+
+icarussigproc::ScopedPhase::~ScopedPhase()
+{
+  PhaseStats stats;
+  stats.calls = 1;
+  stats.nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now() - fStart).count();
+  stats.samples = fSamples;
+  stats.bytes = fBytes;
+  stats.allocations = tAllocations - fAllocations;
+  stats.allocatedBytes = tAllocatedBytes - fAllocatedBytes;
+  Instrumentation::record(fPhase, stats);
+}
+
+#ifdef ICARUSSIGPROC_INSTRUMENTATION
+
+// Counting replacements of the global allocation functions
+
+namespace {
+
+  void* rawAllocate(std::size_t size, std::size_t alignment)
+  {
+    if (alignment <= alignof(std::max_align_t)) return std::malloc(size);
+    return std::aligned_alloc(alignment,
+      (size + alignment - 1) / alignment * alignment);
+  }
+
+  // As the default operator new: retry through the new handler until
+  // either the allocation succeeds or there is no handler left
+  void* checkedAllocate(std::size_t size, std::size_t alignment)
+  {
+    ++tAllocations;
+    tAllocatedBytes += size;
+    if (size == 0) size = 1;
+    void* ptr = rawAllocate(size, alignment);
+    while (!ptr) {
+      std::new_handler handler = std::get_new_handler();
+      if (!handler) throw std::bad_alloc();
+      handler();
+      ptr = rawAllocate(size, alignment);
+    }
+    return ptr;
+  }
+
+  void* nothrowAllocate(std::size_t size, std::size_t alignment) noexcept
+  {
+    try {
+      return checkedAllocate(size, alignment);
+    } catch (const std::bad_alloc&) {
+      return nullptr;
+    }
+  }
+}
+
+void* operator new(std::size_t size)
+{
+  return checkedAllocate(size, 0);
+}
+
+void* operator new[](std::size_t size)
+{
+  return checkedAllocate(size, 0);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+  return nothrowAllocate(size, 0);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+  return nothrowAllocate(size, 0);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+  return checkedAllocate(size, std::size_t(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+  return checkedAllocate(size, std::size_t(alignment));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment,
+  const std::nothrow_t&) noexcept
+{
+  return nothrowAllocate(size, std::size_t(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment,
+  const std::nothrow_t&) noexcept
+{
+  return nothrowAllocate(size, std::size_t(alignment));
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
+{
+  std::free(ptr);
+}
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept
+{
+  std::free(ptr);
+}
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+  std::free(ptr);
+}
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+  std::free(ptr);
+}
+
+#endif
+
+#endif
@@ -0,0 +1,131 @@
+/**
+ * \file Instrumentation.h
+ *
+ * \ingroup icarussigproc
+ *
+ * \brief Per phase counters of the hot paths with a JSON summary
+ *
+ */
+
+/** \addtogroup icarussigproc
+
+    @{*/
+#ifndef __SIGPROC_TOOLS_INSTRUMENTATION_H__
+#define __SIGPROC_TOOLS_INSTRUMENTATION_H__
+
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace icarussigproc {
+
+  /// Counters of a phase; bytes are the array bytes the phase reads and
+  /// writes as estimated by the caller, not measured memory traffic
+  struct PhaseStats {
+    uint64_t calls = 0;
+    uint64_t nanoseconds = 0;
+    uint64_t samples = 0;
+    uint64_t bytes = 0;
+    uint64_t allocations = 0;
+    uint64_t allocatedBytes = 0;
+
+    void add(const PhaseStats& other);
+  };
+
+  /**
+     \class Instrumentation
+     Collects PhaseStats per named phase (see SIGPROC_PHASE) and per thread.
+     Every thread records into its own slot, so recording does not contend
+     between threads; the slot of an exiting thread is reused by the next
+     new one, so a report has as many threads as ran concurrently rather
+     than one per thread ever started.
+
+     Only active when the package is built with ICARUSSIGPROC_INSTRUMENTATION
+     defined (cmake -DICARUSSIGPROC_INSTRUMENTATION=ON). The global operator
+     new and delete are then replaced by counting versions so that phases
+     also report their heap allocations. Without the flag SIGPROC_PHASE
+     expands to nothing and the report is empty.
+
+     Typical use is one job per event: reset(), process, writeJSON().
+  */
+  class Instrumentation{
+
+    public:
+
+#ifdef ICARUSSIGPROC_INSTRUMENTATION
+      static constexpr bool enabled = true;
+#else
+      static constexpr bool enabled = false;
+#endif
+
+      /// Phases of a thread slot in the order they were first recorded
+      using ThreadReport = std::vector<std::pair<std::string, PhaseStats>>;
+
+      /// Adds stats to the phase in the slot of the calling thread; the
+      /// phase name must outlive the job (e.g. a string literal)
+      static void record(const char* phase, const PhaseStats& stats);
+
+      /// Heap allocations made so far by the calling thread (zero when not
+      /// enabled)
+      static void getAllocations(uint64_t& count, uint64_t& bytes);
+
+      /// Copy of the counters of all thread slots
+      static std::vector<ThreadReport> getReport();
+
+      /// Clears the counters of all thread slots
+      static void reset();
+
+      /// Writes the job name, the phases of each thread slot and their sum
+      /// over the threads as a JSON object
+      static void writeJSON(std::ostream& stream, const std::string& job);
+  };
+
+  /**
+     \class ScopedPhase
+     Records the wall time and the heap allocations of the calling thread
+     between construction and destruction, together with the samples and
+     bytes given to the constructor. Use through SIGPROC_PHASE.
+  */
+  class ScopedPhase{
+
+    public:
+
+      ScopedPhase(const char* phase, const uint64_t samples,
+        const uint64_t bytes);
+
+      ~ScopedPhase();
+
+      ScopedPhase(const ScopedPhase&) = delete;
+      ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+    private:
+
+      const char*                           fPhase;
+      uint64_t                              fSamples;
+      uint64_t                              fBytes;
+      uint64_t                              fAllocations;
+      uint64_t                              fAllocatedBytes;
+      std::chrono::steady_clock::time_point fStart;
+  };
+}
+
+#define SIGPROC_CONCAT_IMPL(a, b) a##b
+#define SIGPROC_CONCAT(a, b) SIGPROC_CONCAT_IMPL(a, b)
+
+/// Records the rest of the enclosing scope as the given phase. When
+/// instrumentation is disabled the arguments only appear in an unevaluated
+/// operand, so nothing runs and their variables still count as used.
+#ifdef ICARUSSIGPROC_INSTRUMENTATION
+#define SIGPROC_PHASE(phase, samples, bytes) \
+  icarussigproc::ScopedPhase SIGPROC_CONCAT(sigprocPhase_, __LINE__)( \
+    phase, samples, bytes)
+#else
+#define SIGPROC_PHASE(phase, samples, bytes) \
+  ((void)sizeof((samples) + (bytes)))
+#endif
+
+#endif
+/** @} */ // end of doxygen group
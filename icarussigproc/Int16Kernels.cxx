@@ -0,0 +1,141 @@
+#ifndef __SIGPROC_TOOLS_INT16KERNELS_CXX__
+#define __SIGPROC_TOOLS_INT16KERNELS_CXX__
+
+#include "Int16Kernels.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(__x86_64__)
+#include <emmintrin.h>
+
+namespace {
+
+  inline __m128i load(const short* in)
+  {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+  }
+
+  inline void store(short* out, const __m128i value)
+  {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), value);
+    return;
+  }
+}
+#endif
+
+void icarussigproc::slidingMinMaxRow(
+  const short* in,
+  const size_t n,
+  const int lo,
+  const int hi,
+  short* minOut,
+  short* maxOut)
+{
+  auto clipped = [&](const size_t j) {
+    size_t lower = j < size_t(-lo) ? 0 : j + lo;
+    size_t upper = std::min(j + hi, n - 1);
+    short minVal = in[lower];
+    short maxVal = in[lower];
+    for (size_t k=lower+1; k<=upper; ++k) {
+      minVal = std::min(minVal, in[k]);
+      maxVal = std::max(maxVal, in[k]);
+    }
+    minOut[j] = minVal;
+    maxOut[j] = maxVal;
+  };
+
+  // Windows inside the row, [interiorBegin, interiorEnd), need no clipping
+  size_t interiorBegin = std::min(size_t(-lo), n);
+  size_t interiorEnd = n > size_t(hi) ? n - hi : 0;
+  interiorEnd = std::max(interiorBegin, interiorEnd);
+  size_t j = 0;
+  for (; j<interiorBegin; ++j) clipped(j);
+#if defined(__SSE2__) || defined(__x86_64__)
+  for (; j+8<=interiorEnd; j+=8) {
+    const short* window = in + j + lo;
+    __m128i minVal = load(window);
+    __m128i maxVal = minVal;
+    for (int k=1; k<=hi-lo; ++k) {
+      __m128i samples = load(window + k);
+      minVal = _mm_min_epi16(minVal, samples);
+      maxVal = _mm_max_epi16(maxVal, samples);
+    }
+    store(minOut + j, minVal);
+    store(maxOut + j, maxVal);
+  }
+#endif
+  for (; j<interiorEnd; ++j) {
+    const short* window = in + j + lo;
+    short minVal = window[0];
+    short maxVal = window[0];
+    for (int k=1; k<=hi-lo; ++k) {
+      minVal = std::min(minVal, window[k]);
+      maxVal = std::max(maxVal, window[k]);
+    }
+    minOut[j] = minVal;
+    maxOut[j] = maxVal;
+  }
+  for (; j<n; ++j) clipped(j);
+  return;
+}
+
+void icarussigproc::minRow(const short* in, short* out, const size_t n)
+{
+  size_t j = 0;
+#if defined(__SSE2__) || defined(__x86_64__)
+  for (; j+8<=n; j+=8) store(out + j, _mm_min_epi16(load(out + j), load(in + j)));
+#endif
+  for (; j<n; ++j) out[j] = std::min(out[j], in[j]);
+  return;
+}
+
+void icarussigproc::maxRow(const short* in, short* out, const size_t n)
+{
+  size_t j = 0;
+#if defined(__SSE2__) || defined(__x86_64__)
+  for (; j+8<=n; j+=8) store(out + j, _mm_max_epi16(load(out + j), load(in + j)));
+#endif
+  for (; j<n; ++j) out[j] = std::max(out[j], in[j]);
+  return;
+}
+
+void icarussigproc::subtractRow(
+  const short* a,
+  const short* b,
+  short* out,
+  const size_t n)
+{
+  size_t j = 0;
+#if defined(__SSE2__) || defined(__x86_64__)
+  for (; j+8<=n; j+=8) store(out + j, _mm_subs_epi16(load(a + j), load(b + j)));
+#endif
+  for (; j<n; ++j) out[j] = subtractSaturated(a[j], b[j]);
+  return;
+}
+
+void icarussigproc::averageRow(
+  const short* a,
+  const short* b,
+  short* out,
+  const size_t n)
+{
+  size_t j = 0;
+#if defined(__SSE2__) || defined(__x86_64__)
+  // floor((a + b) / 2) without overflow, then one up for negative odd sums
+  const __m128i one = _mm_set1_epi16(1);
+  for (; j+8<=n; j+=8) {
+    __m128i x = load(a + j);
+    __m128i y = load(b + j);
+    __m128i floorAvg = _mm_add_epi16(
+      _mm_add_epi16(_mm_srai_epi16(x, 1), _mm_srai_epi16(y, 1)),
+      _mm_and_si128(_mm_and_si128(x, y), one));
+    __m128i odd = _mm_and_si128(_mm_xor_si128(x, y), one);
+    __m128i negative = _mm_srai_epi16(floorAvg, 15);
+    store(out + j, _mm_add_epi16(floorAvg, _mm_and_si128(odd, negative)));
+  }
+#endif
+  for (; j<n; ++j) out[j] = averageTruncated(a[j], b[j]);
+  return;
+}
+
+#endif
@@ -0,0 +1,74 @@
+/**
+ * \file Int16Kernels.h
+ *
+ * \ingroup icarussigproc
+ *
+ * \brief Row kernels on int16 ADC samples with saturating arithmetic
+ *
+ */
+
+/** \addtogroup icarussigproc
+
+    @{*/
+#ifndef __SIGPROC_TOOLS_INT16KERNELS_H__
+#define __SIGPROC_TOOLS_INT16KERNELS_H__
+
+#include <cstddef>
+#include <limits>
+
+/**
+   Kernels keeping int16 (short) planes in int16 from input to output,
+   eight samples per SSE2 instruction (scalar loops elsewhere, with the same
+   results). Rounding rules of the int16 path:
+     - differences (gradients, coherent noise subtraction) saturate to
+       [-32768, 32767] instead of wrapping around;
+     - averages of two samples (morphological average, median of an even
+       count) truncate toward zero, as the floating point average converted
+       back to short did; they never overflow.
+*/
+namespace icarussigproc {
+
+  /// value clamped to the int16 range
+  inline short saturateInt16(const int value)
+  {
+    if (value > std::numeric_limits<short>::max()) {
+      return std::numeric_limits<short>::max();
+    }
+    if (value < std::numeric_limits<short>::min()) {
+      return std::numeric_limits<short>::min();
+    }
+    return short(value);
+  }
+
+  /// a - b, saturated
+  inline short subtractSaturated(const short a, const short b)
+  {
+    return saturateInt16(int(a) - int(b));
+  }
+
+  /// (a + b) / 2 truncated toward zero
+  inline short averageTruncated(const short a, const short b)
+  {
+    return short((int(a) + int(b)) / 2);
+  }
+
+  /// minOut[j] and maxOut[j]: extrema of in[j + lo] .. in[j + hi] clipped
+  /// to [0, n), lo <= 0 <= hi
+  void slidingMinMaxRow(const short* in, const size_t n, const int lo,
+    const int hi, short* minOut, short* maxOut);
+
+  /// out[j] = min(out[j], in[j]), for accumulating over rows
+  void minRow(const short* in, short* out, const size_t n);
+
+  /// out[j] = max(out[j], in[j])
+  void maxRow(const short* in, short* out, const size_t n);
+
+  /// out[j] = subtractSaturated(a[j], b[j])
+  void subtractRow(const short* a, const short* b, short* out, const size_t n);
+
+  /// out[j] = averageTruncated(a[j], b[j])
+  void averageRow(const short* a, const short* b, short* out, const size_t n);
+}
+
+#endif
+/** @} */ // end of doxygen group
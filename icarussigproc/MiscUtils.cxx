@@ -2,66 +2,337 @@
 #define __SIGPROC_TOOLS_MISCUTILS_CXX__
 
 #include "MiscUtils.h"
+#include "ParallelFor.h"
 
-short icarussigproc::MiscUtils::computeMedian(const std::vector<short>& vec) {
+short icarussigproc::MiscUtils::computeMedian(const std::vector<short>& vec) const {
   short median = computeMedian<short>(vec);
   return median;
 }
 
-float icarussigproc::MiscUtils::computeMedian(const std::vector<float>& vec) {
+float icarussigproc::MiscUtils::computeMedian(const std::vector<float>& vec) const {
   float median = computeMedian<float>(vec);
   return median;
 }
 
-double icarussigproc::MiscUtils::computeMedian(const std::vector<double>& vec) {
+double icarussigproc::MiscUtils::computeMedian(const std::vector<double>& vec) const {
   double median = computeMedian<double>(vec);
   return median;
 }
 
 template <typename T>
-T icarussigproc::MiscUtils::computeMedian(const std::vector<T>& vec)
+T icarussigproc::MiscUtils::computeMedian(const std::vector<T>& vec) const
 {
-  T median;
   std::vector<T> localVec = vec;
-  if (localVec.size() % 2 == 0) {
-    const auto m1 = localVec.begin() + localVec.size() / 2 - 1;
-    const auto m2 = localVec.begin() + localVec.size() / 2;
-    std::nth_element(localVec.begin(), m1, localVec.end());
-    const auto e1 = *m1;
-    std::nth_element(localVec.begin(), m2, localVec.end());
-    const auto e2 = *m2;
-    median = (e1 + e2) / 2.0;
-  } else {
-    const auto m = localVec.begin() + localVec.size() / 2;
-    std::nth_element(localVec.begin(), m, localVec.end());
-    median = *m;
+  return computeMedianInPlace(localVec.begin(), localVec.end());
+}
+
+icarussigproc::CountingHistogram&
+icarussigproc::MiscUtils::getCountingHistogram()
+{
+  static thread_local CountingHistogram histogram;
+  return histogram;
+}
+
+std::vector<unsigned int>& icarussigproc::MiscUtils::getSketchCounts()
+{
+  static thread_local std::vector<unsigned int> counts;
+  return counts;
+}
+
+int icarussigproc::CountingHistogram::getValue(const size_t rank) const
+{
+  int value;
+  getValues(&rank, 1, &value);
+  return value;
+}
+
+double icarussigproc::CountingHistogram::getMedian() const
+{
+  if (fNumEntries == 0) return 0.;
+  if (fNumEntries % 2 != 0) return getValue(fNumEntries / 2);
+  size_t ranks[2] = {fNumEntries / 2 - 1, fNumEntries / 2};
+  int values[2];
+  getValues(ranks, 2, values);
+  return (values[0] + values[1]) / 2.0;
+}
+
+int icarussigproc::CountingHistogram::getIntegerMedian() const
+{
+  if (fNumEntries == 0) return 0;
+  if (fNumEntries % 2 != 0) return getValue(fNumEntries / 2);
+  size_t ranks[2] = {fNumEntries / 2 - 1, fNumEntries / 2};
+  int values[2];
+  getValues(ranks, 2, values);
+  return int((static_cast<long long>(values[0]) + values[1]) / 2);
+}
+
+int icarussigproc::CountingHistogram::getQuantile(const float quantile) const
+{
+  if (fNumEntries == 0) return 0;
+  return getValue(getRank(quantile));
+}
+
+void icarussigproc::CountingHistogram::getQuantiles(
+  const std::vector<float>& quantiles,
+  std::vector<int>& values) const
+{
+  values.assign(quantiles.size(), 0);
+  if (fNumEntries == 0) return;
+
+  // Walk the histogram once for the queries in increasing rank order
+  std::vector<size_t> order(quantiles.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&quantiles](size_t a, size_t b) {
+    return quantiles[a] < quantiles[b];
+  });
+  std::vector<size_t> ranks(quantiles.size());
+  std::vector<int> sortedValues(quantiles.size());
+  for (size_t i=0; i<order.size(); ++i) ranks[i] = getRank(quantiles[order[i]]);
+  getValues(ranks.data(), ranks.size(), sortedValues.data());
+  for (size_t i=0; i<order.size(); ++i) values[order[i]] = sortedValues[i];
+  return;
+}
+
+size_t icarussigproc::CountingHistogram::getRank(const float quantile) const
+{
+  float q = std::min(std::max(quantile, float(0.)), float(1.));
+  return std::lround(q * (fNumEntries - 1));
+}
+
+void icarussigproc::CountingHistogram::getValues(
+  const size_t* ranks,
+  const size_t numRanks,
+  int* values) const
+{
+  size_t cumulative = 0;
+  size_t idx = 0;
+  for (size_t r=0; r<numRanks; ++r) {
+    // First bin whose cumulative count exceeds the rank
+    while (cumulative + fCounts[idx] <= ranks[r]) cumulative += fCounts[idx++];
+    values[r] = int(idx) + fMinVal;
   }
-  return median;
+  return;
 }
 
 float icarussigproc::MiscUtils::compute_noise_power(
   const std::vector<std::vector<float>>& waveLessCoherent,
-  const std::vector<std::vector<bool>>& selectVals)
+  const std::vector<std::vector<bool>>& selectVals,
+  const unsigned int numThreads) const
+{
+  return compute_noise_power<float>(waveLessCoherent, selectVals,
+    nullptr, nullptr, 1, numThreads);
+}
+
+float icarussigproc::MiscUtils::compute_noise_power(
+  const std::vector<std::vector<double>>& waveLessCoherent,
+  const std::vector<std::vector<bool>>& selectVals,
+  const unsigned int numThreads) const
+{
+  return compute_noise_power<double>(waveLessCoherent, selectVals,
+    nullptr, nullptr, 1, numThreads);
+}
+
+float icarussigproc::MiscUtils::compute_noise_power(
+  const std::vector<std::vector<short>>& waveLessCoherent,
+  const std::vector<std::vector<bool>>& selectVals,
+  const unsigned int numThreads) const
+{
+  return compute_noise_power<short>(waveLessCoherent, selectVals,
+    nullptr, nullptr, 1, numThreads);
+}
+
+float icarussigproc::MiscUtils::compute_noise_power(
+  const std::vector<std::vector<float>>& waveLessCoherent,
+  const std::vector<std::vector<bool>>& selectVals,
+  std::vector<float>& channelPower,
+  std::vector<float>& groupPower,
+  const unsigned int grouping,
+  const unsigned int numThreads) const
+{
+  return compute_noise_power<float>(waveLessCoherent, selectVals,
+    &channelPower, &groupPower, grouping, numThreads);
+}
+
+float icarussigproc::MiscUtils::compute_noise_power(
+  const std::vector<std::vector<double>>& waveLessCoherent,
+  const std::vector<std::vector<bool>>& selectVals,
+  std::vector<float>& channelPower,
+  std::vector<float>& groupPower,
+  const unsigned int grouping,
+  const unsigned int numThreads) const
+{
+  return compute_noise_power<double>(waveLessCoherent, selectVals,
+    &channelPower, &groupPower, grouping, numThreads);
+}
+
+float icarussigproc::MiscUtils::compute_noise_power(
+  const std::vector<std::vector<short>>& waveLessCoherent,
+  const std::vector<std::vector<bool>>& selectVals,
+  std::vector<float>& channelPower,
+  std::vector<float>& groupPower,
+  const unsigned int grouping,
+  const unsigned int numThreads) const
+{
+  return compute_noise_power<short>(waveLessCoherent, selectVals,
+    &channelPower, &groupPower, grouping, numThreads);
+}
+
+float icarussigproc::MiscUtils::compute_noise_power(
+  const Array2DView<const float> waveLessCoherent,
+  const Array2DView<const bool> selectVals,
+  const unsigned int numThreads) const
+{
+  return compute_noise_power<float>(waveLessCoherent, selectVals,
+    nullptr, nullptr, 1, numThreads);
+}
+
+float icarussigproc::MiscUtils::compute_noise_power(
+  const Array2DView<const double> waveLessCoherent,
+  const Array2DView<const bool> selectVals,
+  const unsigned int numThreads) const
+{
+  return compute_noise_power<double>(waveLessCoherent, selectVals,
+    nullptr, nullptr, 1, numThreads);
+}
+
+float icarussigproc::MiscUtils::compute_noise_power(
+  const Array2DView<const short> waveLessCoherent,
+  const Array2DView<const bool> selectVals,
+  const unsigned int numThreads) const
+{
+  return compute_noise_power<short>(waveLessCoherent, selectVals,
+    nullptr, nullptr, 1, numThreads);
+}
+
+float icarussigproc::MiscUtils::compute_noise_power(
+  const Array2DView<const float> waveLessCoherent,
+  const Array2DView<const bool> selectVals,
+  std::vector<float>& channelPower,
+  std::vector<float>& groupPower,
+  const unsigned int grouping,
+  const unsigned int numThreads) const
 {
-  size_t numChannels = waveLessCoherent.size();
-  size_t nTicks = waveLessCoherent.at(0).size();
+  return compute_noise_power<float>(waveLessCoherent, selectVals,
+    &channelPower, &groupPower, grouping, numThreads);
+}
 
-  float var = 0.0;
-  float mean = 0.0;
-  int count = 0;
+float icarussigproc::MiscUtils::compute_noise_power(
+  const Array2DView<const double> waveLessCoherent,
+  const Array2DView<const bool> selectVals,
+  std::vector<float>& channelPower,
+  std::vector<float>& groupPower,
+  const unsigned int grouping,
+  const unsigned int numThreads) const
+{
+  return compute_noise_power<double>(waveLessCoherent, selectVals,
+    &channelPower, &groupPower, grouping, numThreads);
+}
 
-  for (size_t i=0; i<numChannels; ++i) {
-    for (size_t j=0; j<nTicks; ++j) {
-      if (!selectVals[i][j]) {
-        var += std::pow(waveLessCoherent[i][j], 2.0);
-        mean += waveLessCoherent[i][j];
-        count += 1;
+float icarussigproc::MiscUtils::compute_noise_power(
+  const Array2DView<const short> waveLessCoherent,
+  const Array2DView<const bool> selectVals,
+  std::vector<float>& channelPower,
+  std::vector<float>& groupPower,
+  const unsigned int grouping,
+  const unsigned int numThreads) const
+{
+  return compute_noise_power<short>(waveLessCoherent, selectVals,
+    &channelPower, &groupPower, grouping, numThreads);
+}
+
+void icarussigproc::MiscUtils::NoiseMoments::merge(const NoiseMoments& other)
+{
+  if (other.count == 0.) return;
+  double total = count + other.count;
+  double delta = other.mean - mean;
+  mean += delta * other.count / total;
+  sumSqDev += other.sumSqDev + delta * delta * count * other.count / total;
+  count = total;
+  return;
+}
+
+float icarussigproc::MiscUtils::NoiseMoments::getVariance() const
+{
+  return count > 0. ? sumSqDev / count : 0.;
+}
+
+template <typename T, typename InArray, typename MaskArray>
+float icarussigproc::MiscUtils::compute_noise_power(
+  const InArray& waveLessCoherent,
+  const MaskArray& selectVals,
+  std::vector<float>* channelPower,
+  std::vector<float>* groupPower,
+  const unsigned int grouping,
+  const unsigned int numThreads) const
+{
+  /*
+  Noise power (variance) of the samples outside the signal selection.
+
+  INPUTS:
+    - selectVals: true for the samples to exclude.
+    - grouping: channels per group for the group summary.
+
+  MODIFIES:
+    - channelPower, groupPower: if given, variance of the unselected samples
+      of each channel and of each group; 0 where nothing is left.
+  */
+  size_t numChannels = numRows(waveLessCoherent);
+  size_t nTicks = numCols(waveLessCoherent);
+  std::vector<NoiseMoments> channelMoments(numChannels);
+
+  auto processChannels = [&](size_t begin, size_t end, unsigned int) {
+    for (size_t i=begin; i<end; ++i) {
+      const auto& waveform = waveLessCoherent[i];
+      const auto& mask = selectVals[i];
+      // Branch free masked sums; a per channel shift by the first sample
+      // keeps the one pass variance accurate for offset waveforms
+      double shift = nTicks > 0 ? double(waveform[0]) : 0.;
+      double count = 0.;
+      double sum = 0.;
+      double sumSq = 0.;
+      for (size_t j=0; j<nTicks; ++j) {
+        double keep = mask[j] ? 0. : 1.;
+        double diff = (double(waveform[j]) - shift) * keep;
+        count += keep;
+        sum += diff;
+        sumSq += diff * diff;
       }
+      NoiseMoments& moments = channelMoments[i];
+      moments.count = count;
+      moments.mean = count > 0. ? shift + sum / count : 0.;
+      moments.sumSqDev = count > 0. ?
+        std::max(0., sumSq - sum * sum / count) : 0.;
+    }
+  };
+
+  parallelFor(numChannels, 16, processChannels, numThreads);
+
+  // Merged in channel order so that the result is reproducible
+  NoiseMoments total{0., 0., 0.};
+  for (const auto& moments : channelMoments) total.merge(moments);
+
+  if (channelPower) {
+    channelPower->resize(numChannels);
+    for (size_t i=0; i<numChannels; ++i) {
+      (*channelPower)[i] = channelMoments[i].getVariance();
     }
   }
-  mean = mean / ((float) count);
-  var = var / ((float) count) - std::pow(mean, 2.0);
-  return var;
+
+  if (groupPower) {
+    size_t groupSize = std::max(grouping, 1U);
+    size_t nGroups = (numChannels + groupSize - 1) / groupSize;
+    groupPower->resize(nGroups);
+    for (size_t g=0; g<nGroups; ++g) {
+      NoiseMoments groupMoments{0., 0., 0.};
+      size_t groupEnd = std::min((g+1) * groupSize, numChannels);
+      for (size_t i=g*groupSize; i<groupEnd; ++i) {
+        groupMoments.merge(channelMoments[i]);
+      }
+      (*groupPower)[g] = groupMoments.getVariance();
+    }
+  }
+
+  return total.getVariance();
 }
 
 #endif
@@ -20,12 +20,71 @@
 #include <numeric>
 #include <cmath>
 #include <functional>
+#include <type_traits>
+#include "Array2D.h"
 
 namespace icarussigproc {
 
+  /**
+     \class CountingHistogram
+     Histogram of integer samples over their [min, max] range giving order
+     statistics in O(n + range) instead of a comparison based selection.
+     Several quantiles are read off one filled histogram; the storage is
+     reused from one fill to the next.
+  */
+  class CountingHistogram{
+
+    public:
+
+      /// Default constructor
+      CountingHistogram() : fMinVal(0), fNumEntries(0) {}
+
+      /// Histograms [first, last) unless its range of values exceeds
+      /// maxRange, in which case nothing is filled and false is returned
+      template <typename Iterator>
+      bool fill(Iterator first, Iterator last, const size_t maxRange);
+
+      size_t size() const { return fNumEntries; }
+
+      /// Value of the given rank (0 = smallest), rank < size()
+      int getValue(const size_t rank) const;
+
+      /// Average of the two middle values for an even number of entries
+      double getMedian() const;
+
+      /// getMedian in integer arithmetic, truncated toward zero
+      int getIntegerMedian() const;
+
+      /// Value of rank round(quantile * (size()-1)), quantile in [0, 1]
+      int getQuantile(const float quantile) const;
+
+      /// As getQuantile for each entry of quantiles, in one pass
+      void getQuantiles(
+        const std::vector<float>& quantiles,
+        std::vector<int>& values) const;
+
+      /// Default destructor
+      ~CountingHistogram(){}
+
+    private:
+
+      size_t getRank(const float quantile) const;
+
+      /// Values of ranks sorted in increasing order
+      void getValues(
+        const size_t* ranks,
+        const size_t numRanks,
+        int* values) const;
+
+      std::vector<unsigned int> fCounts;
+      int                       fMinVal;
+      size_t                    fNumEntries;
+  };
+
   /**
      \class MiscUtils
      Miscellaneous utility functions. 
+     Reentrant: the const members keep no state between calls.
   */
   class MiscUtils{
     
@@ -34,13 +93,129 @@ namespace icarussigproc {
       /// Default constructor
       MiscUtils(){}
 
-      short computeMedian(const std::vector<short>& vec);
-      float computeMedian(const std::vector<float>& vec);
-      double computeMedian(const std::vector<double>& vec);
+      short computeMedian(const std::vector<short>& vec) const;
+      float computeMedian(const std::vector<float>& vec) const;
+      double computeMedian(const std::vector<double>& vec) const;
+
+      /// Median of [first, last), reordering the range. A single selection
+      /// finds the upper middle element, the lower one of an even range is
+      /// the maximum of the partition below it; the two are averaged.
+      /// Integer samples spanning at most 8 values per sample are counted
+      /// into a CountingHistogram instead. An empty range gives 0.
+      template <typename Iterator>
+      static typename std::iterator_traits<Iterator>::value_type
+      computeMedianInPlace(Iterator first, Iterator last);
+
+      /// Median of [first, last) leaving the range untouched. The values are
+      /// copied into scratch, which only allocates when it has to grow.
+      template <typename Iterator, typename T>
+      static T computeMedian(Iterator first, Iterator last,
+        std::vector<T>& scratch);
 
+      /// Element of rank round(quantile * (n-1)) of [first, last), reordering
+      /// the range; quantile is clamped to [0, 1]. An empty range gives 0.
+      template <typename Iterator>
+      static typename std::iterator_traits<Iterator>::value_type
+      computeQuantileInPlace(Iterator first, Iterator last,
+        const float quantile);
+
+      /// Several quantiles of [first, last) at once, each defined as in
+      /// computeQuantileInPlace. Mode 'e' (exact) reorders the range with one
+      /// recursive multi-selection around all the requested ranks, integer
+      /// samples being counted as in computeMedianInPlace. Mode 'a'
+      /// (approximate) leaves the range untouched and interpolates the
+      /// quantiles from a numBins histogram sketch of the values.
+      template <typename Iterator>
+      static void computeQuantilesInPlace(Iterator first, Iterator last,
+        const std::vector<float>& quantiles,
+        std::vector<typename std::iterator_traits<Iterator>::value_type>&
+          values,
+        const char mode='e',
+        const size_t numBins=1024);
+
+      /// Variance of the samples not flagged in selectVals. Channels are
+      /// reduced in parallel in double precision and merged pairwise
+      /// (Chan/Welford), so the result does not depend on the thread count.
       float compute_noise_power(
         const std::vector<std::vector<float>>& waveLessCoherent,
-        const std::vector<std::vector<bool>>& selectVals);
+        const std::vector<std::vector<bool>>& selectVals,
+        const unsigned int numThreads=0) const;
+
+      float compute_noise_power(
+        const std::vector<std::vector<double>>& waveLessCoherent,
+        const std::vector<std::vector<bool>>& selectVals,
+        const unsigned int numThreads=0) const;
+
+      float compute_noise_power(
+        const std::vector<std::vector<short>>& waveLessCoherent,
+        const std::vector<std::vector<bool>>& selectVals,
+        const unsigned int numThreads=0) const;
+
+      /// Same, also filling the noise power of each channel and of each
+      /// group of grouping consecutive channels (the last may be partial)
+      float compute_noise_power(
+        const std::vector<std::vector<float>>& waveLessCoherent,
+        const std::vector<std::vector<bool>>& selectVals,
+        std::vector<float>& channelPower,
+        std::vector<float>& groupPower,
+        const unsigned int grouping,
+        const unsigned int numThreads=0) const;
+
+      float compute_noise_power(
+        const std::vector<std::vector<double>>& waveLessCoherent,
+        const std::vector<std::vector<bool>>& selectVals,
+        std::vector<float>& channelPower,
+        std::vector<float>& groupPower,
+        const unsigned int grouping,
+        const unsigned int numThreads=0) const;
+
+      float compute_noise_power(
+        const std::vector<std::vector<short>>& waveLessCoherent,
+        const std::vector<std::vector<bool>>& selectVals,
+        std::vector<float>& channelPower,
+        std::vector<float>& groupPower,
+        const unsigned int grouping,
+        const unsigned int numThreads=0) const;
+
+      /// Same on contiguous arrays (see Array2D.h)
+      float compute_noise_power(
+        const Array2DView<const float> waveLessCoherent,
+        const Array2DView<const bool> selectVals,
+        const unsigned int numThreads=0) const;
+
+      float compute_noise_power(
+        const Array2DView<const double> waveLessCoherent,
+        const Array2DView<const bool> selectVals,
+        const unsigned int numThreads=0) const;
+
+      float compute_noise_power(
+        const Array2DView<const short> waveLessCoherent,
+        const Array2DView<const bool> selectVals,
+        const unsigned int numThreads=0) const;
+
+      float compute_noise_power(
+        const Array2DView<const float> waveLessCoherent,
+        const Array2DView<const bool> selectVals,
+        std::vector<float>& channelPower,
+        std::vector<float>& groupPower,
+        const unsigned int grouping,
+        const unsigned int numThreads=0) const;
+
+      float compute_noise_power(
+        const Array2DView<const double> waveLessCoherent,
+        const Array2DView<const bool> selectVals,
+        std::vector<float>& channelPower,
+        std::vector<float>& groupPower,
+        const unsigned int grouping,
+        const unsigned int numThreads=0) const;
+
+      float compute_noise_power(
+        const Array2DView<const short> waveLessCoherent,
+        const Array2DView<const bool> selectVals,
+        std::vector<float>& channelPower,
+        std::vector<float>& groupPower,
+        const unsigned int grouping,
+        const unsigned int numThreads=0) const;
 
       
       /// Default destructor
@@ -49,7 +224,42 @@ namespace icarussigproc {
     private:
 
       template <typename T>
-      T computeMedian(const std::vector<T>& vec);
+      T computeMedian(const std::vector<T>& vec) const;
+
+      /// Histogram reused by the integer paths of the calling thread
+      static CountingHistogram& getCountingHistogram();
+
+      /// Sketch bin counts reused by the calling thread
+      static std::vector<unsigned int>& getSketchCounts();
+
+      /// Places the elements of the sorted ranks [ranksBegin, ranksEnd),
+      /// all within [lo, hi), at their sorted position
+      template <typename Iterator>
+      static void multiSelect(Iterator first,
+        const size_t* ranksBegin, const size_t* ranksEnd,
+        const size_t lo, const size_t hi);
+
+      /// Count, mean and sum of squared deviations of a set of samples
+      struct NoiseMoments {
+        double count;
+        double mean;
+        double sumSqDev;
+
+        void merge(const NoiseMoments& other);
+        float getVariance() const;
+      };
+
+      template <typename T, typename InArray, typename MaskArray>
+      float compute_noise_power(
+        const InArray& waveLessCoherent,
+        const MaskArray& selectVals,
+        std::vector<float>* channelPower,
+        std::vector<float>* groupPower,
+        const unsigned int grouping,
+        const unsigned int numThreads) const;
+
+      /// Maximum range of values per sample for the counting path
+      static constexpr size_t kMaxCountingRange = 8;
 
 
       // template <typename T> T computeMedian(
@@ -58,6 +268,191 @@ namespace icarussigproc {
   };
 }
 
+template <typename Iterator>
+bool icarussigproc::CountingHistogram::fill(
+  Iterator first,
+  Iterator last,
+  const size_t maxRange)
+{
+  if (first == last) {
+    fCounts.clear();
+    fNumEntries = 0;
+    return true;
+  }
+  auto minMaxItr = std::minmax_element(first, last);
+  int minVal = *minMaxItr.first;
+  int maxVal = *minMaxItr.second;
+  size_t range = size_t(maxVal - minVal) + 1;
+  if (range > maxRange) return false;
+
+  fCounts.assign(range, 0);
+  fMinVal = minVal;
+  fNumEntries = std::distance(first, last);
+  for (Iterator itr = first; itr != last; ++itr) {
+    ++fCounts[int(*itr) - minVal];
+  }
+  return true;
+}
+
+template <typename Iterator>
+typename std::iterator_traits<Iterator>::value_type
+icarussigproc::MiscUtils::computeMedianInPlace(Iterator first, Iterator last)
+{
+  using T = typename std::iterator_traits<Iterator>::value_type;
+  auto size = std::distance(first, last);
+  if (size == 0) return T(0);
+  if constexpr (std::is_integral<T>::value) {
+    CountingHistogram& histogram = getCountingHistogram();
+    if (histogram.fill(first, last, kMaxCountingRange * size)) {
+      return static_cast<T>(histogram.getIntegerMedian());
+    }
+  }
+  Iterator middle = first + size / 2;
+  std::nth_element(first, middle, last);
+  if (size % 2 != 0) return *middle;
+  const T lower = *std::max_element(first, middle);
+  // Integers average without a round trip through double, truncating
+  // toward zero as the conversion from double did
+  if constexpr (std::is_integral<T>::value) {
+    return T((static_cast<long long>(lower) + *middle) / 2);
+  }
+  return (lower + *middle) / 2.0;
+}
+
+template <typename Iterator, typename T>
+T icarussigproc::MiscUtils::computeMedian(
+  Iterator first,
+  Iterator last,
+  std::vector<T>& scratch)
+{
+  // Integer samples can be counted straight from the range
+  if constexpr (std::is_integral<T>::value) {
+    auto size = std::distance(first, last);
+    if (size == 0) return T(0);
+    CountingHistogram& histogram = getCountingHistogram();
+    if (histogram.fill(first, last, kMaxCountingRange * size)) {
+      return static_cast<T>(histogram.getIntegerMedian());
+    }
+  }
+  scratch.assign(first, last);
+  return computeMedianInPlace(scratch.begin(), scratch.end());
+}
+
+template <typename Iterator>
+typename std::iterator_traits<Iterator>::value_type
+icarussigproc::MiscUtils::computeQuantileInPlace(
+  Iterator first,
+  Iterator last,
+  const float quantile)
+{
+  using T = typename std::iterator_traits<Iterator>::value_type;
+  auto size = std::distance(first, last);
+  if (size == 0) return T(0);
+  if constexpr (std::is_integral<T>::value) {
+    CountingHistogram& histogram = getCountingHistogram();
+    if (histogram.fill(first, last, kMaxCountingRange * size)) {
+      return static_cast<T>(histogram.getQuantile(quantile));
+    }
+  }
+  float q = std::min(std::max(quantile, float(0.)), float(1.));
+  Iterator rank = first + std::lround(q * (size - 1));
+  std::nth_element(first, rank, last);
+  return *rank;
+}
+
+template <typename Iterator>
+void icarussigproc::MiscUtils::multiSelect(
+  Iterator first,
+  const size_t* ranksBegin,
+  const size_t* ranksEnd,
+  const size_t lo,
+  const size_t hi)
+{
+  if (ranksBegin == ranksEnd) return;
+  // Selecting the middle rank splits the others between the two sides
+  const size_t* middle = ranksBegin + (ranksEnd - ranksBegin) / 2;
+  std::nth_element(first + lo, first + *middle, first + hi);
+  multiSelect(first, ranksBegin, middle, lo, *middle);
+  multiSelect(first, middle + 1, ranksEnd, *middle + 1, hi);
+  return;
+}
+
+template <typename Iterator>
+void icarussigproc::MiscUtils::computeQuantilesInPlace(
+  Iterator first,
+  Iterator last,
+  const std::vector<float>& quantiles,
+  std::vector<typename std::iterator_traits<Iterator>::value_type>& values,
+  const char mode,
+  const size_t numBins)
+{
+  using T = typename std::iterator_traits<Iterator>::value_type;
+  size_t size = std::distance(first, last);
+  values.assign(quantiles.size(), T(0));
+  if (size == 0 || quantiles.empty()) return;
+
+  auto getRank = [size](const float quantile) {
+    float q = std::min(std::max(quantile, float(0.)), float(1.));
+    return size_t(std::lround(q * (size - 1)));
+  };
+
+  if (mode == 'a') {
+    auto minMaxItr = std::minmax_element(first, last);
+    double minVal = *minMaxItr.first;
+    double maxVal = *minMaxItr.second;
+    size_t nBins = std::max(numBins, size_t(1));
+    double binWidth = (maxVal - minVal) / nBins;
+    if (binWidth <= 0.) {
+      std::fill(values.begin(), values.end(), *minMaxItr.first);
+      return;
+    }
+    std::vector<unsigned int>& counts = getSketchCounts();
+    counts.assign(nBins, 0);
+    for (Iterator itr = first; itr != last; ++itr) {
+      size_t bin = std::min(size_t((*itr - minVal) / binWidth), nBins - 1);
+      ++counts[bin];
+    }
+    for (size_t i=0; i<quantiles.size(); ++i) {
+      size_t rank = getRank(quantiles[i]);
+      if (rank == 0 || rank == size - 1) {
+        values[i] = rank == 0 ? *minMaxItr.first : *minMaxItr.second;
+        continue;
+      }
+      // Ranks inside a bin are spread uniformly over its width
+      size_t cumulative = 0;
+      size_t bin = 0;
+      while (cumulative + counts[bin] <= rank) cumulative += counts[bin++];
+      double frac = (rank - cumulative + 0.5) / counts[bin];
+      values[i] = static_cast<T>(minVal + (bin + frac) * binWidth);
+    }
+    return;
+  }
+
+  if constexpr (std::is_integral<T>::value) {
+    CountingHistogram& histogram = getCountingHistogram();
+    if (histogram.fill(first, last, kMaxCountingRange * size)) {
+      // One walk of the histogram for all the quantiles
+      std::vector<int> histogramValues;
+      histogram.getQuantiles(quantiles, histogramValues);
+      for (size_t i=0; i<quantiles.size(); ++i) {
+        values[i] = static_cast<T>(histogramValues[i]);
+      }
+      return;
+    }
+  }
+
+  std::vector<size_t> ranks(quantiles.size());
+  for (size_t i=0; i<quantiles.size(); ++i) ranks[i] = getRank(quantiles[i]);
+  std::vector<size_t> sortedRanks = ranks;
+  std::sort(sortedRanks.begin(), sortedRanks.end());
+  sortedRanks.erase(
+    std::unique(sortedRanks.begin(), sortedRanks.end()), sortedRanks.end());
+  multiSelect(first, sortedRanks.data(),
+    sortedRanks.data() + sortedRanks.size(), 0, size);
+  for (size_t i=0; i<quantiles.size(); ++i) values[i] = *(first + ranks[i]);
+  return;
+}
+
 #endif
 /** @} */ // end of doxygen group 
 
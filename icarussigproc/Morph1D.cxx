@@ -2,13 +2,59 @@
 #define __SIGPROC_TOOLS_MORPH1D_CXX__
 
 #include "Morph1D.h"
+#include "Int16Kernels.h"
+#include "WindowKernels.h"
+
+// Gradient and average of a window's extrema; int16 samples follow the
+// rounding rules of Int16Kernels.h
+template <typename T>
+static T getWindowGradient(const T minVal, const T maxVal)
+{
+  if constexpr (std::is_same<T, short>::value) {
+    return icarussigproc::subtractSaturated(maxVal, minVal);
+  }
+  return T(maxVal - minVal);
+}
+
+template <typename T>
+static T getWindowAverage(const T minVal, const T maxVal)
+{
+  if constexpr (std::is_same<T, short>::value) {
+    return icarussigproc::averageTruncated(minVal, maxVal);
+  }
+  return T(0.5 * (maxVal + minVal));
+}
+
+// Sliding min/max filters with a registered half window, as an unrolled
+// kernel. Same windows as the incremental loops below: centered and
+// clipped at the start, held at the value of the last complete window at
+// the end. False when the size is not registered or the waveform too short.
+template <typename T, typename Op>
+static bool getFixedMinMax(
+  const T* inputWaveform,
+  const size_t nTicks,
+  const int halfWindowSize,
+  T* output,
+  Op op)
+{
+  if (nTicks <= size_t(halfWindowSize)) return false;
+  return icarussigproc::dispatchSize(icarussigproc::TickHalfWindows(),
+    halfWindowSize, [&](auto half) {
+      constexpr int H = decltype(half)::value;
+      size_t last = nTicks - 1 - H;
+      icarussigproc::slidingMinMax<-H, H>(inputWaveform, nTicks,
+        last + 1, [output, &op](size_t i, T minVal, T maxVal) {
+          output[i] = op(minVal, maxVal); });
+      std::fill(output + last + 1, output + nTicks, output[last]);
+    });
+}
 
 
 void icarussigproc::Morph1D::getWaveformParams(
   const std::vector<short>& waveform,
   float& mean,
   float& median,
-  float& rms)
+  float& rms) const
 {
   getWaveformParams<short>(waveform, mean, median, rms);
   return;
@@ -18,7 +64,7 @@ void icarussigproc::Morph1D::getWaveformParams(
   const std::vector<float>& waveform,
   float& mean,
   float& median,
-  float& rms)
+  float& rms) const
 {
   getWaveformParams<float>(waveform, mean, median, rms);
   return;
@@ -28,7 +74,7 @@ void icarussigproc::Morph1D::getWaveformParams(
   const std::vector<double>& waveform,
   float& mean,
   float& median,
-  float& rms)
+  float& rms) const
 {
   getWaveformParams<double>(waveform, mean, median, rms);
   return;
@@ -39,7 +85,7 @@ void icarussigproc::Morph1D::getWaveformParams(
   const std::vector<T>& waveform,
   float& mean,
   float& median,
-  float& rms)
+  float& rms) const
 {
   /*
   Calculate waveform parameters for a given 1D waveform.
@@ -58,15 +104,8 @@ void icarussigproc::Morph1D::getWaveformParams(
     float(std::accumulate(localWaveform.begin(),
     localWaveform.end(),0)) / float(localWaveform.size()));
 
-  if (localWaveform.size() % 2 == 0) {
-    const auto m1 = localWaveform.begin() + localWaveform.size() / 2 - 1;
-    const auto m2 = localWaveform.begin() + localWaveform.size() / 2;
-    std::nth_element(localWaveform.begin(), m1, localWaveform.end());
-    std::nth_element(localWaveform.begin(), m2, localWaveform.end());
-    median = (*m1 + *m2) / 2.0;
-  } else {
-    median = localWaveform[localWaveform.size()/2];
-  }
+  median = icarussigproc::MiscUtils::computeMedianInPlace(
+    localWaveform.begin(), localWaveform.end());
 
   mean = realMean;
   std::vector<float> adcLessPedVec;
@@ -87,7 +126,19 @@ void icarussigproc::Morph1D::getDilation(
   const unsigned int structuringElement,
   Waveform<short>& dilationVec) const
 {
-  getDilation<short>(waveform, structuringElement, dilationVec);
+  dilationVec.resize(waveform.size());
+  getDilation<short>(waveform.data(), waveform.size(), structuringElement,
+    dilationVec.data());
+  return;
+}
+
+void icarussigproc::Morph1D::getDilation(
+  const short* waveform,
+  const size_t nTicks,
+  const unsigned int structuringElement,
+  short* dilationVec) const
+{
+  getDilation<short>(waveform, nTicks, structuringElement, dilationVec);
   return;
 }
 
@@ -96,7 +147,19 @@ void icarussigproc::Morph1D::getDilation(
   const unsigned int structuringElement,
   Waveform<float>& dilationVec) const
 {
-  getDilation<float>(waveform, structuringElement, dilationVec);
+  dilationVec.resize(waveform.size());
+  getDilation<float>(waveform.data(), waveform.size(), structuringElement,
+    dilationVec.data());
+  return;
+}
+
+void icarussigproc::Morph1D::getDilation(
+  const float* waveform,
+  const size_t nTicks,
+  const unsigned int structuringElement,
+  float* dilationVec) const
+{
+  getDilation<float>(waveform, nTicks, structuringElement, dilationVec);
   return;
 }
 
@@ -105,15 +168,28 @@ void icarussigproc::Morph1D::getDilation(
   const unsigned int structuringElement,
   Waveform<double>& dilationVec) const
 {
-  getDilation<double>(waveform, structuringElement, dilationVec);
+  dilationVec.resize(waveform.size());
+  getDilation<double>(waveform.data(), waveform.size(), structuringElement,
+    dilationVec.data());
+  return;
+}
+
+void icarussigproc::Morph1D::getDilation(
+  const double* waveform,
+  const size_t nTicks,
+  const unsigned int structuringElement,
+  double* dilationVec) const
+{
+  getDilation<double>(waveform, nTicks, structuringElement, dilationVec);
   return;
 }
 
 template <typename T> 
 void icarussigproc::Morph1D::getDilation(
-  const Waveform<T>& inputWaveform,
+  const T* inputWaveform,
+  const size_t nTicks,
   const unsigned int structuringElement,
-  Waveform<T>& dilationVec) const
+  T* dilationVec) const
 {
   /*
   Module for 1D Dilation Filter.
@@ -127,27 +203,30 @@ void icarussigproc::Morph1D::getDilation(
   */
   // Set the window size
   int halfWindowSize(structuringElement/2);
+  if (getFixedMinMax(inputWaveform, nTicks, halfWindowSize, dilationVec,
+      [](T, T maxVal) { return maxVal; })) {
+    return;
+  }
+  // The initial window cannot extend past a short waveform
+  int initWindowSize(std::min(halfWindowSize, int(nTicks)));
   // Initialize min and max elements
-  std::pair<typename Waveform<T>::const_iterator,
-            typename Waveform<T>::const_iterator> minMaxItr =
+  std::pair<const T*, const T*> minMaxItr =
             std::minmax_element(
-              inputWaveform.begin(),inputWaveform.begin()+halfWindowSize);
+              inputWaveform,inputWaveform+initWindowSize);
 
-  typename Waveform<T>::const_iterator minElementItr = minMaxItr.first;
-  typename Waveform<T>::const_iterator maxElementItr = minMaxItr.second;
+  const T* minElementItr = minMaxItr.first;
+  const T* maxElementItr = minMaxItr.second;
 
-  // Initialize the erosion and dilation vectors
-  dilationVec.resize(inputWaveform.size());
   // Now loop through remaining elements and complete the vectors
-  typename Waveform<T>::iterator maxItr = dilationVec.begin();
-  for (typename Waveform<T>::const_iterator inputItr = 
-    inputWaveform.begin(); inputItr != inputWaveform.end(); inputItr++)
+  T* maxItr = dilationVec;
+  for (const T* inputItr = 
+    inputWaveform; inputItr != inputWaveform + nTicks; inputItr++)
   {
     // There are two conditions to check:
     // 1) is the current min/max element outside the current window?
     // 2) is the new element smaller/larger than the current min/max?
     // Make sure we are not running off the end of the vector
-    if (std::distance(inputItr,inputWaveform.end()) > halfWindowSize)
+    if (std::distance(inputItr,inputWaveform + nTicks) > halfWindowSize)
     {
       if (std::distance(minElementItr,inputItr) >= halfWindowSize)
           minElementItr = std::min_element(
@@ -172,7 +251,19 @@ void icarussigproc::Morph1D::getErosion(
   const unsigned int structuringElement,
   Waveform<short>& erosionVec) const
 {
-  getErosion<short>(waveform, structuringElement, erosionVec);
+  erosionVec.resize(waveform.size());
+  getErosion<short>(waveform.data(), waveform.size(), structuringElement,
+    erosionVec.data());
+  return;
+}
+
+void icarussigproc::Morph1D::getErosion(
+  const short* waveform,
+  const size_t nTicks,
+  const unsigned int structuringElement,
+  short* erosionVec) const
+{
+  getErosion<short>(waveform, nTicks, structuringElement, erosionVec);
   return;
 }
 
@@ -181,7 +272,19 @@ void icarussigproc::Morph1D::getErosion(
   const unsigned int structuringElement,
   Waveform<float>& erosionVec) const
 {
-  getErosion<float>(waveform, structuringElement, erosionVec);
+  erosionVec.resize(waveform.size());
+  getErosion<float>(waveform.data(), waveform.size(), structuringElement,
+    erosionVec.data());
+  return;
+}
+
+void icarussigproc::Morph1D::getErosion(
+  const float* waveform,
+  const size_t nTicks,
+  const unsigned int structuringElement,
+  float* erosionVec) const
+{
+  getErosion<float>(waveform, nTicks, structuringElement, erosionVec);
   return;
 }
 
@@ -190,40 +293,56 @@ void icarussigproc::Morph1D::getErosion(
   const unsigned int structuringElement,
   Waveform<double>& erosionVec) const
 {
-  getErosion<double>(waveform, structuringElement, erosionVec);
+  erosionVec.resize(waveform.size());
+  getErosion<double>(waveform.data(), waveform.size(), structuringElement,
+    erosionVec.data());
+  return;
+}
+
+void icarussigproc::Morph1D::getErosion(
+  const double* waveform,
+  const size_t nTicks,
+  const unsigned int structuringElement,
+  double* erosionVec) const
+{
+  getErosion<double>(waveform, nTicks, structuringElement, erosionVec);
   return;
 }
 
 template <typename T> 
 void icarussigproc::Morph1D::getErosion(
-  const Waveform<T>& inputWaveform,
+  const T* inputWaveform,
+  const size_t nTicks,
   const unsigned int structuringElement,
-  Waveform<T>& erosionVec) const
+  T* erosionVec) const
 {
   // Set the window size
   int halfWindowSize(structuringElement/2);
+  if (getFixedMinMax(inputWaveform, nTicks, halfWindowSize, erosionVec,
+      [](T minVal, T) { return minVal; })) {
+    return;
+  }
+  // The initial window cannot extend past a short waveform
+  int initWindowSize(std::min(halfWindowSize, int(nTicks)));
   // Initialize min and max elements
-  std::pair<typename Waveform<T>::const_iterator,
-            typename Waveform<T>::const_iterator> minMaxItr =
+  std::pair<const T*, const T*> minMaxItr =
             std::minmax_element(
-              inputWaveform.begin(),inputWaveform.begin()+halfWindowSize);
+              inputWaveform,inputWaveform+initWindowSize);
 
-  typename Waveform<T>::const_iterator minElementItr = minMaxItr.first;
-  typename Waveform<T>::const_iterator maxElementItr = minMaxItr.second;
+  const T* minElementItr = minMaxItr.first;
+  const T* maxElementItr = minMaxItr.second;
 
-  // Initialize the erosion and dilation vectors
-  erosionVec.resize(inputWaveform.size());
   // Now loop through remaining elements and complete the vectors
-  typename Waveform<T>::iterator minItr = erosionVec.begin();
+  T* minItr = erosionVec;
 
-  for (typename Waveform<T>::const_iterator inputItr = 
-    inputWaveform.begin(); inputItr != inputWaveform.end(); inputItr++)
+  for (const T* inputItr = 
+    inputWaveform; inputItr != inputWaveform + nTicks; inputItr++)
   {
     // There are two conditions to check:
     // 1) is the current min/max element outside the current window?
     // 2) is the new element smaller/larger than the current min/max?
     // Make sure we are not running off the end of the vector
-    if (std::distance(inputItr,inputWaveform.end()) > halfWindowSize)
+    if (std::distance(inputItr,inputWaveform + nTicks) > halfWindowSize)
     {
       if (std::distance(minElementItr,inputItr) >= halfWindowSize)
           minElementItr = std::min_element(
@@ -248,7 +367,19 @@ void icarussigproc::Morph1D::getGradient(
   const unsigned int structuringElement,
   Waveform<short>& gradientVec) const
 {
-  getGradient<short>(waveform, structuringElement, gradientVec);
+  gradientVec.resize(waveform.size());
+  getGradient<short>(waveform.data(), waveform.size(), structuringElement,
+    gradientVec.data());
+  return;
+}
+
+void icarussigproc::Morph1D::getGradient(
+  const short* waveform,
+  const size_t nTicks,
+  const unsigned int structuringElement,
+  short* gradientVec) const
+{
+  getGradient<short>(waveform, nTicks, structuringElement, gradientVec);
   return;
 }
 
@@ -257,7 +388,19 @@ void icarussigproc::Morph1D::getGradient(
   const unsigned int structuringElement,
   Waveform<float>& gradientVec) const
 {
-  getGradient<float>(waveform, structuringElement, gradientVec);
+  gradientVec.resize(waveform.size());
+  getGradient<float>(waveform.data(), waveform.size(), structuringElement,
+    gradientVec.data());
+  return;
+}
+
+void icarussigproc::Morph1D::getGradient(
+  const float* waveform,
+  const size_t nTicks,
+  const unsigned int structuringElement,
+  float* gradientVec) const
+{
+  getGradient<float>(waveform, nTicks, structuringElement, gradientVec);
   return;
 }
 
@@ -266,40 +409,56 @@ void icarussigproc::Morph1D::getGradient(
   const unsigned int structuringElement,
   Waveform<double>& gradientVec) const
 {
-  getGradient<double>(waveform, structuringElement, gradientVec);
+  gradientVec.resize(waveform.size());
+  getGradient<double>(waveform.data(), waveform.size(), structuringElement,
+    gradientVec.data());
+  return;
+}
+
+void icarussigproc::Morph1D::getGradient(
+  const double* waveform,
+  const size_t nTicks,
+  const unsigned int structuringElement,
+  double* gradientVec) const
+{
+  getGradient<double>(waveform, nTicks, structuringElement, gradientVec);
   return;
 }
 
 template <typename T> 
 void icarussigproc::Morph1D::getGradient(
-  const Waveform<T>& inputWaveform,
+  const T* inputWaveform,
+  const size_t nTicks,
   const unsigned int structuringElement,
-  Waveform<T>& gradientVec) const
+  T* gradientVec) const
 {
   // Set the window size
   int halfWindowSize(structuringElement/2);
+  if (getFixedMinMax(inputWaveform, nTicks, halfWindowSize, gradientVec,
+      getWindowGradient<T>)) {
+    return;
+  }
+  // The initial window cannot extend past a short waveform
+  int initWindowSize(std::min(halfWindowSize, int(nTicks)));
   // Initialize min and max elements
-  std::pair<typename Waveform<T>::const_iterator,
-            typename Waveform<T>::const_iterator> minMaxItr =
+  std::pair<const T*, const T*> minMaxItr =
             std::minmax_element(
-              inputWaveform.begin(),inputWaveform.begin()+halfWindowSize);
+              inputWaveform,inputWaveform+initWindowSize);
 
-  typename Waveform<T>::const_iterator minElementItr = minMaxItr.first;
-  typename Waveform<T>::const_iterator maxElementItr = minMaxItr.second;
+  const T* minElementItr = minMaxItr.first;
+  const T* maxElementItr = minMaxItr.second;
 
-  // Initialize the erosion and dilation vectors
-  gradientVec.resize(inputWaveform.size());
   // Now loop through remaining elements and complete the vectors
-  typename Waveform<T>::iterator difItr = gradientVec.begin();
+  T* difItr = gradientVec;
 
-  for (typename Waveform<T>::const_iterator inputItr = 
-    inputWaveform.begin(); inputItr != inputWaveform.end(); inputItr++)
+  for (const T* inputItr = 
+    inputWaveform; inputItr != inputWaveform + nTicks; inputItr++)
   {
     // There are two conditions to check:
     // 1) is the current min/max element outside the current window?
     // 2) is the new element smaller/larger than the current min/max?
     // Make sure we are not running off the end of the vector
-    if (std::distance(inputItr,inputWaveform.end()) > halfWindowSize)
+    if (std::distance(inputItr,inputWaveform + nTicks) > halfWindowSize)
     {
       if (std::distance(minElementItr,inputItr) >= halfWindowSize)
           minElementItr = std::min_element(
@@ -313,7 +472,7 @@ void icarussigproc::Morph1D::getGradient(
           maxElementItr = inputItr + halfWindowSize;
     }
     // Update the vectors
-    *difItr++ = *maxElementItr - *minElementItr;
+    *difItr++ = getWindowGradient(*minElementItr, *maxElementItr);
   }
   return;
 }
@@ -324,7 +483,19 @@ void icarussigproc::Morph1D::getAverage(
   const unsigned int structuringElement,
   Waveform<short>& averageVec) const
 {
-  getAverage<short>(waveform, structuringElement, averageVec);
+  averageVec.resize(waveform.size());
+  getAverage<short>(waveform.data(), waveform.size(), structuringElement,
+    averageVec.data());
+  return;
+}
+
+void icarussigproc::Morph1D::getAverage(
+  const short* waveform,
+  const size_t nTicks,
+  const unsigned int structuringElement,
+  short* averageVec) const
+{
+  getAverage<short>(waveform, nTicks, structuringElement, averageVec);
   return;
 }
 
@@ -333,7 +504,19 @@ void icarussigproc::Morph1D::getAverage(
   const unsigned int structuringElement,
   Waveform<float>& averageVec) const
 {
-  getAverage<float>(waveform, structuringElement, averageVec);
+  averageVec.resize(waveform.size());
+  getAverage<float>(waveform.data(), waveform.size(), structuringElement,
+    averageVec.data());
+  return;
+}
+
+void icarussigproc::Morph1D::getAverage(
+  const float* waveform,
+  const size_t nTicks,
+  const unsigned int structuringElement,
+  float* averageVec) const
+{
+  getAverage<float>(waveform, nTicks, structuringElement, averageVec);
   return;
 }
 
@@ -342,40 +525,56 @@ void icarussigproc::Morph1D::getAverage(
   const unsigned int structuringElement,
   Waveform<double>& averageVec) const
 {
-  getAverage<double>(waveform, structuringElement, averageVec);
+  averageVec.resize(waveform.size());
+  getAverage<double>(waveform.data(), waveform.size(), structuringElement,
+    averageVec.data());
+  return;
+}
+
+void icarussigproc::Morph1D::getAverage(
+  const double* waveform,
+  const size_t nTicks,
+  const unsigned int structuringElement,
+  double* averageVec) const
+{
+  getAverage<double>(waveform, nTicks, structuringElement, averageVec);
   return;
 }
 
 template <typename T> 
 void icarussigproc::Morph1D::getAverage(
-  const Waveform<T>& inputWaveform,
+  const T* inputWaveform,
+  const size_t nTicks,
   const unsigned int structuringElement,
-  Waveform<T>& averageVec) const
+  T* averageVec) const
 {
   // Set the window size
   int halfWindowSize(structuringElement/2);
+  if (getFixedMinMax(inputWaveform, nTicks, halfWindowSize, averageVec,
+      getWindowAverage<T>)) {
+    return;
+  }
+  // The initial window cannot extend past a short waveform
+  int initWindowSize(std::min(halfWindowSize, int(nTicks)));
   // Initialize min and max elements
-  std::pair<typename Waveform<T>::const_iterator,
-            typename Waveform<T>::const_iterator> minMaxItr =
+  std::pair<const T*, const T*> minMaxItr =
             std::minmax_element(
-              inputWaveform.begin(),inputWaveform.begin()+halfWindowSize);
+              inputWaveform,inputWaveform+initWindowSize);
 
-  typename Waveform<T>::const_iterator minElementItr = minMaxItr.first;
-  typename Waveform<T>::const_iterator maxElementItr = minMaxItr.second;
+  const T* minElementItr = minMaxItr.first;
+  const T* maxElementItr = minMaxItr.second;
 
-  // Initialize the erosion and dilation vectors
-  averageVec.resize(inputWaveform.size());
   // Now loop through remaining elements and complete the vectors
-  typename Waveform<T>::iterator avgItr = averageVec.begin();
+  T* avgItr = averageVec;
 
-  for (typename Waveform<T>::const_iterator inputItr = 
-    inputWaveform.begin(); inputItr != inputWaveform.end(); inputItr++)
+  for (const T* inputItr = 
+    inputWaveform; inputItr != inputWaveform + nTicks; inputItr++)
   {
     // There are two conditions to check:
     // 1) is the current min/max element outside the current window?
     // 2) is the new element smaller/larger than the current min/max?
     // Make sure we are not running off the end of the vector
-    if (std::distance(inputItr,inputWaveform.end()) > halfWindowSize)
+    if (std::distance(inputItr,inputWaveform + nTicks) > halfWindowSize)
     {
       if (std::distance(minElementItr,inputItr) >= halfWindowSize)
           minElementItr = std::min_element(
@@ -389,7 +588,7 @@ void icarussigproc::Morph1D::getAverage(
           maxElementItr = inputItr + halfWindowSize;
     }
     // Update the vectors
-    *avgItr++ = 0.5 * (*maxElementItr + *minElementItr);
+    *avgItr++ = getWindowAverage(*minElementItr, *maxElementItr);
   }
   return;
 }
@@ -433,28 +632,17 @@ void icarussigproc::Morph1D::getMedian(
   medianVec.resize(inputWaveform.size());
   size_t nTicks = inputWaveform.size();
 
-  T median = 0;
+  typename std::vector<T> localVec;
+  localVec.reserve(structuringElement + 1);
 
   for (size_t i=0; i<nTicks; ++i) {
-    typename std::vector<T> localVec;
-    localVec.reserve(structuringElement);
     int lbx = i - (int) halfWindowSize;
     int ubx = i + (int) halfWindowSize;
     size_t lowerBoundx = std::max(lbx, 0);
-    size_t upperBoundx = std::min(ubx, (int) nTicks);
-    for (size_t j=lowerBoundx; j<upperBoundx+1; ++j) {
-      localVec.push_back(inputWaveform[j]);
-    }
-    if (structuringElement % 2 == 0) {
-      const auto m1 = localVec.begin() + localVec.size() / 2 - 1;
-      const auto m2 = localVec.begin() + localVec.size() / 2;
-      std::nth_element(localVec.begin(), m1, localVec.end());
-      std::nth_element(localVec.begin(), m2, localVec.end());
-      median = (*m1 + *m2) / 2.0;
-    } else {
-      median = localVec[localVec.size() / 2];
-    }
-    medianVec[i] = median;
+    size_t upperBoundx = std::min(ubx, (int) nTicks - 1);
+    medianVec[i] = icarussigproc::MiscUtils::computeMedian(
+      inputWaveform.begin() + lowerBoundx,
+      inputWaveform.begin() + upperBoundx + 1, localVec);
   }
   return;
 }
@@ -508,9 +696,20 @@ void icarussigproc::Morph1D::getOpeningAndClosing(
   getErosion(inputWaveform, structuringElement, erosionVec);
   // Set the window size
   int halfWindowSize(structuringElement/2);
+  size_t nTicks = inputWaveform.size();
+  openingVec.resize(nTicks);
+  closingVec.resize(nTicks);
+  if (getFixedMinMax(erosionVec.data(), nTicks, halfWindowSize,
+        openingVec.data(), [](T, T maxVal) { return maxVal; }) &&
+      getFixedMinMax(dilationVec.data(), nTicks, halfWindowSize,
+        closingVec.data(), [](T minVal, T) { return minVal; })) {
+    return;
+  }
+  // The initial window cannot extend past a short waveform
+  int initWindowSize(std::min(halfWindowSize, int(inputWaveform.size())));
   // Start with the opening: get the max element in the input erosion vector
   typename Waveform<T>::iterator maxElementItr = 
-    std::max_element(erosionVec.begin(),erosionVec.begin()+halfWindowSize);
+    std::max_element(erosionVec.begin(),erosionVec.begin()+initWindowSize);
   // Initialize the opening vector
   openingVec.resize(erosionVec.size());
   // Now loop through remaining elements and complete the vectors
@@ -535,7 +734,7 @@ void icarussigproc::Morph1D::getOpeningAndClosing(
   }
   // Now go with the closing: get the min element in the input dilation vector
   typename Waveform<T>::iterator minElementItr = std::min_element(
-    dilationVec.begin(),dilationVec.begin()+halfWindowSize);
+    dilationVec.begin(),dilationVec.begin()+initWindowSize);
   // Initialize the opening and closing vectors
   closingVec.resize(dilationVec.size());
   // Now loop through remaining elements and complete the vectors
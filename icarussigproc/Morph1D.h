@@ -21,6 +21,7 @@
 #include <numeric>
 #include <cmath>
 #include <functional>
+#include "MiscUtils.h"
 
 namespace icarussigproc {
 
@@ -41,17 +42,17 @@ namespace icarussigproc {
       void getWaveformParams(const std::vector<short>&,
                              float&,
                              float&,
-                             float&);
+                             float&) const;
 
       void getWaveformParams(const std::vector<float>&,
                              float&,
                              float&,
-                             float&);
+                             float&) const;
 
       void getWaveformParams(const std::vector<double>&,
                              float&,
                              float&,
-                             float&);
+                             float&) const;
 
 
       void getDilation(const Waveform<short>&,
@@ -66,6 +67,23 @@ namespace icarussigproc {
                       const unsigned int,
                       Waveform<double>&) const;
 
+      /// Same on rows of nTicks samples, e.g. Array2D rows; the output
+      /// must hold nTicks samples
+      void getDilation(const short*,
+                      const size_t,
+                      const unsigned int,
+                      short*) const;
+
+      void getDilation(const float*,
+                      const size_t,
+                      const unsigned int,
+                      float*) const;
+
+      void getDilation(const double*,
+                      const size_t,
+                      const unsigned int,
+                      double*) const;
+
 
       void getErosion(const Waveform<short>&,
                       const unsigned int,
@@ -79,6 +97,21 @@ namespace icarussigproc {
                       const unsigned int,
                       Waveform<double>&) const;
 
+      void getErosion(const short*,
+                      const size_t,
+                      const unsigned int,
+                      short*) const;
+
+      void getErosion(const float*,
+                      const size_t,
+                      const unsigned int,
+                      float*) const;
+
+      void getErosion(const double*,
+                      const size_t,
+                      const unsigned int,
+                      double*) const;
+
 
       void getGradient(const Waveform<short>&,
                       const unsigned int,
@@ -92,6 +125,21 @@ namespace icarussigproc {
                       const unsigned int,
                       Waveform<double>&) const;
 
+      void getGradient(const short*,
+                      const size_t,
+                      const unsigned int,
+                      short*) const;
+
+      void getGradient(const float*,
+                      const size_t,
+                      const unsigned int,
+                      float*) const;
+
+      void getGradient(const double*,
+                      const size_t,
+                      const unsigned int,
+                      double*) const;
+
 
       void getAverage(const Waveform<short>&,
                       const unsigned int,
@@ -105,6 +153,21 @@ namespace icarussigproc {
                       const unsigned int,
                       Waveform<double>&) const;
 
+      void getAverage(const short*,
+                      const size_t,
+                      const unsigned int,
+                      short*) const;
+
+      void getAverage(const float*,
+                      const size_t,
+                      const unsigned int,
+                      float*) const;
+
+      void getAverage(const double*,
+                      const size_t,
+                      const unsigned int,
+                      double*) const;
+
 
       void getMedian(const Waveform<short>&,
                       const unsigned int,
@@ -144,31 +207,35 @@ namespace icarussigproc {
         const std::vector<T>& waveform,
         float& mean,
         float& median,
-        float& rms);
+        float& rms) const;
 
       template <typename T> 
       void getDilation(
-        const Waveform<T>& inputWaveform,
+        const T* inputWaveform,
+        const size_t nTicks,
         const unsigned int structuringElement,
-        Waveform<T>& dilationVec) const;
+        T* dilationVec) const;
 
       template <typename T> 
       void getErosion(
-        const Waveform<T>& inputWaveform,
+        const T* inputWaveform,
+        const size_t nTicks,
         const unsigned int structuringElement,
-        Waveform<T>& erosionVec) const;
+        T* erosionVec) const;
 
       template <typename T> 
       void getGradient(
-        const Waveform<T>& inputWaveform,
+        const T* inputWaveform,
+        const size_t nTicks,
         const unsigned int structuringElement,
-        Waveform<T>& gradientVec) const;
+        T* gradientVec) const;
     
       template <typename T> 
       void getAverage(
-        const Waveform<T>& inputWaveform,
+        const T* inputWaveform,
+        const size_t nTicks,
         const unsigned int structuringElement,
-        Waveform<T>& averageVec) const;
+        T* averageVec) const;
 
       template <typename T> 
       void getMedian(
@@ -2,6 +2,137 @@
 #define __SIGPROC_TOOLS_MORPH2D_CXX__
 
 #include "Morph2D.h"
+#include "Int16Kernels.h"
+#include "ParallelFor.h"
+#include "WindowKernels.h"
+
+// Channels per task of the 2D filters
+static const size_t kBandRows = 4;
+
+// 2D min/max filters with registered half windows, separated into an
+// unrolled pass over ticks and one over channels. The windows are those of
+// the loops below, [i - hx, i + hx) x [j - hy, j + hy) clipped to the
+// plane; store(i, j, min, max) writes the outputs. False when a size is not
+// registered.
+template <typename T, typename InArray, typename Store>
+static bool getFixedMinMax2D(
+  const InArray& waveform2D,
+  const int xHalfWindowSize,
+  const int yHalfWindowSize,
+  const unsigned int numThreads,
+  Store store)
+{
+  size_t numChannels = icarussigproc::numRows(waveform2D);
+  size_t nTicks = icarussigproc::numCols(waveform2D);
+  if (numChannels == 0 || nTicks == 0) return false;
+  return icarussigproc::dispatchSizes(icarussigproc::ChannelHalfWindows(),
+    icarussigproc::TickHalfWindows(), xHalfWindowSize, yHalfWindowSize,
+    [&](auto halfx, auto halfy) {
+      constexpr int HX = decltype(halfx)::value;
+      constexpr int HY = decltype(halfy)::value;
+
+      // Extrema over the tick window of every channel
+      icarussigproc::Array2D<T> rowMin(numChannels, nTicks);
+      icarussigproc::Array2D<T> rowMax(numChannels, nTicks);
+      auto processTicks = [&](size_t begin, size_t end, unsigned int) {
+        for (size_t i=begin; i<end; ++i) {
+          T* minRow = rowMin[i];
+          T* maxRow = rowMax[i];
+          icarussigproc::slidingMinMax<-HY, HY - 1>(&waveform2D[i][0], nTicks,
+            nTicks, [minRow, maxRow](size_t j, T minVal, T maxVal) {
+              minRow[j] = minVal;
+              maxRow[j] = maxVal;
+            });
+        }
+      };
+      icarussigproc::parallelFor(numChannels, kBandRows, processTicks,
+        numThreads);
+
+      // Extrema of those over the channel window
+      auto processChannels = [&](size_t begin, size_t end, unsigned int) {
+        for (size_t i=begin; i<end; ++i) {
+          if (i >= HX && i + HX <= numChannels) {
+            for (size_t j=0; j<nTicks; ++j) {
+              T minVal = rowMin[i - HX][j];
+              T maxVal = rowMax[i - HX][j];
+              icarussigproc::unrollRange<1, 2 * HX - 1>([&](auto k) {
+                minVal = std::min(minVal, rowMin[i - HX + k][j]);
+                maxVal = std::max(maxVal, rowMax[i - HX + k][j]);
+              });
+              store(i, j, minVal, maxVal);
+            }
+          } else {
+            size_t lowerBoundx = i >= HX ? i - HX : 0;
+            size_t upperBoundx = std::min(i + HX, numChannels);
+            for (size_t j=0; j<nTicks; ++j) {
+              T minVal = rowMin[lowerBoundx][j];
+              T maxVal = rowMax[lowerBoundx][j];
+              for (size_t ix=lowerBoundx+1; ix<upperBoundx; ++ix) {
+                minVal = std::min(minVal, rowMin[ix][j]);
+                maxVal = std::max(maxVal, rowMax[ix][j]);
+              }
+              store(i, j, minVal, maxVal);
+            }
+          }
+        }
+      };
+      icarussigproc::parallelFor(numChannels, kBandRows, processChannels,
+        numThreads);
+    });
+}
+
+// The same separable min/max filters for int16 planes and any window size,
+// on the SIMD row kernels of Int16Kernels.h. store(i, minRow, maxRow) gets
+// the extrema of channel i. False for half windows of 0, whose windows are
+// empty, and for empty planes.
+template <typename InArray, typename Store>
+static bool getInt16MinMax2D(
+  const InArray& waveform2D,
+  const int xHalfWindowSize,
+  const int yHalfWindowSize,
+  const unsigned int numThreads,
+  Store store)
+{
+  size_t numChannels = icarussigproc::numRows(waveform2D);
+  size_t nTicks = icarussigproc::numCols(waveform2D);
+  if (numChannels == 0 || nTicks == 0) return false;
+  if (xHalfWindowSize <= 0 || yHalfWindowSize <= 0) return false;
+
+  // Extrema over the tick window of every channel
+  icarussigproc::Array2D<short> rowMin(numChannels, nTicks);
+  icarussigproc::Array2D<short> rowMax(numChannels, nTicks);
+  auto processTicks = [&](size_t begin, size_t end, unsigned int) {
+    for (size_t i=begin; i<end; ++i) {
+      icarussigproc::slidingMinMaxRow(&waveform2D[i][0], nTicks,
+        -yHalfWindowSize, yHalfWindowSize - 1, rowMin[i], rowMax[i]);
+    }
+  };
+  icarussigproc::parallelFor(numChannels, kBandRows, processTicks,
+    numThreads);
+
+  // Extrema of those over the channel window, accumulated a row at a time
+  auto processChannels = [&](size_t begin, size_t end, unsigned int) {
+    std::vector<short> minVals(nTicks);
+    std::vector<short> maxVals(nTicks);
+    for (size_t i=begin; i<end; ++i) {
+      size_t lowerBoundx = i >= size_t(xHalfWindowSize) ?
+        i - xHalfWindowSize : 0;
+      size_t upperBoundx = std::min(i + xHalfWindowSize, numChannels);
+      std::copy(rowMin[lowerBoundx], rowMin[lowerBoundx] + nTicks,
+        minVals.begin());
+      std::copy(rowMax[lowerBoundx], rowMax[lowerBoundx] + nTicks,
+        maxVals.begin());
+      for (size_t ix=lowerBoundx+1; ix<upperBoundx; ++ix) {
+        icarussigproc::minRow(rowMin[ix], minVals.data(), nTicks);
+        icarussigproc::maxRow(rowMax[ix], maxVals.data(), nTicks);
+      }
+      store(i, minVals.data(), maxVals.data());
+    }
+  };
+  icarussigproc::parallelFor(numChannels, kBandRows, processChannels,
+    numThreads);
+  return true;
+}
 
 
 void icarussigproc::Morph2D::getFilter2D(
@@ -46,64 +177,131 @@ void icarussigproc::Morph2D::getFilter2D(
   return;
 }
 
-template <typename T>
 void icarussigproc::Morph2D::getFilter2D(
-  const std::vector<std::vector<T> >& waveform2D,
+  const Array2DView<const short> waveform2D,
   const unsigned int structuringElementx,
   const unsigned int structuringElementy,
-  std::vector<std::vector<T> >& dilation2D,
-  std::vector<std::vector<T> >& erosion2D,
-  std::vector<std::vector<T> >& average2D,
-  std::vector<std::vector<T> >& gradient2D) const
+  Array2D<short>& dilation2D,
+  Array2D<short>& erosion2D,
+  Array2D<short>& average2D,
+  Array2D<short>& gradient2D) const
 {
-  auto numChannels = waveform2D.size();
-  auto nTicks = waveform2D.at(0).size();
+  getFilter2D<short>(waveform2D, structuringElementx, structuringElementy,
+    dilation2D, erosion2D, average2D, gradient2D);
+  return;
+}
+
+void icarussigproc::Morph2D::getFilter2D(
+  const Array2DView<const float> waveform2D,
+  const unsigned int structuringElementx,
+  const unsigned int structuringElementy,
+  Array2D<float>& dilation2D,
+  Array2D<float>& erosion2D,
+  Array2D<float>& average2D,
+  Array2D<float>& gradient2D) const
+{
+  getFilter2D<float>(waveform2D, structuringElementx, structuringElementy,
+    dilation2D, erosion2D, average2D, gradient2D);
+  return;
+}
+
+void icarussigproc::Morph2D::getFilter2D(
+  const Array2DView<const double> waveform2D,
+  const unsigned int structuringElementx,
+  const unsigned int structuringElementy,
+  Array2D<double>& dilation2D,
+  Array2D<double>& erosion2D,
+  Array2D<double>& average2D,
+  Array2D<double>& gradient2D) const
+{
+  getFilter2D<double>(waveform2D, structuringElementx, structuringElementy,
+    dilation2D, erosion2D, average2D, gradient2D);
+  return;
+}
+
+template <typename T, typename InArray, typename OutArray>
+void icarussigproc::Morph2D::getFilter2D(
+  const InArray& waveform2D,
+  const unsigned int structuringElementx,
+  const unsigned int structuringElementy,
+  OutArray& dilation2D,
+  OutArray& erosion2D,
+  OutArray& average2D,
+  OutArray& gradient2D) const
+{
+  auto numChannels = numRows(waveform2D);
+  auto nTicks = numCols(waveform2D);
   int xHalfWindowSize(structuringElementx / 2);
   int yHalfWindowSize(structuringElementy / 2);
 
-  dilation2D.resize(waveform2D.size());
-  erosion2D.resize(waveform2D.size());
-  average2D.resize(waveform2D.size());
-  gradient2D.resize(waveform2D.size());
+  resize2D(dilation2D, numChannels, nTicks);
+  resize2D(erosion2D, numChannels, nTicks);
+  resize2D(average2D, numChannels, nTicks);
+  resize2D(gradient2D, numChannels, nTicks);
+
+  // int16 planes stay int16, with the rounding rules of Int16Kernels.h
+  if constexpr (std::is_same<T, short>::value) {
+    if (getInt16MinMax2D(waveform2D, xHalfWindowSize, yHalfWindowSize,
+        fNumThreads, [&](size_t i, const short* minRow, const short* maxRow) {
+          std::copy(maxRow, maxRow + nTicks, &dilation2D[i][0]);
+          std::copy(minRow, minRow + nTicks, &erosion2D[i][0]);
+          averageRow(minRow, maxRow, &average2D[i][0], nTicks);
+          subtractRow(maxRow, minRow, &gradient2D[i][0], nTicks);
+        })) {
+      return;
+    }
+  }
 
-  for (size_t i=0; i<waveform2D.size(); ++i) {
-    dilation2D[i].resize(waveform2D.at(0).size());
-    erosion2D[i].resize(waveform2D.at(0).size());
-    average2D[i].resize(waveform2D.at(0).size());
-    gradient2D[i].resize(waveform2D.at(0).size());
+  // Registered window sizes take the separable kernel of WindowKernels.h
+  if (getFixedMinMax2D<T>(waveform2D, xHalfWindowSize, yHalfWindowSize,
+      fNumThreads, [&](size_t i, size_t j, T minVal, T maxVal) {
+        float dilation = maxVal;
+        float erosion = minVal;
+        float average = 0.5 * (dilation + erosion);
+        float gradient = dilation - erosion;
+        dilation2D[i][j] = dilation;
+        erosion2D[i][j] = erosion;
+        average2D[i][j] = average;
+        gradient2D[i][j] = gradient;
+      })) {
+    return;
   }
-  float dilation;
-  float erosion;
-  float gradient;
-  float average;
-  for (size_t i=0; i<numChannels; ++i) {
-    for (size_t j=0; j<nTicks; ++j) {
-      // For each center pixel, do 2D morphological filtering.
-      int lbx = i - (int) xHalfWindowSize;
-      int ubx = i + (int) xHalfWindowSize;
-      int lby = j - (int) yHalfWindowSize;
-      int uby = j + (int) yHalfWindowSize;
-      size_t lowerBoundx = std::max(lbx, 0);
-      size_t upperBoundx = std::min(ubx, (int) numChannels);
-      size_t lowerBoundy = std::max(lby, 0);
-      size_t upperBoundy = std::min(uby, (int) nTicks);
-      std::vector<T> v;
-      v.reserve(structuringElementx * structuringElementy);
-      for (size_t ix=lowerBoundx; ix<upperBoundx; ++ix) {
-        for (size_t iy=lowerBoundy; iy<upperBoundy; ++iy) {
-          v.push_back(waveform2D[ix][iy]);
+
+  auto processBand = [&](size_t begin, size_t end, unsigned int) {
+    float dilation;
+    float erosion;
+    float gradient;
+    float average;
+    for (size_t i=begin; i<end; ++i) {
+      for (size_t j=0; j<nTicks; ++j) {
+        // For each center pixel, do 2D morphological filtering.
+        int lbx = i - (int) xHalfWindowSize;
+        int ubx = i + (int) xHalfWindowSize;
+        int lby = j - (int) yHalfWindowSize;
+        int uby = j + (int) yHalfWindowSize;
+        size_t lowerBoundx = std::max(lbx, 0);
+        size_t upperBoundx = std::min(ubx, (int) numChannels);
+        size_t lowerBoundy = std::max(lby, 0);
+        size_t upperBoundy = std::min(uby, (int) nTicks);
+        std::vector<T> v;
+        v.reserve(structuringElementx * structuringElementy);
+        for (size_t ix=lowerBoundx; ix<upperBoundx; ++ix) {
+          for (size_t iy=lowerBoundy; iy<upperBoundy; ++iy) {
+            v.push_back(waveform2D[ix][iy]);
+          }
         }
+        dilation = *std::max_element(v.begin(), v.end());
+        erosion = *std::min_element(v.begin(), v.end());
+        average = 0.5 * (dilation + erosion);
+        gradient = dilation - erosion;
+        dilation2D[i][j] = dilation;
+        erosion2D[i][j] = erosion;
+        average2D[i][j] = average;
+        gradient2D[i][j] = gradient;
       }
-      dilation = *std::max_element(v.begin(), v.end());
-      erosion = *std::min_element(v.begin(), v.end());
-      average = 0.5 * (dilation + erosion);
-      gradient = dilation - erosion;
-      dilation2D[i][j] = dilation;
-      erosion2D[i][j] = erosion;
-      average2D[i][j] = average;
-      gradient2D[i][j] = gradient;
     }
-  }
+  };
+  parallelFor(numChannels, kBandRows, processBand, fNumThreads);
   return;
 }
 
@@ -141,46 +339,98 @@ void icarussigproc::Morph2D::getDilation(
   return;
 }
 
-template <typename T>
 void icarussigproc::Morph2D::getDilation(
-  const std::vector<std::vector<T> >& waveform2D,
+  const Array2DView<const short> waveform2D,
   const unsigned int structuringElementx,
   const unsigned int structuringElementy,
-  std::vector<std::vector<T> >& dilation2D) const
+  Array2D<short>& dilation2D) const
 {
-  auto numChannels = waveform2D.size();
-  auto nTicks = waveform2D.at(0).size();
+  getDilation<short>(waveform2D, structuringElementx, 
+    structuringElementy, dilation2D);
+  return;
+}
+
+void icarussigproc::Morph2D::getDilation(
+  const Array2DView<const float> waveform2D,
+  const unsigned int structuringElementx,
+  const unsigned int structuringElementy,
+  Array2D<float>& dilation2D) const
+{
+  getDilation<float>(waveform2D, structuringElementx, 
+    structuringElementy, dilation2D);
+  return;
+}
+
+void icarussigproc::Morph2D::getDilation(
+  const Array2DView<const double> waveform2D,
+  const unsigned int structuringElementx,
+  const unsigned int structuringElementy,
+  Array2D<double>& dilation2D) const
+{
+  getDilation<double>(waveform2D, structuringElementx, 
+    structuringElementy, dilation2D);
+  return;
+}
+
+template <typename T, typename InArray, typename OutArray>
+void icarussigproc::Morph2D::getDilation(
+  const InArray& waveform2D,
+  const unsigned int structuringElementx,
+  const unsigned int structuringElementy,
+  OutArray& dilation2D) const
+{
+  auto numChannels = numRows(waveform2D);
+  auto nTicks = numCols(waveform2D);
   int xHalfWindowSize(structuringElementx / 2);
   int yHalfWindowSize(structuringElementy / 2);
 
-  dilation2D.resize(waveform2D.size());
+  resize2D(dilation2D, numChannels, nTicks);
 
-  for (size_t i=0; i<waveform2D.size(); ++i) {
-    dilation2D[i].resize(waveform2D.at(0).size());
+  // int16 planes stay int16, with the rounding rules of Int16Kernels.h
+  if constexpr (std::is_same<T, short>::value) {
+    if (getInt16MinMax2D(waveform2D, xHalfWindowSize, yHalfWindowSize,
+        fNumThreads, [&](size_t i, const short*, const short* maxRow) {
+          std::copy(maxRow, maxRow + nTicks, &dilation2D[i][0]);
+        })) {
+      return;
+    }
   }
-  float dilation;
-  for (size_t i=0; i<numChannels; ++i) {
-    for (size_t j=0; j<nTicks; ++j) {
-      // For each center pixel, do 2D morphological filtering.
-      int lbx = i - (int) xHalfWindowSize;
-      int ubx = i + (int) xHalfWindowSize;
-      int lby = j - (int) yHalfWindowSize;
-      int uby = j + (int) yHalfWindowSize;
-      size_t lowerBoundx = std::max(lbx, 0);
-      size_t upperBoundx = std::min(ubx, (int) numChannels);
-      size_t lowerBoundy = std::max(lby, 0);
-      size_t upperBoundy = std::min(uby, (int) nTicks);
-      std::vector<T> v;
-      v.reserve(structuringElementx * structuringElementy);
-      for (size_t ix=lowerBoundx; ix<upperBoundx; ++ix) {
-        for (size_t iy=lowerBoundy; iy<upperBoundy; ++iy) {
-          v.push_back(waveform2D[ix][iy]);
+
+  // Registered window sizes take the separable kernel of WindowKernels.h
+  if (getFixedMinMax2D<T>(waveform2D, xHalfWindowSize, yHalfWindowSize,
+      fNumThreads, [&](size_t i, size_t j, T, T maxVal) {
+        float dilation = maxVal;
+        dilation2D[i][j] = dilation;
+      })) {
+    return;
+  }
+
+  auto processBand = [&](size_t begin, size_t end, unsigned int) {
+    float dilation;
+    for (size_t i=begin; i<end; ++i) {
+      for (size_t j=0; j<nTicks; ++j) {
+        // For each center pixel, do 2D morphological filtering.
+        int lbx = i - (int) xHalfWindowSize;
+        int ubx = i + (int) xHalfWindowSize;
+        int lby = j - (int) yHalfWindowSize;
+        int uby = j + (int) yHalfWindowSize;
+        size_t lowerBoundx = std::max(lbx, 0);
+        size_t upperBoundx = std::min(ubx, (int) numChannels);
+        size_t lowerBoundy = std::max(lby, 0);
+        size_t upperBoundy = std::min(uby, (int) nTicks);
+        std::vector<T> v;
+        v.reserve(structuringElementx * structuringElementy);
+        for (size_t ix=lowerBoundx; ix<upperBoundx; ++ix) {
+          for (size_t iy=lowerBoundy; iy<upperBoundy; ++iy) {
+            v.push_back(waveform2D[ix][iy]);
+          }
         }
+        dilation = *std::max_element(v.begin(), v.end());
+        dilation2D[i][j] = dilation;
       }
-      dilation = *std::max_element(v.begin(), v.end());
-      dilation2D[i][j] = dilation;
     }
-  }
+  };
+  parallelFor(numChannels, kBandRows, processBand, fNumThreads);
   return;
 }
 
@@ -218,46 +468,98 @@ void icarussigproc::Morph2D::getErosion(
   return;
 }
 
-template <typename T>
 void icarussigproc::Morph2D::getErosion(
-  const std::vector<std::vector<T> >& waveform2D,
+  const Array2DView<const short> waveform2D,
+  const unsigned int structuringElementx,
+  const unsigned int structuringElementy,
+  Array2D<short>& erosion2D) const
+{
+  getErosion<short>(waveform2D, structuringElementx, 
+    structuringElementy, erosion2D);
+  return;
+}
+
+void icarussigproc::Morph2D::getErosion(
+  const Array2DView<const float> waveform2D,
+  const unsigned int structuringElementx,
+  const unsigned int structuringElementy,
+  Array2D<float>& erosion2D) const
+{
+  getErosion<float>(waveform2D, structuringElementx, 
+    structuringElementy, erosion2D);
+  return;
+}
+
+void icarussigproc::Morph2D::getErosion(
+  const Array2DView<const double> waveform2D,
+  const unsigned int structuringElementx,
+  const unsigned int structuringElementy,
+  Array2D<double>& erosion2D) const
+{
+  getErosion<double>(waveform2D, structuringElementx, 
+    structuringElementy, erosion2D);
+  return;
+}
+
+template <typename T, typename InArray, typename OutArray>
+void icarussigproc::Morph2D::getErosion(
+  const InArray& waveform2D,
   const unsigned int structuringElementx,
   const unsigned int structuringElementy,
-  std::vector<std::vector<T> >& erosion2D) const
+  OutArray& erosion2D) const
 {
-  auto numChannels = waveform2D.size();
-  auto nTicks = waveform2D.at(0).size();
+  auto numChannels = numRows(waveform2D);
+  auto nTicks = numCols(waveform2D);
   int xHalfWindowSize(structuringElementx / 2);
   int yHalfWindowSize(structuringElementy / 2);
 
-  erosion2D.resize(waveform2D.size());
+  resize2D(erosion2D, numChannels, nTicks);
+
+  // int16 planes stay int16, with the rounding rules of Int16Kernels.h
+  if constexpr (std::is_same<T, short>::value) {
+    if (getInt16MinMax2D(waveform2D, xHalfWindowSize, yHalfWindowSize,
+        fNumThreads, [&](size_t i, const short* minRow, const short*) {
+          std::copy(minRow, minRow + nTicks, &erosion2D[i][0]);
+        })) {
+      return;
+    }
+  }
 
-  for (size_t i=0; i<waveform2D.size(); ++i) {
-    erosion2D[i].resize(waveform2D.at(0).size());
+  // Registered window sizes take the separable kernel of WindowKernels.h
+  if (getFixedMinMax2D<T>(waveform2D, xHalfWindowSize, yHalfWindowSize,
+      fNumThreads, [&](size_t i, size_t j, T minVal, T) {
+        float erosion = minVal;
+        erosion2D[i][j] = erosion;
+      })) {
+    return;
   }
-  float erosion;
-  for (size_t i=0; i<numChannels; ++i) {
-    for (size_t j=0; j<nTicks; ++j) {
-      // For each center pixel, do 2D morphological filtering.
-      int lbx = i - (int) xHalfWindowSize;
-      int ubx = i + (int) xHalfWindowSize;
-      int lby = j - (int) yHalfWindowSize;
-      int uby = j + (int) yHalfWindowSize;
-      size_t lowerBoundx = std::max(lbx, 0);
-      size_t upperBoundx = std::min(ubx, (int) numChannels);
-      size_t lowerBoundy = std::max(lby, 0);
-      size_t upperBoundy = std::min(uby, (int) nTicks);
-      std::vector<T> v;
-      v.reserve(structuringElementx * structuringElementy);
-      for (size_t ix=lowerBoundx; ix<upperBoundx; ++ix) {
-        for (size_t iy=lowerBoundy; iy<upperBoundy; ++iy) {
-          v.push_back(waveform2D[ix][iy]);
+
+  auto processBand = [&](size_t begin, size_t end, unsigned int) {
+    float erosion;
+    for (size_t i=begin; i<end; ++i) {
+      for (size_t j=0; j<nTicks; ++j) {
+        // For each center pixel, do 2D morphological filtering.
+        int lbx = i - (int) xHalfWindowSize;
+        int ubx = i + (int) xHalfWindowSize;
+        int lby = j - (int) yHalfWindowSize;
+        int uby = j + (int) yHalfWindowSize;
+        size_t lowerBoundx = std::max(lbx, 0);
+        size_t upperBoundx = std::min(ubx, (int) numChannels);
+        size_t lowerBoundy = std::max(lby, 0);
+        size_t upperBoundy = std::min(uby, (int) nTicks);
+        std::vector<T> v;
+        v.reserve(structuringElementx * structuringElementy);
+        for (size_t ix=lowerBoundx; ix<upperBoundx; ++ix) {
+          for (size_t iy=lowerBoundy; iy<upperBoundy; ++iy) {
+            v.push_back(waveform2D[ix][iy]);
+          }
         }
+        erosion = *std::min_element(v.begin(), v.end());
+        erosion2D[i][j] = erosion;
       }
-      erosion = *std::min_element(v.begin(), v.end());
-      erosion2D[i][j] = erosion;
     }
-  }
+  };
+  parallelFor(numChannels, kBandRows, processBand, fNumThreads);
   return;
 }
 
@@ -295,50 +597,104 @@ void icarussigproc::Morph2D::getGradient(
   return;
 }
 
-template <typename T>
 void icarussigproc::Morph2D::getGradient(
-  const std::vector<std::vector<T> >& waveform2D,
+  const Array2DView<const short> waveform2D,
   const unsigned int structuringElementx,
   const unsigned int structuringElementy,
-  std::vector<std::vector<T> >& gradient2D) const
+  Array2D<short>& gradient2D) const
 {
-  auto numChannels = waveform2D.size();
-  auto nTicks = waveform2D.at(0).size();
+  getGradient<short>(waveform2D, structuringElementx, 
+    structuringElementy, gradient2D);
+  return;
+}
+
+void icarussigproc::Morph2D::getGradient(
+  const Array2DView<const float> waveform2D,
+  const unsigned int structuringElementx,
+  const unsigned int structuringElementy,
+  Array2D<float>& gradient2D) const
+{
+  getGradient<float>(waveform2D, structuringElementx, 
+    structuringElementy, gradient2D);
+  return;
+}
+
+void icarussigproc::Morph2D::getGradient(
+  const Array2DView<const double> waveform2D,
+  const unsigned int structuringElementx,
+  const unsigned int structuringElementy,
+  Array2D<double>& gradient2D) const
+{
+  getGradient<double>(waveform2D, structuringElementx, 
+    structuringElementy, gradient2D);
+  return;
+}
+
+template <typename T, typename InArray, typename OutArray>
+void icarussigproc::Morph2D::getGradient(
+  const InArray& waveform2D,
+  const unsigned int structuringElementx,
+  const unsigned int structuringElementy,
+  OutArray& gradient2D) const
+{
+  auto numChannels = numRows(waveform2D);
+  auto nTicks = numCols(waveform2D);
   int xHalfWindowSize(structuringElementx / 2);
   int yHalfWindowSize(structuringElementy / 2);
 
-  gradient2D.resize(waveform2D.size());
+  resize2D(gradient2D, numChannels, nTicks);
 
-  for (size_t i=0; i<waveform2D.size(); ++i) {
-    gradient2D[i].resize(waveform2D.at(0).size());
+  // int16 planes stay int16, with the rounding rules of Int16Kernels.h
+  if constexpr (std::is_same<T, short>::value) {
+    if (getInt16MinMax2D(waveform2D, xHalfWindowSize, yHalfWindowSize,
+        fNumThreads, [&](size_t i, const short* minRow, const short* maxRow) {
+          subtractRow(maxRow, minRow, &gradient2D[i][0], nTicks);
+        })) {
+      return;
+    }
+  }
+
+  // Registered window sizes take the separable kernel of WindowKernels.h
+  if (getFixedMinMax2D<T>(waveform2D, xHalfWindowSize, yHalfWindowSize,
+      fNumThreads, [&](size_t i, size_t j, T minVal, T maxVal) {
+        float dilation = maxVal;
+        float erosion = minVal;
+        float gradient = dilation - erosion;
+        gradient2D[i][j] = gradient;
+      })) {
+    return;
   }
-  float dilation;
-  float erosion;
-  float gradient;
-  for (size_t i=0; i<numChannels; ++i) {
-    for (size_t j=0; j<nTicks; ++j) {
-      // For each center pixel, do 2D morphological filtering.
-      int lbx = i - (int) xHalfWindowSize;
-      int ubx = i + (int) xHalfWindowSize;
-      int lby = j - (int) yHalfWindowSize;
-      int uby = j + (int) yHalfWindowSize;
-      size_t lowerBoundx = std::max(lbx, 0);
-      size_t upperBoundx = std::min(ubx, (int) numChannels);
-      size_t lowerBoundy = std::max(lby, 0);
-      size_t upperBoundy = std::min(uby, (int) nTicks);
-      std::vector<T> v;
-      v.reserve(structuringElementx * structuringElementy);
-      for (size_t ix=lowerBoundx; ix<upperBoundx; ++ix) {
-        for (size_t iy=lowerBoundy; iy<upperBoundy; ++iy) {
-          v.push_back(waveform2D[ix][iy]);
+
+  auto processBand = [&](size_t begin, size_t end, unsigned int) {
+    float dilation;
+    float erosion;
+    float gradient;
+    for (size_t i=begin; i<end; ++i) {
+      for (size_t j=0; j<nTicks; ++j) {
+        // For each center pixel, do 2D morphological filtering.
+        int lbx = i - (int) xHalfWindowSize;
+        int ubx = i + (int) xHalfWindowSize;
+        int lby = j - (int) yHalfWindowSize;
+        int uby = j + (int) yHalfWindowSize;
+        size_t lowerBoundx = std::max(lbx, 0);
+        size_t upperBoundx = std::min(ubx, (int) numChannels);
+        size_t lowerBoundy = std::max(lby, 0);
+        size_t upperBoundy = std::min(uby, (int) nTicks);
+        std::vector<T> v;
+        v.reserve(structuringElementx * structuringElementy);
+        for (size_t ix=lowerBoundx; ix<upperBoundx; ++ix) {
+          for (size_t iy=lowerBoundy; iy<upperBoundy; ++iy) {
+            v.push_back(waveform2D[ix][iy]);
+          }
         }
+        dilation = *std::max_element(v.begin(), v.end());
+        erosion = *std::min_element(v.begin(), v.end());
+        gradient = dilation - erosion;
+        gradient2D[i][j] = gradient;
       }
-      dilation = *std::max_element(v.begin(), v.end());
-      erosion = *std::min_element(v.begin(), v.end());
-      gradient = dilation - erosion;
-      gradient2D[i][j] = gradient;
     }
-  }
+  };
+  parallelFor(numChannels, kBandRows, processBand, fNumThreads);
   return;
 }
 
@@ -376,54 +732,79 @@ void icarussigproc::Morph2D::getMedian(
   return;
 }
 
-template <typename T>
 void icarussigproc::Morph2D::getMedian(
-  const std::vector<std::vector<T> >& waveform2D,
+  const Array2DView<const short> waveform2D,
+  const unsigned int structuringElementx,
+  const unsigned int structuringElementy,
+  Array2D<short>& median2D) const
+{
+  getMedian<short>(waveform2D, structuringElementx, 
+    structuringElementy, median2D);
+  return;
+}
+
+void icarussigproc::Morph2D::getMedian(
+  const Array2DView<const float> waveform2D,
   const unsigned int structuringElementx,
   const unsigned int structuringElementy,
-  std::vector<std::vector<T> >& median2D) const
+  Array2D<float>& median2D) const
 {
-  auto numChannels = waveform2D.size();
-  auto nTicks = waveform2D.at(0).size();
+  getMedian<float>(waveform2D, structuringElementx, 
+    structuringElementy, median2D);
+  return;
+}
+
+void icarussigproc::Morph2D::getMedian(
+  const Array2DView<const double> waveform2D,
+  const unsigned int structuringElementx,
+  const unsigned int structuringElementy,
+  Array2D<double>& median2D) const
+{
+  getMedian<double>(waveform2D, structuringElementx, 
+    structuringElementy, median2D);
+  return;
+}
+
+template <typename T, typename InArray, typename OutArray>
+void icarussigproc::Morph2D::getMedian(
+  const InArray& waveform2D,
+  const unsigned int structuringElementx,
+  const unsigned int structuringElementy,
+  OutArray& median2D) const
+{
+  auto numChannels = numRows(waveform2D);
+  auto nTicks = numCols(waveform2D);
   int xHalfWindowSize(structuringElementx / 2);
   int yHalfWindowSize(structuringElementy / 2);
 
-  median2D.resize(waveform2D.size());
-
-  for (size_t i=0; i<waveform2D.size(); ++i) {
-    median2D[i].resize(waveform2D.at(0).size());
-  }
-  float median;
-  for (size_t i=0; i<numChannels; ++i) {
-    for (size_t j=0; j<nTicks; ++j) {
-      // For each center pixel, do 2D morphological filtering.
-      int lbx = i - (int) xHalfWindowSize;
-      int ubx = i + (int) xHalfWindowSize;
-      int lby = j - (int) yHalfWindowSize;
-      int uby = j + (int) yHalfWindowSize;
-      size_t lowerBoundx = std::max(lbx, 0);
-      size_t upperBoundx = std::min(ubx, (int) numChannels);
-      size_t lowerBoundy = std::max(lby, 0);
-      size_t upperBoundy = std::min(uby, (int) nTicks);
-      std::vector<T> v;
-      v.reserve(structuringElementx * structuringElementy);
-      for (size_t ix=lowerBoundx; ix<upperBoundx; ++ix) {
-        for (size_t iy=lowerBoundy; iy<upperBoundy; ++iy) {
-          v.push_back(waveform2D[ix][iy]);
+  resize2D(median2D, numChannels, nTicks);
+
+  auto processBand = [&](size_t begin, size_t end, unsigned int) {
+    std::vector<T> v;
+    v.reserve(structuringElementx * structuringElementy);
+    for (size_t i=begin; i<end; ++i) {
+      for (size_t j=0; j<nTicks; ++j) {
+        // For each center pixel, do 2D morphological filtering.
+        int lbx = i - (int) xHalfWindowSize;
+        int ubx = i + (int) xHalfWindowSize;
+        int lby = j - (int) yHalfWindowSize;
+        int uby = j + (int) yHalfWindowSize;
+        size_t lowerBoundx = std::max(lbx, 0);
+        size_t upperBoundx = std::min(ubx, (int) numChannels);
+        size_t lowerBoundy = std::max(lby, 0);
+        size_t upperBoundy = std::min(uby, (int) nTicks);
+        v.clear();
+        for (size_t ix=lowerBoundx; ix<upperBoundx; ++ix) {
+          for (size_t iy=lowerBoundy; iy<upperBoundy; ++iy) {
+            v.push_back(waveform2D[ix][iy]);
+          }
         }
+        median2D[i][j] = icarussigproc::MiscUtils::computeMedianInPlace(
+          v.begin(), v.end());
       }
-      if (v.size() % 2 == 0) {
-        const auto m1 = v.begin() + v.size() / 2 - 1;
-        const auto m2 = v.begin() + v.size() / 2;
-        std::nth_element(v.begin(), m1, v.end());
-        std::nth_element(v.begin(), m2, v.end());
-        median = (*m1 + *m2) / 2.0;
-      } else {
-        median = v[v.size() / 2];
-      }
-      median2D[i][j] = median;
     }
-  }
+  };
+  parallelFor(numChannels, kBandRows, processBand, fNumThreads);
   return;
 }
 
@@ -476,64 +857,126 @@ void icarussigproc::Morph2D::getOpeningAndClosing(
   return;
 }
 
+void icarussigproc::Morph2D::getOpeningAndClosing(
+  const Array2DView<const short> waveform2D,
+  const unsigned int structuringElementx,
+  const unsigned int structuringElementy,
+  Array2D<short>& opening2D,
+  Array2D<short>& closing2D) const
+{
+  getOpeningAndClosing<short>(
+    waveform2D, 
+    structuringElementx, 
+    structuringElementy, 
+    opening2D,
+    closing2D);
+  return;
+}
+
+void icarussigproc::Morph2D::getOpeningAndClosing(
+  const Array2DView<const float> waveform2D,
+  const unsigned int structuringElementx,
+  const unsigned int structuringElementy,
+  Array2D<float>& opening2D,
+  Array2D<float>& closing2D) const
+{
+  getOpeningAndClosing<float>(
+    waveform2D, 
+    structuringElementx, 
+    structuringElementy, 
+    opening2D,
+    closing2D);
+  return;
+}
+
+void icarussigproc::Morph2D::getOpeningAndClosing(
+  const Array2DView<const double> waveform2D,
+  const unsigned int structuringElementx,
+  const unsigned int structuringElementy,
+  Array2D<double>& opening2D,
+  Array2D<double>& closing2D) const
+{
+  getOpeningAndClosing<double>(
+    waveform2D, 
+    structuringElementx, 
+    structuringElementy, 
+    opening2D,
+    closing2D);
+  return;
+}
+
 
-template <typename T>
+template <typename T, typename InArray, typename OutArray>
 void icarussigproc::Morph2D::getOpeningAndClosing(
-  const std::vector<std::vector<T> >& waveform2D,
+  const InArray& waveform2D,
   const unsigned int structuringElementx,
   const unsigned int structuringElementy,
-  std::vector<std::vector<T> >& opening2D,
-  std::vector<std::vector<T> >& closing2D) const
+  OutArray& opening2D,
+  OutArray& closing2D) const
 {
-  auto numChannels = waveform2D.size();
-  auto nTicks = waveform2D.at(0).size();
+  auto numChannels = numRows(waveform2D);
+  auto nTicks = numCols(waveform2D);
   int xHalfWindowSize(structuringElementx / 2);
   int yHalfWindowSize(structuringElementy / 2);
 
-  opening2D.resize(waveform2D.size());
-  closing2D.resize(waveform2D.size());
+  resize2D(opening2D, numChannels, nTicks);
+  resize2D(closing2D, numChannels, nTicks);
 
-  std::vector<std::vector<T> > dilation2D;
-  std::vector<std::vector<T> > erosion2D;
-  std::vector<std::vector<T> > average2D;
-  std::vector<std::vector<T> > gradient2D;
+  Array2D<T> dilation2D;
+  Array2D<T> erosion2D;
+  Array2D<T> average2D;
+  Array2D<T> gradient2D;
 
-  getFilter2D(waveform2D, structuringElementx, structuringElementy,
+  getFilter2D<T>(waveform2D, structuringElementx, structuringElementy,
               dilation2D, erosion2D, average2D, gradient2D);
 
-  for (size_t i=0; i<waveform2D.size(); ++i) {
-    opening2D[i].resize(waveform2D.at(0).size());
-    closing2D[i].resize(waveform2D.at(0).size());
+  // int16 planes take the int16 kernels for both passes; the sizes decide
+  // for both calls alike
+  if constexpr (std::is_same<T, short>::value) {
+    if (getInt16MinMax2D(erosion2D, xHalfWindowSize, yHalfWindowSize,
+          fNumThreads, [&](size_t i, const short*, const short* maxRow) {
+            std::copy(maxRow, maxRow + nTicks, &opening2D[i][0]);
+          }) &&
+        getInt16MinMax2D(dilation2D, xHalfWindowSize, yHalfWindowSize,
+          fNumThreads, [&](size_t i, const short* minRow, const short*) {
+            std::copy(minRow, minRow + nTicks, &closing2D[i][0]);
+          })) {
+      return;
+    }
   }
-  float opening;
-  float closing;
-  for (size_t i=0; i<numChannels; ++i) {
-    for (size_t j=0; j<nTicks; ++j) {
-      // For each center pixel, do 2D morphological filtering.
-      int lbx = i - (int) xHalfWindowSize;
-      int ubx = i + (int) xHalfWindowSize;
-      int lby = j - (int) yHalfWindowSize;
-      int uby = j + (int) yHalfWindowSize;
-      size_t lowerBoundx = std::max(lbx, 0);
-      size_t upperBoundx = std::min(ubx, (int) numChannels);
-      size_t lowerBoundy = std::max(lby, 0);
-      size_t upperBoundy = std::min(uby, (int) nTicks);
-      std::vector<T> v1;
-      std::vector<T> v2;
-      v1.reserve(structuringElementx * structuringElementy);
-      v2.reserve(structuringElementx * structuringElementy);
-      for (size_t ix=lowerBoundx; ix<upperBoundx; ++ix) {
-        for (size_t iy=lowerBoundy; iy<upperBoundy; ++iy) {
-          v1.push_back(dilation2D[ix][iy]);
-          v2.push_back(erosion2D[ix][iy]);
+
+  auto processBand = [&](size_t begin, size_t end, unsigned int) {
+    float opening;
+    float closing;
+    for (size_t i=begin; i<end; ++i) {
+      for (size_t j=0; j<nTicks; ++j) {
+        // For each center pixel, do 2D morphological filtering.
+        int lbx = i - (int) xHalfWindowSize;
+        int ubx = i + (int) xHalfWindowSize;
+        int lby = j - (int) yHalfWindowSize;
+        int uby = j + (int) yHalfWindowSize;
+        size_t lowerBoundx = std::max(lbx, 0);
+        size_t upperBoundx = std::min(ubx, (int) numChannels);
+        size_t lowerBoundy = std::max(lby, 0);
+        size_t upperBoundy = std::min(uby, (int) nTicks);
+        std::vector<T> v1;
+        std::vector<T> v2;
+        v1.reserve(structuringElementx * structuringElementy);
+        v2.reserve(structuringElementx * structuringElementy);
+        for (size_t ix=lowerBoundx; ix<upperBoundx; ++ix) {
+          for (size_t iy=lowerBoundy; iy<upperBoundy; ++iy) {
+            v1.push_back(dilation2D[ix][iy]);
+            v2.push_back(erosion2D[ix][iy]);
+          }
         }
+        opening = *std::max_element(v2.begin(), v2.end());
+        closing = *std::min_element(v1.begin(), v1.end());
+        opening2D[i][j] = opening;
+        closing2D[i][j] = closing;
       }
-      opening = *std::max_element(v2.begin(), v2.end());
-      closing = *std::min_element(v1.begin(), v1.end());
-      opening2D[i][j] = opening;
-      closing2D[i][j] = closing;
     }
-  }
+  };
+  parallelFor(numChannels, kBandRows, processBand, fNumThreads);
   return;
 }
 
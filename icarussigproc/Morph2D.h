@@ -12,7 +12,7 @@
 
     @{*/
 #ifndef __SIGPROC_TOOLS_MORPH2D_H__
-#define __SIGPROC_TOOLS_MORPH2D_H__icarussigproc
+#define __SIGPROC_TOOLS_MORPH2D_H__
 
 #include <iostream>
 #include <vector>
@@ -21,12 +21,17 @@
 #include <numeric>
 #include <cmath>
 #include <functional>
+#include "MiscUtils.h"
+#include "Array2D.h"
 
 namespace icarussigproc {
 
   /**
      \class Morph2D
-     2D Morphological Filters
+     2D Morphological Filters. Every filter takes either nested vectors or
+     an Array2DView input with an Array2D output.
+     The filters are const and keep no state between calls: one instance
+     may be shared by any number of threads.
   */
   class Morph2D{
     
@@ -59,6 +64,30 @@ namespace icarussigproc {
                       std::vector<std::vector<double> >&,
                       std::vector<std::vector<double> >&) const;
 
+      void getFilter2D(const Array2DView<const short>,
+                      const unsigned int,
+                      const unsigned int,
+                      Array2D<short>&,
+                      Array2D<short>&,
+                      Array2D<short>&,
+                      Array2D<short>&) const;
+
+      void getFilter2D(const Array2DView<const float>,
+                      const unsigned int,
+                      const unsigned int,
+                      Array2D<float>&,
+                      Array2D<float>&,
+                      Array2D<float>&,
+                      Array2D<float>&) const;
+
+      void getFilter2D(const Array2DView<const double>,
+                      const unsigned int,
+                      const unsigned int,
+                      Array2D<double>&,
+                      Array2D<double>&,
+                      Array2D<double>&,
+                      Array2D<double>&) const;
+
 
       void getDilation(const std::vector<std::vector<short> >&,
                       const unsigned int,
@@ -75,6 +104,21 @@ namespace icarussigproc {
                       const unsigned int,
                       std::vector<std::vector<double> >&) const;
 
+      void getDilation(const Array2DView<const short>,
+                      const unsigned int,
+                      const unsigned int,
+                      Array2D<short>&) const;
+
+      void getDilation(const Array2DView<const float>,
+                      const unsigned int,
+                      const unsigned int,
+                      Array2D<float>&) const;
+
+      void getDilation(const Array2DView<const double>,
+                      const unsigned int,
+                      const unsigned int,
+                      Array2D<double>&) const;
+
 
       void getErosion(const std::vector<std::vector<short> >&,
                       const unsigned int,
@@ -91,6 +135,21 @@ namespace icarussigproc {
                       const unsigned int,
                       std::vector<std::vector<double> >&) const;
 
+      void getErosion(const Array2DView<const short>,
+                      const unsigned int,
+                      const unsigned int,
+                      Array2D<short>&) const;
+
+      void getErosion(const Array2DView<const float>,
+                      const unsigned int,
+                      const unsigned int,
+                      Array2D<float>&) const;
+
+      void getErosion(const Array2DView<const double>,
+                      const unsigned int,
+                      const unsigned int,
+                      Array2D<double>&) const;
+
 
       void getGradient(const std::vector<std::vector<short> >&,
                       const unsigned int,
@@ -107,6 +166,21 @@ namespace icarussigproc {
                       const unsigned int,
                       std::vector<std::vector<double> >&) const;
 
+      void getGradient(const Array2DView<const short>,
+                      const unsigned int,
+                      const unsigned int,
+                      Array2D<short>&) const;
+
+      void getGradient(const Array2DView<const float>,
+                      const unsigned int,
+                      const unsigned int,
+                      Array2D<float>&) const;
+
+      void getGradient(const Array2DView<const double>,
+                      const unsigned int,
+                      const unsigned int,
+                      Array2D<double>&) const;
+
 
       void getMedian(const std::vector<std::vector<short> >&,
                       const unsigned int,
@@ -123,6 +197,21 @@ namespace icarussigproc {
                       const unsigned int,
                       std::vector<std::vector<double> >&) const;
 
+      void getMedian(const Array2DView<const short>,
+                      const unsigned int,
+                      const unsigned int,
+                      Array2D<short>&) const;
+
+      void getMedian(const Array2DView<const float>,
+                      const unsigned int,
+                      const unsigned int,
+                      Array2D<float>&) const;
+
+      void getMedian(const Array2DView<const double>,
+                      const unsigned int,
+                      const unsigned int,
+                      Array2D<double>&) const;
+
 
       void getOpeningAndClosing(const std::vector<std::vector<short> >&,
                       const unsigned int,
@@ -142,56 +231,80 @@ namespace icarussigproc {
                       std::vector<std::vector<double> >&,
                       std::vector<std::vector<double> >&) const;
 
+      void getOpeningAndClosing(const Array2DView<const short>,
+                      const unsigned int,
+                      const unsigned int,
+                      Array2D<short>&,
+                      Array2D<short>&) const;
+
+      void getOpeningAndClosing(const Array2DView<const float>,
+                      const unsigned int,
+                      const unsigned int,
+                      Array2D<float>&,
+                      Array2D<float>&) const;
+
+      void getOpeningAndClosing(const Array2DView<const double>,
+                      const unsigned int,
+                      const unsigned int,
+                      Array2D<double>&,
+                      Array2D<double>&) const;
+
+      /// Threads of the parallel loops over channels, 0 for the
+      /// concurrency of the library thread pool
+      void setNumThreads(const unsigned int numThreads) { fNumThreads = numThreads; }
+
       /// Default destructor
       ~Morph2D(){}
       
     private:
 
-      template <typename T> 
+      template <typename T, typename InArray, typename OutArray>
       void getFilter2D(
-        const std::vector<std::vector<T> >& waveform2D,
+        const InArray& waveform2D,
         const unsigned int structuringElementx,
         const unsigned int structuringElementy,
-        std::vector<std::vector<T> >& dilation2D,
-        std::vector<std::vector<T> >& erosion2D,
-        std::vector<std::vector<T> >& average2D,
-        std::vector<std::vector<T> >& gradient2D) const;
+        OutArray& dilation2D,
+        OutArray& erosion2D,
+        OutArray& average2D,
+        OutArray& gradient2D) const;
 
-      template <typename T> 
+      template <typename T, typename InArray, typename OutArray>
       void getGradient(
-        const std::vector<std::vector<T> >& waveform2D,
+        const InArray& waveform2D,
         const unsigned int structuringElementx,
         const unsigned int structuringElementy,
-        std::vector<std::vector<T> >& gradient2D) const;
+        OutArray& gradient2D) const;
 
-      template <typename T> 
+      template <typename T, typename InArray, typename OutArray>
       void getDilation(
-        const std::vector<std::vector<T> >& waveform2D,
+        const InArray& waveform2D,
         const unsigned int structuringElementx,
         const unsigned int structuringElementy,
-        std::vector<std::vector<T> >& dilation2D) const;
+        OutArray& dilation2D) const;
 
-      template <typename T> 
+      template <typename T, typename InArray, typename OutArray>
       void getErosion(
-        const std::vector<std::vector<T> >& waveform2D,
+        const InArray& waveform2D,
         const unsigned int structuringElementx,
         const unsigned int structuringElementy,
-        std::vector<std::vector<T> >& erosion2D) const;
+        OutArray& erosion2D) const;
 
-      template <typename T> 
+      template <typename T, typename InArray, typename OutArray>
       void getMedian(
-        const std::vector<std::vector<T> >& waveform2D,
+        const InArray& waveform2D,
         const unsigned int structuringElementx,
         const unsigned int structuringElementy,
-        std::vector<std::vector<T> >& median2D) const;
+        OutArray& median2D) const;
 
-      template <typename T> 
+      template <typename T, typename InArray, typename OutArray>
       void getOpeningAndClosing(
-        const std::vector<std::vector<T> >& waveform2D,
+        const InArray& waveform2D,
         const unsigned int structuringElementx,
         const unsigned int structuringElementy,
-        std::vector<std::vector<T> >& opening2D,
-        std::vector<std::vector<T> >& closing2D) const;
+        OutArray& opening2D,
+        OutArray& closing2D) const;
+
+      unsigned int fNumThreads = 0;
     
   };
 }
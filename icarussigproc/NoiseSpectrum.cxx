@@ -0,0 +1,165 @@
+#ifndef __SIGPROC_TOOLS_NOISESPECTRUM_CXX__
+#define __SIGPROC_TOOLS_NOISESPECTRUM_CXX__
+
+#include "NoiseSpectrum.h"
+
+
+void icarussigproc::NoiseSpectrum::getNoisePSD(
+  const ArrayFloat& waveforms,
+  const ArrayBool& selectVals,
+  icarussigproc::FFTPlanCache& planCache,
+  ArrayFloat& noisePSD,
+  const unsigned int grouping,
+  const unsigned int segmentLength) const
+{
+  getNoisePSD<float>(waveforms, selectVals, planCache, noisePSD,
+    grouping, segmentLength);
+  return;
+}
+
+void icarussigproc::NoiseSpectrum::getNoisePSD(
+  const ArrayDouble& waveforms,
+  const ArrayBool& selectVals,
+  icarussigproc::FFTPlanCache& planCache,
+  ArrayDouble& noisePSD,
+  const unsigned int grouping,
+  const unsigned int segmentLength) const
+{
+  getNoisePSD<double>(waveforms, selectVals, planCache, noisePSD,
+    grouping, segmentLength);
+  return;
+}
+
+void icarussigproc::NoiseSpectrum::getNoisePSD(
+  const Array2DView<const float> waveforms,
+  const Array2DView<const bool> selectVals,
+  icarussigproc::FFTPlanCache& planCache,
+  ArrayFloat& noisePSD,
+  const unsigned int grouping,
+  const unsigned int segmentLength) const
+{
+  getNoisePSD<float>(waveforms, selectVals, planCache, noisePSD,
+    grouping, segmentLength);
+  return;
+}
+
+void icarussigproc::NoiseSpectrum::getNoisePSD(
+  const Array2DView<const double> waveforms,
+  const Array2DView<const bool> selectVals,
+  icarussigproc::FFTPlanCache& planCache,
+  ArrayDouble& noisePSD,
+  const unsigned int grouping,
+  const unsigned int segmentLength) const
+{
+  getNoisePSD<double>(waveforms, selectVals, planCache, noisePSD,
+    grouping, segmentLength);
+  return;
+}
+
+template <typename T, typename InArray, typename MaskArray>
+void icarussigproc::NoiseSpectrum::getNoisePSD(
+  const InArray& waveforms,
+  const MaskArray& selectVals,
+  icarussigproc::FFTPlanCache& planCache,
+  std::vector<std::vector<T>>& noisePSD,
+  const unsigned int grouping,
+  const unsigned int segmentLength) const
+{
+  /*
+  Welch noise power spectrum per channel group.
+
+  INPUTS:
+    - waveforms: coherent noise subtracted waveforms.
+    - selectVals: signal mask from Denoising; segments touching it are skipped.
+    - planCache: FFT engines, shared with the deconvolution stage.
+    - grouping: number of consecutive channels averaged together.
+    - segmentLength: Welch segment length (50% overlap, Hann window).
+
+  MODIFIES:
+    - noisePSD: one nTicks/2+1 bin spectrum per group (the last group may
+      be partial). Groups without any quiet segment get the plane average,
+      all groups get the white noise floor if the plane has none.
+  */
+  size_t numChannels = numRows(waveforms);
+  size_t nTicks = numCols(waveforms);
+  size_t nGroups = (numChannels + grouping - 1) / grouping;
+  size_t nSegBins = segmentLength / 2 + 1;
+  size_t nBins = nTicks / 2 + 1;
+
+  std::vector<T> window(segmentLength);
+  double windowPower = 0.;
+  for (size_t k=0; k<segmentLength; ++k) {
+    window[k] = 0.5 - 0.5 * std::cos(2. * M_PI * k / segmentLength);
+    windowPower += window[k] * window[k];
+  }
+
+  std::vector<std::vector<double>> groupPower(
+    nGroups, std::vector<double>(nSegBins, 0.));
+  std::vector<size_t> groupCount(nGroups, 0);
+
+  // All segments are the same length so they are transformed back to back
+  // with a single plan and scratch buffers.
+  Eigen::FFT<T>& fft = planCache.getFFT<T>();
+  std::vector<T> segment(segmentLength);
+  std::vector<std::complex<T>> spectrum;
+
+  for (size_t i=0; i<numChannels; ++i) {
+    size_t group = i / grouping;
+    size_t runStart = 0;
+    for (size_t j=0; j<nTicks; ++j) {
+      if (selectVals[i][j]) {
+        runStart = j + 1;
+        continue;
+      }
+      if (j + 1 - runStart < segmentLength) continue;
+      size_t segStart = j + 1 - segmentLength;
+      const T* samples = &waveforms[i][0] + segStart;
+      T mean = std::accumulate(samples, samples + segmentLength, T(0)) /
+        T(segmentLength);
+      for (size_t k=0; k<segmentLength; ++k) {
+        segment[k] = (samples[k] - mean) * window[k];
+      }
+      fft.fwd(spectrum, segment);
+      for (size_t k=0; k<nSegBins; ++k) {
+        groupPower[group][k] += std::norm(spectrum[k]);
+      }
+      groupCount[group] += 1;
+      runStart = segStart + segmentLength / 2;
+    }
+  }
+
+  std::vector<double> planePower(nSegBins, 0.);
+  size_t planeCount = 0;
+  for (size_t g=0; g<nGroups; ++g) {
+    // The per-segment mean removal empties the DC bin, take its neighbour
+    if (nSegBins > 1) groupPower[g][0] = groupPower[g][1];
+    for (size_t k=0; k<nSegBins; ++k) planePower[k] += groupPower[g][k];
+    planeCount += groupCount[g];
+  }
+
+  // Resample to the nTicks bin spacing and scale the per-sample density to
+  // the power of an nTicks long transform.
+  noisePSD.resize(nGroups);
+  for (size_t g=0; g<nGroups; ++g) {
+    const std::vector<double>& power =
+      groupCount[g] > 0 ? groupPower[g] : planePower;
+    size_t count = groupCount[g] > 0 ? groupCount[g] : planeCount;
+    if (count == 0) {
+      // |X(k)|^2 of white noise of variance fNoiseFloor
+      noisePSD[g].assign(nBins, T(nTicks) * fNoiseFloor);
+      continue;
+    }
+    noisePSD[g].assign(nBins, 0);
+    double norm = double(nTicks) / (double(count) * windowPower);
+    for (size_t m=0; m<nBins; ++m) {
+      double pos = double(m) * segmentLength / double(nTicks);
+      size_t k0 = std::min(size_t(pos), nSegBins - 1);
+      size_t k1 = std::min(k0 + 1, nSegBins - 1);
+      double frac = pos - k0;
+      noisePSD[g][m] = norm * ((1. - frac) * power[k0] + frac * power[k1]);
+    }
+  }
+  return;
+}
+
+#endif
@@ -0,0 +1,107 @@
+/**
+ * \file NoiseSpectrum.h
+ *
+ * \ingroup icarussigproc
+ *
+ * \brief Class def header for a class NoiseSpectrum
+ *
+ */
+
+/** \addtogroup icarussigproc
+
+    @{*/
+#ifndef __SIGPROC_TOOLS_NOISESPECTRUM_H__
+#define __SIGPROC_TOOLS_NOISESPECTRUM_H__
+
+#include <vector>
+#include <complex>
+#include <cmath>
+#include <numeric>
+#include "FFTPlanCache.h"
+#include "Array2D.h"
+
+namespace icarussigproc {
+
+  /**
+     \class NoiseSpectrum
+     Welch estimate of the noise power spectrum of each channel group from
+     the signal free (non selectVals) stretches of the waveforms. The result
+     is expressed per bin of an nTicks long half spectrum, in the units of
+     |X(k)|^2, so it can be passed directly to Deconvolution::Wiener1D, for
+     nested vector and Array2D waveforms alike.
+     Groups without a quiet stretch get the plane average; a plane without
+     any gets a white spectrum at the noise floor, so the Wiener filter never
+     divides by a zero noise power.
+  */
+  class NoiseSpectrum{
+
+    public:
+
+      /// Default constructor
+      NoiseSpectrum(){}
+
+      /// Define some more convenient names for containers we are going to be using
+      using VectorFloat  = std::vector<float>;
+      using VectorDouble = std::vector<double>;
+      using VectorBool   = std::vector<bool>;
+      using ArrayFloat   = std::vector<VectorFloat>;
+      using ArrayDouble  = std::vector<VectorDouble>;
+      using ArrayBool    = std::vector<VectorBool>;
+
+      void getNoisePSD(
+        const ArrayFloat&,
+        const ArrayBool&,
+        icarussigproc::FFTPlanCache&,
+        ArrayFloat&,
+        const unsigned int,
+        const unsigned int) const;
+
+      void getNoisePSD(
+        const ArrayDouble&,
+        const ArrayBool&,
+        icarussigproc::FFTPlanCache&,
+        ArrayDouble&,
+        const unsigned int,
+        const unsigned int) const;
+
+      void getNoisePSD(
+        const Array2DView<const float>,
+        const Array2DView<const bool>,
+        icarussigproc::FFTPlanCache&,
+        ArrayFloat&,
+        const unsigned int,
+        const unsigned int) const;
+
+      void getNoisePSD(
+        const Array2DView<const double>,
+        const Array2DView<const bool>,
+        icarussigproc::FFTPlanCache&,
+        ArrayDouble&,
+        const unsigned int,
+        const unsigned int) const;
+
+      /// Noise variance per sample (ADC^2) of the spectrum used when no
+      /// channel of the plane has a signal free stretch
+      void setNoiseFloor(const float noiseFloor) { fNoiseFloor = noiseFloor; }
+
+      /// Default destructor
+      ~NoiseSpectrum(){}
+
+    private:
+
+      template <typename T, typename InArray, typename MaskArray>
+      void getNoisePSD(
+        const InArray& waveforms,
+        const MaskArray& selectVals,
+        icarussigproc::FFTPlanCache& planCache,
+        std::vector<std::vector<T>>& noisePSD,
+        const unsigned int grouping=64,
+        const unsigned int segmentLength=128) const;
+
+      float fNoiseFloor = 1.;
+  };
+}
+
+#endif
+/** @} */ // end of doxygen group
+
@@ -0,0 +1,49 @@
+#ifndef __SIGPROC_TOOLS_PARALLELFOR_CXX__
+#define __SIGPROC_TOOLS_PARALLELFOR_CXX__
+
+#include "ParallelFor.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+
+unsigned int icarussigproc::getNumWorkers(const unsigned int numThreads)
+{
+  if (numThreads > 0) return numThreads;
+  return ThreadPool::getInstance().getConcurrency();
+}
+
+void icarussigproc::parallelFor(
+  const size_t numItems,
+  const size_t grain,
+  const std::function<void(size_t, size_t, unsigned int)>& func,
+  const unsigned int numThreads)
+{
+  size_t blockSize = std::max(grain, size_t(1));
+  size_t numBlocks = (numItems + blockSize - 1) / blockSize;
+  unsigned int numWorkers = std::min(
+    size_t(getNumWorkers(numThreads)), numBlocks);
+
+  if (numWorkers <= 1) {
+    if (numItems > 0) func(0, numItems, 0);
+    return;
+  }
+
+  // Each worker is a lane of the pool; lanes that start late find the
+  // blocks taken and return at once
+  std::atomic<size_t> nextBlock(0);
+  ThreadPool::getInstance().runLanes(numWorkers, [&](unsigned int workerID) {
+    try {
+      for (size_t block = nextBlock++; block < numBlocks; block = nextBlock++) {
+        size_t begin = block * blockSize;
+        func(begin, std::min(begin + blockSize, numItems), workerID);
+      }
+    } catch (...) {
+      nextBlock = numBlocks;
+      throw;
+    }
+  });
+  return;
+}
+
+#endif
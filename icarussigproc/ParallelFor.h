@@ -0,0 +1,41 @@
+/**
+ * \file ParallelFor.h
+ *
+ * \ingroup icarussigproc
+ *
+ * \brief Loop parallelization helpers shared by the batch interfaces
+ *
+ */
+
+/** \addtogroup icarussigproc
+
+    @{*/
+#ifndef __SIGPROC_TOOLS_PARALLELFOR_H__
+#define __SIGPROC_TOOLS_PARALLELFOR_H__
+
+#include <cstddef>
+#include <functional>
+
+namespace icarussigproc {
+
+  /// Number of workers parallelFor runs with for a requested thread count
+  /// (0 means the concurrency of the ThreadPool). Size per worker scratch
+  /// with it.
+  unsigned int getNumWorkers(const unsigned int numThreads=0);
+
+  /// Calls func(begin, end, worker) on consecutive blocks of at most grain
+  /// items covering [0, numItems). Blocks are handed out dynamically to the
+  /// workers, the calling thread being worker 0; worker < getNumWorkers().
+  /// The workers run as tasks of the library ThreadPool, so no threads are
+  /// started and nested calls are allowed. Returns when all blocks are
+  /// done, rethrowing the first exception.
+  void parallelFor(
+    const size_t numItems,
+    const size_t grain,
+    const std::function<void(size_t, size_t, unsigned int)>& func,
+    const unsigned int numThreads=0);
+}
+
+#endif
+/** @} */ // end of doxygen group
+
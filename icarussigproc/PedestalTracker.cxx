@@ -0,0 +1,213 @@
+#ifndef __SIGPROC_TOOLS_PEDESTALTRACKER_CXX__
+#define __SIGPROC_TOOLS_PEDESTALTRACKER_CXX__
+
+#include "PedestalTracker.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Half width of the pedestal window in units of the rms, as in the
+// truncated rms of WaveformParamsAlg
+static const float kTruncCut = 2.5;
+
+// rms of a gaussian truncated at +-cut sigma, in units of sigma
+static double getTruncatedRmsRatio(const double cut)
+{
+  double phi = std::exp(-0.5 * cut * cut) / std::sqrt(2. * M_PI);
+  return std::sqrt(1. - 2. * cut * phi / std::erf(cut / std::sqrt(2.)));
+}
+
+icarussigproc::PedestalTracker::PedestalTracker(
+  const float decay,
+  const float driftCut,
+  const float minKeptFraction,
+  const float varianceCut) :
+  fDecay(decay),
+  fDriftCut(driftCut),
+  fMinKeptFraction(minKeptFraction),
+  fVarianceCut(varianceCut)
+{
+  fWindowRmsRatio = getTruncatedRmsRatio(kTruncCut);
+}
+
+bool icarussigproc::PedestalTracker::update(
+  const size_t channel,
+  Span<const float> waveform,
+  float& pedestal,
+  float& rms)
+{
+  ChannelState& state = getChannel(channel);
+  bool recomputed = update<float>(state, waveform, fScratch);
+  pedestal = state.pedestal;
+  rms = state.rms;
+  return recomputed;
+}
+
+bool icarussigproc::PedestalTracker::update(
+  const size_t channel,
+  Span<const short> waveform,
+  float& pedestal,
+  float& rms)
+{
+  ChannelState& state = getChannel(channel);
+  bool recomputed = update<short>(state, waveform, fScratch);
+  pedestal = state.pedestal;
+  rms = state.rms;
+  return recomputed;
+}
+
+size_t icarussigproc::PedestalTracker::update(
+  const float* waveforms,
+  const size_t numChannels,
+  const size_t nTicks,
+  std::vector<float>& pedestals,
+  std::vector<float>& rmsVals,
+  const unsigned int numThreads)
+{
+  return update<float>(waveforms, numChannels, nTicks, pedestals, rmsVals,
+    numThreads);
+}
+
+size_t icarussigproc::PedestalTracker::update(
+  const short* waveforms,
+  const size_t numChannels,
+  const size_t nTicks,
+  std::vector<float>& pedestals,
+  std::vector<float>& rmsVals,
+  const unsigned int numThreads)
+{
+  return update<short>(waveforms, numChannels, nTicks, pedestals, rmsVals,
+    numThreads);
+}
+
+const icarussigproc::PedestalTracker::ChannelState&
+icarussigproc::PedestalTracker::getState(const size_t channel) const
+{
+  return fChannels.at(channel);
+}
+
+void icarussigproc::PedestalTracker::reset()
+{
+  fChannels.clear();
+  return;
+}
+
+icarussigproc::PedestalTracker::ChannelState&
+icarussigproc::PedestalTracker::getChannel(const size_t channel)
+{
+  if (channel >= fChannels.size()) {
+    fChannels.resize(channel + 1, ChannelState{0., 0., 0, false});
+  }
+  return fChannels[channel];
+}
+
+template <typename T>
+size_t icarussigproc::PedestalTracker::update(
+  const T* waveforms,
+  const size_t numChannels,
+  const size_t nTicks,
+  std::vector<float>& pedestals,
+  std::vector<float>& rmsVals,
+  const unsigned int numThreads)
+{
+  /*
+  Update numChannels channels stored as contiguous rows of nTicks samples.
+  Returns the number of channels that needed a full recomputation.
+
+  MODIFIES:
+    - pedestals, rmsVals: tracked pedestal and rms of each channel.
+  */
+  if (numChannels > fChannels.size()) {
+    fChannels.resize(numChannels, ChannelState{0., 0., 0, false});
+  }
+  pedestals.resize(numChannels);
+  rmsVals.resize(numChannels);
+
+  std::vector<WaveformParamsAlg::PedestalScratch> scratches(
+    getNumWorkers(numThreads));
+  std::vector<size_t> numRecomputed(scratches.size(), 0);
+
+  auto processChannels = [&](size_t begin, size_t end, unsigned int worker) {
+    for (size_t i=begin; i<end; ++i) {
+      ChannelState& state = fChannels[i];
+      Span<const T> waveform(waveforms + i * nTicks, nTicks);
+      if (update<T>(state, waveform, scratches[worker])) {
+        ++numRecomputed[worker];
+      }
+      pedestals[i] = state.pedestal;
+      rmsVals[i] = state.rms;
+    }
+  };
+
+  parallelFor(numChannels, 64, processChannels, numThreads);
+
+  size_t total = 0;
+  for (const auto& count : numRecomputed) total += count;
+  return total;
+}
+
+template <typename T>
+bool icarussigproc::PedestalTracker::update(
+  ChannelState& state,
+  Span<const T> waveform,
+  WaveformParamsAlg::PedestalScratch& scratch)
+{
+  /*
+  Cheap update of one channel, falling back to the full histogram.
+  Returns true when the pedestal was recomputed from scratch.
+  */
+  if (waveform.empty()) return false;
+
+  if (state.valid) {
+    // Window of at least one ADC count so that quiet channels still
+    // collect their samples
+    float window = std::max(kTruncCut * state.rms, float(1.));
+    double sum = 0.;
+    double sumSq = 0.;
+    size_t count = 0;
+    for (const auto& val : waveform) {
+      float diff = float(val) - state.pedestal;
+      if (std::abs(diff) > window) continue;
+      sum += diff;
+      sumSq += double(diff) * double(diff);
+      ++count;
+    }
+
+    if (count > 1 && count >= fMinKeptFraction * waveform.size()) {
+      double shift = sum / double(count);
+      double windowVar = std::max(0., sumSq / double(count) - shift * shift);
+      // The floor widens the cut beyond kTruncCut sigma on quiet
+      // channels, which truncates less of the gaussian
+      double ratio = fWindowRmsRatio;
+      if (window > kTruncCut * state.rms) {
+        ratio = state.rms > 0. ? getTruncatedRmsRatio(window / state.rms) : 1.;
+      }
+      double trackedVar = double(state.rms) * double(state.rms);
+      double expectedVar = ratio * ratio * trackedVar;
+      bool sameNoise = windowVar <= fVarianceCut * expectedVar &&
+        fVarianceCut * windowVar >= expectedVar;
+      if (std::abs(shift) <= fDriftCut * window / kTruncCut && sameNoise) {
+        double eventVar = windowVar / (ratio * ratio);
+        state.pedestal += fDecay * shift;
+        state.rms = std::sqrt((1. - fDecay) * trackedVar + fDecay * eventVar);
+        ++state.numEvents;
+        return false;
+      }
+    }
+  }
+
+  // Drift, noise change (or first event): rebuild from the full histogram
+  float pedestal, rms, truncRms;
+  int numBins;
+  fWaveformParamsAlg.getMeanAndTruncRms(
+    waveform, pedestal, rms, truncRms, numBins, scratch);
+
+  state.pedestal = pedestal;
+  state.rms = truncRms / fWindowRmsRatio;
+  state.numEvents = 1;
+  state.valid = true;
+  return true;
+}
+
+#endif
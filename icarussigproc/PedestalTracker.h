@@ -0,0 +1,120 @@
+/**
+ * \file PedestalTracker.h
+ *
+ * \ingroup icarussigproc
+ *
+ * \brief Class def header for a class PedestalTracker
+ *
+ */
+
+/** \addtogroup icarussigproc
+
+    @{*/
+#ifndef __SIGPROC_TOOLS_PEDESTALTRACKER_H__
+#define __SIGPROC_TOOLS_PEDESTALTRACKER_H__
+
+#include <vector>
+#include "Span.h"
+#include "WaveformParamsAlg.h"
+
+namespace icarussigproc {
+
+  /**
+     \class PedestalTracker
+     Per channel pedestal and noise rms carried across events. Once a
+     channel is seeded by the full histogram of WaveformParamsAlg, each event
+     only costs one pass accumulating the samples within 2.5 rms of the
+     tracked pedestal; the window mean and (truncation corrected) rms update
+     exponentially weighted moving averages. The histogram is rebuilt when
+     the window mean moves by more than driftCut rms (the pedestal jumped),
+     when too few samples fall in the window or when their variance is off
+     by more than a factor varianceCut from the one expected from the
+     tracked rms (the noise changed).
+  */
+  class PedestalTracker{
+
+    public:
+
+      /// Tracked state of one channel
+      struct ChannelState {
+        float        pedestal;
+        float        rms;        // gaussian noise rms estimate
+        unsigned int numEvents;  // events since the last full recomputation
+        bool         valid;
+      };
+
+      /// decay: weight of the current event in the moving averages
+      PedestalTracker(
+        const float decay=0.05,
+        const float driftCut=0.25,
+        const float minKeptFraction=0.5,
+        const float varianceCut=1.5);
+
+      bool update(
+        const size_t,
+        Span<const float>,
+        float&,
+        float&);
+
+      bool update(
+        const size_t,
+        Span<const short>,
+        float&,
+        float&);
+
+      size_t update(
+        const float*,
+        const size_t,
+        const size_t,
+        std::vector<float>&,
+        std::vector<float>&,
+        const unsigned int numThreads=0);
+
+      size_t update(
+        const short*,
+        const size_t,
+        const size_t,
+        std::vector<float>&,
+        std::vector<float>&,
+        const unsigned int numThreads=0);
+
+      const ChannelState& getState(const size_t) const;
+
+      void reset();
+
+      /// Default destructor
+      ~PedestalTracker(){}
+
+    private:
+
+      template <typename T>
+      bool update(
+        ChannelState& state,
+        Span<const T> waveform,
+        WaveformParamsAlg::PedestalScratch& scratch);
+
+      template <typename T>
+      size_t update(
+        const T* waveforms,
+        const size_t numChannels,
+        const size_t nTicks,
+        std::vector<float>& pedestals,
+        std::vector<float>& rmsVals,
+        const unsigned int numThreads);
+
+      ChannelState& getChannel(const size_t channel);
+
+      float                              fDecay;
+      float                              fDriftCut;
+      float                              fMinKeptFraction;
+      float                              fVarianceCut;
+      float                              fWindowRmsRatio;
+      std::vector<ChannelState>          fChannels;
+      WaveformParamsAlg                  fWaveformParamsAlg;
+      WaveformParamsAlg::PedestalScratch fScratch;
+  };
+}
+
+#endif
+/** @} */ // end of doxygen group
+
@@ -0,0 +1,176 @@
+#ifndef __SIGPROC_TOOLS_RAWDIGITINGESTER_CXX__
+#define __SIGPROC_TOOLS_RAWDIGITINGESTER_CXX__
+
+#include "RawDigitIngester.h"
+#include "ParallelFor.h"
+
+#include "lardataobj/RawData/raw.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(__x86_64__)
+#include <emmintrin.h>
+#endif
+
+icarussigproc::RawDigitIngester::RawDigitIngester(const char pedestalMode) :
+  fPedestalMode(pedestalMode)
+{
+}
+
+void icarussigproc::RawDigitIngester::ingest(
+  const std::vector<raw::RawDigit>& rawDigits,
+  Array2D<float>& plane,
+  std::vector<float>& pedestals,
+  const unsigned int numThreads) const
+{
+  /*
+  MODIFIES:
+    - plane: numDigits x nTicks pedestal subtracted waveforms
+    - pedestals: pedestal subtracted from each channel (0 in mode 'n')
+  */
+  size_t nTicks = getNumTicks(rawDigits);
+  plane.resize(rawDigits.size(), nTicks);
+  pedestals.resize(rawDigits.size());
+
+  std::vector<WaveformParamsAlg::PedestalScratch> scratches(
+    fPedestalMode == 'c' ? getNumWorkers(numThreads) : 0);
+
+  auto writeRow = [&](size_t channel, const short* adc, size_t nADC,
+    unsigned int worker) {
+    float* row = plane[channel];
+    float pedestal = 0.;
+    if (fPedestalMode == 'c') {
+      // The histogram kernel writes the subtracted samples itself
+      float rms, truncRms;
+      int numBins;
+      fWaveformParamsAlg.getMeanAndTruncRms(Span<const short>(adc, nADC),
+        pedestal, rms, truncRms, numBins, scratches[worker],
+        Span<float>(row, nADC));
+    }
+    else {
+      if (fPedestalMode == 'd') pedestal = rawDigits[channel].GetPedestal();
+      convertRow(adc, nADC, pedestal, row);
+    }
+    std::fill(row + nADC, row + nTicks, float(0.));
+    pedestals[channel] = pedestal;
+  };
+
+  decode(rawDigits, nTicks, writeRow, numThreads);
+  return;
+}
+
+void icarussigproc::RawDigitIngester::ingest(
+  const std::vector<raw::RawDigit>& rawDigits,
+  const std::vector<float>& pedestals,
+  Array2D<float>& plane,
+  const unsigned int numThreads) const
+{
+  if (pedestals.size() != rawDigits.size()) {
+    throw std::invalid_argument(
+      "RawDigitIngester::ingest: one pedestal per RawDigit is needed");
+  }
+
+  size_t nTicks = getNumTicks(rawDigits);
+  plane.resize(rawDigits.size(), nTicks);
+
+  auto writeRow = [&](size_t channel, const short* adc, size_t nADC,
+    unsigned int) {
+    float* row = plane[channel];
+    convertRow(adc, nADC, pedestals[channel], row);
+    std::fill(row + nADC, row + nTicks, float(0.));
+  };
+
+  decode(rawDigits, nTicks, writeRow, numThreads);
+  return;
+}
+
+void icarussigproc::RawDigitIngester::ingest(
+  const std::vector<raw::RawDigit>& rawDigits,
+  Array2D<short>& plane,
+  const unsigned int numThreads) const
+{
+  size_t nTicks = getNumTicks(rawDigits);
+  plane.resize(rawDigits.size(), nTicks);
+
+  auto writeRow = [&](size_t channel, const short* adc, size_t nADC,
+    unsigned int) {
+    short* row = plane[channel];
+    std::copy(adc, adc + nADC, row);
+    std::fill(row + nADC, row + nTicks, short(0));
+  };
+
+  decode(rawDigits, nTicks, writeRow, numThreads);
+  return;
+}
+
+void icarussigproc::RawDigitIngester::convertRow(
+  const short* adc,
+  const size_t nADC,
+  const float pedestal,
+  float* output)
+{
+  size_t j = 0;
+#if defined(__SSE2__) || defined(__x86_64__)
+  // Eight samples per step: sign extend to 32 bits, convert, subtract
+  const __m128 ped = _mm_set1_ps(pedestal);
+  for (; j+8<=nADC; j+=8) {
+    __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(adc + j));
+    __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+    __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16);
+    _mm_storeu_ps(output + j,     _mm_sub_ps(_mm_cvtepi32_ps(lo), ped));
+    _mm_storeu_ps(output + j + 4, _mm_sub_ps(_mm_cvtepi32_ps(hi), ped));
+  }
+#endif
+  for (; j<nADC; ++j) {
+    output[j] = float(adc[j]) - pedestal;
+  }
+  return;
+}
+
+template <typename RowWriter>
+void icarussigproc::RawDigitIngester::decode(
+  const std::vector<raw::RawDigit>& rawDigits,
+  const size_t nTicks,
+  RowWriter writeRow,
+  const unsigned int numThreads) const
+{
+  // One uncompression buffer per worker, only touched for compressed digits
+  std::vector<std::vector<short>> adcBuffers(getNumWorkers(numThreads));
+
+  auto processChannels = [&](size_t begin, size_t end, unsigned int worker) {
+    for (size_t i=begin; i<end; ++i) {
+      const raw::RawDigit& rawDigit = rawDigits[i];
+      if (rawDigit.Compression() == raw::kNone) {
+        const raw::RawDigit::ADCvector_t& adcs = rawDigit.ADCs();
+        writeRow(i, adcs.data(), std::min(adcs.size(), nTicks), worker);
+      }
+      else {
+        // raw::Uncompress only writes std::vectors, the buffer stays in
+        // cache until the row is written
+        std::vector<short>& adcBuffer = adcBuffers[worker];
+        adcBuffer.resize(rawDigit.Samples());
+        raw::Uncompress(rawDigit.ADCs(), adcBuffer, rawDigit.Compression());
+        writeRow(i, adcBuffer.data(), std::min(adcBuffer.size(), nTicks),
+          worker);
+      }
+    }
+  };
+
+  parallelFor(rawDigits.size(), 16, processChannels, numThreads);
+  return;
+}
+
+size_t icarussigproc::RawDigitIngester::getNumTicks(
+  const std::vector<raw::RawDigit>& rawDigits) const
+{
+  size_t nTicks = 0;
+  for (const auto& rawDigit : rawDigits) {
+    size_t nADC = rawDigit.Compression() == raw::kNone ?
+      rawDigit.ADCs().size() : size_t(rawDigit.Samples());
+    nTicks = std::max(nTicks, nADC);
+  }
+  return nTicks;
+}
+
+#endif
@@ -0,0 +1,95 @@
+/**
+ * \file RawDigitIngester.h
+ *
+ * \ingroup icarussigproc
+ *
+ * \brief Class def header for a class RawDigitIngester
+ *
+ */
+
+/** \addtogroup icarussigproc
+
+    @{*/
+#ifndef __SIGPROC_TOOLS_RAWDIGITINGESTER_H__
+#define __SIGPROC_TOOLS_RAWDIGITINGESTER_H__
+
+#include <vector>
+#include "lardataobj/RawData/RawDigit.h"
+#include "Array2D.h"
+#include "WaveformParamsAlg.h"
+
+namespace icarussigproc {
+
+  /**
+     \class RawDigitIngester
+     Decodes the ADC vectors of a collection of RawDigits into one channel x
+     tick plane, row i holding rawDigits[i]. Uncompressed digits are read in
+     place; compressed ones are uncompressed into a per worker buffer. The
+     conversion to float and the pedestal subtraction are done in the same
+     pass that writes the row. The number of ticks is the largest
+     Samples() of the collection, shorter channels are zero padded.
+
+     Pedestal modes: 'd' the pedestal stored in the RawDigit, 'c' computed
+     from the decoded samples (WaveformParamsAlg truncated mean), 'n' none.
+  */
+  class RawDigitIngester{
+
+    public:
+
+      explicit RawDigitIngester(const char pedestalMode='d');
+
+      void setPedestalMode(const char pedestalMode) { fPedestalMode = pedestalMode; }
+      char getPedestalMode() const { return fPedestalMode; }
+
+      /// Pedestal subtracted float plane, pedestals receives the value
+      /// subtracted from each channel
+      void ingest(
+        const std::vector<raw::RawDigit>&,
+        Array2D<float>&,
+        std::vector<float>&,
+        const unsigned int numThreads=0) const;
+
+      /// As above with externally provided pedestals (e.g. PedestalTracker),
+      /// one per digit
+      void ingest(
+        const std::vector<raw::RawDigit>&,
+        const std::vector<float>&,
+        Array2D<float>&,
+        const unsigned int numThreads=0) const;
+
+      /// Decoded ADC counts, no conversion
+      void ingest(
+        const std::vector<raw::RawDigit>&,
+        Array2D<short>&,
+        const unsigned int numThreads=0) const;
+
+      /// Fused conversion of one row: output[j] = adc[j] - pedestal
+      static void convertRow(
+        const short*,
+        const size_t,
+        const float,
+        float*);
+
+      /// Default destructor
+      ~RawDigitIngester(){}
+
+    private:
+
+      /// Decodes every digit and calls writeRow(channel, adc, nADC, worker)
+      /// with its samples, nADC <= nTicks
+      template <typename RowWriter>
+      void decode(
+        const std::vector<raw::RawDigit>& rawDigits,
+        const size_t nTicks,
+        RowWriter writeRow,
+        const unsigned int numThreads) const;
+
+      size_t getNumTicks(const std::vector<raw::RawDigit>& rawDigits) const;
+
+      char              fPedestalMode;
+      WaveformParamsAlg fWaveformParamsAlg;
+  };
+}
+
+#endif
+/** @} */ // end of doxygen group
@@ -0,0 +1,220 @@
+#ifndef __SIGPROC_TOOLS_RESPONSEREGISTRY_CXX__
+#define __SIGPROC_TOOLS_RESPONSEREGISTRY_CXX__
+
+#include "ResponseRegistry.h"
+
+#include <fstream>
+#include <stdexcept>
+#include <cstdint>
+
+// Cache file layout (native byte order):
+//   char[8] magic, uint32 version, uint32 number of entries, then per entry
+//   uint32 plane, uint32 nTicks, uint64 response hash, uint32 nBins,
+//   nBins complex<double> response.
+static const char          kCacheMagic[8] = {'I','C','S','P','R','E','S','P'};
+static const std::uint32_t kCacheVersion  = 4;
+
+// FNV-1a of the response samples, with the lengths so that moving samples
+// from one response to the other changes the hash
+static std::uint64_t hashResponse(
+  const std::vector<double>& fieldResponse,
+  const std::vector<double>& electronicsResponse)
+{
+  std::uint64_t hash = 14695981039346656037ULL;
+  auto addBytes = [&](const void* data, const size_t numBytes) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t k=0; k<numBytes; ++k) {
+      hash ^= bytes[k];
+      hash *= 1099511628211ULL;
+    }
+  };
+  for (const auto* response : {&fieldResponse, &electronicsResponse}) {
+    std::uint64_t length = response->size();
+    addBytes(&length, sizeof(length));
+    addBytes(response->data(), length * sizeof(double));
+  }
+  return hash;
+}
+
+void icarussigproc::ResponseRegistry::setResponse(
+  const unsigned int planeID,
+  const std::vector<double>& fieldResponse,
+  const std::vector<double>& electronicsResponse)
+{
+  /*
+  Register the responses of a plane, sampled in ticks. The combined
+  response is their convolution; an empty electronics response means the
+  field response is already the combined one. Filters memoized for this
+  plane are dropped from the memo; spectra still held by callers survive.
+  */
+  std::lock_guard<std::mutex> lock(fMutex);
+  fResponses[planeID] = PlaneResponse{fieldResponse, electronicsResponse,
+    hashResponse(fieldResponse, electronicsResponse)};
+  for (auto itr = fFilters.begin(); itr != fFilters.end(); ) {
+    if (itr->first.first == planeID) itr = fFilters.erase(itr);
+    else ++itr;
+  }
+  return;
+}
+
+std::shared_ptr<const icarussigproc::FilterSpectrum>
+icarussigproc::ResponseRegistry::getFilter(
+  const unsigned int planeID,
+  const size_t nTicks)
+{
+  /*
+  A memoized spectrum is returned if it was built from the registered
+  response of the plane, or if no response is registered (spectra read
+  from a cache file); otherwise it is rebuilt.
+  */
+  std::lock_guard<std::mutex> lock(fMutex);
+  Key key(planeID, nTicks);
+  auto filterItr = fFilters.find(key);
+  auto responseItr = fResponses.find(planeID);
+  if (filterItr != fFilters.end() && (responseItr == fResponses.end() ||
+      filterItr->second->responseHash == responseItr->second.hash)) {
+    return filterItr->second;
+  }
+
+  if (responseItr == fResponses.end()) {
+    throw std::invalid_argument(
+      "ResponseRegistry: no response registered for plane " +
+      std::to_string(planeID));
+  }
+  auto filterSpectrum = std::make_shared<FilterSpectrum>();
+  buildFilter(responseItr->second, nTicks, *filterSpectrum);
+  fFilters[key] = filterSpectrum;
+  return filterSpectrum;
+}
+
+void icarussigproc::ResponseRegistry::buildFilter(
+  const PlaneResponse& planeResponse,
+  const size_t nTicks,
+  FilterSpectrum& filterSpectrum)
+{
+  Eigen::FFT<double>& fft = fPlanCache.getFFT<double>();
+  std::vector<double> folded;
+  std::vector<std::complex<double>> fieldFFT;
+  std::vector<std::complex<double>> electronicsFFT;
+
+  // Responses longer than the waveform wrap around, as they would in
+  // the circular convolution the deconvolution inverts.
+  folded.assign(nTicks, 0.);
+  for (size_t k=0; k<planeResponse.fieldResponse.size(); ++k) {
+    folded[k % nTicks] += planeResponse.fieldResponse[k];
+  }
+  fft.fwd(fieldFFT, folded);
+
+  if (!planeResponse.electronicsResponse.empty()) {
+    folded.assign(nTicks, 0.);
+    for (size_t k=0; k<planeResponse.electronicsResponse.size(); ++k) {
+      folded[k % nTicks] += planeResponse.electronicsResponse[k];
+    }
+    fft.fwd(electronicsFFT, folded);
+    for (size_t j=0; j<fieldFFT.size(); ++j) {
+      fieldFFT[j] *= electronicsFFT[j];
+    }
+  }
+
+  size_t nBins = fieldFFT.size();
+  filterSpectrum.nTicks = nTicks;
+  filterSpectrum.responseHash = planeResponse.hash;
+  filterSpectrum.response.resize(nBins);
+  filterSpectrum.responsePower.resize(nBins);
+  for (size_t j=0; j<nBins; ++j) {
+    filterSpectrum.response[j] = fieldFFT[j];
+    filterSpectrum.responsePower[j] = std::norm(fieldFFT[j]);
+  }
+  return;
+}
+
+size_t icarussigproc::ResponseRegistry::size() const
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  return fFilters.size();
+}
+
+bool icarussigproc::ResponseRegistry::writeCache(const std::string& fileName) const
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  std::ofstream out(fileName, std::ios::binary | std::ios::trunc);
+  if (!out) return false;
+
+  std::uint32_t numEntries = fFilters.size();
+  out.write(kCacheMagic, sizeof(kCacheMagic));
+  out.write(reinterpret_cast<const char*>(&kCacheVersion), sizeof(kCacheVersion));
+  out.write(reinterpret_cast<const char*>(&numEntries), sizeof(numEntries));
+
+  for (const auto& entry : fFilters) {
+    const FilterSpectrum& filterSpectrum = *entry.second;
+    std::uint32_t planeID = entry.first.first;
+    std::uint32_t nTicks = filterSpectrum.nTicks;
+    std::uint32_t nBins = filterSpectrum.response.size();
+    out.write(reinterpret_cast<const char*>(&planeID), sizeof(planeID));
+    out.write(reinterpret_cast<const char*>(&nTicks), sizeof(nTicks));
+    out.write(reinterpret_cast<const char*>(&filterSpectrum.responseHash),
+      sizeof(filterSpectrum.responseHash));
+    out.write(reinterpret_cast<const char*>(&nBins), sizeof(nBins));
+    out.write(reinterpret_cast<const char*>(filterSpectrum.response.data()),
+      nBins * sizeof(std::complex<double>));
+  }
+  return bool(out);
+}
+
+bool icarussigproc::ResponseRegistry::readCache(const std::string& fileName)
+{
+  /*
+  Merge the spectra of a cache file into the memo. Entries already present
+  are kept, entries built from another response than the one registered
+  for their plane are skipped. Returns false, leaving the registry
+  untouched, if the file is missing or malformed.
+  */
+  std::ifstream in(fileName, std::ios::binary);
+  if (!in) return false;
+
+  char magic[sizeof(kCacheMagic)];
+  std::uint32_t version = 0;
+  std::uint32_t numEntries = 0;
+  in.read(magic, sizeof(magic));
+  in.read(reinterpret_cast<char*>(&version), sizeof(version));
+  in.read(reinterpret_cast<char*>(&numEntries), sizeof(numEntries));
+  if (!in || !std::equal(magic, magic + sizeof(magic), kCacheMagic) ||
+      version != kCacheVersion) return false;
+
+  std::map<Key, std::shared_ptr<const FilterSpectrum>> filters;
+  for (std::uint32_t i=0; i<numEntries; ++i) {
+    std::uint32_t planeID = 0;
+    std::uint32_t nTicks = 0;
+    std::uint32_t nBins = 0;
+    FilterSpectrum filterSpectrum;
+    in.read(reinterpret_cast<char*>(&planeID), sizeof(planeID));
+    in.read(reinterpret_cast<char*>(&nTicks), sizeof(nTicks));
+    in.read(reinterpret_cast<char*>(&filterSpectrum.responseHash),
+      sizeof(filterSpectrum.responseHash));
+    in.read(reinterpret_cast<char*>(&nBins), sizeof(nBins));
+    if (!in || nBins != nTicks / 2 + 1) return false;
+    filterSpectrum.nTicks = nTicks;
+    filterSpectrum.response.resize(nBins);
+    filterSpectrum.responsePower.resize(nBins);
+    in.read(reinterpret_cast<char*>(filterSpectrum.response.data()),
+      nBins * sizeof(std::complex<double>));
+    if (!in) return false;
+    for (size_t j=0; j<nBins; ++j) {
+      filterSpectrum.responsePower[j] = std::norm(filterSpectrum.response[j]);
+    }
+    Key key(planeID, nTicks);
+    filters.emplace(key,
+      std::make_shared<const FilterSpectrum>(std::move(filterSpectrum)));
+  }
+
+  std::lock_guard<std::mutex> lock(fMutex);
+  for (auto& entry : filters) {
+    auto responseItr = fResponses.find(entry.first.first);
+    if (responseItr != fResponses.end() &&
+        responseItr->second.hash != entry.second->responseHash) continue;
+    fFilters.insert(entry);
+  }
+  return true;
+}
+
+#endif
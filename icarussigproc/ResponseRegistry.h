@@ -0,0 +1,105 @@
+/**
+ * \file ResponseRegistry.h
+ *
+ * \ingroup icarussigproc
+ *
+ * \brief Class def header for a class ResponseRegistry
+ *
+ */
+
+/** \addtogroup icarussigproc
+
+    @{*/
+#ifndef __SIGPROC_TOOLS_RESPONSEREGISTRY_H__
+#define __SIGPROC_TOOLS_RESPONSEREGISTRY_H__
+
+#include <vector>
+#include <complex>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include "FFTPlanCache.h"
+
+namespace icarussigproc {
+
+  /**
+     \struct FilterSpectrum
+     Half spectra (nTicks/2+1 bins) of the combined response H and its power
+     |H|^2, in double precision, with the hash of the field and electronics
+     responses they were built from. They do not depend on the noise:
+     Deconvolution::Wiener1D takes noiseVar along with the spectrum and
+     applies the same data dependent filter,
+     conj(H) |X|^2 / (|H|^2 |X|^2 + noiseVar), as with the response itself.
+  */
+  struct FilterSpectrum {
+    size_t                            nTicks;
+    std::uint64_t                     responseHash;
+    std::vector<std::complex<double>> response;
+    std::vector<double>               responsePower;
+  };
+
+  /**
+     \class ResponseRegistry
+     Field and electronics responses of each plane (0 = Induction-1,
+     1 = Induction-2, 2 = Collection), and the filter spectra built from them
+     memoized by (plane, number of ticks). Spectra can be written to and
+     read back from a binary cache file so a new job does not need to
+     rebuild them; cached spectra whose response hash differs from the
+     registered response of their plane are discarded and rebuilt. Lookups
+     are serialized. getFilter hands out shared ownership: a spectrum stays
+     valid while held, even once setResponse has replaced the response it
+     was built from.
+  */
+  class ResponseRegistry{
+
+    public:
+
+      /// Default constructor
+      ResponseRegistry(){}
+
+      void setResponse(
+        const unsigned int,
+        const std::vector<double>&,
+        const std::vector<double>&);
+
+      std::shared_ptr<const FilterSpectrum> getFilter(
+        const unsigned int,
+        const size_t);
+
+      bool writeCache(const std::string&) const;
+
+      bool readCache(const std::string&);
+
+      size_t size() const;
+
+      /// Default destructor
+      ~ResponseRegistry(){}
+
+    private:
+
+      using Key = std::pair<unsigned int, size_t>;
+
+      struct PlaneResponse {
+        std::vector<double> fieldResponse;
+        std::vector<double> electronicsResponse;
+        std::uint64_t       hash;
+      };
+
+      void buildFilter(
+        const PlaneResponse& planeResponse,
+        const size_t nTicks,
+        FilterSpectrum& filterSpectrum);
+
+      std::map<unsigned int, PlaneResponse> fResponses;
+      std::map<Key, std::shared_ptr<const FilterSpectrum>> fFilters;
+      icarussigproc::FFTPlanCache           fPlanCache;
+      mutable std::mutex                    fMutex;
+  };
+}
+
+#endif
+/** @} */ // end of doxygen group
+
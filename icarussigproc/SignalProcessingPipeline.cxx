@@ -0,0 +1,213 @@
+#ifndef __SIGPROC_TOOLS_SIGNALPROCESSINGPIPELINE_CXX__
+#define __SIGPROC_TOOLS_SIGNALPROCESSINGPIPELINE_CXX__
+
+#include "SignalProcessingPipeline.h"
+#include "Trace.h"
+#include "ParallelFor.h"
+#include "MiscUtils.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+icarussigproc::SignalProcessingPipeline::SignalProcessingPipeline() :
+  SignalProcessingPipeline(Config())
+{
+}
+
+icarussigproc::SignalProcessingPipeline::SignalProcessingPipeline(
+  const Config& config) :
+  fConfig(config),
+  fIngester(config.pedestalMode),
+  fWorkers(getNumWorkers(config.numThreads)),
+  fOutput(0),
+  fNoiseVar(0.)
+{
+  if (fConfig.grouping == 0) {
+    throw std::invalid_argument(
+      "SignalProcessingPipeline: grouping must be positive");
+  }
+  // Bands are the parallel tasks, the kernels of a band run serially
+  fDenoising.setNumThreads(1);
+  for (auto& worker : fWorkers) worker.deconvolution.setNumThreads(1);
+  fAdaptiveWiener.setNumThreads(fConfig.numThreads);
+}
+
+void icarussigproc::SignalProcessingPipeline::process(
+  const Array2DView<const float> waveforms)
+{
+  if (fConfig.pedestalMode == 'd') {
+    throw std::invalid_argument(
+      "SignalProcessingPipeline: RawDigit pedestals need RawDigit input");
+  }
+  allocate(waveforms.numRows(), waveforms.numCols());
+  if (fConfig.pedestalMode != 'c') {
+    std::fill(fPedestals.begin(), fPedestals.end(), float(0.));
+  }
+  run(waveforms, fConfig.pedestalMode == 'c');
+  return;
+}
+
+void icarussigproc::SignalProcessingPipeline::process(
+  const std::vector<raw::RawDigit>& rawDigits)
+{
+  // The ingester subtracts the pedestals while decoding
+  fIngester.ingest(rawDigits, fPlanes[0], fPedestals, fConfig.numThreads);
+  allocate(fPlanes[0].numRows(), fPlanes[0].numCols());
+  run(fPlanes[0], false);
+  return;
+}
+
+void icarussigproc::SignalProcessingPipeline::processEvents(
+  Span<Event> events)
+{
+  // Events are the parallel tasks: one single threaded pipeline per worker,
+  // kept for the next call
+  unsigned int numWorkers = getNumWorkers(fConfig.numThreads);
+  if (fEventPipelines.size() < numWorkers) {
+    Config config = fConfig;
+    config.numThreads = 1;
+    while (fEventPipelines.size() < numWorkers) {
+      fEventPipelines.emplace_back(new SignalProcessingPipeline(config));
+    }
+  }
+
+  auto processBlock = [&](size_t begin, size_t end, unsigned int worker) {
+    for (size_t i=begin; i<end; ++i) {
+      SIGPROC_TRACE("Pipeline event", "event", i);
+      fEventPipelines[worker]->processEvent(events[i]);
+    }
+  };
+  parallelFor(events.size(), 1, processBlock, fConfig.numThreads);
+  return;
+}
+
+void icarussigproc::SignalProcessingPipeline::processEvent(Event& event)
+{
+  if (event.rawDigits) process(*event.rawDigits);
+  else process(event.waveforms);
+
+  // Swapped rather than copied: the event's previous planes become the
+  // scratch of the next event of this pipeline
+  event.output.swap(fPlanes[fOutput]);
+  event.pedestals.swap(fPedestals);
+  event.selectVals.swap(fSelectVals);
+  event.roi.swap(fROI);
+  event.intrinsicRMS.swap(fIntrinsicRMS);
+  event.correctedMedians.swap(fCorrectedMedians);
+  event.noiseVar = fNoiseVar;
+  return;
+}
+
+void icarussigproc::SignalProcessingPipeline::allocate(
+  const size_t numChannels,
+  const size_t nTicks)
+{
+  // Same shape as the previous event: nothing is reallocated
+  size_t nGroups = (numChannels + fConfig.grouping - 1) / fConfig.grouping;
+  fPlanes[0].resize(numChannels, nTicks);
+  fPlanes[1].resize(numChannels, nTicks);
+  fPedestals.resize(numChannels, 0.);
+  fSelectVals.resize(numChannels, nTicks);
+  fROI.assign(numChannels, nTicks, false);
+  fIntrinsicRMS.resize(nGroups, nTicks);
+  fCorrectedMedians.resize(nGroups, nTicks);
+  return;
+}
+
+void icarussigproc::SignalProcessingPipeline::run(
+  const Array2DView<const float> input,
+  const bool subtractPedestals)
+{
+  /*
+  Band stage from input into fPlanes[1], then ROI filter into fPlanes[0].
+  fPlanes[0] may itself be the input (RawDigit path): each band only
+  overwrites its own rows of it once they have been read.
+  */
+  size_t numChannels = input.numRows();
+  if (numChannels == 0) return;
+
+  if (!fConfig.removeCoherentNoise) {
+    fSelectVals.assign(numChannels, input.numCols(), false);
+  }
+
+  size_t grouping = fConfig.grouping;
+  size_t nBands = (numChannels + grouping - 1) / grouping;
+  auto processBands = [&](size_t begin, size_t end, unsigned int worker) {
+    for (size_t band=begin; band<end; ++band) {
+      processBand(input, band * grouping,
+        std::min((band + 1) * grouping, numChannels), subtractPedestals,
+        fWorkers[worker]);
+    }
+  };
+  parallelFor(nBands, 1, processBands, fConfig.numThreads);
+
+  fOutput = 1;
+  if (!fConfig.roiWiener) return;
+
+  fNoiseVar = fConfig.roiNoiseVar;
+  if (fNoiseVar < 0.) {
+    fNoiseVar = MiscUtils().compute_noise_power(fPlanes[1], fSelectVals,
+      fConfig.numThreads);
+  }
+  fAdaptiveWiener.adaptiveROIWiener(fPlanes[0], fPlanes[1], fSelectVals,
+    fNoiseVar, fConfig.sx, fConfig.sy, fConfig.a, fConfig.epsilon);
+  fOutput = 0;
+  return;
+}
+
+void icarussigproc::SignalProcessingPipeline::processBand(
+  const Array2DView<const float> input,
+  const size_t begin,
+  const size_t end,
+  const bool subtractPedestals,
+  Worker& worker)
+{
+  /*
+  Pedestal subtraction, coherent noise removal and deconvolution of the
+  channels [begin, end), leaving the result in the same rows of fPlanes[1].
+  */
+  size_t numRows = end - begin;
+  size_t nTicks = input.numCols();
+  Array2DView<const float> current = input.subView(begin, numRows, 0, nTicks);
+  Array2DView<float> first = fPlanes[0].view().subView(begin, numRows, 0, nTicks);
+  Array2DView<float> second = fPlanes[1].view().subView(begin, numRows, 0, nTicks);
+
+  if (subtractPedestals) {
+    for (size_t i=0; i<numRows; ++i) {
+      float rms, truncRms;
+      int numBins;
+      fWaveformParamsAlg.getMeanAndTruncRms(current.row(i),
+        fPedestals[begin + i], rms, truncRms, numBins, worker.scratch,
+        first.row(i));
+    }
+    current = first;
+  }
+
+  if (fConfig.removeCoherentNoise) {
+    size_t group = begin / fConfig.grouping;
+    SIGPROC_TRACE("Denoising group", "group", group);
+    worker.morphed.resize(numRows, nTicks);
+    fDenoising.removeCoherentNoise1D(second, current, worker.morphed.view(),
+      fIntrinsicRMS.view().subView(group, 1, 0, nTicks),
+      fSelectVals.view().subView(begin, numRows, 0, nTicks),
+      fROI.view().subView(begin, numRows, 0, nTicks),
+      fCorrectedMedians.view().subView(group, 1, 0, nTicks),
+      fConfig.filterName, numRows, fConfig.structuringElement,
+      fConfig.window, fConfig.thresholdFactor);
+    current = second;
+  }
+
+  if (!fConfig.responseFunction.empty()) {
+    // In place when the band is already in the second plane
+    worker.deconvolution.Wiener1D(second, current, fConfig.responseFunction,
+      fConfig.deconvolutionNoiseVar);
+  }
+  else if (current.data() != second.data()) {
+    for (size_t i=0; i<numRows; ++i) {
+      std::copy(current[i], current[i] + nTicks, second[i]);
+    }
+  }
+  return;
+}
+
+#endif
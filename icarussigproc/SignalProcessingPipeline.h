@@ -0,0 +1,179 @@
+/**
+ * \file SignalProcessingPipeline.h
+ *
+ * \ingroup icarussigproc
+ *
+ * \brief Class def header for a class SignalProcessingPipeline
+ *
+ */
+
+/** \addtogroup icarussigproc
+
+    @{*/
+#ifndef __SIGPROC_TOOLS_SIGNALPROCESSINGPIPELINE_H__
+#define __SIGPROC_TOOLS_SIGNALPROCESSINGPIPELINE_H__
+
+#include <memory>
+#include <vector>
+#include "lardataobj/RawData/RawDigit.h"
+#include "Array2D.h"
+#include "Span.h"
+#include "RawDigitIngester.h"
+#include "WaveformParamsAlg.h"
+#include "Denoising.h"
+#include "Deconvolution.h"
+#include "AdaptiveWiener.h"
+
+namespace icarussigproc {
+
+  /**
+     \class SignalProcessingPipeline
+     Pedestal subtraction, coherent noise removal (Denoising), Wiener
+     deconvolution and adaptive ROI Wiener filtering of an event, with all
+     planes owned by the pipeline and reused from one event to the next.
+
+     The row local stages are fused: each band of grouping channels is
+     pedestal subtracted, denoised and deconvolved while it is in cache,
+     bands being spread over the workers. The deconvolution runs in place,
+     the other stages alternate between two planes. The selection mask of
+     the coherent noise removal and the noise power of the unselected
+     samples are then handed to the ROI Wiener filter, which needs the
+     neighbouring channels and runs on the whole plane.
+
+     A pipeline owns its planes and is used by one thread at a time; the
+     kernels it calls are const and keep no state, so any number of
+     pipelines may run concurrently. processEvents spreads independent
+     events over the library ThreadPool, each event being processed
+     serially by one of a set of pipelines owned by this one.
+  */
+  class SignalProcessingPipeline{
+
+    public:
+
+      struct Config {
+        // Pedestals: 'c' computed per channel (WaveformParamsAlg), 'd' from
+        // the RawDigit (RawDigit input only), 'n' input already subtracted
+        char               pedestalMode = 'c';
+
+        // Coherent noise removal (Denoising::removeCoherentNoise1D); a
+        // trailing partial group of channels is treated as its own group
+        bool               removeCoherentNoise = true;
+        char               filterName = 'd';
+        unsigned int       grouping = 64;
+        unsigned int       structuringElement = 5;
+        unsigned int       window = 0;
+        float              thresholdFactor = 2.5;
+
+        // Wiener deconvolution, skipped when no response is given
+        std::vector<float> responseFunction;
+        float              deconvolutionNoiseVar = 1.;
+
+        // Adaptive ROI Wiener filter; a negative noise variance is replaced
+        // by the noise power of the samples outside the selection
+        bool               roiWiener = true;
+        float              roiNoiseVar = -1.;
+        unsigned int       sx = 3;
+        unsigned int       sy = 3;
+        float              a = 1.;
+        float              epsilon = 2.5;
+
+        // Workers for the band stage and the ROI filter (0 = the
+        // concurrency of the library ThreadPool)
+        unsigned int       numThreads = 0;
+      };
+
+      /// An event of processEvents: the input, either waveforms or
+      /// rawDigits when not null (which then must outlive the call), and
+      /// the results as getOutput() etc. would give them. The result
+      /// planes are handed over without copies; events reused from one
+      /// call to the next avoid reallocations.
+      struct Event {
+        Array2DView<const float>          waveforms;
+        const std::vector<raw::RawDigit>* rawDigits = nullptr;
+
+        Array2D<float>                    output;
+        std::vector<float>                pedestals;
+        Array2D<bool>                     selectVals;
+        Array2D<bool>                     roi;
+        Array2D<float>                    intrinsicRMS;
+        Array2D<float>                    correctedMedians;
+        float                             noiseVar = 0.;
+      };
+
+      SignalProcessingPipeline();
+
+      explicit SignalProcessingPipeline(const Config&);
+
+      const Config& getConfig() const { return fConfig; }
+
+      /// Processes an event given as numChannels x nTicks waveforms
+      void process(const Array2DView<const float>);
+
+      /// Processes the RawDigits of an event, decoded by RawDigitIngester
+      void process(const std::vector<raw::RawDigit>&);
+
+      /// Processes independent events concurrently, up to numThreads at a
+      /// time, with the kernels of each event running serially. The
+      /// results of the last event (getOutput() etc.) are not changed.
+      void processEvents(Span<Event> events);
+
+      /// Results of the last event
+      Array2DView<const float> getOutput() const { return fPlanes[fOutput].view(); }
+      const std::vector<float>& getPedestals() const { return fPedestals; }
+      const Array2D<bool>&      getSelectVals() const { return fSelectVals; }
+      const Array2D<bool>&      getROI() const { return fROI; }
+      const Array2D<float>&     getIntrinsicRMS() const { return fIntrinsicRMS; }
+      const Array2D<float>&     getCorrectedMedians() const { return fCorrectedMedians; }
+      float                     getNoiseVar() const { return fNoiseVar; }
+
+      /// Default destructor
+      ~SignalProcessingPipeline(){}
+
+    private:
+
+      /// Per worker state of the band stage
+      struct Worker {
+        sigproc_tools::Deconvolution       deconvolution;
+        Array2D<float>                     morphed;
+        WaveformParamsAlg::PedestalScratch scratch;
+      };
+
+      /// Processes one event of processEvents and moves the results to it
+      void processEvent(Event& event);
+
+      /// Sizes the planes and masks for an event
+      void allocate(const size_t numChannels, const size_t nTicks);
+
+      /// Runs the fused band stage and the ROI filter, input being either
+      /// the caller's waveforms or fPlanes[0]
+      void run(const Array2DView<const float> input, const bool subtractPedestals);
+
+      /// Band of channels [begin, end)
+      void processBand(
+        const Array2DView<const float> input,
+        const size_t begin,
+        const size_t end,
+        const bool subtractPedestals,
+        Worker& worker);
+
+      Config                          fConfig;
+      RawDigitIngester                fIngester;
+      WaveformParamsAlg               fWaveformParamsAlg;
+      Denoising                       fDenoising;
+      sigproc_tools::AdaptiveWiener   fAdaptiveWiener;
+      std::vector<Worker>             fWorkers;
+      std::vector<std::unique_ptr<SignalProcessingPipeline>> fEventPipelines;
+
+      Array2D<float>                  fPlanes[2];
+      size_t                          fOutput;
+      std::vector<float>              fPedestals;
+      Array2D<bool>                   fSelectVals;
+      Array2D<bool>                   fROI;
+      Array2D<float>                  fIntrinsicRMS;
+      Array2D<float>                  fCorrectedMedians;
+      float                           fNoiseVar;
+  };
+}
+
+#endif
+/** @} */ // end of doxygen group
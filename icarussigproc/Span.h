@@ -0,0 +1,78 @@
+/**
+ * \file Span.h
+ *
+ * \ingroup icarussigproc
+ *
+ * \brief Non-owning view of contiguous samples
+ *
+ */
+
+/** \addtogroup icarussigproc
+
+    @{*/
+#ifndef __SIGPROC_TOOLS_SPAN_H__
+#define __SIGPROC_TOOLS_SPAN_H__
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace icarussigproc {
+
+  /**
+     \class Span
+     Pointer and length view of contiguous elements, the subset of C++20
+     std::span the library needs. Converts implicitly from any container
+     with data() and size() (std::vector, std::array, ...) and from Span<U>
+     to Span<const U>. Never owns or allocates.
+  */
+  template <typename T>
+  class Span{
+
+    public:
+
+      using element_type = T;
+      using value_type   = typename std::remove_cv<T>::type;
+      using iterator     = T*;
+
+      constexpr Span() noexcept : fData(nullptr), fSize(0) {}
+
+      constexpr Span(T* data, const size_t size) noexcept :
+        fData(data), fSize(size) {}
+
+      template <typename Container, typename = typename std::enable_if<
+        std::is_convertible<
+          decltype(std::declval<Container&>().data()), T*>::value>::type>
+      constexpr Span(Container& container) noexcept :
+        fData(container.data()), fSize(container.size()) {}
+
+      template <typename U, typename = typename std::enable_if<
+        std::is_convertible<U*, T*>::value>::type>
+      constexpr Span(const Span<U>& other) noexcept :
+        fData(other.data()), fSize(other.size()) {}
+
+      constexpr T*     data()  const noexcept { return fData; }
+      constexpr size_t size()  const noexcept { return fSize; }
+      constexpr bool   empty() const noexcept { return fSize == 0; }
+
+      constexpr T& operator[](const size_t idx) const { return fData[idx]; }
+
+      constexpr iterator begin() const noexcept { return fData; }
+      constexpr iterator end()   const noexcept { return fData + fSize; }
+
+      /// View of count elements starting at offset
+      constexpr Span subspan(const size_t offset, const size_t count) const
+      {
+        return Span(fData + offset, count);
+      }
+
+    private:
+
+      T*     fData;
+      size_t fSize;
+  };
+}
+
+#endif
+/** @} */ // end of doxygen group
+
@@ -0,0 +1,258 @@
+#ifndef __SIGPROC_TOOLS_THREADPOOL_CXX__
+#define __SIGPROC_TOOLS_THREADPOOL_CXX__
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+
+#ifdef ICARUSSIGPROC_USE_TBB
+#include "tbb/task_group.h"
+#endif
+
+namespace {
+
+  std::mutex                                 gInstanceMutex;
+  std::unique_ptr<icarussigproc::ThreadPool> gInstance;
+  std::atomic<icarussigproc::ThreadPool*>    gPool(nullptr);
+
+#ifdef ICARUSSIGPROC_USE_TBB
+  std::atomic<tbb::task_arena*>              gArena(nullptr);
+#endif
+
+  // Pool and queue index of the calling thread when it is a worker
+  thread_local const icarussigproc::ThreadPool* tPool = nullptr;
+  thread_local unsigned int                      tIndex = 0;
+  thread_local unsigned int                      tVictim = 0;
+
+  unsigned int getDefaultConcurrency()
+  {
+    if (const char* value = std::getenv("ICARUSSIGPROC_NUM_THREADS")) {
+      char* end = nullptr;
+      unsigned long number = std::strtoul(value, &end, 10);
+      if (*value != '\0' && *end == '\0' && number > 0) return number;
+    }
+    return std::max(1U, std::thread::hardware_concurrency());
+  }
+}
+
+icarussigproc::ThreadPool& icarussigproc::ThreadPool::getInstance()
+{
+  ThreadPool* pool = gPool.load(std::memory_order_acquire);
+  if (pool) return *pool;
+  std::lock_guard<std::mutex> lock(gInstanceMutex);
+  if (!gInstance) {
+    gInstance.reset(new ThreadPool(getDefaultConcurrency()));
+    gPool.store(gInstance.get(), std::memory_order_release);
+  }
+  return *gInstance;
+}
+
+void icarussigproc::ThreadPool::configure(const unsigned int concurrency)
+{
+  std::lock_guard<std::mutex> lock(gInstanceMutex);
+  gPool.store(nullptr, std::memory_order_release);
+  gInstance.reset();
+  gInstance.reset(new ThreadPool(
+    concurrency > 0 ? concurrency : getDefaultConcurrency()));
+  gPool.store(gInstance.get(), std::memory_order_release);
+  return;
+}
+
+#ifdef ICARUSSIGPROC_USE_TBB
+void icarussigproc::ThreadPool::setArena(tbb::task_arena* arena)
+{
+  gArena.store(arena);
+  return;
+}
+#endif
+
+icarussigproc::ThreadPool::ThreadPool(const unsigned int concurrency) :
+  fPending(0),
+  fStop(false)
+{
+  unsigned int numThreads = std::max(concurrency, 1U) - 1;
+  for (unsigned int i=0; i<=numThreads; ++i) {
+    fQueues.emplace_back(new WorkQueue);
+  }
+  fThreads.reserve(numThreads);
+  for (unsigned int i=0; i<numThreads; ++i) {
+    fThreads.emplace_back(&ThreadPool::workerLoop, this, i);
+  }
+}
+
+icarussigproc::ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(fSleepMutex);
+    fStop = true;
+  }
+  fWake.notify_all();
+  for (auto& thread : fThreads) thread.join();
+}
+
+unsigned int icarussigproc::ThreadPool::getConcurrency() const
+{
+#ifdef ICARUSSIGPROC_USE_TBB
+  if (tbb::task_arena* arena = gArena.load()) {
+    return std::max(arena->max_concurrency(), 1);
+  }
+#endif
+  return fQueues.size();
+}
+
+void icarussigproc::ThreadPool::runLanes(
+  const unsigned int numLanes,
+  const std::function<void(unsigned int)>& func)
+{
+  if (numLanes == 0) return;
+
+#ifdef ICARUSSIGPROC_USE_TBB
+  if (tbb::task_arena* arena = gArena.load()) {
+    std::exception_ptr error;
+    arena->execute([&]() {
+      tbb::task_group group;
+      for (unsigned int lane=1; lane<numLanes; ++lane) {
+        group.run([&func, lane]() { func(lane); });
+      }
+      try {
+        func(0);
+      } catch (...) {
+        error = std::current_exception();
+      }
+      try {
+        group.wait();
+      } catch (...) {
+        if (!error) error = std::current_exception();
+      }
+    });
+    if (error) std::rethrow_exception(error);
+    return;
+  }
+#endif
+
+  if (numLanes == 1) {
+    func(0);
+    return;
+  }
+
+  // Completion is counted under the mutex so that the group outlives the
+  // last notification
+  struct LaneGroup {
+    std::mutex              mutex;
+    std::condition_variable done;
+    unsigned int            remaining;
+    std::exception_ptr      error;
+  };
+  LaneGroup group;
+  group.remaining = numLanes - 1;
+
+  for (unsigned int lane=1; lane<numLanes; ++lane) {
+    submit(Task{[&group, &func, lane]() {
+      std::exception_ptr error;
+      try {
+        func(lane);
+      } catch (...) {
+        error = std::current_exception();
+      }
+      std::lock_guard<std::mutex> lock(group.mutex);
+      if (error && !group.error) group.error = error;
+      if (--group.remaining == 0) group.done.notify_all();
+    }});
+  }
+
+  std::exception_ptr error;
+  try {
+    func(0);
+  } catch (...) {
+    error = std::current_exception();
+  }
+
+  // Help with queued work (ours or not) until the lanes are done
+  while (true) {
+    {
+      std::lock_guard<std::mutex> lock(group.mutex);
+      if (group.remaining == 0) break;
+    }
+    if (runOne()) continue;
+    std::unique_lock<std::mutex> lock(group.mutex);
+    group.done.wait_for(lock, std::chrono::microseconds(100),
+      [&group]() { return group.remaining == 0; });
+  }
+
+  if (!error) error = group.error;
+  if (error) std::rethrow_exception(error);
+  return;
+}
+
+void icarussigproc::ThreadPool::submit(Task&& task)
+{
+  WorkQueue& queue = tPool == this ? *fQueues[tIndex] : *fQueues.back();
+  ++fPending;
+  {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back(std::move(task));
+  }
+  {
+    // Pairs with the predicate check of sleeping workers
+    std::lock_guard<std::mutex> lock(fSleepMutex);
+  }
+  fWake.notify_one();
+  return;
+}
+
+bool icarussigproc::ThreadPool::runOne()
+{
+  Task task;
+  bool isWorker = tPool == this;
+  bool found = isWorker && popBack(*fQueues[tIndex], task);
+  if (!found) found = popFront(*fQueues.back(), task);
+  // fQueues is complete before the first worker starts, unlike fThreads
+  size_t numThreads = fQueues.size() - 1;
+  for (size_t k=0; !found && k<numThreads; ++k) {
+    size_t victim = (tVictim + k) % numThreads;
+    if (isWorker && victim == tIndex) continue;
+    found = popFront(*fQueues[victim], task);
+    if (found) tVictim = victim;
+  }
+  if (!found) return false;
+  --fPending;
+  task.func();
+  return true;
+}
+
+bool icarussigproc::ThreadPool::popBack(WorkQueue& queue, Task& task)
+{
+  std::lock_guard<std::mutex> lock(queue.mutex);
+  if (queue.tasks.empty()) return false;
+  task = std::move(queue.tasks.back());
+  queue.tasks.pop_back();
+  return true;
+}
+
+bool icarussigproc::ThreadPool::popFront(WorkQueue& queue, Task& task)
+{
+  std::lock_guard<std::mutex> lock(queue.mutex);
+  if (queue.tasks.empty()) return false;
+  task = std::move(queue.tasks.front());
+  queue.tasks.pop_front();
+  return true;
+}
+
+void icarussigproc::ThreadPool::workerLoop(const unsigned int index)
+{
+  tPool = this;
+  tIndex = index;
+  tVictim = index + 1;
+  while (true) {
+    if (runOne()) continue;
+    std::unique_lock<std::mutex> lock(fSleepMutex);
+    fWake.wait(lock, [this]() { return fStop || fPending > 0; });
+    if (fStop) break;
+  }
+  return;
+}
+
+#endif
@@ -0,0 +1,113 @@
+/**
+ * \file ThreadPool.h
+ *
+ * \ingroup icarussigproc
+ *
+ * \brief Library-wide work-stealing task scheduler behind parallelFor
+ *
+ */
+
+/** \addtogroup icarussigproc
+
+    @{*/
+#ifndef __SIGPROC_TOOLS_THREADPOOL_H__
+#define __SIGPROC_TOOLS_THREADPOOL_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef ICARUSSIGPROC_USE_TBB
+#include "tbb/task_arena.h"
+#endif
+
+namespace icarussigproc {
+
+  /**
+     \class ThreadPool
+     One set of worker threads shared by every parallel kernel of the
+     library, so that concurrent and nested parallel calls queue tasks
+     instead of starting threads of their own. Each worker owns a deque:
+     it pushes and pops its own tasks at the back, idle workers steal from
+     the front of the others; tasks submitted from outside the pool go to a
+     shared queue. A thread waiting for its tasks executes queued tasks
+     meanwhile, which keeps nested parallelism deadlock free.
+
+     The concurrency (workers plus the submitting thread) defaults to the
+     ICARUSSIGPROC_NUM_THREADS environment variable, else the number of
+     hardware threads. When built with ICARUSSIGPROC_USE_TBB, the work can
+     instead run in an external tbb::task_arena (e.g. the one of the art
+     framework), which then also sets the concurrency.
+  */
+  class ThreadPool{
+
+    public:
+
+      /// The library-wide pool, started on first use
+      static ThreadPool& getInstance();
+
+      /// Restarts the library-wide pool with the given concurrency (0 for
+      /// the default). Call it while no parallel work is running.
+      static void configure(const unsigned int concurrency);
+
+#ifdef ICARUSSIGPROC_USE_TBB
+      /// Runs all parallel work in arena instead of the own workers, or in
+      /// the own workers again for nullptr. The arena must outlive its use.
+      static void setArena(tbb::task_arena* arena);
+#endif
+
+      explicit ThreadPool(const unsigned int concurrency);
+
+      ~ThreadPool();
+
+      ThreadPool(const ThreadPool&) = delete;
+      ThreadPool& operator=(const ThreadPool&) = delete;
+
+      /// Number of threads running tasks at once, the caller included
+      unsigned int getConcurrency() const;
+
+      /// Calls func(lane) for every lane in [0, numLanes), lane 0 on the
+      /// calling thread, and returns when all are done, rethrowing the
+      /// first exception. Each lane runs exactly once, on one thread.
+      void runLanes(const unsigned int numLanes,
+        const std::function<void(unsigned int)>& func);
+
+    private:
+
+      struct Task {
+        std::function<void()> func;
+      };
+
+      /// Deque of one worker, the shared queue being the last one
+      struct WorkQueue {
+        std::mutex       mutex;
+        std::deque<Task> tasks;
+      };
+
+      void submit(Task&& task);
+
+      /// Runs one queued task: own queue first, then the shared queue,
+      /// then stealing; false when there was none
+      bool runOne();
+
+      bool popBack(WorkQueue& queue, Task& task);
+      bool popFront(WorkQueue& queue, Task& task);
+
+      void workerLoop(const unsigned int index);
+
+      std::vector<std::unique_ptr<WorkQueue>> fQueues;
+      std::vector<std::thread>                fThreads;
+      std::mutex                              fSleepMutex;
+      std::condition_variable                 fWake;
+      std::atomic<size_t>                     fPending;
+      bool                                    fStop;
+  };
+}
+
+#endif
+/** @} */ // end of doxygen group
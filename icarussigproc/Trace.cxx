@@ -0,0 +1,236 @@
+#ifndef __SIGPROC_TOOLS_TRACE_CXX__
+#define __SIGPROC_TOOLS_TRACE_CXX__
+
+#include "Trace.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace {
+
+  struct Event {
+    const char* name;
+    const char* argName;
+    int64_t     argValue;
+    int64_t     begin;
+    int64_t     end;
+  };
+
+  // Events in fixed size chunks: appending never moves recorded events
+  class ThreadBuffer {
+
+    public:
+
+      static constexpr size_t kChunkSize = 4096;
+
+      void append(const Event& event)
+      {
+        if (fSize == fChunks.size() * kChunkSize) {
+          fChunks.emplace_back(new Event[kChunkSize]);
+        }
+        fChunks[fSize / kChunkSize][fSize % kChunkSize] = event;
+        ++fSize;
+        return;
+      }
+
+      void clear() { fSize = 0; }
+
+      size_t size() const { return fSize; }
+
+      const Event& operator[](const size_t i) const
+      {
+        return fChunks[i / kChunkSize][i % kChunkSize];
+      }
+
+    private:
+
+      std::vector<std::unique_ptr<Event[]>> fChunks;
+      size_t                                fSize = 0;
+  };
+
+  class Registry {
+
+    public:
+
+      // Never destroyed: threads may release their buffer during static
+      // destruction
+      static Registry& get()
+      {
+        static Registry* registry = new Registry;
+        return *registry;
+      }
+
+      ThreadBuffer* acquire()
+      {
+        std::lock_guard<std::mutex> lock(fMutex);
+        for (size_t i=0; i<fBuffers.size(); ++i) {
+          if (!fInUse[i]) {
+            fInUse[i] = true;
+            return fBuffers[i].get();
+          }
+        }
+        fBuffers.emplace_back(new ThreadBuffer);
+        fInUse.push_back(true);
+        return fBuffers.back().get();
+      }
+
+      void release(const ThreadBuffer* buffer)
+      {
+        std::lock_guard<std::mutex> lock(fMutex);
+        for (size_t i=0; i<fBuffers.size(); ++i) {
+          if (fBuffers[i].get() == buffer) fInUse[i] = false;
+        }
+        return;
+      }
+
+      template <typename Func>
+      void forEach(Func func)
+      {
+        std::lock_guard<std::mutex> lock(fMutex);
+        for (size_t i=0; i<fBuffers.size(); ++i) func(i, *fBuffers[i]);
+        return;
+      }
+
+    private:
+
+      std::mutex                                 fMutex;
+      std::vector<std::unique_ptr<ThreadBuffer>> fBuffers;
+      std::vector<bool>                          fInUse;
+  };
+
+  struct ThreadSlot {
+    ThreadBuffer* buffer = nullptr;
+
+    ThreadBuffer& get()
+    {
+      if (!buffer) buffer = Registry::get().acquire();
+      return *buffer;
+    }
+
+    ~ThreadSlot()
+    {
+      if (buffer) Registry::get().release(buffer);
+    }
+  };
+
+  thread_local ThreadSlot tSlot;
+
+  std::atomic<bool> gActive(false);
+
+  const std::chrono::steady_clock::time_point gEpoch =
+    std::chrono::steady_clock::now();
+
+  void writeString(std::ostream& stream, const char* value)
+  {
+    stream << '"';
+    for (const char* c = value; *c; ++c) {
+      if (*c == '"' || *c == '\\') stream << '\\' << *c;
+      else if (static_cast<unsigned char>(*c) >= 0x20) stream << *c;
+    }
+    stream << '"';
+    return;
+  }
+
+  // Microseconds with nanosecond digits, the unit of the format
+  void writeMicroseconds(std::ostream& stream, const int64_t ns)
+  {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%lld.%03lld",
+      static_cast<long long>(ns / 1000), static_cast<long long>(ns % 1000));
+    stream << text;
+    return;
+  }
+}
+
+void icarussigproc::Trace::start()
+{
+  Registry::get().forEach([](size_t, ThreadBuffer& buffer) { buffer.clear(); });
+  gActive = true;
+  return;
+}
+
+void icarussigproc::Trace::stop()
+{
+  gActive = false;
+  return;
+}
+
+bool icarussigproc::Trace::isActive()
+{
+  return gActive.load(std::memory_order_relaxed);
+}
+
+void icarussigproc::Trace::record(
+  const char* name,
+  const char* argName,
+  const int64_t argValue,
+  const int64_t beginNs,
+  const int64_t endNs)
+{
+  if (!isActive()) return;
+  tSlot.get().append(Event{name, argName, argValue, beginNs, endNs});
+  return;
+}
+
+int64_t icarussigproc::Trace::now()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now() - gEpoch).count();
+}
+
+void icarussigproc::Trace::writeJSON(std::ostream& stream)
+{
+  stream << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+  bool first = true;
+  Registry::get().forEach([&](size_t thread, const ThreadBuffer& buffer) {
+    if (buffer.size() == 0) return;
+    stream << (first ? "\n" : ",\n")
+           << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, "
+           << "\"tid\": " << thread << ", \"args\": {\"name\": \"thread "
+           << thread << "\"}}";
+    first = false;
+    for (size_t i=0; i<buffer.size(); ++i) {
+      const Event& event = buffer[i];
+      stream << ",\n{\"name\": ";
+      writeString(stream, event.name);
+      stream << ", \"cat\": \"sigproc\", \"ph\": \"X\", \"pid\": 1, \"tid\": "
+             << thread << ", \"ts\": ";
+      writeMicroseconds(stream, event.begin);
+      stream << ", \"dur\": ";
+      writeMicroseconds(stream, event.end - event.begin);
+      if (event.argName) {
+        stream << ", \"args\": {";
+        writeString(stream, event.argName);
+        stream << ": " << event.argValue << "}";
+      }
+      stream << "}";
+    }
+  });
+  stream << "\n]}\n";
+  return;
+}
+
+icarussigproc::TraceScope::TraceScope(
+  const char* name,
+  const char* argName,
+  const int64_t argValue) :
+  fName(name),
+  fArgName(argName),
+  fArgValue(argValue),
+  fBegin(Trace::isActive() ? Trace::now() : -1)
+{
+}
+
+icarussigproc::TraceScope::~TraceScope()
+{
+  if (fBegin >= 0) {
+    Trace::record(fName, fArgName, fArgValue, fBegin, Trace::now());
+  }
+}
+
+#endif
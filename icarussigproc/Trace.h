@@ -0,0 +1,96 @@
+/**
+ * \file Trace.h
+ *
+ * \ingroup icarussigproc
+ *
+ * \brief Timeline of scoped events in the Chrome trace format
+ *
+ */
+
+/** \addtogroup icarussigproc
+
+    @{*/
+#ifndef __SIGPROC_TOOLS_TRACE_H__
+#define __SIGPROC_TOOLS_TRACE_H__
+
+#include <cstdint>
+#include <iosfwd>
+#include "Instrumentation.h"
+
+namespace icarussigproc {
+
+  /**
+     \class Trace
+     Records begin and end of scoped events (see SIGPROC_TRACE) while a
+     session is active and writes them in the Chrome trace event format,
+     which chrome://tracing and ui.perfetto.dev open. Each thread appends to
+     its own buffer without locking; a buffer is reused by the next new
+     thread once its owner exits, so the timeline has one row per
+     concurrently running thread.
+
+     Compiled in with ICARUSSIGPROC_INSTRUMENTATION, like the phase
+     counters. Usage: start(), process, stop(), writeJSON(). writeJSON must
+     not run while traced code is running.
+  */
+  class Trace{
+
+    public:
+
+      /// Clears all buffers and starts recording
+      static void start();
+
+      /// Stops recording, keeping the events
+      static void stop();
+
+      static bool isActive();
+
+      /// Appends a complete event to the buffer of the calling thread; the
+      /// names must outlive the session (e.g. string literals)
+      static void record(const char* name, const char* argName,
+        const int64_t argValue, const int64_t beginNs, const int64_t endNs);
+
+      /// Nanoseconds on the clock of the event timestamps
+      static int64_t now();
+
+      /// Writes the recorded events as a Chrome trace JSON object
+      static void writeJSON(std::ostream& stream);
+  };
+
+  /**
+     \class TraceScope
+     One event from construction to destruction, with an optional integer
+     argument (e.g. the channel group). Use through SIGPROC_TRACE.
+  */
+  class TraceScope{
+
+    public:
+
+      TraceScope(const char* name, const char* argName=nullptr,
+        const int64_t argValue=0);
+
+      ~TraceScope();
+
+      TraceScope(const TraceScope&) = delete;
+      TraceScope& operator=(const TraceScope&) = delete;
+
+    private:
+
+      const char* fName;
+      const char* fArgName;
+      int64_t     fArgValue;
+      int64_t     fBegin;
+  };
+}
+
+/// Records the rest of the enclosing scope as a trace event named name with
+/// the integer argument argName = argValue; compiled out like SIGPROC_PHASE
+#ifdef ICARUSSIGPROC_INSTRUMENTATION
+#define SIGPROC_TRACE(name, argName, argValue) \
+  icarussigproc::TraceScope SIGPROC_CONCAT(sigprocTrace_, __LINE__)( \
+    name, argName, argValue)
+#else
+#define SIGPROC_TRACE(name, argName, argValue) ((void)sizeof(argValue))
+#endif
+
+#endif
+/** @} */ // end of doxygen group
@@ -1,179 +1,542 @@
-
-#include "WaveformParamsAlg.h"
-
-#include <cmath>
-#include <algorithm>
-#include <functional>
-#include <numeric>
-#include <vector>
-
-namespace icarussigproc
-{
-//----------------------------------------------------------------------------
-/// Constructor.
-///
-/// Arguments:
-///
-/// pset - Fcl parameters.
-///
-WaveformParamsAlg::WaveformParamsAlg()
-{
-    return;
-}
-    
-//----------------------------------------------------------------------------
-/// Destructor.
-WaveformParamsAlg::~WaveformParamsAlg()
-{}
-
-void WaveformParamsAlg::getTruncatedRMS(VectorFloat& rawWaveform,
-                                        float&       pedestal,
-                                        float&       truncRms) const
-{
-    // do rms calculation - the old fashioned way and over all adc values
-    std::vector<float> adcLessPedVec;
-    
-    adcLessPedVec.resize(rawWaveform.size());
-    
-    // Fill the vector
-    std::transform(rawWaveform.begin(),rawWaveform.end(),adcLessPedVec.begin(),std::bind(std::minus<short>(),std::placeholders::_1,pedestal));
-    
-    // sort in ascending order so we can truncate the sume
-    std::sort(adcLessPedVec.begin(), adcLessPedVec.end(),[](const auto& left, const auto& right){return std::fabs(left) < std::fabs(right);});
-    
-    int minNumBins = 0.6 * rawWaveform.size();
-    
-    // Get the truncated sum
-    truncRms = std::inner_product(adcLessPedVec.begin(), adcLessPedVec.begin() + minNumBins, adcLessPedVec.begin(), 0.);
-    truncRms = std::sqrt(std::max(0.,truncRms / double(minNumBins)));
-    
-    return;
-}
-
-void WaveformParamsAlg::getMeanAndRms(VectorFloat& rawWaveform,
-                                      float&       aveVal,
-                                      float&       rmsVal,
-                                      int&         numBins) const
-{
-    // The strategy for finding the average for a given wire will be to
-    // find the most populated bin and the average using the neighboring bins
-    // To do this we'll use a map with key the bin number and data the count in that bin
-    std::pair<VectorFloat::const_iterator,VectorFloat::const_iterator> minMaxValItr = std::minmax_element(rawWaveform.begin(),rawWaveform.end());
-    
-    int minVal = std::floor(*minMaxValItr.first);
-    int maxVal = std::ceil(*minMaxValItr.second);
-    int range  = maxVal - minVal + 1;
-    
-    std::vector<int> frequencyVec(range, 0);
-    int              mpCount(0);
-    int              mpVal(0);
-    
-    for(const auto& val : rawWaveform)
-    {
-        int intVal = std::round(val) - minVal;
-        
-        frequencyVec[intVal]++;
-        
-        if (frequencyVec.at(intVal) > mpCount)
-        {
-            mpCount = frequencyVec[intVal];
-            mpVal   = intVal;
-        }
-    }
-    
-    // take a weighted average of two neighbor bins
-    int meanCnt  = 0;
-    int meanSum  = 0;
-    int binRange = std::min(16, int(range/2 + 1));
-
-    for(int idx = mpVal-binRange; idx <= mpVal+binRange; idx++)
-    {
-        if (idx < 0 || idx >= range) continue;
-        
-        meanSum += (idx + minVal) * frequencyVec[idx];
-        meanCnt += frequencyVec[idx];
-    }
-    
-    aveVal = float(meanSum) / float(meanCnt);
-    
-    // do rms calculation - the old fashioned way and over all adc values
-    std::vector<float> adcLessPedVec(rawWaveform.size());
-    
-    std::transform(rawWaveform.begin(),rawWaveform.end(),adcLessPedVec.begin(),std::bind(std::minus<float>(),std::placeholders::_1,aveVal));
-    
-    // recalculate the rms for truncation
-    rmsVal  = std::inner_product(adcLessPedVec.begin(), adcLessPedVec.end(), adcLessPedVec.begin(), 0.);
-    rmsVal  = std::sqrt(std::max(float(0.),rmsVal / float(adcLessPedVec.size())));
-    numBins = meanCnt;
-    
-    return;
-}
-
-void WaveformParamsAlg::getMeanAndTruncRms(VectorFloat& rawWaveform,
-                                           float&       aveVal,
-                                           float&       rmsVal,
-                                           float&       rmsTrunc,
-                                           int&         numBins) const
-{
-    // The strategy for finding the average for a given wire will be to
-    // find the most populated bin and the average using the neighboring bins
-    // To do this we'll use a map with key the bin number and data the count in that bin
-    std::pair<VectorFloat::const_iterator,VectorFloat::const_iterator> minMaxValItr = std::minmax_element(rawWaveform.begin(),rawWaveform.end());
-    
-    int minVal = std::floor(*minMaxValItr.first);
-    int maxVal = std::ceil(*minMaxValItr.second);
-    int range  = maxVal - minVal + 1;
-    
-    std::vector<int> frequencyVec(range, 0);
-    int              mpCount(0);
-    int              mpVal(0);
-    
-    for(const auto& val : rawWaveform)
-    {
-        int intVal = std::round(val) - minVal;
-        
-        frequencyVec[intVal]++;
-        
-        if (frequencyVec.at(intVal) > mpCount)
-        {
-            mpCount = frequencyVec[intVal];
-            mpVal   = intVal;
-        }
-    }
-    
-    // take a weighted average of two neighbor bins
-    int meanCnt  = 0;
-    int meanSum  = 0;
-    int binRange = std::min(16, int(range/2 + 1));
-    
-    for(int idx = mpVal-binRange; idx <= mpVal+binRange; idx++)
-    {
-        if (idx < 0 || idx >= range) continue;
-        
-        meanSum += (idx + minVal) * frequencyVec[idx];
-        meanCnt += frequencyVec[idx];
-    }
-    
-    aveVal = float(meanSum) / float(meanCnt);
-    
-    // Subtract the pedestal 
-    std::transform(rawWaveform.begin(),rawWaveform.end(),rawWaveform.begin(),std::bind(std::minus<float>(),std::placeholders::_1,aveVal));
-    
-    // do rms calculation - the old fashioned way and over all adc values
-    VectorFloat adcLessPedVec = rawWaveform;
-    
-    // recalculate the rms for truncation
-    rmsVal  = std::inner_product(adcLessPedVec.begin(), adcLessPedVec.end(), adcLessPedVec.begin(), 0.);
-    rmsVal  = std::sqrt(std::max(float(0.),rmsVal / float(adcLessPedVec.size())));
-    
-    // Drop the "large" rms values and recompute
-    std::vector<float>::iterator newEndItr = std::remove_if(adcLessPedVec.begin(),adcLessPedVec.end(),[rmsVal](const auto& val){return std::abs(val) > 2.5*rmsVal;});
-    
-    rmsTrunc = std::inner_product(adcLessPedVec.begin(), newEndItr, adcLessPedVec.begin(), 0.);
-    numBins  = std::distance(adcLessPedVec.begin(),newEndItr);
-    rmsTrunc = std::sqrt(std::max(float(0.),rmsTrunc / float(numBins)));
-    
-    return;
-}
-    
-}
+
+#include "WaveformParamsAlg.h"
+#include "ParallelFor.h"
+
+#include "lardataobj/RawData/raw.h"
+
+#include <cmath>
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace icarussigproc
+{
+//----------------------------------------------------------------------------
+/// Constructor.
+///
+/// Arguments:
+///
+/// pset - Fcl parameters.
+///
+WaveformParamsAlg::WaveformParamsAlg()
+{
+    return;
+}
+    
+//----------------------------------------------------------------------------
+/// Destructor.
+WaveformParamsAlg::~WaveformParamsAlg()
+{}
+
+void WaveformParamsAlg::getTruncatedRMS(VectorFloat& rawWaveform,
+                                        float&       pedestal,
+                                        float&       truncRms) const
+{
+    VectorFloat scratch;
+    
+    getTruncatedRMS(rawWaveform, pedestal, truncRms, scratch);
+    
+    return;
+}
+
+void WaveformParamsAlg::getTruncatedRMS(Span<const float> rawWaveform,
+                                        float             pedestal,
+                                        float&            truncRms,
+                                        VectorFloat&      scratch) const
+{
+    // The rms is computed from the 60% of the bins closest to the pedestal.
+    // Only which bins are kept matters, not their order, so a selection on
+    // |adc - pedestal| replaces the full sort.
+    int minNumBins = 0.6 * rawWaveform.size();
+    
+    truncRms = 0.;
+    
+    if (minNumBins < 1) return;
+    
+    scratch.resize(rawWaveform.size());
+    
+    std::transform(rawWaveform.begin(),rawWaveform.end(),scratch.begin(),[pedestal](const auto& val){return std::fabs(val - pedestal);});
+    
+    if (minNumBins < int(scratch.size())) std::nth_element(scratch.begin(), scratch.begin() + minNumBins, scratch.end());
+    
+    // Get the truncated sum
+    double truncSum = std::inner_product(scratch.begin(), scratch.begin() + minNumBins, scratch.begin(), 0.);
+    
+    truncRms = std::sqrt(std::max(0.,truncSum / double(minNumBins)));
+    
+    return;
+}
+
+void WaveformParamsAlg::getTruncatedRMS(Span<const short> rawWaveform,
+                                        float             pedestal,
+                                        float&            truncRms,
+                                        std::vector<int>& histogram) const
+{
+    // Integer ADC values: count the occurrences of each value, then collect
+    // the 60% of the bins closest to the pedestal by walking the histogram
+    // outwards from the pedestal.
+    int minNumBins = 0.6 * rawWaveform.size();
+    
+    truncRms = 0.;
+    
+    if (minNumBins < 1) return;
+    
+    std::pair<const short*,const short*> minMaxValItr = std::minmax_element(rawWaveform.begin(),rawWaveform.end());
+    
+    int minVal = *minMaxValItr.first;
+    int maxVal = *minMaxValItr.second;
+    
+    histogram.assign(maxVal - minVal + 1, 0);
+    
+    for(const auto& val : rawWaveform) histogram[val - minVal]++;
+    
+    // Start from the values on either side of the pedestal
+    int    hiIdx    = std::min(std::max(int(std::ceil(pedestal)) - minVal, 0), maxVal - minVal + 1);
+    int    loIdx    = hiIdx - 1;
+    int    numLeft  = minNumBins;
+    double truncSum = 0.;
+    
+    while(numLeft > 0)
+    {
+        double loDiff = loIdx >= 0                   ? pedestal - float(loIdx + minVal) : -1.;
+        double hiDiff = hiIdx <= maxVal - minVal     ? float(hiIdx + minVal) - pedestal : -1.;
+        bool   takeLo = hiDiff < 0. || (loDiff >= 0. && loDiff <= hiDiff);
+        int    idx    = takeLo ? loIdx-- : hiIdx++;
+        double diff   = takeLo ? loDiff  : hiDiff;
+        int    count  = std::min(histogram[idx], numLeft);
+        
+        truncSum += count * diff * diff;
+        numLeft  -= count;
+    }
+    
+    truncRms = std::sqrt(std::max(0.,truncSum / double(minNumBins)));
+    
+    return;
+}
+
+void WaveformParamsAlg::getMeanAndRms(VectorFloat& rawWaveform,
+                                      float&       aveVal,
+                                      float&       rmsVal,
+                                      int&         numBins) const
+{
+    PedestalScratch scratch;
+    
+    getMeanAndRms(Span<const float>(rawWaveform), aveVal, rmsVal, numBins, scratch);
+    
+    return;
+}
+
+void WaveformParamsAlg::getMeanAndTruncRms(VectorFloat& rawWaveform,
+                                           float&       aveVal,
+                                           float&       rmsVal,
+                                           float&       rmsTrunc,
+                                           int&         numBins) const
+{
+    PedestalScratch scratch;
+    
+    // The original interface subtracts the pedestal in place
+    getMeanAndTruncRms(Span<const float>(rawWaveform), aveVal, rmsVal, rmsTrunc, numBins, scratch, Span<float>(rawWaveform));
+    
+    return;
+}
+
+void WaveformParamsAlg::getMeanAndRms(Span<const float> rawWaveform,
+                                      float&            aveVal,
+                                      float&            rmsVal,
+                                      int&              numBins,
+                                      PedestalScratch&  scratch) const
+{
+    PedestalStats stats;
+    
+    getPedestalStats(rawWaveform.data(), rawWaveform.size(), stats, scratch);
+    
+    aveVal  = stats.pedestal;
+    rmsVal  = stats.rms;
+    numBins = stats.numBins;
+    
+    return;
+}
+
+void WaveformParamsAlg::getMeanAndRms(Span<const short> rawWaveform,
+                                      float&            aveVal,
+                                      float&            rmsVal,
+                                      int&              numBins,
+                                      PedestalScratch&  scratch) const
+{
+    PedestalStats stats;
+    
+    getPedestalStats(rawWaveform.data(), rawWaveform.size(), stats, scratch);
+    
+    aveVal  = stats.pedestal;
+    rmsVal  = stats.rms;
+    numBins = stats.numBins;
+    
+    return;
+}
+
+void WaveformParamsAlg::getMeanAndTruncRms(Span<const float> rawWaveform,
+                                           float&            aveVal,
+                                           float&            rmsVal,
+                                           float&            rmsTrunc,
+                                           int&              numBins,
+                                           PedestalScratch&  scratch,
+                                           Span<float>       pedSubtracted) const
+{
+    PedestalStats stats;
+    
+    getMeanAndTruncRms<float>(rawWaveform, stats, scratch, pedSubtracted);
+    
+    aveVal   = stats.pedestal;
+    rmsVal   = stats.rms;
+    rmsTrunc = stats.truncRms;
+    numBins  = stats.numTruncBins;
+    
+    return;
+}
+
+void WaveformParamsAlg::getMeanAndTruncRms(Span<const short> rawWaveform,
+                                           float&            aveVal,
+                                           float&            rmsVal,
+                                           float&            rmsTrunc,
+                                           int&              numBins,
+                                           PedestalScratch&  scratch,
+                                           Span<float>       pedSubtracted) const
+{
+    PedestalStats stats;
+    
+    getMeanAndTruncRms<short>(rawWaveform, stats, scratch, pedSubtracted);
+    
+    aveVal   = stats.pedestal;
+    rmsVal   = stats.rms;
+    rmsTrunc = stats.truncRms;
+    numBins  = stats.numTruncBins;
+    
+    return;
+}
+
+template <typename T>
+void WaveformParamsAlg::getMeanAndTruncRms(Span<const T>    rawWaveform,
+                                           PedestalStats&   stats,
+                                           PedestalScratch& scratch,
+                                           Span<float>      pedSubtracted) const
+{
+    if (!pedSubtracted.empty() && pedSubtracted.size() != rawWaveform.size())
+        throw std::invalid_argument("WaveformParamsAlg: output buffer length differs from the waveform");
+    
+    getPedestalStats(rawWaveform.data(), rawWaveform.size(), stats, scratch);
+    
+    // Subtract the pedestal into the output, the statistics are complete so
+    // the output may be the input itself
+    if (!pedSubtracted.empty())
+    {
+        const float pedestal = stats.pedestal;
+        
+        std::transform(rawWaveform.begin(),rawWaveform.end(),pedSubtracted.begin(),[pedestal](const T& val){return float(val) - pedestal;});
+    }
+    
+    return;
+}
+
+void WaveformParamsAlg::getMeanAndTruncRms(const float*    waveforms,
+                                           size_t          numChannels,
+                                           size_t          nTicks,
+                                           PedestalArrays& results,
+                                           unsigned int    numThreads) const
+{
+    auto getWaveform = [waveforms, nTicks](size_t channel, unsigned int)
+    {
+        return std::make_pair(waveforms + channel * nTicks, nTicks);
+    };
+    
+    getMeanAndTruncRms<float>(numChannels, getWaveform, results, numThreads);
+    
+    return;
+}
+
+void WaveformParamsAlg::getMeanAndTruncRms(const short*    waveforms,
+                                           size_t          numChannels,
+                                           size_t          nTicks,
+                                           PedestalArrays& results,
+                                           unsigned int    numThreads) const
+{
+    auto getWaveform = [waveforms, nTicks](size_t channel, unsigned int)
+    {
+        return std::make_pair(waveforms + channel * nTicks, nTicks);
+    };
+    
+    getMeanAndTruncRms<short>(numChannels, getWaveform, results, numThreads);
+    
+    return;
+}
+
+void WaveformParamsAlg::getMeanAndTruncRms(Array2DView<const float> waveforms,
+                                           PedestalArrays&          results,
+                                           unsigned int             numThreads) const
+{
+    auto getWaveform = [waveforms](size_t channel, unsigned int)
+    {
+        return std::make_pair(waveforms[channel], waveforms.numCols());
+    };
+    
+    getMeanAndTruncRms<float>(waveforms.numRows(), getWaveform, results, numThreads);
+    
+    return;
+}
+
+void WaveformParamsAlg::getMeanAndTruncRms(Array2DView<const short> waveforms,
+                                           PedestalArrays&          results,
+                                           unsigned int             numThreads) const
+{
+    auto getWaveform = [waveforms](size_t channel, unsigned int)
+    {
+        return std::make_pair(waveforms[channel], waveforms.numCols());
+    };
+    
+    getMeanAndTruncRms<short>(waveforms.numRows(), getWaveform, results, numThreads);
+    
+    return;
+}
+
+void WaveformParamsAlg::getMeanAndTruncRms(const std::vector<raw::RawDigit>& rawDigits,
+                                           PedestalArrays&                   results,
+                                           unsigned int                      numThreads) const
+{
+    // One uncompression buffer per worker, only touched for compressed digits
+    std::vector<std::vector<short>> adcBuffers(getNumWorkers(numThreads));
+    
+    auto getWaveform = [&rawDigits, &adcBuffers](size_t channel, unsigned int worker)
+    {
+        const raw::RawDigit& rawDigit = rawDigits[channel];
+        
+        if (rawDigit.Compression() == raw::kNone) return std::make_pair(rawDigit.ADCs().data(), rawDigit.ADCs().size());
+        
+        std::vector<short>& adcBuffer = adcBuffers[worker];
+        
+        adcBuffer.resize(rawDigit.Samples());
+        
+        raw::Uncompress(rawDigit.ADCs(), adcBuffer, rawDigit.Compression());
+        
+        return std::make_pair(static_cast<const short*>(adcBuffer.data()), adcBuffer.size());
+    };
+    
+    getMeanAndTruncRms<short>(rawDigits.size(), getWaveform, results, numThreads);
+    
+    return;
+}
+
+template <typename T, typename WaveformGetter>
+void WaveformParamsAlg::getMeanAndTruncRms(size_t          numChannels,
+                                           WaveformGetter  getWaveform,
+                                           PedestalArrays& results,
+                                           unsigned int    numThreads) const
+{
+    results.pedestal.resize(numChannels);
+    results.rms.resize(numChannels);
+    results.truncRms.resize(numChannels);
+    results.numBins.resize(numChannels);
+    
+    // Scratch histograms are allocated once per worker, sized for 12 bit ADCs
+    std::vector<PedestalScratch> scratches(getNumWorkers(numThreads));
+    
+    for(auto& scratch : scratches)
+    {
+        scratch.counts.reserve(4096);
+        
+        if (!std::is_integral<T>::value)
+        {
+            scratch.sums.reserve(4096);
+            scratch.sumSqs.reserve(4096);
+            scratch.straddles.reserve(4096);
+        }
+    }
+    
+    // Channels are handed out in blocks to amortize the scheduling
+    auto processChannels = [&](size_t begin, size_t end, unsigned int worker)
+    {
+        PedestalStats stats;
+        
+        for(size_t channel = begin; channel < end; channel++)
+        {
+            std::pair<const T*,size_t> waveform = getWaveform(channel, worker);
+            
+            getPedestalStats(waveform.first, waveform.second, stats, scratches[worker]);
+            
+            results.pedestal[channel] = stats.pedestal;
+            results.rms[channel]      = stats.rms;
+            results.truncRms[channel] = stats.truncRms;
+            results.numBins[channel]  = stats.numTruncBins;
+        }
+    };
+    
+    parallelFor(numChannels, 64, processChannels, numThreads);
+    
+    return;
+}
+
+template <typename T>
+void WaveformParamsAlg::getPedestalStats(const T*         waveform,
+                                         size_t           nTicks,
+                                         PedestalStats&   stats,
+                                         PedestalScratch& scratch) const
+{
+    // The strategy for finding the average for a given wire will be to
+    // find the most populated bin and the average using the neighboring bins.
+    // The histogram also keeps the sum and sum of squares of the samples in
+    // each bin (implicit for integer samples, where all samples of a bin have
+    // the bin value), so the full and truncated rms follow from the bin
+    // moments without going back over the samples.
+    if (nTicks == 0)
+    {
+        stats = PedestalStats{0., 0., 0., 0, 0};
+        return;
+    }
+    
+    std::pair<const T*,const T*> minMaxValItr = std::minmax_element(waveform,waveform+nTicks);
+    
+    int minVal = std::floor(*minMaxValItr.first);
+    int maxVal = std::ceil(*minMaxValItr.second);
+    int range  = maxVal - minVal + 1;
+    
+    constexpr bool isIntegral = std::is_integral<T>::value;
+    
+    std::vector<int>&    frequencyVec = scratch.counts;
+    std::vector<double>& sumVec       = scratch.sums;
+    std::vector<double>& sumSqVec     = scratch.sumSqs;
+    
+    frequencyVec.assign(range, 0);
+    
+    if (!isIntegral)
+    {
+        sumVec.assign(range, 0.);
+        sumSqVec.assign(range, 0.);
+    }
+    
+    int  mpCount(0);
+    int  mpVal(0);
+    bool allIntegral(true);
+    
+    for(size_t tick = 0; tick < nTicks; tick++)
+    {
+        const T val    = waveform[tick];
+        int     intVal = std::round(val) - minVal;
+        
+        frequencyVec[intVal]++;
+        
+        if (!isIntegral)
+        {
+            sumVec[intVal]   += val;
+            sumSqVec[intVal] += double(val) * double(val);
+            allIntegral       = allIntegral && val == std::round(val);
+        }
+        
+        if (frequencyVec[intVal] > mpCount)
+        {
+            mpCount = frequencyVec[intVal];
+            mpVal   = intVal;
+        }
+    }
+    
+    // take a weighted average of two neighbor bins
+    int meanCnt  = 0;
+    int meanSum  = 0;
+    int binRange = std::min(16, int(range/2 + 1));
+    
+    for(int idx = mpVal-binRange; idx <= mpVal+binRange; idx++)
+    {
+        if (idx < 0 || idx >= range) continue;
+        
+        meanSum += (idx + minVal) * frequencyVec[idx];
+        meanCnt += frequencyVec[idx];
+    }
+    
+    float aveVal = float(meanSum) / float(meanCnt);
+    
+    // Moments of each bin about the pedestal: sum (x - ave)^2 = S2 - 2 ave S1 + n ave^2
+    auto binSumSq = [&](int idx)
+    {
+        double binVal = idx + minVal;
+        double count  = frequencyVec[idx];
+        double sum    = allIntegral ? count * binVal          : sumVec[idx];
+        double sumSq  = allIntegral ? count * binVal * binVal : sumSqVec[idx];
+        
+        return sumSq - 2. * aveVal * sum + count * double(aveVal) * double(aveVal);
+    };
+    
+    double rmsSum = 0.;
+    
+    for(int idx = 0; idx < range; idx++) if (frequencyVec[idx] > 0) rmsSum += binSumSq(idx);
+    
+    float rmsVal = std::max(0., rmsSum);
+    
+    rmsVal = std::sqrt(std::max(float(0.),rmsVal / float(nTicks)));
+    
+    // Drop the "large" rms values and recompute. For integer samples a bin is
+    // kept or dropped as a whole; otherwise only bins whose [v-0.5,v+0.5] range
+    // straddles the cut need their samples examined individually
+    double truncCut   = 2.5 * rmsVal;
+    double truncSum   = 0.;
+    int    truncCnt   = 0;
+    bool   straddling = false;
+    
+    if (!allIntegral) scratch.straddles.assign(range, 0);
+    
+    for(int idx = 0; idx < range; idx++)
+    {
+        if (frequencyVec[idx] == 0) continue;
+        
+        float binVal = idx + minVal;
+        
+        if (!allIntegral)
+        {
+            double loDiff = std::abs(binVal - 0.5 - aveVal);
+            double hiDiff = std::abs(binVal + 0.5 - aveVal);
+            double minDiff = (binVal - 0.5 <= aveVal && aveVal <= binVal + 0.5) ? 0. : std::min(loDiff, hiDiff);
+            double maxDiff = std::max(loDiff, hiDiff);
+            
+            if (minDiff > truncCut) continue;
+            
+            if (maxDiff > truncCut)
+            {
+                scratch.straddles[idx] = 1;
+                straddling = true;
+                continue;
+            }
+        }
+        else if (std::abs(binVal - aveVal) > truncCut) continue;
+        
+        truncSum += binSumSq(idx);
+        truncCnt += frequencyVec[idx];
+    }
+    
+    if (straddling)
+    {
+        for(size_t tick = 0; tick < nTicks; tick++)
+        {
+            const T val = waveform[tick];
+            
+            if (!scratch.straddles[int(std::round(val)) - minVal]) continue;
+            
+            float adcLessPed = val - aveVal;
+            
+            if (std::abs(adcLessPed) > truncCut) continue;
+            
+            truncSum += adcLessPed * adcLessPed;
+            truncCnt++;
+        }
+    }
+    
+    float rmsTrunc = std::max(0., truncSum);
+    
+    stats.pedestal     = aveVal;
+    stats.rms          = rmsVal;
+    stats.truncRms     = std::sqrt(std::max(float(0.),rmsTrunc / float(truncCnt)));
+    stats.numBins      = meanCnt;
+    stats.numTruncBins = truncCnt;
+    
+    return;
+}
+    
+}
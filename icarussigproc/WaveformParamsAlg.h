@@ -1,65 +1,192 @@
-#ifndef WAVEFORMPARAMSALG_H
-#define WAVEFORMPARAMSALG_H
-////////////////////////////////////////////////////////////////////////
-//
-// Class:       WaveformParamsAlg
-// Module Type: producer
-// File:        WaveformParamsAlg.h
-//
-//              The intent of this module is to provide methods for
-//              characterizing an input RawDigit waveform
-//
-// Configuration parameters:
-//
-// TruncMeanFraction     - the fraction of waveform bins to discard when
-//                         computing the means and rms
-// RMSRejectionCutHi     - vector of maximum allowed rms values to keep channel
-// RMSRejectionCutLow    - vector of lowest allowed rms values to keep channel
-// RMSSelectionCut       - vector of rms values below which to not correct
-// MaxPedestalDiff       - Baseline difference to pedestal to flag
-//
-// Created by Tracy Usher (usher@slac.stanford.edu) on January 6, 2016
-// Based on work done by Brian Kirby, Mike Mooney and Jyoti Joshi
-//
-////////////////////////////////////////////////////////////////////////
-#include "lardataobj/RawData/RawDigit.h"
-
-namespace icarussigproc
-{
-class WaveformParamsAlg
-{
-public:
-
-    // Copnstructors, destructor.
-    WaveformParamsAlg();
-    ~WaveformParamsAlg();
-
-    // Provide definitions of the raw waveforms for internal use
-      using VectorFloat = std::vector<float>;
-      using ArrayFloat  = std::vector<VectorFloat>;
-    
-    // Basic waveform mean and rms
-    void getMeanAndRms(VectorFloat& rawWaveform,
-                       float&       aveVal,
-                       float&       rmsVal,
-                       int&         numBins) const;
-    
-    // Basic waveform mean and rms plus trunated rms
-    void getMeanAndTruncRms(VectorFloat& rawWaveform,
-                            float&       aveVal,
-                            float&       rmsVal,
-                            float&       rmsTrunc,
-                            int&         numBins) const;
-
-    // Truncated rms calculation
-    void getTruncatedRMS(VectorFloat& rawWaveform,
-                         float&       pedestal,
-                         float&       truncRms) const;
-    
-private:
-
-};
-
-} // end of namespace caldata
-
-#endif
+#ifndef WAVEFORMPARAMSALG_H
+#define WAVEFORMPARAMSALG_H
+////////////////////////////////////////////////////////////////////////
+//
+// Class:       WaveformParamsAlg
+// Module Type: producer
+// File:        WaveformParamsAlg.h
+//
+//              The intent of this module is to provide methods for
+//              characterizing an input RawDigit waveform
+//
+// Configuration parameters:
+//
+// TruncMeanFraction     - the fraction of waveform bins to discard when
+//                         computing the means and rms
+// RMSRejectionCutHi     - vector of maximum allowed rms values to keep channel
+// RMSRejectionCutLow    - vector of lowest allowed rms values to keep channel
+// RMSSelectionCut       - vector of rms values below which to not correct
+// MaxPedestalDiff       - Baseline difference to pedestal to flag
+//
+// Created by Tracy Usher (usher@slac.stanford.edu) on January 6, 2016
+// Based on work done by Brian Kirby, Mike Mooney and Jyoti Joshi
+//
+////////////////////////////////////////////////////////////////////////
+#include "lardataobj/RawData/RawDigit.h"
+#include "Span.h"
+#include "Array2D.h"
+
+#include <vector>
+
+namespace icarussigproc
+{
+class WaveformParamsAlg
+{
+public:
+
+    // Copnstructors, destructor.
+    WaveformParamsAlg();
+    ~WaveformParamsAlg();
+
+    // Provide definitions of the raw waveforms for internal use
+      using VectorFloat = std::vector<float>;
+      using ArrayFloat  = std::vector<VectorFloat>;
+    
+    // Results of the fused histogram kernel
+    struct PedestalStats
+    {
+        float pedestal;      // mean of the bins around the most probable value
+        float rms;           // rms about the pedestal, all samples
+        float truncRms;      // rms of the samples within 2.5 rms of the pedestal
+        int   numBins;       // number of samples used for the pedestal
+        int   numTruncBins;  // number of samples kept for the truncated rms
+    };
+    
+    // Per channel results of the batch interfaces, as parallel arrays
+    struct PedestalArrays
+    {
+        std::vector<float> pedestal;
+        std::vector<float> rms;
+        std::vector<float> truncRms;
+        std::vector<int>   numBins;  // samples kept for the truncated rms
+    };
+    
+    // Reusable histogram storage for the fused kernel
+    struct PedestalScratch
+    {
+        std::vector<int>    counts;
+        std::vector<double> sums;
+        std::vector<double> sumSqs;
+        std::vector<char>   straddles;
+    };
+    
+    // Basic waveform mean and rms
+    void getMeanAndRms(VectorFloat& rawWaveform,
+                       float&       aveVal,
+                       float&       rmsVal,
+                       int&         numBins) const;
+    
+    // Basic waveform mean and rms plus trunated rms
+    void getMeanAndTruncRms(VectorFloat& rawWaveform,
+                            float&       aveVal,
+                            float&       rmsVal,
+                            float&       rmsTrunc,
+                            int&         numBins) const;
+
+    // Non-destructive versions over a view of the samples: the input is
+    // never modified and nothing is allocated once scratch has grown to the
+    // ADC range. A non-empty pedSubtracted must have the waveform length and
+    // receives the pedestal subtracted samples; it may alias the input.
+    void getMeanAndRms(Span<const float> rawWaveform,
+                       float&            aveVal,
+                       float&            rmsVal,
+                       int&              numBins,
+                       PedestalScratch&  scratch) const;
+    
+    void getMeanAndRms(Span<const short> rawWaveform,
+                       float&            aveVal,
+                       float&            rmsVal,
+                       int&              numBins,
+                       PedestalScratch&  scratch) const;
+    
+    void getMeanAndTruncRms(Span<const float> rawWaveform,
+                            float&            aveVal,
+                            float&            rmsVal,
+                            float&            rmsTrunc,
+                            int&              numBins,
+                            PedestalScratch&  scratch,
+                            Span<float>       pedSubtracted = Span<float>()) const;
+    
+    void getMeanAndTruncRms(Span<const short> rawWaveform,
+                            float&            aveVal,
+                            float&            rmsVal,
+                            float&            rmsTrunc,
+                            int&              numBins,
+                            PedestalScratch&  scratch,
+                            Span<float>       pedSubtracted = Span<float>()) const;
+
+    // Truncated rms calculation
+    void getTruncatedRMS(VectorFloat& rawWaveform,
+                         float&       pedestal,
+                         float&       truncRms) const;
+
+    // Truncated rms by selection, scratch is resized to the waveform length
+    void getTruncatedRMS(Span<const float> rawWaveform,
+                         float             pedestal,
+                         float&            truncRms,
+                         VectorFloat&      scratch) const;
+
+    // Truncated rms of integer ADC values from a histogram of the values,
+    // histogram is resized to the ADC range
+    void getTruncatedRMS(Span<const short> rawWaveform,
+                         float             pedestal,
+                         float&            truncRms,
+                         std::vector<int>& histogram) const;
+    
+    // Batch pedestal, rms and truncated rms of numChannels dense rows of
+    // nTicks samples, spread over numThreads workers (0 = all cores)
+    void getMeanAndTruncRms(const float*    waveforms,
+                            size_t          numChannels,
+                            size_t          nTicks,
+                            PedestalArrays& results,
+                            unsigned int    numThreads = 0) const;
+    
+    void getMeanAndTruncRms(const short*    waveforms,
+                            size_t          numChannels,
+                            size_t          nTicks,
+                            PedestalArrays& results,
+                            unsigned int    numThreads = 0) const;
+    
+    // Same over the rows of a view, whatever their stride (padded Array2D)
+    void getMeanAndTruncRms(Array2DView<const float> waveforms,
+                            PedestalArrays&          results,
+                            unsigned int             numThreads = 0) const;
+    
+    void getMeanAndTruncRms(Array2DView<const short> waveforms,
+                            PedestalArrays&          results,
+                            unsigned int             numThreads = 0) const;
+    
+    // Batch over RawDigits, compressed ADC vectors are uncompressed into
+    // per worker buffers
+    void getMeanAndTruncRms(const std::vector<raw::RawDigit>& rawDigits,
+                            PedestalArrays&                   results,
+                            unsigned int                      numThreads = 0) const;
+    
+private:
+
+    // Common body of the span interfaces
+    template <typename T>
+    void getMeanAndTruncRms(Span<const T>    rawWaveform,
+                            PedestalStats&   stats,
+                            PedestalScratch& scratch,
+                            Span<float>      pedSubtracted) const;
+    
+    // Batch driver: getWaveform(channel, worker) returns the samples of a
+    // channel as a (pointer, size) pair
+    template <typename T, typename WaveformGetter>
+    void getMeanAndTruncRms(size_t          numChannels,
+                            WaveformGetter  getWaveform,
+                            PedestalArrays& results,
+                            unsigned int    numThreads) const;
+    
+    // Single histogram pass giving all the pedestal statistics
+    template <typename T>
+    void getPedestalStats(const T*         waveform,
+                          size_t           nTicks,
+                          PedestalStats&   stats,
+                          PedestalScratch& scratch) const;
+};
+
+} // end of namespace caldata
+
+#endif
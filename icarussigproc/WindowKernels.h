@@ -0,0 +1,132 @@
+/**
+ * \file WindowKernels.h
+ *
+ * \ingroup icarussigproc
+ *
+ * \brief Sliding window kernels specialized at compile time for the
+ *        registered window sizes
+ *
+ */
+
+/** \addtogroup icarussigproc
+
+    @{*/
+#ifndef __SIGPROC_TOOLS_WINDOWKERNELS_H__
+#define __SIGPROC_TOOLS_WINDOWKERNELS_H__
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace icarussigproc {
+
+  /// Compile-time list of half window sizes (structuring element / 2)
+  template <int... Sizes> struct SizeList {};
+
+  /// Tick direction of Morph1D and Morph2D: structuring elements of 7, 11
+  /// and 21 (or 20) ticks
+  using TickHalfWindows = SizeList<3, 5, 10>;
+
+  /// Channel direction of Morph2D: 3, 5 and 7 channels
+  using ChannelHalfWindows = SizeList<1, 2, 3>;
+
+  /// Both directions of the AdaptiveWiener filters: 3, 5 and 7 samples
+  using FilterHalfWindows = SizeList<1, 2, 3>;
+
+  /// Calls func(std::integral_constant<int, Size>()) for the registered Size
+  /// equal to size. Returns false, without calling func, for other sizes so
+  /// that the caller can take its generic path.
+  template <typename Func>
+  inline bool dispatchSize(SizeList<>, const int, Func&&)
+  {
+    return false;
+  }
+
+  template <int Size, int... Sizes, typename Func>
+  inline bool dispatchSize(SizeList<Size, Sizes...>, const int size, Func&& func)
+  {
+    if (size != Size) {
+      return dispatchSize(SizeList<Sizes...>(), size, std::forward<Func>(func));
+    }
+    func(std::integral_constant<int, Size>());
+    return true;
+  }
+
+  /// dispatchSize for a pair of sizes, calling func(sizeX, sizeY) only when
+  /// both are registered
+  template <typename ListX, typename ListY, typename Func>
+  inline bool dispatchSizes(ListX, ListY, const int sizeX, const int sizeY,
+    Func&& func)
+  {
+    bool found = false;
+    dispatchSize(ListX(), sizeX, [&](auto x) {
+      found = dispatchSize(ListY(), sizeY, [&](auto y) { func(x, y); });
+    });
+    return found;
+  }
+
+  template <int First, typename Func, int... K>
+  inline void unrollRangeImpl(Func& func, std::integer_sequence<int, K...>)
+  {
+    (func(std::integral_constant<int, First + K>()), ...);
+    return;
+  }
+
+  /// Calls func(std::integral_constant<int, K>()) for K = First..Last in
+  /// order, as straight-line code
+  template <int First, int Last, typename Func>
+  inline void unrollRange(Func&& func)
+  {
+    static_assert(First <= Last, "unrollRange: empty range");
+    unrollRangeImpl<First>(func,
+      std::make_integer_sequence<int, Last - First + 1>());
+    return;
+  }
+
+  /**
+     Minimum and maximum of the window in[i + Lo] .. in[i + Hi], clipped to
+     [0, n), for every i in [0, numOut), passed on as store(i, min, max).
+     Windows inside the input run the unrolled loop, only the -Lo leading
+     and Hi trailing positions take the clipped one. Lo <= 0 <= Hi, so that
+     no window is empty.
+  */
+  template <int Lo, int Hi, typename T, typename Store>
+  inline void slidingMinMax(const T* in, const size_t n, const size_t numOut,
+    Store&& store)
+  {
+    static_assert(Lo <= 0 && Hi >= 0, "slidingMinMax: window misses center");
+    auto clipped = [&](const size_t i) {
+      size_t lower = i < size_t(-Lo) ? 0 : i + Lo;
+      size_t upper = std::min(i + Hi, n - 1);
+      T minVal = in[lower];
+      T maxVal = in[lower];
+      for (size_t k=lower+1; k<=upper; ++k) {
+        minVal = std::min(minVal, in[k]);
+        maxVal = std::max(maxVal, in[k]);
+      }
+      store(i, minVal, maxVal);
+    };
+    size_t interiorBegin = std::min(size_t(-Lo), numOut);
+    size_t interiorEnd = n > size_t(Hi) ? std::min(n - Hi, numOut) : 0;
+    interiorEnd = std::max(interiorBegin, interiorEnd);
+    for (size_t i=0; i<interiorBegin; ++i) clipped(i);
+    for (size_t i=interiorBegin; i<interiorEnd; ++i) {
+      const T* window = in + i + Lo;
+      T minVal = window[0];
+      T maxVal = window[0];
+      if constexpr (Hi > Lo) {
+        unrollRange<1, Hi - Lo>([&](auto k) {
+          minVal = std::min(minVal, window[k]);
+          maxVal = std::max(maxVal, window[k]);
+        });
+      }
+      store(i, minVal, maxVal);
+    }
+    for (size_t i=interiorEnd; i<numOut; ++i) clipped(i);
+    return;
+  }
+}
+
+#endif
+/** @} */ // end of doxygen group
@@ -0,0 +1,696 @@
+/**
+ * \file KernelEquivalence_test.cxx
+ *
+ * \ingroup icarussigproc
+ *
+ * \brief Randomized comparison of the library kernels with the references
+ *
+ * Usage: KernelEquivalence_test [--iterations N] [--seed S]
+ *
+ * Each iteration draws a plane (shape, values, ties) and kernel parameters
+ * (structuring elements and windows from 0/2 up to beyond the plane, even
+ * sizes, groupings that do not divide the channel count) and runs the
+ * Morph1D, Morph2D, AdaptiveWiener and Denoising kernels of the library on
+ * nested vectors and Array2D, comparing every output with
+ * ReferenceKernels.h. A short plane with full scale samples checks the
+ * integer saturation rules, and one synthetic event is checked. The
+ * maximum deviation of each kernel and type is reported; the test fails when
+ * it exceeds the tolerance: none for order statistics and masks, float
+ * rounding for arithmetic kernels (and for the double 2D morphology, whose
+ * extrema pass through float).
+ */
+
+#include "ReferenceKernels.h"
+#include "SyntheticEvent.h"
+
+#include "icarussigproc/Array2D.h"
+#include "icarussigproc/Morph1D.h"
+#include "icarussigproc/Morph2D.h"
+#include "icarussigproc/AdaptiveWiener.h"
+#include "icarussigproc/Denoising.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <map>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using namespace icarussigproc;
+
+namespace {
+
+  template <class T> using Nested = std::vector<std::vector<T>>;
+
+  template <typename T> struct TypeName;
+  template <> struct TypeName<short>  { static constexpr const char* value = "short"; };
+  template <> struct TypeName<float>  { static constexpr const char* value = "float"; };
+  template <> struct TypeName<double> { static constexpr const char* value = "double"; };
+
+  /// Maximum deviation and worst case of each kernel
+  class Report{
+
+    public:
+
+      /// kind: 'o' order statistic (exact), 'a' arithmetic, 'm' mask
+      template <typename T>
+      void compare(
+        const std::string& kernel,
+        const char kind,
+        const Nested<T>& output,
+        const Nested<T>& reference,
+        const double scale,
+        const std::string& parameters)
+      {
+        std::string name = kernel + "<" + TypeName<T>::value + ">";
+        Entry& entry = getEntry(name);
+        double tolerance = getTolerance<T>(kind, scale);
+        double deviation = 0.;
+        if (output.size() != reference.size()) {
+          deviation = std::numeric_limits<double>::infinity();
+        }
+        for (size_t i=0; i<output.size() && i<reference.size(); ++i) {
+          if (output[i].size() != reference[i].size()) {
+            deviation = std::numeric_limits<double>::infinity();
+            break;
+          }
+          for (size_t j=0; j<output[i].size(); ++j) {
+            double diff = std::fabs(double(output[i][j]) - double(reference[i][j]));
+            if (!(diff <= deviation)) deviation = diff;
+          }
+        }
+        update(entry, deviation, tolerance, parameters);
+        return;
+      }
+
+      template <typename T>
+      void compare(
+        const std::string& kernel,
+        const char kind,
+        const std::vector<T>& output,
+        const std::vector<T>& reference,
+        const double scale,
+        const std::string& parameters)
+      {
+        compare(kernel, kind, Nested<T>(1, output), Nested<T>(1, reference),
+          scale, parameters);
+        return;
+      }
+
+      void compareMask(
+        const std::string& kernel,
+        const Nested<bool>& output,
+        const Nested<bool>& reference,
+        const std::string& parameters)
+      {
+        Entry& entry = getEntry(kernel);
+        double mismatches = output.size() == reference.size() ? 0. :
+          std::numeric_limits<double>::infinity();
+        for (size_t i=0; i<output.size() && i<reference.size(); ++i) {
+          if (output[i].size() != reference[i].size()) {
+            mismatches = std::numeric_limits<double>::infinity();
+            break;
+          }
+          for (size_t j=0; j<output[i].size(); ++j) {
+            if (output[i][j] != reference[i][j]) mismatches += 1.;
+          }
+        }
+        update(entry, mismatches, 0., parameters);
+        return;
+      }
+
+      /// Prints the table, returns the number of failing kernels
+      int print() const
+      {
+        int numFailed = 0;
+        std::printf("%-48s %8s %12s %12s  %s\n", "# kernel", "cases",
+          "max dev", "tolerance", "worst case");
+        for (const auto& name : fNames) {
+          const Entry& entry = fEntries.at(name);
+          std::printf("%-48s %8zu %12.4g %12.4g  %s%s\n", name.c_str(),
+            entry.cases, entry.deviation, entry.tolerance,
+            entry.worstCase.c_str(), entry.failed ? "  FAILED" : "");
+          if (entry.failed) ++numFailed;
+        }
+        return numFailed;
+      }
+
+    private:
+
+      struct Entry {
+        size_t      cases = 0;
+        double      deviation = 0.;
+        double      tolerance = 0.;
+        bool        failed = false;
+        std::string worstCase;
+      };
+
+      template <typename T>
+      static double getTolerance(const char kind, const double scale)
+      {
+        if (kind == 'o') return std::is_same<T, double>::value ?
+          1e-6 * (1. + scale) : 0.;
+        return std::is_integral<T>::value ? 1. : 1e-4 * (1. + scale);
+      }
+
+      Entry& getEntry(const std::string& name)
+      {
+        if (fEntries.find(name) == fEntries.end()) fNames.push_back(name);
+        return fEntries[name];
+      }
+
+      void update(Entry& entry, const double deviation, const double tolerance,
+        const std::string& parameters)
+      {
+        ++entry.cases;
+        bool failed = !(deviation <= tolerance);
+        if (entry.cases == 1 || deviation > entry.deviation ||
+          (failed && !entry.failed)) {
+          entry.deviation = deviation;
+          entry.tolerance = tolerance;
+          entry.worstCase = parameters;
+        }
+        entry.failed = entry.failed || failed;
+        return;
+      }
+
+      std::vector<std::string>     fNames;
+      std::map<std::string, Entry> fEntries;
+  };
+
+  template <typename T>
+  Nested<T> toNested(const Array2D<T>& array)
+  {
+    Nested<T> nested;
+    toNestedVector(array, nested);
+    return nested;
+  }
+
+  template <typename T>
+  Array2D<T> toArray(const Nested<T>& nested)
+  {
+    Array2D<T> array;
+    toArray2D(nested, array);
+    return array;
+  }
+
+  template <typename T>
+  double getScale(const Nested<T>& plane)
+  {
+    double scale = 0.;
+    for (const auto& row : plane) {
+      for (const auto& val : row) scale = std::max(scale, std::fabs(double(val)));
+    }
+    return scale;
+  }
+
+  std::string describe(const size_t numChannels, const size_t nTicks,
+    const std::string& parameters)
+  {
+    return std::to_string(numChannels) + "x" + std::to_string(nTicks) + " " +
+      parameters;
+  }
+
+  /// Parameters and planes of an iteration
+  class Generator{
+
+    public:
+
+      explicit Generator(const unsigned int seed) : fEngine(seed) {}
+
+      /// Uniform integer in [low, high]
+      int uniform(const int low, const int high)
+      {
+        return low + int(fEngine() % (unsigned int)(high - low + 1));
+      }
+
+      double uniform() { return double(fEngine()) / 4294967296.; }
+
+      /// Noise of rms about noiseRms, sparse pulses, and for quantized planes
+      /// integer values so that windows have ties
+      template <typename T>
+      Nested<T> getPlane(const size_t numChannels, const size_t nTicks,
+        const float noiseRms, const bool quantized)
+      {
+        Nested<T> plane(numChannels, std::vector<T>(nTicks));
+        for (auto& row : plane) {
+          for (auto& val : row) {
+            double sum = 0.;
+            for (int k=0; k<12; ++k) sum += uniform();
+            double value = noiseRms * (sum - 6.);
+            if (uniform() < 0.02) value += 10. * noiseRms * uniform();
+            val = quantized || std::is_integral<T>::value ?
+              T(std::lround(value)) : T(value);
+          }
+        }
+        return plane;
+      }
+
+      /// Structuring element along the ticks, small or beyond the waveform,
+      /// often one of the sizes registered in WindowKernels.h
+      unsigned int getTickSize(const size_t nTicks, const unsigned int minSize)
+      {
+        const unsigned int registered[] = {3, 5, 7, 11, 20, 21};
+        switch (uniform(0, 5)) {
+          case 0:  return nTicks + uniform(0, 3);
+          case 1:  return std::max(2 * nTicks, size_t(minSize));
+          case 2:  return registered[uniform(0, 5)];
+          default: return uniform(minSize, 25);
+        }
+      }
+
+      /// Sets about fraction of the samples to the extremes of T, for the
+      /// saturation rules of integer samples
+      template <typename T>
+      void addExtremes(Nested<T>& plane, const double fraction)
+      {
+        for (auto& row : plane) {
+          for (auto& val : row) {
+            if (uniform() >= fraction) continue;
+            val = uniform(0, 1) == 0 ? std::numeric_limits<T>::lowest() :
+              std::numeric_limits<T>::max();
+          }
+        }
+        return;
+      }
+
+      unsigned int getChannelSize(const size_t numChannels)
+      {
+        return uniform(0, 4) == 0 ? numChannels + uniform(1, 3) : uniform(2, 9);
+      }
+
+    private:
+
+      std::mt19937 fEngine;
+  };
+
+  template <typename T>
+  void checkMorph1D(Report& report, Generator& generator, const Nested<T>& plane)
+  {
+    using Op = void (Morph1D::*)(const std::vector<T>&, const unsigned int,
+      std::vector<T>&) const;
+    const std::vector<std::pair<char, Op>> ops = {
+      {'d', &Morph1D::getDilation}, {'e', &Morph1D::getErosion},
+      {'g', &Morph1D::getGradient}, {'a', &Morph1D::getAverage},
+      {'m', &Morph1D::getMedian}};
+    const std::map<char, std::string> names = {
+      {'d', "Morph1D::getDilation"}, {'e', "Morph1D::getErosion"},
+      {'g', "Morph1D::getGradient"}, {'a', "Morph1D::getAverage"},
+      {'m', "Morph1D::getMedian"}};
+
+    size_t nTicks = plane.empty() ? 0 : plane[0].size();
+    unsigned int se = generator.getTickSize(nTicks, 0);
+    std::string parameters = describe(plane.size(), nTicks,
+      "se=" + std::to_string(se));
+    double scale = getScale(plane);
+
+    const Morph1D morph;
+    std::vector<T> output, output2, reference, reference2;
+    for (const auto& op : ops) {
+      for (const auto& waveform : plane) {
+        (morph.*op.second)(waveform, se, output);
+        reference::morph1D(waveform, se, op.first, reference);
+        report.compare(names.at(op.first), 'o', output, reference, scale,
+          parameters);
+      }
+    }
+    for (const auto& waveform : plane) {
+      morph.getOpeningAndClosing(waveform, se, output, output2);
+      reference::openingAndClosing1D(waveform, se, reference, reference2);
+      report.compare("Morph1D::getOpeningAndClosing", 'o', output, reference,
+        scale, parameters);
+      report.compare("Morph1D::getOpeningAndClosing", 'o', output2,
+        reference2, scale, parameters);
+    }
+    return;
+  }
+
+  template <typename T>
+  void checkMorph2D(Report& report, Generator& generator, const Nested<T>& plane)
+  {
+    size_t numChannels = plane.size();
+    size_t nTicks = plane.empty() ? 0 : plane[0].size();
+    unsigned int sx = generator.getChannelSize(numChannels);
+    unsigned int sy = generator.getTickSize(nTicks, 2);
+    std::string parameters = describe(numChannels, nTicks,
+      std::to_string(sx) + "x" + std::to_string(sy));
+    double scale = getScale(plane);
+    Array2D<T> array = toArray(plane);
+
+    const Morph2D morph;
+    std::map<char, Nested<T>> references;
+    for (char op : {'d', 'e', 'g', 'a', 'm'}) {
+      reference::morph2D(plane, sx, sy, op, references[op]);
+    }
+
+    Nested<T> dilation, erosion, average, gradient, median;
+    Array2D<T> dilationArray, erosionArray, averageArray, gradientArray;
+    morph.getFilter2D(plane, sx, sy, dilation, erosion, average, gradient);
+    morph.getFilter2D(array, sx, sy, dilationArray, erosionArray,
+      averageArray, gradientArray);
+    for (const Nested<T>& output : {dilation, toNested(dilationArray)}) {
+      report.compare("Morph2D::getFilter2D", 'o', output, references['d'],
+        scale, parameters);
+    }
+    for (const Nested<T>& output : {erosion, toNested(erosionArray)}) {
+      report.compare("Morph2D::getFilter2D", 'o', output, references['e'],
+        scale, parameters);
+    }
+    for (const Nested<T>& output : {average, toNested(averageArray)}) {
+      report.compare("Morph2D::getFilter2D", 'o', output, references['a'],
+        scale, parameters);
+    }
+    for (const Nested<T>& output : {gradient, toNested(gradientArray)}) {
+      report.compare("Morph2D::getFilter2D", 'o', output, references['g'],
+        scale, parameters);
+    }
+
+    Array2D<T> outputArray, outputArray2;
+    morph.getDilation(plane, sx, sy, dilation);
+    morph.getDilation(array, sx, sy, outputArray);
+    report.compare("Morph2D::getDilation", 'o', dilation, references['d'],
+      scale, parameters);
+    report.compare("Morph2D::getDilation", 'o', toNested(outputArray),
+      references['d'], scale, parameters);
+    morph.getErosion(plane, sx, sy, erosion);
+    morph.getErosion(array, sx, sy, outputArray);
+    report.compare("Morph2D::getErosion", 'o', erosion, references['e'],
+      scale, parameters);
+    report.compare("Morph2D::getErosion", 'o', toNested(outputArray),
+      references['e'], scale, parameters);
+    morph.getGradient(plane, sx, sy, gradient);
+    morph.getGradient(array, sx, sy, outputArray);
+    report.compare("Morph2D::getGradient", 'o', gradient, references['g'],
+      scale, parameters);
+    report.compare("Morph2D::getGradient", 'o', toNested(outputArray),
+      references['g'], scale, parameters);
+    morph.getMedian(plane, sx, sy, median);
+    morph.getMedian(array, sx, sy, outputArray);
+    report.compare("Morph2D::getMedian", 'o', median, references['m'],
+      scale, parameters);
+    report.compare("Morph2D::getMedian", 'o', toNested(outputArray),
+      references['m'], scale, parameters);
+
+    Nested<T> opening, closing, referenceOpening, referenceClosing;
+    reference::openingAndClosing2D(plane, sx, sy, referenceOpening,
+      referenceClosing);
+    morph.getOpeningAndClosing(plane, sx, sy, opening, closing);
+    morph.getOpeningAndClosing(array, sx, sy, outputArray, outputArray2);
+    report.compare("Morph2D::getOpeningAndClosing", 'o', opening,
+      referenceOpening, scale, parameters);
+    report.compare("Morph2D::getOpeningAndClosing", 'o', closing,
+      referenceClosing, scale, parameters);
+    report.compare("Morph2D::getOpeningAndClosing", 'o', toNested(outputArray),
+      referenceOpening, scale, parameters);
+    report.compare("Morph2D::getOpeningAndClosing", 'o', toNested(outputArray2),
+      referenceClosing, scale, parameters);
+    return;
+  }
+
+  template <typename T>
+  void checkAdaptiveWiener(Report& report, Generator& generator,
+    const Nested<T>& plane, const Nested<bool>& selectVals)
+  {
+    size_t numChannels = plane.size();
+    size_t nTicks = plane.empty() ? 0 : plane[0].size();
+    unsigned int sx = generator.getChannelSize(numChannels);
+    unsigned int sy = generator.getTickSize(nTicks, 2);
+    float noiseVar = 1. + 20. * generator.uniform();
+    float a = 0.5 + generator.uniform();
+    float epsilon = 1. + 3. * generator.uniform();
+    unsigned int K = generator.uniform(0, 8);
+    float sigmaFactor = 0.5 + generator.uniform();
+    std::string parameters = describe(numChannels, nTicks,
+      std::to_string(sx) + "x" + std::to_string(sy) + " noiseVar=" +
+      std::to_string(noiseVar));
+    double scale = getScale(plane);
+    Array2D<T> array = toArray(plane);
+    Array2D<bool> selectArray = toArray(selectVals);
+
+    sigproc_tools::AdaptiveWiener wiener;
+    Nested<T> output, referenceOutput;
+    Array2D<T> outputArray;
+
+    reference::filterLee(referenceOutput, plane, noiseVar, sx, sy);
+    wiener.filterLee(output, plane, noiseVar, sx, sy);
+    wiener.filterLee(outputArray, array, noiseVar, sx, sy);
+    report.compare("AdaptiveWiener::filterLee", 'a', output, referenceOutput,
+      scale, parameters);
+    report.compare("AdaptiveWiener::filterLee", 'a', toNested(outputArray),
+      referenceOutput, scale, parameters);
+
+    reference::MMWF(referenceOutput, plane, noiseVar, sx, sy);
+    wiener.MMWF(output, plane, noiseVar, sx, sy);
+    wiener.MMWF(outputArray, array, noiseVar, sx, sy);
+    report.compare("AdaptiveWiener::MMWF", 'a', output, referenceOutput,
+      scale, parameters);
+    report.compare("AdaptiveWiener::MMWF", 'a', toNested(outputArray),
+      referenceOutput, scale, parameters);
+
+    reference::MMWFStar(referenceOutput, plane, sx, sy);
+    wiener.MMWFStar(output, plane, sx, sy);
+    wiener.MMWFStar(outputArray, array, sx, sy);
+    report.compare("AdaptiveWiener::MMWFStar", 'a', output, referenceOutput,
+      scale, parameters);
+    report.compare("AdaptiveWiener::MMWFStar", 'a', toNested(outputArray),
+      referenceOutput, scale, parameters);
+
+    reference::filterLeeEnhanced(referenceOutput, plane, noiseVar, sx, sy, a,
+      epsilon);
+    wiener.filterLeeEnhanced(output, plane, noiseVar, sx, sy, a, epsilon);
+    wiener.filterLeeEnhanced(outputArray, array, noiseVar, sx, sy, a, epsilon);
+    report.compare("AdaptiveWiener::filterLeeEnhanced", 'a', output,
+      referenceOutput, scale, parameters);
+    report.compare("AdaptiveWiener::filterLeeEnhanced", 'a',
+      toNested(outputArray), referenceOutput, scale, parameters);
+
+    reference::adaptiveROIWiener(referenceOutput, plane, selectVals, noiseVar,
+      sx, sy, a, epsilon);
+    wiener.adaptiveROIWiener(output, plane, selectVals, noiseVar, sx, sy, a,
+      epsilon);
+    wiener.adaptiveROIWiener(outputArray, array, selectArray, noiseVar, sx, sy,
+      a, epsilon);
+    report.compare("AdaptiveWiener::adaptiveROIWiener", 'a', output,
+      referenceOutput, scale, parameters);
+    report.compare("AdaptiveWiener::adaptiveROIWiener", 'a',
+      toNested(outputArray), referenceOutput, scale, parameters);
+
+    reference::sigmaFilter(referenceOutput, plane, noiseVar, sx, sy, K,
+      sigmaFactor);
+    wiener.sigmaFilter(output, plane, noiseVar, sx, sy, K, sigmaFactor);
+    wiener.sigmaFilter(outputArray, array, noiseVar, sx, sy, K, sigmaFactor);
+    report.compare("AdaptiveWiener::sigmaFilter", 'a', output,
+      referenceOutput, scale, parameters);
+    report.compare("AdaptiveWiener::sigmaFilter", 'a', toNested(outputArray),
+      referenceOutput, scale, parameters);
+    return;
+  }
+
+  template <typename T>
+  void compareDenoising(Report& report, const std::string& kernel,
+    const reference::DenoisingResult<T>& output,
+    const reference::DenoisingResult<T>& referenceResult,
+    const double scale, const std::string& parameters)
+  {
+    report.compare(kernel + " waveLessCoherent", 'o', output.waveLessCoherent,
+      referenceResult.waveLessCoherent, scale, parameters);
+    report.compare(kernel + " morphed", 'o', output.morphed,
+      referenceResult.morphed, scale, parameters);
+    report.compare(kernel + " intrinsicRMS", 'a', output.intrinsicRMS,
+      referenceResult.intrinsicRMS, scale, parameters);
+    report.compare(kernel + " correctedMedians", 'o', output.correctedMedians,
+      referenceResult.correctedMedians, scale, parameters);
+    std::string type = std::string("<") + TypeName<T>::value + ">";
+    report.compareMask(kernel + type + " selectVals", output.selectVals,
+      referenceResult.selectVals, parameters);
+    report.compareMask(kernel + type + " roi", output.roi, referenceResult.roi,
+      parameters);
+    return;
+  }
+
+  template <typename T>
+  void checkDenoising(Report& report, Generator& generator,
+    const Nested<T>& plane)
+  {
+    size_t numChannels = plane.size();
+    size_t nTicks = plane.empty() ? 0 : plane[0].size();
+    const char filterNames[] = {'d', 'e', 'a', 'g', 'x'};
+    char filterName = filterNames[generator.uniform(0, 4)];
+    unsigned int grouping = generator.uniform(0, 3) == 0 ?
+      numChannels + generator.uniform(0, 5) : generator.uniform(1, 40);
+    unsigned int window = generator.uniform(0, 6);
+    float thresholdFactor = 1.5 + 2. * generator.uniform();
+    double scale = getScale(plane);
+    Array2D<T> array = toArray(plane);
+
+    Denoising denoising;
+    reference::DenoisingResult<T> output, referenceResult;
+    Array2D<T> waveLessCoherent, morphed, intrinsicRMS, correctedMedians;
+    Array2D<bool> selectVals, roi;
+    auto fromArrays = [&]() {
+      output.waveLessCoherent = toNested(waveLessCoherent);
+      output.morphed = toNested(morphed);
+      output.intrinsicRMS = toNested(intrinsicRMS);
+      output.selectVals = toNested(selectVals);
+      output.roi = toNested(roi);
+      output.correctedMedians = toNested(correctedMedians);
+    };
+
+    unsigned int se = generator.getTickSize(nTicks, 0);
+    std::string parameters = describe(numChannels, nTicks,
+      std::string(1, filterName) + " grouping=" + std::to_string(grouping) +
+      " se=" + std::to_string(se) + " window=" + std::to_string(window));
+    reference::removeCoherentNoise(plane, false, filterName, grouping, 0, se,
+      window, thresholdFactor, referenceResult);
+    denoising.removeCoherentNoise1D(output.waveLessCoherent, plane,
+      output.morphed, output.intrinsicRMS, output.selectVals, output.roi,
+      output.correctedMedians, filterName, grouping, se, window,
+      thresholdFactor);
+    compareDenoising(report, "Denoising::removeCoherentNoise1D", output,
+      referenceResult, scale, parameters);
+    denoising.removeCoherentNoise1D(waveLessCoherent, array, morphed,
+      intrinsicRMS, selectVals, roi, correctedMedians, filterName, grouping,
+      se, window, thresholdFactor);
+    fromArrays();
+    compareDenoising(report, "Denoising::removeCoherentNoise1D", output,
+      referenceResult, scale, parameters);
+
+    unsigned int sx = generator.getChannelSize(numChannels);
+    unsigned int sy = generator.getTickSize(nTicks, 2);
+    parameters = describe(numChannels, nTicks,
+      std::string(1, filterName) + " grouping=" + std::to_string(grouping) +
+      " " + std::to_string(sx) + "x" + std::to_string(sy) + " window=" +
+      std::to_string(window));
+    reference::removeCoherentNoise(plane, true, filterName, grouping, sx, sy,
+      window, thresholdFactor, referenceResult);
+    output = reference::DenoisingResult<T>();
+    denoising.removeCoherentNoise2D(output.waveLessCoherent, plane,
+      output.morphed, output.intrinsicRMS, output.selectVals, output.roi,
+      output.correctedMedians, filterName, grouping, sx, sy, window,
+      thresholdFactor);
+    compareDenoising(report, "Denoising::removeCoherentNoise2D", output,
+      referenceResult, scale, parameters);
+    selectVals = Array2D<bool>();
+    roi = Array2D<bool>();
+    denoising.removeCoherentNoise2D(waveLessCoherent, array, morphed,
+      intrinsicRMS, selectVals, roi, correctedMedians, filterName, grouping,
+      sx, sy, window, thresholdFactor);
+    fromArrays();
+    compareDenoising(report, "Denoising::removeCoherentNoise2D", output,
+      referenceResult, scale, parameters);
+    return;
+  }
+
+  template <typename T>
+  void checkPlane(Report& report, Generator& generator, const Nested<T>& plane,
+    const Nested<bool>& selectVals)
+  {
+    checkMorph1D(report, generator, plane);
+    checkMorph2D(report, generator, plane);
+    checkAdaptiveWiener(report, generator, plane, selectVals);
+    checkDenoising(report, generator, plane);
+    return;
+  }
+
+  template <typename T>
+  void checkRandom(Report& report, Generator& generator)
+  {
+    size_t numChannels = generator.uniform(1, 70);
+    size_t nTicks = generator.uniform(1, 4) == 1 ?
+      generator.uniform(1, 12) : generator.uniform(13, 200);
+    float noiseRms = 0.5 + 5. * generator.uniform();
+    Nested<T> plane = generator.getPlane<T>(numChannels, nTicks, noiseRms,
+      generator.uniform(0, 1) == 0);
+    Nested<bool> selectVals(numChannels, std::vector<bool>(nTicks));
+    for (auto& row : selectVals) {
+      for (size_t j=0; j<nTicks; ++j) row[j] = generator.uniform() < 0.1;
+    }
+    checkPlane(report, generator, plane, selectVals);
+    return;
+  }
+
+  /// Full scale samples, for the kernels with integer saturation rules; the
+  /// AdaptiveWiener filters have none and are left out
+  template <typename T>
+  void checkSaturated(Report& report, Generator& generator)
+  {
+    size_t numChannels = generator.uniform(1, 40);
+    size_t nTicks = generator.uniform(1, 120);
+    Nested<T> plane = generator.getPlane<T>(numChannels, nTicks, 100., true);
+    generator.addExtremes(plane, 0.05);
+    checkMorph1D(report, generator, plane);
+    checkMorph2D(report, generator, plane);
+    checkDenoising(report, generator, plane);
+    return;
+  }
+
+  template <typename T>
+  void checkEvent(Report& report, Generator& generator,
+    const SyntheticEvent& event)
+  {
+    Array2D<T> array;
+    event.getWaveforms(array);
+    for (size_t i=0; i<array.numRows(); ++i) {
+      T pedestal = T(event.getPedestals()[i]);
+      for (size_t j=0; j<array.numCols(); ++j) array[i][j] -= pedestal;
+    }
+    checkPlane(report, generator, toNested(array),
+      toNested(event.getSignalMask()));
+    return;
+  }
+
+  bool parseOptions(int argc, char** argv, unsigned int& iterations,
+    unsigned int& seed)
+  {
+    for (int i=1; i+1<argc; i+=2) {
+      std::string key = argv[i];
+      char* end = nullptr;
+      unsigned long value = std::strtoul(argv[i+1], &end, 10);
+      if (*end != '\0') return false;
+      if (key == "--iterations") iterations = value;
+      else if (key == "--seed") seed = value;
+      else return false;
+    }
+    return argc % 2 == 1;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  unsigned int iterations = 10;
+  unsigned int seed = 12345;
+  if (!parseOptions(argc, argv, iterations, seed)) {
+    std::fprintf(stderr, "Usage: %s [--iterations N] [--seed S]\n", argv[0]);
+    return 1;
+  }
+
+  Report report;
+  Generator generator(seed);
+  for (unsigned int iteration=0; iteration<iterations; ++iteration) {
+    checkRandom<short>(report, generator);
+    checkRandom<float>(report, generator);
+    checkRandom<double>(report, generator);
+    checkSaturated<short>(report, generator);
+  }
+
+  SyntheticEvent::Config config;
+  config.numChannels = 48;
+  config.nTicks = 256;
+  config.grouping = 16;
+  config.numTracks = 4;
+  SyntheticEvent event(config);
+  checkEvent<short>(report, generator, event);
+  checkEvent<float>(report, generator, event);
+  checkEvent<double>(report, generator, event);
+
+  std::printf("# %u iterations, seed %u\n", iterations, seed);
+  int numFailed = report.print();
+  if (numFailed > 0) {
+    std::printf("%d kernels differ from the references\n", numFailed);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,116 @@
+/**
+ * \file NoiseSpectrum_test.cxx
+ *
+ * \ingroup icarussigproc
+ *
+ * \brief Noise spectra of planes without signal free stretches
+ *
+ * Usage: NoiseSpectrum_test
+ *
+ * A group whose channels are all masked by selectVals must get the plane
+ * average spectrum, and a fully masked plane the white noise floor, so that
+ * Deconvolution::Wiener1D with the noise spectra stays finite. Array2D
+ * input must give the same spectra as nested vectors.
+ */
+
+#include "icarussigproc/NoiseSpectrum.h"
+#include "icarussigproc/Deconvolution.h"
+#include "icarussigproc/Array2D.h"
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace icarussigproc;
+
+namespace {
+
+  const size_t       kNumChannels = 32;
+  const size_t       kNumTicks = 512;
+  const unsigned int kGrouping = 16;
+
+  std::vector<std::vector<float>> getWaveforms()
+  {
+    std::vector<std::vector<float>> waveforms(kNumChannels,
+      std::vector<float>(kNumTicks));
+    unsigned int state = 12345;
+    for (auto& waveform : waveforms) {
+      for (auto& sample : waveform) {
+        state = state * 1103515245 + 12345;
+        sample = float((state >> 16) & 0x7fff) / 0x7fff - 0.5;
+      }
+    }
+    return waveforms;
+  }
+
+  bool isFinite(const std::vector<std::vector<float>>& array)
+  {
+    for (const auto& row : array) {
+      for (auto value : row) if (!std::isfinite(value)) return false;
+    }
+    return true;
+  }
+
+  /// Spectra and deconvolution of a plane whose first maskedGroups groups
+  /// are masked
+  bool checkMasked(const size_t maskedGroups)
+  {
+    std::vector<std::vector<float>> waveforms = getWaveforms();
+    std::vector<std::vector<bool>> selectVals(kNumChannels,
+      std::vector<bool>(kNumTicks, false));
+    for (size_t i=0; i<maskedGroups * kGrouping; ++i) {
+      selectVals[i].assign(kNumTicks, true);
+    }
+
+    const float noiseFloor = 2.;
+    NoiseSpectrum noiseSpectrum;
+    noiseSpectrum.setNoiseFloor(noiseFloor);
+    FFTPlanCache planCache;
+    std::vector<std::vector<float>> noisePSD;
+    noiseSpectrum.getNoisePSD(waveforms, selectVals, planCache, noisePSD,
+      kGrouping, 128);
+
+    Array2D<float> waveformArray;
+    Array2D<bool> selectArray;
+    toArray2D(waveforms, waveformArray);
+    toArray2D(selectVals, selectArray);
+    std::vector<std::vector<float>> arrayPSD;
+    noiseSpectrum.getNoisePSD(Array2DView<const float>(waveformArray),
+      Array2DView<const bool>(selectArray), planCache, arrayPSD, kGrouping,
+      128);
+
+    bool ok = noisePSD.size() == kNumChannels / kGrouping &&
+      arrayPSD == noisePSD;
+    size_t nGroups = noisePSD.size();
+    for (size_t g=0; ok && g<nGroups; ++g) {
+      for (auto value : noisePSD[g]) ok = ok && value > 0.;
+    }
+    if (ok && maskedGroups == nGroups) {
+      for (auto value : noisePSD[0]) ok = ok && value == kNumTicks * noiseFloor;
+    } else if (ok && maskedGroups > 0) {
+      ok = noisePSD[0] == noisePSD[nGroups - 1];
+    }
+
+    std::vector<float> response(kNumTicks, 0.);
+    for (size_t j=0; j<40; ++j) {
+      double t = j / 4.;
+      response[j] = t * t * std::exp(-t);
+    }
+    sigproc_tools::Deconvolution deconvolution;
+    std::vector<std::vector<float>> deconvolved;
+    deconvolution.Wiener1D(deconvolved, waveforms, response, noisePSD,
+      kGrouping);
+    return ok && isFinite(deconvolved);
+  }
+}
+
+int main()
+{
+  bool groupOk = checkMasked(1);
+  bool planeOk = checkMasked(kNumChannels / kGrouping);
+  std::printf("%-40s %s\n", "masked group gets plane average",
+    groupOk ? "ok" : "FAILED");
+  std::printf("%-40s %s\n", "masked plane gets noise floor",
+    planeOk ? "ok" : "FAILED");
+  return groupOk && planeOk ? 0 : 1;
+}
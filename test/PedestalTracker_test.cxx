@@ -0,0 +1,89 @@
+/**
+ * \file PedestalTracker_test.cxx
+ *
+ * \ingroup icarussigproc
+ *
+ * \brief Recomputation of tracked pedestals after steps of pedestal and noise
+ *
+ * Usage: PedestalTracker_test
+ *
+ * One channel goes through phases of gaussian noise around a pedestal,
+ * each changing either the noise rms (up by 2, down to a fraction of an
+ * ADC count) or the pedestal (by half the rms). The first event of every
+ * phase must recompute the pedestal from the full histogram, the other
+ * events must take the cheap path, and from the first event on the tracked
+ * pedestal and rms must be those of the phase. Float and (rounded) short
+ * samples.
+ */
+
+#include "icarussigproc/PedestalTracker.h"
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+using namespace icarussigproc;
+
+namespace {
+
+  const size_t       kNumTicks = 4096;
+  const unsigned int kEventsPerPhase = 20;
+
+  struct Phase {
+    double pedestal;
+    double rms;
+  };
+
+  const Phase kPhases[] = {
+    {100.,  3. },
+    {100.,  6. },   // noise up
+    {100.,  0.4},   // noise down, below the one count window floor
+    {100.2, 0.4},   // pedestal step of half the rms
+    {100.,  3. },
+    {101.5, 3. }    // pedestal step of half the rms
+  };
+
+  /// Number of events that did not behave as expected
+  template <typename T>
+  unsigned int checkPhases()
+  {
+    PedestalTracker tracker;
+    std::mt19937 engine(2024);
+    std::vector<T> waveform(kNumTicks);
+    unsigned int numFailures = 0;
+    for (const auto& phase : kPhases) {
+      std::normal_distribution<double> noise(phase.pedestal, phase.rms);
+      // Rounding to integers adds the variance of a uniform distribution
+      bool isInteger = std::is_integral<T>::value;
+      double rms = std::sqrt(
+        phase.rms * phase.rms + (isInteger ? 1. / 12. : 0.));
+      for (unsigned int event=0; event<kEventsPerPhase; ++event) {
+        for (auto& sample : waveform) {
+          double value = noise(engine);
+          sample = isInteger ? T(std::lround(value)) : T(value);
+        }
+        float pedestal, trackedRms;
+        bool recomputed = tracker.update(0,
+          Span<const T>(waveform.data(), waveform.size()), pedestal,
+          trackedRms);
+        if (recomputed != (event == 0) ||
+            std::abs(pedestal - phase.pedestal) > 0.1 * rms ||
+            std::abs(trackedRms - rms) > 0.1 * rms) {
+          ++numFailures;
+        }
+      }
+    }
+    return numFailures;
+  }
+}
+
+int main()
+{
+  unsigned int floatFailures = checkPhases<float>();
+  unsigned int shortFailures = checkPhases<short>();
+  std::printf("%-40s %8u\n", "float events off", floatFailures);
+  std::printf("%-40s %8u\n", "short events off", shortFailures);
+  return floatFailures + shortFailures > 0 ? 1 : 0;
+}
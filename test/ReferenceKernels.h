@@ -0,0 +1,548 @@
+/**
+ * \file ReferenceKernels.h
+ *
+ * \ingroup icarussigproc
+ *
+ * \brief Naive reference versions of the Morph1D, Morph2D, AdaptiveWiener
+ *        and Denoising kernels
+ *
+ */
+
+/** \addtogroup icarussigproc
+
+    @{*/
+#ifndef __SIGPROC_TOOLS_REFERENCEKERNELS_H__
+#define __SIGPROC_TOOLS_REFERENCEKERNELS_H__
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+/**
+   Straight from the definitions, one output sample at a time, on nested
+   vectors. These define the results every faster implementation of the
+   library kernels must reproduce (see KernelEquivalence_test.cxx), so they
+   are kept as simple as possible and never optimized.
+
+   Boundary conventions, as used by the physics results:
+     - 1D (structuring element se, h = se/2): the window of tick i is
+       [i-h, i+h] clipped to the waveform, and the last h ticks hold the
+       value of tick n-1-h (the first tick whose window reaches the end).
+       The median has no hold.
+     - 2D (sx x sy, hx = sx/2, hy = sy/2): the window of (i, j) is
+       [i-hx, i+hx) x [j-hy, j+hy) clipped to the plane, i.e. sx or sx-1
+       channels; sizes below 2 give empty windows and are not defined.
+     - Denoising: a trailing partial group of channels is its own group.
+     - Medians of an even count average the two middle values, in double.
+     - Integer samples: differences (gradients, coherent noise subtraction)
+       saturate to the range of the type, averages truncate toward zero.
+*/
+namespace icarussigproc {
+namespace reference {
+
+  template <class T> using Array2DRef = std::vector<std::vector<T>>;
+
+  template <typename T>
+  T getMedian(std::vector<T> values);
+
+  // 1D, operation 'd' dilation, 'e' erosion, 'g' gradient, 'a' average,
+  // 'm' median
+  template <typename T>
+  void morph1D(const std::vector<T>& waveform, const unsigned int se,
+    const char operation, std::vector<T>& output);
+
+  template <typename T>
+  void openingAndClosing1D(const std::vector<T>& waveform,
+    const unsigned int se, std::vector<T>& opening, std::vector<T>& closing);
+
+  // 2D, same operations
+  template <typename T>
+  void morph2D(const Array2DRef<T>& waveforms, const unsigned int sx,
+    const unsigned int sy, const char operation, Array2DRef<T>& output);
+
+  template <typename T>
+  void openingAndClosing2D(const Array2DRef<T>& waveforms,
+    const unsigned int sx, const unsigned int sy, Array2DRef<T>& opening,
+    Array2DRef<T>& closing);
+
+  // AdaptiveWiener
+  template <typename T>
+  void filterLee(Array2DRef<T>& output, const Array2DRef<T>& input,
+    const float noiseVar, const unsigned int sx, const unsigned int sy);
+
+  template <typename T>
+  void MMWF(Array2DRef<T>& output, const Array2DRef<T>& input,
+    const float noiseVar, const unsigned int sx, const unsigned int sy);
+
+  template <typename T>
+  void MMWFStar(Array2DRef<T>& output, const Array2DRef<T>& input,
+    const unsigned int sx, const unsigned int sy);
+
+  template <typename T>
+  void filterLeeEnhanced(Array2DRef<T>& output, const Array2DRef<T>& input,
+    const float noiseVar, const unsigned int sx, const unsigned int sy,
+    const float a, const float epsilon);
+
+  template <typename T>
+  void adaptiveROIWiener(Array2DRef<T>& output, const Array2DRef<T>& input,
+    const Array2DRef<bool>& selectVals, const float noiseVar,
+    const unsigned int sx, const unsigned int sy, const float a,
+    const float epsilon);
+
+  template <typename T>
+  void sigmaFilter(Array2DRef<T>& output, const Array2DRef<T>& input,
+    const float noiseVar, const unsigned int sx, const unsigned int sy,
+    const unsigned int K, const float sigmaFactor);
+
+  // Denoising; is2D selects the Morph2D (sx x sy) or Morph1D (sy) filter
+  template <typename T>
+  struct DenoisingResult {
+    Array2DRef<T>    waveLessCoherent;
+    Array2DRef<T>    morphed;
+    Array2DRef<T>    intrinsicRMS;
+    Array2DRef<bool> selectVals;
+    Array2DRef<bool> roi;
+    Array2DRef<T>    correctedMedians;
+  };
+
+  template <typename T>
+  void removeCoherentNoise(const Array2DRef<T>& waveforms, const bool is2D,
+    const char filterName, const unsigned int grouping,
+    const unsigned int sx, const unsigned int sy, const unsigned int window,
+    const float thresholdFactor, DenoisingResult<T>& result);
+
+  // a - b in the sample type, saturated for integer samples
+  template <typename T>
+  inline T getDifference(const T a, const T b)
+  {
+    if constexpr (std::is_integral<T>::value) {
+      double value = double(a) - double(b);
+      value = std::min(value, double(std::numeric_limits<T>::max()));
+      value = std::max(value, double(std::numeric_limits<T>::lowest()));
+      return T(value);
+    }
+    return T(a - b);
+  }
+
+  // Window bounds of the 2D kernels, see above
+  inline void getBounds(const size_t center, const size_t size,
+    const unsigned int s, size_t& lower, size_t& upper)
+  {
+    int half = s / 2;
+    lower = std::max(int(center) - half, 0);
+    upper = std::min(int(center) + half, int(size));
+    return;
+  }
+}
+}
+
+template <typename T>
+T icarussigproc::reference::getMedian(std::vector<T> values)
+{
+  size_t n = values.size();
+  if (n == 0) return T(0);
+  std::sort(values.begin(), values.end());
+  if (n % 2 != 0) return values[n / 2];
+  return (values[n / 2 - 1] + values[n / 2]) / 2.0;
+}
+
+template <typename T>
+void icarussigproc::reference::morph1D(
+  const std::vector<T>& waveform,
+  const unsigned int se,
+  const char operation,
+  std::vector<T>& output)
+{
+  size_t n = waveform.size();
+  size_t half = se / 2;
+  output.resize(n);
+  // Last tick whose window is complete on the right
+  size_t last = n > half ? n - 1 - half : 0;
+  for (size_t i=0; i<n; ++i) {
+    size_t center = operation == 'm' ? i : std::min(i, last);
+    size_t lower = center > half ? center - half : 0;
+    size_t upper = std::min(n - 1, center + half);
+    std::vector<T> window(waveform.begin() + lower,
+      waveform.begin() + upper + 1);
+    T maxVal = *std::max_element(window.begin(), window.end());
+    T minVal = *std::min_element(window.begin(), window.end());
+    switch (operation) {
+      case 'd': output[i] = maxVal; break;
+      case 'e': output[i] = minVal; break;
+      case 'g': output[i] = getDifference(maxVal, minVal); break;
+      case 'a': output[i] = 0.5 * (maxVal + minVal); break;
+      default:  output[i] = getMedian(window); break;
+    }
+  }
+  return;
+}
+
+template <typename T>
+void icarussigproc::reference::openingAndClosing1D(
+  const std::vector<T>& waveform,
+  const unsigned int se,
+  std::vector<T>& opening,
+  std::vector<T>& closing)
+{
+  std::vector<T> dilation, erosion;
+  morph1D(waveform, se, 'd', dilation);
+  morph1D(waveform, se, 'e', erosion);
+  morph1D(erosion, se, 'd', opening);
+  morph1D(dilation, se, 'e', closing);
+  return;
+}
+
+template <typename T>
+void icarussigproc::reference::morph2D(
+  const Array2DRef<T>& waveforms,
+  const unsigned int sx,
+  const unsigned int sy,
+  const char operation,
+  Array2DRef<T>& output)
+{
+  size_t numChannels = waveforms.size();
+  size_t nTicks = numChannels > 0 ? waveforms[0].size() : 0;
+  output.assign(numChannels, std::vector<T>(nTicks));
+  for (size_t i=0; i<numChannels; ++i) {
+    for (size_t j=0; j<nTicks; ++j) {
+      size_t lowerx, upperx, lowery, uppery;
+      getBounds(i, numChannels, sx, lowerx, upperx);
+      getBounds(j, nTicks, sy, lowery, uppery);
+      std::vector<T> window;
+      for (size_t ix=lowerx; ix<upperx; ++ix) {
+        for (size_t iy=lowery; iy<uppery; ++iy) window.push_back(waveforms[ix][iy]);
+      }
+      if (operation == 'm') {
+        output[i][j] = getMedian(window);
+        continue;
+      }
+      T maxVal = *std::max_element(window.begin(), window.end());
+      T minVal = *std::min_element(window.begin(), window.end());
+      switch (operation) {
+        case 'd': output[i][j] = maxVal; break;
+        case 'e': output[i][j] = minVal; break;
+        case 'g': output[i][j] = getDifference(maxVal, minVal); break;
+        default:  output[i][j] = 0.5 * (maxVal + minVal); break;
+      }
+    }
+  }
+  return;
+}
+
+template <typename T>
+void icarussigproc::reference::openingAndClosing2D(
+  const Array2DRef<T>& waveforms,
+  const unsigned int sx,
+  const unsigned int sy,
+  Array2DRef<T>& opening,
+  Array2DRef<T>& closing)
+{
+  Array2DRef<T> dilation, erosion;
+  morph2D(waveforms, sx, sy, 'd', dilation);
+  morph2D(waveforms, sx, sy, 'e', erosion);
+  morph2D(erosion, sx, sy, 'd', opening);
+  morph2D(dilation, sx, sy, 'e', closing);
+  return;
+}
+
+// The AdaptiveWiener references keep the arithmetic of the original
+// implementation step by step (accumulation in double, locals of type T,
+// weights in float), including the squares stored as T.
+
+template <typename T>
+void icarussigproc::reference::filterLee(
+  Array2DRef<T>& output,
+  const Array2DRef<T>& input,
+  const float noiseVar,
+  const unsigned int sx,
+  const unsigned int sy)
+{
+  size_t numChannels = input.size();
+  size_t nTicks = numChannels > 0 ? input[0].size() : 0;
+  output.assign(numChannels, std::vector<T>(nTicks));
+  for (size_t i=0; i<numChannels; ++i) {
+    for (size_t j=0; j<nTicks; ++j) {
+      size_t lowerx, upperx, lowery, uppery;
+      getBounds(i, numChannels, sx, lowerx, upperx);
+      getBounds(j, nTicks, sy, lowery, uppery);
+      std::vector<T> x, xsq;
+      for (size_t ix=lowerx; ix<upperx; ++ix) {
+        for (size_t iy=lowery; iy<uppery; ++iy) {
+          x.push_back(input[ix][iy]);
+          xsq.push_back(input[ix][iy] * input[ix][iy]);
+        }
+      }
+      T localMean = std::accumulate(x.begin(), x.end(), 0.0) / x.size();
+      T localSquare = std::accumulate(xsq.begin(), xsq.end(), 0.0) / x.size();
+      T localVar = localSquare - localMean * localMean;
+      if (noiseVar > localVar) output[i][j] = localMean;
+      else output[i][j] = localMean + (1 - noiseVar / localVar) *
+        (input[i][j] - localMean);
+    }
+  }
+  return;
+}
+
+template <typename T>
+void icarussigproc::reference::MMWF(
+  Array2DRef<T>& output,
+  const Array2DRef<T>& input,
+  const float noiseVar,
+  const unsigned int sx,
+  const unsigned int sy)
+{
+  size_t numChannels = input.size();
+  size_t nTicks = numChannels > 0 ? input[0].size() : 0;
+  output.assign(numChannels, std::vector<T>(nTicks));
+  for (size_t i=0; i<numChannels; ++i) {
+    for (size_t j=0; j<nTicks; ++j) {
+      size_t lowerx, upperx, lowery, uppery;
+      getBounds(i, numChannels, sx, lowerx, upperx);
+      getBounds(j, nTicks, sy, lowery, uppery);
+      std::vector<T> x, xsq;
+      for (size_t ix=lowerx; ix<upperx; ++ix) {
+        for (size_t iy=lowery; iy<uppery; ++iy) {
+          x.push_back(input[ix][iy]);
+          xsq.push_back(input[ix][iy] * input[ix][iy]);
+        }
+      }
+      T localMean = std::accumulate(x.begin(), x.end(), 0.0) / x.size();
+      T localSquare = std::accumulate(xsq.begin(), xsq.end(), 0.0) / x.size();
+      T localVar = localSquare - localMean * localMean;
+      T localMedian = getMedian(x);
+      if (noiseVar > localVar) output[i][j] = localMedian;
+      else output[i][j] = localMedian + (1 - noiseVar / localVar) *
+        (input[i][j] - localMedian);
+    }
+  }
+  return;
+}
+
+template <typename T>
+void icarussigproc::reference::MMWFStar(
+  Array2DRef<T>& output,
+  const Array2DRef<T>& input,
+  const unsigned int sx,
+  const unsigned int sy)
+{
+  size_t numChannels = input.size();
+  size_t nTicks = numChannels > 0 ? input[0].size() : 0;
+  output.assign(numChannels, std::vector<T>(nTicks));
+  Array2DRef<T> localMedians(numChannels, std::vector<T>(nTicks));
+  Array2DRef<T> localVars(numChannels, std::vector<T>(nTicks));
+  std::vector<T> allVars;
+  for (size_t i=0; i<numChannels; ++i) {
+    for (size_t j=0; j<nTicks; ++j) {
+      size_t lowerx, upperx, lowery, uppery;
+      getBounds(i, numChannels, sx, lowerx, upperx);
+      getBounds(j, nTicks, sy, lowery, uppery);
+      std::vector<T> x, xsq;
+      for (size_t ix=lowerx; ix<upperx; ++ix) {
+        for (size_t iy=lowery; iy<uppery; ++iy) {
+          x.push_back(input[ix][iy]);
+          xsq.push_back(input[ix][iy] * input[ix][iy]);
+        }
+      }
+      T localMean = std::accumulate(x.begin(), x.end(), 0.0) / x.size();
+      T localSquare = std::accumulate(xsq.begin(), xsq.end(), 0.0) / x.size();
+      T localMedian = getMedian(x);
+      T localVar = localSquare - 2.0 * localMean * localMedian +
+        std::pow(localMean, 2.0);
+      localMedians[i][j] = localMedian;
+      localVars[i][j] = localVar;
+      allVars.push_back(localVar);
+    }
+  }
+  // Noise variance of the plane: median of the local variances
+  float noiseMedian = getMedian(allVars);
+  for (size_t i=0; i<numChannels; ++i) {
+    for (size_t j=0; j<nTicks; ++j) {
+      if (noiseMedian > localVars[i][j]) output[i][j] = localMedians[i][j];
+      else output[i][j] = localMedians[i][j] +
+        (1.0 - noiseMedian / localVars[i][j]) *
+        (input[i][j] - localMedians[i][j]);
+    }
+  }
+  return;
+}
+
+template <typename T>
+void icarussigproc::reference::filterLeeEnhanced(
+  Array2DRef<T>& output,
+  const Array2DRef<T>& input,
+  const float noiseVar,
+  const unsigned int sx,
+  const unsigned int sy,
+  const float a,
+  const float epsilon)
+{
+  Array2DRef<bool> noSelection(input.size(),
+    std::vector<bool>(input.empty() ? 0 : input[0].size(), false));
+  adaptiveROIWiener(output, input, noSelection, noiseVar, sx, sy, a, epsilon);
+  return;
+}
+
+template <typename T>
+void icarussigproc::reference::adaptiveROIWiener(
+  Array2DRef<T>& output,
+  const Array2DRef<T>& input,
+  const Array2DRef<bool>& selectVals,
+  const float noiseVar,
+  const unsigned int sx,
+  const unsigned int sy,
+  const float a,
+  const float epsilon)
+{
+  size_t numChannels = input.size();
+  size_t nTicks = numChannels > 0 ? input[0].size() : 0;
+  output.assign(numChannels, std::vector<T>(nTicks));
+  float eps = std::pow(epsilon * std::sqrt(noiseVar), 2);
+  for (size_t i=0; i<numChannels; ++i) {
+    for (size_t j=0; j<nTicks; ++j) {
+      size_t lowerx, upperx, lowery, uppery;
+      getBounds(i, numChannels, sx, lowerx, upperx);
+      getBounds(j, nTicks, sy, lowery, uppery);
+      std::vector<T> x, xsq;
+      std::vector<float> weight;
+      for (size_t ix=lowerx; ix<upperx; ++ix) {
+        for (size_t iy=lowery; iy<uppery; ++iy) {
+          float fsq = std::pow(input[i][j] - input[ix][iy], 2.0);
+          x.push_back(input[ix][iy]);
+          xsq.push_back(input[ix][iy] * input[ix][iy]);
+          weight.push_back(1.0 / (1.0 + a * std::max(eps, fsq)));
+        }
+      }
+      float normWeight = std::accumulate(weight.begin(), weight.end(), 0.0);
+      for (auto& w : weight) w = w / normWeight;
+      T localMean = std::inner_product(
+        x.begin(), x.end(), weight.begin(), 0.0) / x.size();
+      T localSquare = std::inner_product(
+        xsq.begin(), xsq.end(), weight.begin(), 0.0) / x.size();
+      T localVar = localSquare - localMean * localMean;
+      if (noiseVar > localVar) output[i][j] = localMean;
+      else if (selectVals[i][j]) output[i][j] = input[i][j];
+      else output[i][j] = localMean + (1 - noiseVar / localVar) *
+        (input[i][j] - localMean);
+    }
+  }
+  return;
+}
+
+template <typename T>
+void icarussigproc::reference::sigmaFilter(
+  Array2DRef<T>& output,
+  const Array2DRef<T>& input,
+  const float noiseVar,
+  const unsigned int sx,
+  const unsigned int sy,
+  const unsigned int K,
+  const float sigmaFactor)
+{
+  size_t numChannels = input.size();
+  size_t nTicks = numChannels > 0 ? input[0].size() : 0;
+  output.assign(numChannels, std::vector<T>(nTicks));
+  for (size_t i=0; i<numChannels; ++i) {
+    for (size_t j=0; j<nTicks; ++j) {
+      size_t lowerx, upperx, lowery, uppery;
+      getBounds(i, numChannels, sx, lowerx, upperx);
+      getBounds(j, nTicks, sy, lowery, uppery);
+      std::vector<T> x;
+      for (size_t ix=lowerx; ix<upperx; ++ix) {
+        for (size_t iy=lowery; iy<uppery; ++iy) {
+          if (std::abs(input[ix][iy]) < sigmaFactor * noiseVar) {
+            x.push_back(input[ix][iy]);
+          }
+        }
+      }
+      T localMean = std::accumulate(x.begin(), x.end(), 0.0) / x.size();
+      output[i][j] = x.size() > K ? localMean : input[i][j];
+    }
+  }
+  return;
+}
+
+template <typename T>
+void icarussigproc::reference::removeCoherentNoise(
+  const Array2DRef<T>& waveforms,
+  const bool is2D,
+  const char filterName,
+  const unsigned int grouping,
+  const unsigned int sx,
+  const unsigned int sy,
+  const unsigned int window,
+  const float thresholdFactor,
+  DenoisingResult<T>& result)
+{
+  size_t numChannels = waveforms.size();
+  size_t nTicks = numChannels > 0 ? waveforms[0].size() : 0;
+  size_t nGroups = (numChannels + grouping - 1) / grouping;
+
+  // Morphological filter, 2D falling back to the gradient, 1D to dilation
+  char operation = filterName;
+  if (filterName != 'd' && filterName != 'e' && filterName != 'a' &&
+    filterName != 'g') operation = is2D ? 'g' : 'd';
+  if (is2D) {
+    morph2D(waveforms, sx, sy, operation, result.morphed);
+  }
+  else {
+    result.morphed.resize(numChannels);
+    for (size_t i=0; i<numChannels; ++i) {
+      morph1D(waveforms[i], sy, operation, result.morphed[i]);
+    }
+  }
+
+  // Selection: morphed samples beyond thresholdFactor times their rms
+  // about the channel median, protected with window ticks on each side
+  result.selectVals.assign(numChannels, std::vector<bool>(nTicks, false));
+  result.roi.assign(numChannels, std::vector<bool>(nTicks, false));
+  for (size_t i=0; i<numChannels; ++i) {
+    const std::vector<T>& morphed = result.morphed[i];
+    T median = getMedian(morphed);
+    double sumSq = 0.;
+    for (size_t j=0; j<nTicks; ++j) {
+      T diff = morphed[j] - median;
+      sumSq += diff * diff;
+    }
+    float rms = std::sqrt(sumSq / float(nTicks));
+    float threshold = thresholdFactor * rms;
+    for (size_t j=0; j<nTicks; ++j) {
+      if (std::fabs(morphed[j]) <= threshold) continue;
+      result.selectVals[i][j] = true;
+      size_t lower = j > window ? j - window : 0;
+      size_t upper = std::min(j + window + 1, nTicks);
+      for (size_t k=lower; k<upper; ++k) result.roi[i][k] = true;
+    }
+  }
+
+  // Median of the unselected samples of each group and tick
+  result.waveLessCoherent.assign(numChannels, std::vector<T>(nTicks));
+  result.correctedMedians.assign(nGroups, std::vector<T>(nTicks));
+  result.intrinsicRMS.assign(nGroups, std::vector<T>(nTicks));
+  for (size_t g=0; g<nGroups; ++g) {
+    size_t begin = g * grouping;
+    size_t end = std::min(begin + grouping, numChannels);
+    for (size_t j=0; j<nTicks; ++j) {
+      std::vector<T> unselected;
+      for (size_t c=begin; c<end; ++c) {
+        if (!result.selectVals[c][j]) unselected.push_back(waveforms[c][j]);
+      }
+      T median = getMedian(unselected);
+      result.correctedMedians[g][j] = median;
+      double sumSq = 0.;
+      for (size_t c=begin; c<end; ++c) {
+        T value = result.selectVals[c][j] ? waveforms[c][j] :
+          getDifference(waveforms[c][j], median);
+        result.waveLessCoherent[c][j] = value;
+        sumSq += value * value;
+      }
+      result.intrinsicRMS[g][j] = std::sqrt(sumSq / T(end - begin));
+    }
+  }
+  return;
+}
+
+#endif
+/** @} */ // end of doxygen group
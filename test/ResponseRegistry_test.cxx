@@ -0,0 +1,143 @@
+/**
+ * \file ResponseRegistry_test.cxx
+ *
+ * \ingroup icarussigproc
+ *
+ * \brief Ownership and cache consistency of the ResponseRegistry
+ *
+ * Usage: ResponseRegistry_test
+ *
+ * A filter spectrum obtained before setResponse replaces its plane's
+ * response must stay intact and keep describing the old response, while
+ * the next lookup builds the spectrum of the new one. Spectra read from a
+ * cache file written with another response must not replace those of the
+ * registered response. Deconvolution with a memoized spectrum must match,
+ * up to rounding, Wiener1D with the response function and same noiseVar.
+ */
+
+#include "icarussigproc/ResponseRegistry.h"
+#include "icarussigproc/Deconvolution.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace icarussigproc;
+
+namespace {
+
+  const size_t kNumTicks = 256;
+  const float  kNoiseVar = 0.5;
+  const std::string kCacheFile = "ResponseRegistry_test.cache";
+
+  std::vector<double> getResponse(const double tau)
+  {
+    std::vector<double> response(kNumTicks, 0.);
+    for (size_t j=0; j<64; ++j) {
+      double t = j / tau;
+      response[j] = t * t * std::exp(-t);
+    }
+    return response;
+  }
+
+  // The power is left out: a cache stores the response only
+  bool isEqual(const FilterSpectrum& a, const FilterSpectrum& b)
+  {
+    return a.nTicks == b.nTicks && a.responseHash == b.responseHash &&
+      a.response == b.response;
+  }
+
+  bool checkReplacedResponse()
+  {
+    ResponseRegistry registry;
+    registry.setResponse(2, getResponse(4.), {});
+    auto oldFilter = registry.getFilter(2, kNumTicks);
+    FilterSpectrum oldCopy = *oldFilter;
+
+    registry.setResponse(2, getResponse(8.), {});
+    auto newFilter = registry.getFilter(2, kNumTicks);
+
+    ResponseRegistry reference;
+    reference.setResponse(2, getResponse(8.), {});
+    return isEqual(*oldFilter, oldCopy) && !isEqual(*newFilter, oldCopy) &&
+      isEqual(*newFilter, *reference.getFilter(2, kNumTicks));
+  }
+
+  bool checkStaleCache()
+  {
+    ResponseRegistry writer;
+    writer.setResponse(2, getResponse(4.), {});
+    auto cached = writer.getFilter(2, kNumTicks);
+    if (!writer.writeCache(kCacheFile)) return false;
+
+    // Registered before and after reading the stale cache
+    ResponseRegistry before;
+    before.setResponse(2, getResponse(8.), {});
+    bool beforeRead = before.readCache(kCacheFile);
+    ResponseRegistry after;
+    bool afterRead = after.readCache(kCacheFile);
+    bool cacheUsed = isEqual(*after.getFilter(2, kNumTicks), *cached);
+    after.setResponse(2, getResponse(8.), {});
+
+    ResponseRegistry reference;
+    reference.setResponse(2, getResponse(8.), {});
+    auto expected = reference.getFilter(2, kNumTicks);
+    std::remove(kCacheFile.c_str());
+    return beforeRead && afterRead && cacheUsed &&
+      isEqual(*before.getFilter(2, kNumTicks), *expected) &&
+      isEqual(*after.getFilter(2, kNumTicks), *expected);
+  }
+
+  /// Largest difference between the two Wiener1D versions, relative to the
+  /// largest output sample
+  template <typename T>
+  double getWienerDeviation()
+  {
+    std::vector<double> field = getResponse(4.);
+    ResponseRegistry registry;
+    registry.setResponse(2, field, {});
+    auto filterSpectrum = registry.getFilter(2, kNumTicks);
+
+    std::vector<std::vector<T>> waveforms(8, std::vector<T>(kNumTicks));
+    for (size_t i=0; i<waveforms.size(); ++i) {
+      for (size_t j=0; j<kNumTicks; ++j) {
+        waveforms[i][j] = std::sin(0.05 * (i + 1) * j) + (j % 37 == i ? 5. : 0.);
+      }
+    }
+
+    sigproc_tools::Deconvolution deconvolution;
+    std::vector<std::vector<T>> memoized, direct;
+    deconvolution.Wiener1D(memoized, waveforms, *filterSpectrum, kNoiseVar);
+    deconvolution.Wiener1D(direct, waveforms,
+      std::vector<T>(field.begin(), field.end()), kNoiseVar);
+
+    double maxValue = 0.;
+    double maxDiff = 0.;
+    for (size_t i=0; i<waveforms.size(); ++i) {
+      for (size_t j=0; j<kNumTicks; ++j) {
+        maxValue = std::max(maxValue, double(std::fabs(direct[i][j])));
+        maxDiff = std::max(maxDiff, double(std::fabs(memoized[i][j] - direct[i][j])));
+      }
+    }
+    return maxDiff / maxValue;
+  }
+}
+
+int main()
+{
+  bool replacedOk = checkReplacedResponse();
+  bool staleCacheOk = checkStaleCache();
+  double floatDeviation = getWienerDeviation<float>();
+  double doubleDeviation = getWienerDeviation<double>();
+  bool wienerOk = floatDeviation < 1e-4 && doubleDeviation < 1e-10;
+  std::printf("%-40s %s\n", "response replaced while held",
+    replacedOk ? "ok" : "FAILED");
+  std::printf("%-40s %s\n", "stale cache entries rebuilt",
+    staleCacheOk ? "ok" : "FAILED");
+  std::printf("%-40s %s (float %.2g, double %.2g)\n",
+    "memoized spectrum Wiener1D", wienerOk ? "ok" : "FAILED",
+    floatDeviation, doubleDeviation);
+  return replacedOk && staleCacheOk && wienerOk ? 0 : 1;
+}
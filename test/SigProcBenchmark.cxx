@@ -0,0 +1,725 @@
+/**
+ * \file SigProcBenchmark.cxx
+ *
+ * \ingroup icarussigproc
+ *
+ * \brief Timing of the public kernels on synthetic ICARUS-like events
+ *
+ * Usage: sigproc_benchmark [--channels N] [--ticks N] [--reps N]
+ *                          [--threads N] [--filter TEXT]
+ *                          [--layout nested|array|both]
+ *                          [--report FILE] [--trace FILE]
+ *
+ * Every kernel runs once to warm up (caches, FFT plans, scratch growth),
+ * then --reps timed times. Reported are the minimum and mean wall time, the
+ * minimum time per sample of the plane and the corresponding throughput,
+ * counting each plane read or written by the kernel once. --filter keeps
+ * the kernels whose name contains TEXT. --report writes the per phase
+ * counters of the run as JSON (see Instrumentation.h; empty unless built
+ * with ICARUSSIGPROC_INSTRUMENTATION). --trace writes the timeline of the
+ * run in the Chrome trace format (Trace.h, same build flag).
+ */
+
+#include "SyntheticEvent.h"
+
+#include "icarussigproc/Array2D.h"
+#include "icarussigproc/Morph1D.h"
+#include "icarussigproc/Morph2D.h"
+#include "icarussigproc/Denoising.h"
+#include "icarussigproc/AdaptiveWiener.h"
+#include "icarussigproc/Deconvolution.h"
+#include "icarussigproc/ResponseRegistry.h"
+#include "icarussigproc/HarmonicNoiseFilter.h"
+#include "icarussigproc/NoiseSpectrum.h"
+#include "icarussigproc/FFTPlanCache.h"
+#include "icarussigproc/MiscUtils.h"
+#include "icarussigproc/WaveformParamsAlg.h"
+#include "icarussigproc/PedestalTracker.h"
+#include "icarussigproc/RawDigitIngester.h"
+#include "icarussigproc/SignalProcessingPipeline.h"
+#include "icarussigproc/ParallelFor.h"
+#include "icarussigproc/Instrumentation.h"
+#include "icarussigproc/Trace.h"
+
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using namespace icarussigproc;
+
+namespace {
+
+  // Structuring element and window sizes of the configurations in use:
+  // along the ticks for the 1D kernels, channels x ticks for the 2D ones
+  const std::vector<unsigned int> kTickSizes = {5, 7, 11, 21};
+  const std::vector<unsigned int> kChannelSizes2D = {3, 5, 7};
+  const std::vector<unsigned int> kTickSizes2D = {7, 11, 21};
+  const std::vector<std::pair<unsigned int, unsigned int>> kWindows = {
+    {3, 3}, {3, 7}, {5, 11}, {7, 21}};
+  const std::vector<char> kFilterNames = {'d', 'e', 'a', 'g'};
+  const unsigned int kGrouping = 64;
+
+  struct Options {
+    size_t       numChannels = 576;
+    size_t       nTicks = 4096;
+    unsigned int reps = 3;
+    unsigned int numThreads = 0;
+    std::string  filter;
+    bool         nested = true;
+    bool         array = true;
+    std::string  report;
+    std::string  trace;
+  };
+
+  /// Runs, times and reports one kernel at a time
+  class Suite{
+
+    public:
+
+      explicit Suite(const Options& options) : fOptions(options) {}
+
+      /// kernel is timed, setup (e.g. restoring an in place input) is not;
+      /// bytesPerSample is the traffic of all planes per sample of the event
+      void run(
+        const std::string& name,
+        const double bytesPerSample,
+        const std::function<void()>& kernel,
+        const std::function<void()>& setup = std::function<void()>()) const
+      {
+        if (name.find(fOptions.filter) == std::string::npos) return;
+
+        if (setup) setup();
+        kernel();
+
+        double minTime = std::numeric_limits<double>::max();
+        double sumTime = 0.;
+        for (unsigned int rep=0; rep<fOptions.reps; ++rep) {
+          if (setup) setup();
+          auto start = std::chrono::steady_clock::now();
+          kernel();
+          std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+          minTime = std::min(minTime, elapsed.count());
+          sumTime += elapsed.count();
+        }
+
+        double numSamples = double(fOptions.numChannels) * fOptions.nTicks;
+        std::printf("%-56s %10.3f %10.3f %10.3f %8.3f\n", name.c_str(),
+          1e3 * minTime, 1e3 * sumTime / fOptions.reps,
+          1e9 * minTime / numSamples,
+          bytesPerSample * numSamples / minTime / 1e9);
+        std::fflush(stdout);
+        return;
+      }
+
+      const Options& getOptions() const { return fOptions; }
+
+    private:
+
+      Options fOptions;
+  };
+
+  template <typename T> struct TypeName;
+  template <> struct TypeName<short>  { static constexpr const char* value = "short"; };
+  template <> struct TypeName<float>  { static constexpr const char* value = "float"; };
+  template <> struct TypeName<double> { static constexpr const char* value = "double"; };
+
+  /// Argument and output types of the two layouts of the 2D interfaces
+  template <typename Array> struct Layout;
+
+  template <typename T> struct Layout<std::vector<std::vector<T>>> {
+    using In      = const std::vector<std::vector<T>>&;
+    using Mask    = std::vector<std::vector<bool>>;
+    using Spectra = std::vector<std::vector<std::complex<T>>>;
+    static constexpr const char* name = "nested";
+  };
+
+  template <typename T> struct Layout<Array2D<T>> {
+    using In      = const Array2DView<const T>;
+    using Mask    = Array2D<bool>;
+    using Spectra = Array2D<std::complex<T>>;
+    static constexpr const char* name = "array";
+  };
+
+  template <typename T>
+  void convertLayout(const Array2D<T>& in, std::vector<std::vector<T>>& out)
+  {
+    toNestedVector(in, out);
+    return;
+  }
+
+  template <typename T>
+  void convertLayout(const Array2D<T>& in, Array2D<T>& out)
+  {
+    out = in;
+    return;
+  }
+
+  void convertLayout(const Array2D<bool>& in, std::vector<std::vector<bool>>& out)
+  {
+    out.assign(in.numRows(), std::vector<bool>(in.numCols()));
+    for (size_t i=0; i<in.numRows(); ++i) {
+      for (size_t j=0; j<in.numCols(); ++j) out[i][j] = in[i][j];
+    }
+    return;
+  }
+
+  void convertLayout(const Array2D<bool>& in, Array2D<bool>& out)
+  {
+    out = in;
+    return;
+  }
+
+  /// Pedestal subtracted plane of the event (pedestals are whole counts)
+  template <typename T>
+  void getPlane(const SyntheticEvent& event, Array2D<T>& plane)
+  {
+    event.getWaveforms(plane);
+    const std::vector<float>& pedestals = event.getPedestals();
+    for (size_t i=0; i<plane.numRows(); ++i) {
+      T pedestal = T(pedestals[i]);
+      for (size_t j=0; j<plane.numCols(); ++j) plane[i][j] -= pedestal;
+    }
+    return;
+  }
+
+  /// Contiguous numChannels x nTicks samples including the pedestals
+  template <typename T>
+  void getContiguous(const SyntheticEvent& event, std::vector<T>& samples)
+  {
+    Array2D<T> plane;
+    event.getWaveforms(plane);
+    samples.resize(plane.numRows() * plane.numCols());
+    for (size_t i=0; i<plane.numRows(); ++i) {
+      std::copy(plane[i], plane[i] + plane.numCols(),
+        samples.begin() + i * plane.numCols());
+    }
+    return;
+  }
+
+  /// Electronics-like unipolar response, tau in ticks, unit area
+  template <typename T>
+  std::vector<T> getResponse(const size_t nTicks, const double tau=4.)
+  {
+    std::vector<T> response(nTicks, T(0.));
+    double sum = 0.;
+    for (size_t j=0; j<nTicks && j<size_t(40. * tau); ++j) {
+      double t = j / tau;
+      response[j] = t * t * std::exp(-t);
+      sum += response[j];
+    }
+    for (auto& val : response) val /= sum;
+    return response;
+  }
+
+  std::string label(const std::string& kernel, const std::string& type,
+    const std::string& layout, const std::string& params=std::string())
+  {
+    std::string name = kernel + "<" + type;
+    if (!layout.empty()) name += "," + layout;
+    name += ">";
+    if (!params.empty()) name += " " + params;
+    return name;
+  }
+
+  std::string size2D(const unsigned int sx, const unsigned int sy)
+  {
+    return std::to_string(sx) + "x" + std::to_string(sy);
+  }
+
+  // Morph1D on each channel, vector interface only
+  template <typename T>
+  void benchMorph1D(const Suite& suite, const std::vector<std::vector<T>>& in)
+  {
+    using Op = void (Morph1D::*)(const std::vector<T>&, const unsigned int,
+      std::vector<T>&) const;
+    const std::vector<std::pair<std::string, Op>> ops = {
+      {"Morph1D::getDilation", &Morph1D::getDilation},
+      {"Morph1D::getErosion",  &Morph1D::getErosion},
+      {"Morph1D::getGradient", &Morph1D::getGradient},
+      {"Morph1D::getAverage",  &Morph1D::getAverage},
+      {"Morph1D::getMedian",   &Morph1D::getMedian}};
+
+    const Morph1D morph;
+    std::vector<std::vector<T>> out(in.size());
+    std::vector<std::vector<T>> out2(in.size());
+    for (unsigned int se : kTickSizes) {
+      std::string params = "se=" + std::to_string(se);
+      for (const auto& op : ops) {
+        suite.run(label(op.first, TypeName<T>::value, "", params),
+          2 * sizeof(T), [&]() {
+            for (size_t i=0; i<in.size(); ++i) (morph.*op.second)(in[i], se, out[i]);
+          });
+      }
+      suite.run(label("Morph1D::getOpeningAndClosing", TypeName<T>::value, "",
+        params), 3 * sizeof(T), [&]() {
+          for (size_t i=0; i<in.size(); ++i) {
+            morph.getOpeningAndClosing(in[i], se, out[i], out2[i]);
+          }
+        });
+    }
+    return;
+  }
+
+  // Morph2D over all channel x tick structuring elements
+  template <typename T, typename Array>
+  void benchMorph2D(const Suite& suite, const Array& in)
+  {
+    using Op = void (Morph2D::*)(typename Layout<Array>::In, const unsigned int,
+      const unsigned int, Array&) const;
+    const std::vector<std::pair<std::string, Op>> ops = {
+      {"Morph2D::getDilation", &Morph2D::getDilation},
+      {"Morph2D::getErosion",  &Morph2D::getErosion},
+      {"Morph2D::getGradient", &Morph2D::getGradient},
+      {"Morph2D::getMedian",   &Morph2D::getMedian}};
+    const char* layout = Layout<Array>::name;
+
+    const Morph2D morph;
+    Array out1, out2, out3, out4;
+    for (unsigned int sx : kChannelSizes2D) {
+      for (unsigned int sy : kTickSizes2D) {
+        std::string params = size2D(sx, sy);
+        for (const auto& op : ops) {
+          suite.run(label(op.first, TypeName<T>::value, layout, params),
+            2 * sizeof(T), [&]() { (morph.*op.second)(in, sx, sy, out1); });
+        }
+        suite.run(label("Morph2D::getOpeningAndClosing", TypeName<T>::value,
+          layout, params), 3 * sizeof(T),
+          [&]() { morph.getOpeningAndClosing(in, sx, sy, out1, out2); });
+        suite.run(label("Morph2D::getFilter2D", TypeName<T>::value, layout,
+          params), 5 * sizeof(T),
+          [&]() { morph.getFilter2D(in, sx, sy, out1, out2, out3, out4); });
+      }
+    }
+    return;
+  }
+
+  // Coherent noise removal, 1D for every filter and structuring element,
+  // 2D for every filter and window
+  template <typename T, typename Array>
+  void benchDenoising(const Suite& suite, const Array& in)
+  {
+    using Mask = typename Layout<Array>::Mask;
+    const char* layout = Layout<Array>::name;
+    const double bytes = 3 * sizeof(T) + 2 * sizeof(bool);
+
+    Denoising denoising;
+    Array waveLessCoherent, morphed, intrinsicRMS, correctedMedians;
+    Mask selectVals, roi;
+    for (char filterName : kFilterNames) {
+      for (unsigned int se : kTickSizes) {
+        suite.run(label("Denoising::removeCoherentNoise1D", TypeName<T>::value,
+          layout, std::string(1, filterName) + " se=" + std::to_string(se)),
+          bytes, [&]() {
+            denoising.removeCoherentNoise1D(waveLessCoherent, in, morphed,
+              intrinsicRMS, selectVals, roi, correctedMedians, filterName,
+              kGrouping, se, 0, 2.5);
+          });
+      }
+      for (const auto& window : kWindows) {
+        suite.run(label("Denoising::removeCoherentNoise2D", TypeName<T>::value,
+          layout, std::string(1, filterName) + " " +
+          size2D(window.first, window.second)), bytes, [&]() {
+            denoising.removeCoherentNoise2D(waveLessCoherent, in, morphed,
+              intrinsicRMS, selectVals, roi, correctedMedians, filterName,
+              kGrouping, window.first, window.second, 0, 2.5);
+          });
+      }
+    }
+    return;
+  }
+
+  template <typename T, typename Array>
+  void benchAdaptiveWiener(
+    const Suite& suite,
+    const Array& in,
+    const typename Layout<Array>::Mask& mask,
+    const float noiseVar)
+  {
+    const char* layout = Layout<Array>::name;
+    const char* type = TypeName<T>::value;
+
+    sigproc_tools::AdaptiveWiener wiener;
+    Array out;
+    for (const auto& window : kWindows) {
+      unsigned int sx = window.first;
+      unsigned int sy = window.second;
+      std::string params = size2D(sx, sy);
+      suite.run(label("AdaptiveWiener::filterLee", type, layout, params),
+        2 * sizeof(T), [&]() { wiener.filterLee(out, in, noiseVar, sx, sy); });
+      suite.run(label("AdaptiveWiener::MMWF", type, layout, params),
+        2 * sizeof(T), [&]() { wiener.MMWF(out, in, noiseVar, sx, sy); });
+      suite.run(label("AdaptiveWiener::MMWFStar", type, layout, params),
+        2 * sizeof(T), [&]() { wiener.MMWFStar(out, in, sx, sy); });
+      suite.run(label("AdaptiveWiener::filterLeeEnhanced", type, layout,
+        params), 2 * sizeof(T), [&]() {
+          wiener.filterLeeEnhanced(out, in, noiseVar, sx, sy, 1., 2.5); });
+      suite.run(label("AdaptiveWiener::adaptiveROIWiener", type, layout,
+        params), 2 * sizeof(T) + sizeof(bool), [&]() {
+          wiener.adaptiveROIWiener(out, in, mask, noiseVar, sx, sy, 1., 2.5); });
+      suite.run(label("AdaptiveWiener::sigmaFilter", type, layout, params),
+        2 * sizeof(T), [&]() {
+          wiener.sigmaFilter(out, in, noiseVar, sx, sy, 3, 2.); });
+    }
+    return;
+  }
+
+  template <typename T, typename Array>
+  void benchNoisePower(
+    const Suite& suite,
+    const Array& in,
+    const typename Layout<Array>::Mask& mask)
+  {
+    MiscUtils utils;
+    std::vector<float> channelPower, groupPower;
+    unsigned int numThreads = suite.getOptions().numThreads;
+    suite.run(label("MiscUtils::compute_noise_power", TypeName<T>::value,
+      Layout<Array>::name), sizeof(T) + sizeof(bool),
+      [&]() { utils.compute_noise_power(in, mask, numThreads); });
+    suite.run(label("MiscUtils::compute_noise_power", TypeName<T>::value,
+      Layout<Array>::name, "groups"), sizeof(T) + sizeof(bool), [&]() {
+        utils.compute_noise_power(in, mask, channelPower, groupPower,
+          kGrouping, numThreads);
+      });
+    return;
+  }
+
+  // Deconvolution variants, floating point only
+  template <typename T, typename Array>
+  void benchDeconvolution(
+    const Suite& suite,
+    const Array& in,
+    const typename Layout<Array>::Mask& mask,
+    const float noiseVar)
+  {
+    const char* layout = Layout<Array>::name;
+    const char* type = TypeName<T>::value;
+    size_t numChannels = suite.getOptions().numChannels;
+    size_t nTicks = suite.getOptions().nTicks;
+    std::vector<T> response = getResponse<T>(nTicks);
+    std::vector<std::vector<T>> noisePSD(
+      (numChannels + kGrouping - 1) / kGrouping,
+      std::vector<T>(nTicks / 2 + 1, T(noiseVar)));
+
+    sigproc_tools::Deconvolution deconvolution;
+    Array out;
+    typename Layout<Array>::Spectra spectra, spectraCopy;
+    std::vector<sigproc_tools::ROIWaveform<T>> rois;
+
+    suite.run(label("Deconvolution::Inverse1D", type, layout), 2 * sizeof(T),
+      [&]() { deconvolution.Inverse1D(out, in, response); });
+    suite.run(label("Deconvolution::Wiener1D", type, layout), 2 * sizeof(T),
+      [&]() { deconvolution.Wiener1D(out, in, response, noiseVar); });
+    suite.run(label("Deconvolution::Wiener1D", type, layout, "noisePSD"),
+      2 * sizeof(T), [&]() {
+        deconvolution.Wiener1D(out, in, response, noisePSD, kGrouping); });
+    suite.run(label("Deconvolution::getSpectra", type, layout), 2 * sizeof(T),
+      [&]() { deconvolution.getSpectra(spectra, in); });
+    suite.run(label("Deconvolution::Wiener1D", type, layout, "spectra"),
+      2 * sizeof(T),
+      [&]() { deconvolution.Wiener1D(out, spectraCopy, response, noiseVar,
+        nTicks); },
+      [&]() { spectraCopy = spectra; });
+    suite.run(label("Deconvolution::WienerROI1D", type, layout),
+      2 * sizeof(T) + sizeof(bool), [&]() {
+        deconvolution.WienerROI1D(rois, in, mask, response, noiseVar, 20); });
+    return;
+  }
+
+  // FilterSpectrum version, float only
+  template <typename Array>
+  void benchFilterSpectrum(const Suite& suite, const Array& in,
+    const float noiseVar)
+  {
+    size_t nTicks = suite.getOptions().nTicks;
+    std::vector<double> field(nTicks, 0.);
+    field[0] = 1.;
+    std::vector<float> electronics = getResponse<float>(nTicks);
+    ResponseRegistry registry;
+    registry.setResponse(2, field,
+      std::vector<double>(electronics.begin(), electronics.end()));
+    auto filter = registry.getFilter(2, nTicks);
+
+    sigproc_tools::Deconvolution deconvolution;
+    Array out;
+    suite.run(label("Deconvolution::Wiener1D", "float", Layout<Array>::name,
+      "FilterSpectrum"), 2 * sizeof(float),
+      [&]() { deconvolution.Wiener1D(out, in, *filter, noiseVar); });
+    return;
+  }
+
+  // Spectral stages on nested vectors
+  template <typename T>
+  void benchSpectral(
+    const Suite& suite,
+    const std::vector<std::vector<T>>& in,
+    const std::vector<std::vector<bool>>& mask)
+  {
+    const char* type = TypeName<T>::value;
+    sigproc_tools::Deconvolution deconvolution;
+    std::vector<std::vector<std::complex<T>>> spectra, spectraCopy;
+    deconvolution.getSpectra(spectra, in);
+
+    HarmonicNoiseFilter harmonicFilter;
+    HarmonicNoiseFilter::ArrayBins notchedBins;
+    suite.run(label("HarmonicNoiseFilter::removeHarmonics", type, "nested"),
+      2 * sizeof(T),
+      [&]() { harmonicFilter.removeHarmonics(spectraCopy, notchedBins, 'i',
+        kGrouping, 16, 10.); },
+      [&]() { spectraCopy = spectra; });
+
+    NoiseSpectrum noiseSpectrum;
+    FFTPlanCache planCache;
+    std::vector<std::vector<T>> psd;
+    for (unsigned int segmentLength : {256U, 1024U}) {
+      suite.run(label("NoiseSpectrum::getNoisePSD", type, "nested",
+        "segment=" + std::to_string(segmentLength)), sizeof(T) + sizeof(bool),
+        [&]() { noiseSpectrum.getNoisePSD(in, mask, planCache, psd, kGrouping,
+          segmentLength); });
+    }
+    return;
+  }
+
+  // All 2D kernels of one type and layout
+  template <typename T, typename Array>
+  void benchLayout(
+    const Suite& suite,
+    const Array2D<T>& plane,
+    const Array2D<bool>& signalMask,
+    const float noiseVar)
+  {
+    Array in;
+    typename Layout<Array>::Mask mask;
+    convertLayout(plane, in);
+    convertLayout(signalMask, mask);
+
+    benchMorph2D<T>(suite, in);
+    benchDenoising<T>(suite, in);
+    benchAdaptiveWiener<T>(suite, in, mask, noiseVar);
+    benchNoisePower<T>(suite, in, mask);
+    return;
+  }
+
+  template <typename T>
+  void benchType(const Suite& suite, const SyntheticEvent& event)
+  {
+    const Options& options = suite.getOptions();
+    float noiseVar = event.getConfig().noiseRms * event.getConfig().noiseRms;
+    Array2D<T> plane;
+    getPlane(event, plane);
+
+    if (options.nested) {
+      std::vector<std::vector<T>> in;
+      convertLayout(plane, in);
+      benchMorph1D<T>(suite, in);
+      benchLayout<T, std::vector<std::vector<T>>>(suite, plane,
+        event.getSignalMask(), noiseVar);
+    }
+    if (options.array) {
+      benchLayout<T, Array2D<T>>(suite, plane, event.getSignalMask(), noiseVar);
+    }
+    return;
+  }
+
+  template <typename T>
+  void benchFloatingPoint(const Suite& suite, const SyntheticEvent& event)
+  {
+    const Options& options = suite.getOptions();
+    float noiseVar = event.getConfig().noiseRms * event.getConfig().noiseRms;
+    Array2D<T> plane;
+    getPlane(event, plane);
+
+    if (options.nested) {
+      std::vector<std::vector<T>> in;
+      std::vector<std::vector<bool>> mask;
+      convertLayout(plane, in);
+      convertLayout(event.getSignalMask(), mask);
+      benchDeconvolution<T>(suite, in, mask, noiseVar);
+      benchSpectral<T>(suite, in, mask);
+      if constexpr (std::is_same<T, float>::value) {
+        benchFilterSpectrum(suite, in, noiseVar);
+      }
+    }
+    if (options.array) {
+      benchDeconvolution<T>(suite, plane, event.getSignalMask(), noiseVar);
+      if constexpr (std::is_same<T, float>::value) {
+        benchFilterSpectrum(suite, plane, noiseVar);
+      }
+    }
+    return;
+  }
+
+  // Pedestal finding, RawDigit decoding and the full pipeline; these work
+  // on contiguous channels and have no nested layout
+  void benchEvent(const Suite& suite, const SyntheticEvent& event)
+  {
+    const Options& options = suite.getOptions();
+    size_t numChannels = options.numChannels;
+    size_t nTicks = options.nTicks;
+    unsigned int numThreads = options.numThreads;
+
+    std::vector<float> floatSamples;
+    std::vector<short> shortSamples;
+    getContiguous(event, floatSamples);
+    getContiguous(event, shortSamples);
+    std::vector<raw::RawDigit> rawDigits;
+    event.getRawDigits(rawDigits);
+
+    WaveformParamsAlg paramsAlg;
+    WaveformParamsAlg::PedestalArrays pedestalArrays;
+    suite.run(label("WaveformParamsAlg::getMeanAndTruncRms", "float", ""),
+      sizeof(float), [&]() {
+        paramsAlg.getMeanAndTruncRms(floatSamples.data(), numChannels, nTicks,
+          pedestalArrays, numThreads);
+      });
+    suite.run(label("WaveformParamsAlg::getMeanAndTruncRms", "short", ""),
+      sizeof(short), [&]() {
+        paramsAlg.getMeanAndTruncRms(shortSamples.data(), numChannels, nTicks,
+          pedestalArrays, numThreads);
+      });
+    suite.run(label("WaveformParamsAlg::getMeanAndTruncRms", "RawDigit", ""),
+      sizeof(short), [&]() {
+        paramsAlg.getMeanAndTruncRms(rawDigits, pedestalArrays, numThreads); });
+
+    // Steady state: the tracker has seen the event before being timed
+    PedestalTracker floatTracker, shortTracker;
+    std::vector<float> pedestals, rmsVals;
+    suite.run(label("PedestalTracker::update", "float", ""), sizeof(float),
+      [&]() {
+        floatTracker.update(floatSamples.data(), numChannels, nTicks,
+          pedestals, rmsVals, numThreads);
+      });
+    suite.run(label("PedestalTracker::update", "short", ""), sizeof(short),
+      [&]() {
+        shortTracker.update(shortSamples.data(), numChannels, nTicks,
+          pedestals, rmsVals, numThreads);
+      });
+
+    Array2D<float> floatPlane;
+    Array2D<short> shortPlane;
+    for (char mode : {'d', 'c', 'n'}) {
+      RawDigitIngester ingester(mode);
+      suite.run(label("RawDigitIngester::ingest", "float", "",
+        std::string("mode=") + mode), sizeof(short) + sizeof(float), [&]() {
+          ingester.ingest(rawDigits, floatPlane, pedestals, numThreads); });
+    }
+    RawDigitIngester ingester;
+    std::vector<float> truePedestals = event.getPedestals();
+    suite.run(label("RawDigitIngester::ingest", "float", "", "pedestals"),
+      sizeof(short) + sizeof(float), [&]() {
+        ingester.ingest(rawDigits, truePedestals, floatPlane, numThreads); });
+    suite.run(label("RawDigitIngester::ingest", "short", ""),
+      2 * sizeof(short),
+      [&]() { ingester.ingest(rawDigits, shortPlane, numThreads); });
+
+    SignalProcessingPipeline::Config config;
+    config.responseFunction = getResponse<float>(nTicks);
+    config.deconvolutionNoiseVar =
+      event.getConfig().noiseRms * event.getConfig().noiseRms;
+    config.numThreads = numThreads;
+    SignalProcessingPipeline pipeline(config);
+    Array2D<float> rawPlane;
+    event.getWaveforms(rawPlane);
+    suite.run(label("SignalProcessingPipeline::process", "float", "array"),
+      2 * sizeof(float), [&]() { pipeline.process(rawPlane); });
+
+    config.pedestalMode = 'd';
+    SignalProcessingPipeline rawDigitPipeline(config);
+    suite.run(label("SignalProcessingPipeline::process", "RawDigit", ""),
+      sizeof(short) + sizeof(float),
+      [&]() { rawDigitPipeline.process(rawDigits); });
+    return;
+  }
+
+  void printUsage(const char* program)
+  {
+    std::fprintf(stderr, "Usage: %s [--channels N] [--ticks N] [--reps N] "
+      "[--threads N] [--filter TEXT] [--layout nested|array|both] "
+      "[--report FILE] [--trace FILE]\n", program);
+    return;
+  }
+
+  bool parseOptions(int argc, char** argv, Options& options)
+  {
+    for (int i=1; i<argc; ++i) {
+      std::string key = argv[i];
+      if (i + 1 >= argc) return false;
+      std::string value = argv[++i];
+      char* end = nullptr;
+      unsigned long number = std::strtoul(value.c_str(), &end, 10);
+      bool isNumber = !value.empty() && *end == '\0';
+      if (key == "--channels" && isNumber && number > 0) options.numChannels = number;
+      else if (key == "--ticks" && isNumber && number > 1) options.nTicks = number;
+      else if (key == "--reps" && isNumber && number > 0) options.reps = number;
+      else if (key == "--threads" && isNumber) options.numThreads = number;
+      else if (key == "--filter") options.filter = value;
+      else if (key == "--report") options.report = value;
+      else if (key == "--trace") options.trace = value;
+      else if (key == "--layout" && (value == "nested" || value == "array" ||
+        value == "both")) {
+        options.nested = value != "array";
+        options.array = value != "nested";
+      }
+      else return false;
+    }
+    return true;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  Options options;
+  if (!parseOptions(argc, argv, options)) {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  SyntheticEvent::Config config;
+  config.numChannels = options.numChannels;
+  config.nTicks = options.nTicks;
+  SyntheticEvent event(config);
+
+  std::printf("# %zu channels x %zu ticks, %u repetitions, %u workers\n",
+    options.numChannels, options.nTicks, options.reps,
+    getNumWorkers(options.numThreads));
+  std::printf("%-56s %10s %10s %10s %8s\n", "# kernel", "min [ms]",
+    "mean [ms]", "ns/sample", "GB/s");
+
+  Instrumentation::reset();
+  if (!options.trace.empty()) Trace::start();
+  Suite suite(options);
+  benchType<short>(suite, event);
+  benchType<float>(suite, event);
+  benchType<double>(suite, event);
+  benchFloatingPoint<float>(suite, event);
+  benchFloatingPoint<double>(suite, event);
+  benchEvent(suite, event);
+
+  if (!options.report.empty()) {
+    std::ofstream report(options.report);
+    Instrumentation::writeJSON(report, "sigproc_benchmark");
+    if (!report) {
+      std::fprintf(stderr, "Cannot write %s\n", options.report.c_str());
+      return 1;
+    }
+  }
+  if (!options.trace.empty()) {
+    Trace::stop();
+    std::ofstream trace(options.trace);
+    Trace::writeJSON(trace);
+    if (!trace) {
+      std::fprintf(stderr, "Cannot write %s\n", options.trace.c_str());
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,182 @@
+#ifndef __SIGPROC_TOOLS_SYNTHETICEVENT_CXX__
+#define __SIGPROC_TOOLS_SYNTHETICEVENT_CXX__
+
+#include "SyntheticEvent.h"
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+namespace {
+
+  // splitmix64: small, fast and identical everywhere
+  class Random {
+    public:
+      explicit Random(const uint64_t seed) : fState(seed) {}
+
+      uint64_t next()
+      {
+        uint64_t z = (fState += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+      }
+
+      /// Uniform in [0, 1)
+      double uniform() { return double(next() >> 11) * (1. / 9007199254740992.); }
+
+      /// Standard normal (Box-Muller)
+      double gauss()
+      {
+        double u1 = 1. - uniform();
+        double u2 = uniform();
+        return std::sqrt(-2. * std::log(u1)) * std::cos(2. * M_PI * u2);
+      }
+
+    private:
+      uint64_t fState;
+  };
+}
+
+icarussigproc::SyntheticEvent::SyntheticEvent() :
+  SyntheticEvent(Config())
+{
+}
+
+icarussigproc::SyntheticEvent::SyntheticEvent(const Config& config) :
+  fConfig(config)
+{
+  generate();
+}
+
+void icarussigproc::SyntheticEvent::generate()
+{
+  size_t numChannels = fConfig.numChannels;
+  size_t nTicks = fConfig.nTicks;
+  size_t grouping = std::max(fConfig.grouping, 1U);
+  Random random(fConfig.seed);
+
+  fWaveforms.assign(numChannels, nTicks, 0.);
+  fSignalMask.assign(numChannels, nTicks, false);
+  fPedestals.resize(numChannels);
+
+  // Pedestals, incoherent and harmonic noise; the harmonic phases are
+  // shared by a group (common pickup)
+  std::vector<double> phases(fConfig.harmonics.size());
+  std::vector<float> coherent(nTicks);
+  for (size_t i=0; i<numChannels; ++i) {
+    if (i % grouping == 0) {
+      for (auto& val : coherent) val = fConfig.coherentRms * random.gauss();
+      for (auto& phase : phases) phase = 2. * M_PI * random.uniform();
+    }
+    fPedestals[i] = std::round(fConfig.pedestal +
+      fConfig.pedestalSpread * (2. * random.uniform() - 1.));
+    float* row = fWaveforms[i];
+    for (size_t j=0; j<nTicks; ++j) {
+      double harmonic = 0.;
+      for (size_t h=0; h<phases.size(); ++h) {
+        harmonic += std::sin(2. * M_PI * fConfig.harmonics[h] * j + phases[h]);
+      }
+      row[j] = fPedestals[i] + coherent[j] +
+        fConfig.noiseRms * random.gauss() +
+        fConfig.harmonicAmplitude * harmonic;
+    }
+  }
+
+  // Tracks: straight lines from (c0, t0) to (c1, t1) with a gaussian pulse
+  // on every channel they cross
+  double halfWidth = 4. * fConfig.trackWidth;
+  for (size_t k=0; k<fConfig.numTracks && numChannels>0 && nTicks>0; ++k) {
+    size_t c0 = size_t(random.uniform() * numChannels);
+    size_t c1 = size_t(random.uniform() * numChannels);
+    if (c0 > c1) std::swap(c0, c1);
+    double t0 = random.uniform() * nTicks;
+    double t1 = random.uniform() * nTicks;
+    double amplitude = fConfig.trackAmplitude * (0.5 + random.uniform());
+    for (size_t i=c0; i<=c1; ++i) {
+      double center = c1 > c0 ? t0 + (t1 - t0) * double(i - c0) / double(c1 - c0) : t0;
+      size_t lower = size_t(std::max(0., center - halfWidth));
+      size_t upper = size_t(std::min(double(nTicks), center + halfWidth + 1.));
+      for (size_t j=lower; j<upper; ++j) {
+        double x = (double(j) - center) / fConfig.trackWidth;
+        float pulse = amplitude * std::exp(-0.5 * x * x);
+        fWaveforms[i][j] += pulse;
+        if (pulse > fConfig.noiseRms) fSignalMask[i][j] = true;
+      }
+    }
+  }
+  return;
+}
+
+template <typename T>
+void icarussigproc::SyntheticEvent::convert(Array2D<T>& waveforms) const
+{
+  waveforms.resize(fWaveforms.numRows(), fWaveforms.numCols());
+  for (size_t i=0; i<fWaveforms.numRows(); ++i) {
+    for (size_t j=0; j<fWaveforms.numCols(); ++j) {
+      waveforms[i][j] = std::is_integral<T>::value ?
+        T(std::lround(fWaveforms[i][j])) : T(fWaveforms[i][j]);
+    }
+  }
+  return;
+}
+
+void icarussigproc::SyntheticEvent::getWaveforms(Array2D<short>& waveforms) const
+{
+  convert(waveforms);
+  return;
+}
+
+void icarussigproc::SyntheticEvent::getWaveforms(Array2D<float>& waveforms) const
+{
+  waveforms = fWaveforms;
+  return;
+}
+
+void icarussigproc::SyntheticEvent::getWaveforms(Array2D<double>& waveforms) const
+{
+  convert(waveforms);
+  return;
+}
+
+void icarussigproc::SyntheticEvent::getWaveforms(
+  std::vector<std::vector<short>>& waveforms) const
+{
+  Array2D<short> array;
+  convert(array);
+  toNestedVector(array, waveforms);
+  return;
+}
+
+void icarussigproc::SyntheticEvent::getWaveforms(
+  std::vector<std::vector<float>>& waveforms) const
+{
+  toNestedVector(fWaveforms, waveforms);
+  return;
+}
+
+void icarussigproc::SyntheticEvent::getWaveforms(
+  std::vector<std::vector<double>>& waveforms) const
+{
+  Array2D<double> array;
+  convert(array);
+  toNestedVector(array, waveforms);
+  return;
+}
+
+void icarussigproc::SyntheticEvent::getRawDigits(
+  std::vector<raw::RawDigit>& rawDigits) const
+{
+  Array2D<short> array;
+  convert(array);
+  rawDigits.clear();
+  rawDigits.reserve(array.numRows());
+  for (size_t i=0; i<array.numRows(); ++i) {
+    raw::RawDigit::ADCvector_t adc(array[i], array[i] + array.numCols());
+    rawDigits.emplace_back(raw::ChannelID_t(i), array.numCols(), adc);
+    rawDigits.back().SetPedestal(fPedestals[i], fConfig.noiseRms);
+  }
+  return;
+}
+
+#endif
@@ -0,0 +1,95 @@
+/**
+ * \file SyntheticEvent.h
+ *
+ * \ingroup icarussigproc
+ *
+ * \brief Deterministic ICARUS-like test events for the benchmarks and tests
+ *
+ */
+
+/** \addtogroup icarussigproc
+
+    @{*/
+#ifndef __SIGPROC_TOOLS_SYNTHETICEVENT_H__
+#define __SIGPROC_TOOLS_SYNTHETICEVENT_H__
+
+#include <cstdint>
+#include <vector>
+#include "lardataobj/RawData/RawDigit.h"
+#include "icarussigproc/Array2D.h"
+
+namespace icarussigproc {
+
+  /**
+     \class SyntheticEvent
+     Channel x tick ADC plane made of a per channel pedestal, gaussian noise,
+     noise common to each group of channels, harmonic pickup lines and
+     track-like signals (gaussian pulses along straight lines in the
+     channel-tick plane). Fully determined by the configuration, including
+     the seed: the random numbers come from a local generator, not from the
+     standard library distributions, so every platform gets the same event.
+  */
+  class SyntheticEvent{
+
+    public:
+
+      struct Config {
+        size_t             numChannels = 576;
+        size_t             nTicks = 4096;
+        uint64_t           seed = 20201028;
+        float              pedestal = 900.;        // mean pedestal, ADC
+        float              pedestalSpread = 20.;   // channel to channel, ADC
+        float              noiseRms = 3.;          // incoherent noise, ADC
+        float              coherentRms = 2.;       // common to a group, ADC
+        unsigned int       grouping = 64;
+        std::vector<float> harmonics = {0.0123, 0.0517};  // cycles per tick
+        float              harmonicAmplitude = 1.5;       // ADC
+        size_t             numTracks = 20;
+        float              trackAmplitude = 40.;   // pulse height, ADC
+        float              trackWidth = 4.;        // pulse sigma, ticks
+      };
+
+      SyntheticEvent();
+
+      explicit SyntheticEvent(const Config&);
+
+      const Config& getConfig() const { return fConfig; }
+
+      /// ADC values including pedestals (rounded to counts for short)
+      void getWaveforms(Array2D<short>&) const;
+      void getWaveforms(Array2D<float>&) const;
+      void getWaveforms(Array2D<double>&) const;
+
+      /// Same content as nested vectors
+      void getWaveforms(std::vector<std::vector<short>>&) const;
+      void getWaveforms(std::vector<std::vector<float>>&) const;
+      void getWaveforms(std::vector<std::vector<double>>&) const;
+
+      /// Uncompressed RawDigits carrying the true pedestal and noise rms
+      void getRawDigits(std::vector<raw::RawDigit>&) const;
+
+      /// True where a track pulse exceeds noiseRms
+      const Array2D<bool>& getSignalMask() const { return fSignalMask; }
+
+      /// True pedestal of each channel
+      const std::vector<float>& getPedestals() const { return fPedestals; }
+
+      /// Default destructor
+      ~SyntheticEvent(){}
+
+    private:
+
+      void generate();
+
+      template <typename T>
+      void convert(Array2D<T>& waveforms) const;
+
+      Config             fConfig;
+      Array2D<float>     fWaveforms;
+      Array2D<bool>      fSignalMask;
+      std::vector<float> fPedestals;
+  };
+}
+
+#endif
+/** @} */ // end of doxygen group
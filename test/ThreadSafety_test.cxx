@@ -0,0 +1,260 @@
+/**
+ * \file ThreadSafety_test.cxx
+ *
+ * \ingroup icarussigproc
+ *
+ * \brief Concurrent use of shared kernels and of batches of events
+ *
+ * Usage: ThreadSafety_test [--threads N] [--events N]
+ *
+ * Checks the reentrancy of the library. One const Morph2D, Denoising,
+ * AdaptiveWiener and MiscUtils are shared by N std::threads, each running
+ * the kernels on every plane of a set of synthetic events in its own
+ * order, and SignalProcessingPipeline::processEvents processes a batch of
+ * events (waveform and RawDigit input mixed) on a ThreadPool of N threads,
+ * twice with the same Event objects. Every result must equal bit for bit
+ * the one of a serial call. Meant to be run under ThreadSanitizer too.
+ */
+
+#include "SyntheticEvent.h"
+
+#include "icarussigproc/Array2D.h"
+#include "icarussigproc/Morph2D.h"
+#include "icarussigproc/Denoising.h"
+#include "icarussigproc/AdaptiveWiener.h"
+#include "icarussigproc/MiscUtils.h"
+#include "icarussigproc/SignalProcessingPipeline.h"
+#include "icarussigproc/ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace icarussigproc;
+using sigproc_tools::AdaptiveWiener;
+
+namespace {
+
+  // Passes of every thread over the planes
+  const unsigned int kRounds = 3;
+
+  template <typename T>
+  bool isEqual(const Array2DView<const T> a, const Array2DView<const T> b)
+  {
+    if (a.numRows() != b.numRows() || a.numCols() != b.numCols()) return false;
+    for (size_t i=0; i<a.numRows(); ++i) {
+      if (!std::equal(a[i], a[i] + a.numCols(), b[i])) return false;
+    }
+    return true;
+  }
+
+  /// Outputs of the shared kernels for one plane
+  template <typename T>
+  struct KernelResults {
+    Array2D<T>    dilation;
+    Array2D<T>    erosion;
+    Array2D<T>    average;
+    Array2D<T>    gradient;
+    Array2D<T>    waveLessCoherent;
+    Array2D<T>    morphed;
+    Array2D<T>    intrinsicRMS;
+    Array2D<T>    correctedMedians;
+    Array2D<bool> selectVals;
+    Array2D<bool> roi;
+    float         noisePower = 0.;
+    Array2D<T>    filtered;
+
+    bool operator==(const KernelResults& other) const
+    {
+      return isEqual<T>(dilation, other.dilation) &&
+        isEqual<T>(erosion, other.erosion) &&
+        isEqual<T>(average, other.average) &&
+        isEqual<T>(gradient, other.gradient) &&
+        isEqual<T>(waveLessCoherent, other.waveLessCoherent) &&
+        isEqual<T>(morphed, other.morphed) &&
+        isEqual<T>(intrinsicRMS, other.intrinsicRMS) &&
+        isEqual<T>(correctedMedians, other.correctedMedians) &&
+        isEqual<bool>(selectVals, other.selectVals) &&
+        isEqual<bool>(roi, other.roi) &&
+        noisePower == other.noisePower &&
+        isEqual<T>(filtered, other.filtered);
+    }
+  };
+
+  /// The kernel objects every thread shares
+  struct SharedKernels {
+    const Morph2D&        morph;
+    const Denoising&      denoising;
+    const AdaptiveWiener& wiener;
+    const MiscUtils&      utils;
+  };
+
+  template <typename T>
+  void runKernels(const SharedKernels& kernels, const Array2D<T>& plane,
+    KernelResults<T>& results)
+  {
+    kernels.morph.getFilter2D(plane.view(), 5, 11, results.dilation,
+      results.erosion, results.average, results.gradient);
+    kernels.denoising.removeCoherentNoise2D(results.waveLessCoherent,
+      plane.view(), results.morphed, results.intrinsicRMS, results.selectVals,
+      results.roi, results.correctedMedians, 'd', 16, 5, 11, 4, 2.5);
+    results.noisePower = kernels.utils.compute_noise_power(
+      results.waveLessCoherent.view(), results.selectVals.view());
+    kernels.wiener.adaptiveROIWiener(results.filtered,
+      results.waveLessCoherent.view(), results.selectVals.view(),
+      results.noisePower, 3, 3, 1., 2.5);
+    return;
+  }
+
+  /// Number of results of concurrent runs that differ from the serial ones
+  template <typename T>
+  size_t checkSharedKernels(const std::vector<SyntheticEvent>& events,
+    const unsigned int numThreads)
+  {
+    std::vector<Array2D<T>> planes(events.size());
+    for (size_t k=0; k<events.size(); ++k) {
+      events[k].getWaveforms(planes[k]);
+      for (size_t i=0; i<planes[k].numRows(); ++i) {
+        T pedestal = T(events[k].getPedestals()[i]);
+        for (size_t j=0; j<planes[k].numCols(); ++j) planes[k][i][j] -= pedestal;
+      }
+    }
+
+    Morph2D morph;
+    Denoising denoising;
+    AdaptiveWiener wiener;
+    MiscUtils utils;
+    SharedKernels kernels{morph, denoising, wiener, utils};
+
+    std::vector<KernelResults<T>> expected(planes.size());
+    for (size_t k=0; k<planes.size(); ++k) {
+      runKernels(kernels, planes[k], expected[k]);
+    }
+
+    // Each thread starts at another plane, so that different kernels and
+    // planes overlap
+    std::vector<size_t> mismatches(numThreads, 0);
+    std::vector<std::thread> threads;
+    for (unsigned int t=0; t<numThreads; ++t) {
+      threads.emplace_back([&, t]() {
+        KernelResults<T> results;
+        for (unsigned int round=0; round<kRounds; ++round) {
+          for (size_t n=0; n<planes.size(); ++n) {
+            size_t k = (n + t) % planes.size();
+            runKernels(kernels, planes[k], results);
+            if (!(results == expected[k])) ++mismatches[t];
+          }
+        }
+      });
+    }
+    for (auto& thread : threads) thread.join();
+
+    size_t numMismatches = 0;
+    for (auto count : mismatches) numMismatches += count;
+    return numMismatches;
+  }
+
+  bool isEqual(const SignalProcessingPipeline& pipeline,
+    const SignalProcessingPipeline::Event& event)
+  {
+    return isEqual<float>(pipeline.getOutput(), event.output) &&
+      pipeline.getPedestals() == event.pedestals &&
+      isEqual<bool>(pipeline.getSelectVals(), event.selectVals) &&
+      isEqual<bool>(pipeline.getROI(), event.roi) &&
+      isEqual<float>(pipeline.getIntrinsicRMS(), event.intrinsicRMS) &&
+      isEqual<float>(pipeline.getCorrectedMedians(), event.correctedMedians) &&
+      pipeline.getNoiseVar() == event.noiseVar;
+  }
+
+  /// Number of events of two batches that differ from serial processing
+  size_t checkProcessEvents(const std::vector<SyntheticEvent>& events)
+  {
+    SignalProcessingPipeline::Config config;
+    config.grouping = 16;
+    config.responseFunction.assign(events[0].getConfig().nTicks, 0.);
+    for (size_t j=0; j<40; ++j) {
+      double t = j / 4.;
+      config.responseFunction[j] = t * t * std::exp(-t);
+    }
+
+    // Even events from waveforms, odd ones from RawDigits
+    std::vector<Array2D<float>> waveforms(events.size());
+    std::vector<std::vector<raw::RawDigit>> rawDigits(events.size());
+    std::vector<SignalProcessingPipeline::Event> batch(events.size());
+    for (size_t k=0; k<events.size(); ++k) {
+      if (k % 2 == 0) {
+        events[k].getWaveforms(waveforms[k]);
+        batch[k].waveforms = waveforms[k].view();
+      } else {
+        events[k].getRawDigits(rawDigits[k]);
+        batch[k].rawDigits = &rawDigits[k];
+      }
+    }
+
+    SignalProcessingPipeline pipeline(config);
+    size_t numMismatches = 0;
+    for (unsigned int round=0; round<2; ++round) {
+      pipeline.processEvents(batch);
+      SignalProcessingPipeline serial(config);
+      for (size_t k=0; k<events.size(); ++k) {
+        if (batch[k].rawDigits) serial.process(*batch[k].rawDigits);
+        else serial.process(batch[k].waveforms);
+        if (!isEqual(serial, batch[k])) ++numMismatches;
+      }
+    }
+    return numMismatches;
+  }
+
+  bool parseOptions(int argc, char** argv, unsigned int& numThreads,
+    unsigned int& numEvents)
+  {
+    for (int i=1; i+1<argc; i+=2) {
+      std::string key = argv[i];
+      char* end = nullptr;
+      unsigned long value = std::strtoul(argv[i+1], &end, 10);
+      if (*end != '\0' || value == 0) return false;
+      if (key == "--threads") numThreads = value;
+      else if (key == "--events") numEvents = value;
+      else return false;
+    }
+    return argc % 2 == 1;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  unsigned int numThreads = 4;
+  unsigned int numEvents = 6;
+  if (!parseOptions(argc, argv, numThreads, numEvents)) {
+    std::fprintf(stderr, "Usage: %s [--threads N] [--events N]\n", argv[0]);
+    return 1;
+  }
+
+  // Real concurrency also on machines with fewer cores
+  ThreadPool::configure(numThreads);
+
+  std::vector<SyntheticEvent> events;
+  for (unsigned int k=0; k<numEvents; ++k) {
+    SyntheticEvent::Config config;
+    config.numChannels = 64;
+    config.nTicks = 512;
+    config.grouping = 16;
+    config.numTracks = 4;
+    config.seed = 1000 + k;
+    events.emplace_back(config);
+  }
+
+  size_t shortMismatches = checkSharedKernels<short>(events, numThreads);
+  size_t floatMismatches = checkSharedKernels<float>(events, numThreads);
+  size_t eventMismatches = checkProcessEvents(events);
+
+  std::printf("# %u threads, %u events\n", numThreads, numEvents);
+  std::printf("%-40s %8zu\n", "shared kernels<short> mismatches", shortMismatches);
+  std::printf("%-40s %8zu\n", "shared kernels<float> mismatches", floatMismatches);
+  std::printf("%-40s %8zu\n", "processEvents mismatches", eventMismatches);
+  return shortMismatches + floatMismatches + eventMismatches > 0 ? 1 : 0;
+}
@@ -0,0 +1,142 @@
+/**
+ * \file WienerROI1D_test.cxx
+ *
+ * \ingroup icarussigproc
+ *
+ * \brief ROI-only Wiener deconvolution against the full length Wiener1D
+ *
+ * Usage: WienerROI1D_test
+ *
+ * One deposit per channel, convolved with a response longer than the
+ * padded ROIs and placed at the start, in the middle and close to the end
+ * of the waveforms. Without noise WienerROI1D must reproduce Wiener1D on
+ * the ROI ticks, up to the regularisation of the frequencies without
+ * power, which vanishes with noiseVar. With white noise of variance
+ * noiseVar the two differ by the part of the deconvolved noise that
+ * depends on the rest of the waveform, which must stay of the order of the
+ * noise rms of the Wiener1D output.
+ */
+
+#include "icarussigproc/Deconvolution.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using sigproc_tools::Deconvolution;
+using sigproc_tools::ROIWaveform;
+
+namespace {
+
+  const size_t       kNumChannels = 8;
+  const size_t       kNumTicks = 4096;
+  const size_t       kResponseTicks = 120;
+  const unsigned int kMargin = 32;
+
+  // Ticks of the deposits. The windows of the first and the last one wrap
+  // around the ends of the waveform, which holds the whole response.
+  const size_t kDeposits[kNumChannels] =
+    {12, 300, 1000, 1700, 2400, 3100, 3600, 3950};
+
+  template <typename T>
+  std::vector<T> getResponse()
+  {
+    std::vector<T> response(kNumTicks, 0.);
+    for (size_t j=0; j<kResponseTicks; ++j) {
+      double t = j / 12.;
+      response[j] = t * t * std::exp(-t);
+    }
+    return response;
+  }
+
+  template <typename T>
+  void getEvent(const double noiseRms, std::vector<std::vector<T>>& waveforms,
+    std::vector<std::vector<bool>>& roi)
+  {
+    std::vector<T> response = getResponse<T>();
+    std::mt19937 engine(4321);
+    std::normal_distribution<double> noise(0., noiseRms);
+    waveforms.assign(kNumChannels, std::vector<T>(kNumTicks, 0.));
+    roi.assign(kNumChannels, std::vector<bool>(kNumTicks, false));
+    for (size_t i=0; i<kNumChannels; ++i) {
+      for (size_t t=0; t<kNumTicks; ++t) {
+        // Gaussian deposit of 300 ADC and 2 ticks sigma
+        double value = noise(engine);
+        for (size_t k=0; k<kResponseTicks && k<=t; ++k) {
+          double d = double(t - k) - double(kDeposits[i]);
+          value += response[k] * 300. * std::exp(-0.125 * d * d);
+        }
+        waveforms[i][t] = value;
+      }
+      size_t roiStart = kDeposits[i] - std::min(kDeposits[i], size_t(10));
+      size_t roiEnd = std::min(kDeposits[i] + 40, kNumTicks);
+      for (size_t t=roiStart; t<roiEnd; ++t) roi[i][t] = true;
+    }
+    return;
+  }
+
+  /// Largest difference of the ROI outputs from Wiener1D on the ROI ticks,
+  /// relative to the scale (largest output sample or noise rms)
+  template <typename T>
+  double getDeviation(const double noiseRms, const float noiseVar,
+    const bool relativeToNoise)
+  {
+    std::vector<std::vector<T>> waveforms;
+    std::vector<std::vector<bool>> roi;
+    getEvent<T>(noiseRms, waveforms, roi);
+    std::vector<T> response = getResponse<T>();
+
+    Deconvolution deconvolution;
+    std::vector<std::vector<T>> full;
+    deconvolution.Wiener1D(full, waveforms, response, noiseVar);
+    std::vector<ROIWaveform<T>> outputROIs;
+    deconvolution.WienerROI1D(outputROIs, waveforms, roi, response, noiseVar,
+      kMargin);
+
+    // Noise rms on the ticks away from the deposits, or largest sample
+    double sumSq = 0.;
+    size_t count = 0;
+    double maxValue = 0.;
+    for (size_t i=0; i<kNumChannels; ++i) {
+      for (size_t t=0; t<kNumTicks; ++t) {
+        maxValue = std::max(maxValue, double(std::fabs(full[i][t])));
+        if (t + 200 > kDeposits[i] && t < kDeposits[i] + 400) continue;
+        sumSq += double(full[i][t]) * double(full[i][t]);
+        ++count;
+      }
+    }
+    double scale = relativeToNoise ? std::sqrt(sumSq / count) : maxValue;
+
+    size_t numROIs = 0;
+    double maxDiff = 0.;
+    for (const auto& window : outputROIs) {
+      for (size_t k=0; k<window.data.size(); ++k) {
+        size_t t = window.startTick + k;
+        if (!roi[window.channel][t]) continue;
+        maxDiff = std::max(maxDiff,
+          double(std::fabs(window.data[k] - full[window.channel][t])));
+      }
+      ++numROIs;
+    }
+    return numROIs == kNumChannels ? maxDiff / scale : HUGE_VAL;
+  }
+}
+
+int main()
+{
+  double floatExact = getDeviation<float>(0., 1e-6, false);
+  double doubleExact = getDeviation<double>(0., 1e-6, false);
+  bool exactOk = floatExact < 5e-3 && doubleExact < 5e-3;
+  double floatNoisy = getDeviation<float>(1., 1., true);
+  double doubleNoisy = getDeviation<double>(3., 9., true);
+  bool noisyOk = floatNoisy < 2.2 && doubleNoisy < 2.2;
+  std::printf("%-40s %s (float %.2g, double %.2g)\n",
+    "noise free ROIs match Wiener1D", exactOk ? "ok" : "FAILED",
+    floatExact, doubleExact);
+  std::printf("%-40s %s (float %.2g, double %.2g noise rms)\n",
+    "noisy ROIs within deconvolved noise", noisyOk ? "ok" : "FAILED",
+    floatNoisy, doubleNoisy);
+  return exactOk && noisyOk ? 0 : 1;
+}